@@ -0,0 +1,259 @@
+#include <benchmark/benchmark.h>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <memory>
+#include <string>
+#include "Benchmarks/Workload.h"
+#include "Database/Connection.h"
+#include "Database/Database.h"
+#include "Export/StatisticsExporter.h"
+
+// Бенчмарки слоя хранения на воспроизводимой нагрузке (Workload.h).
+// Базы с данными создаются при первом обращении и остаются на диске
+// (hoka_bench_<N>.db в каталоге HOKA_BENCH_DIR или в текущем), поэтому
+// повторный запуск не тратит время на заполнение 10M нажатий.
+//
+// С HOKA_BENCH_STORAGE=memory основная БД живет в памяти, а файлы
+// служат ее снимками (Database::setSnapshotPolicy).
+//
+//   hoka_bench --benchmark_filter='/1000$'   - только маленький размер
+//   HOKA_BENCH_DIR=/tmp hoka_bench            - базы во временном каталоге
+
+namespace {
+
+constexpr std::uint64_t kWorkloadSeed = 42;
+
+std::string benchPath(const std::string& name) {
+    const char* dir = std::getenv("HOKA_BENCH_DIR");
+    std::string base = dir && *dir ? std::string(dir) + "/" : std::string();
+    return base + name;
+}
+
+bool inMemoryStorage() {
+    const char* storage = std::getenv("HOKA_BENCH_STORAGE");
+    return storage && std::string(storage) == "memory";
+}
+
+// Открывает БД по пути; в режиме памяти путь становится файлом снимков
+bool openBenchDatabase(Database& db, const std::string& path) {
+    if (!inMemoryStorage()) {
+        return db.initialize(path);
+    }
+    db.setSnapshotPolicy(path, std::chrono::hours(24));
+    return db.initialize(Database::kInMemory);
+}
+
+// Хранить все уровни: нагрузка начинается в 2024 году, и политика по
+// умолчанию удалила бы ее при первом же уплотнении
+RetentionPolicy keepEverything() {
+    return RetentionPolicy{std::nullopt, std::nullopt, std::nullopt, std::nullopt};
+}
+
+void removeDatabase(const std::string& path) {
+    for (const char* suffix : {"", "-wal", "-shm"}) {
+        std::remove((path + suffix).c_str());
+    }
+}
+
+// База с rows нажатиями одной и той же нагрузки; открывается один раз
+// на процесс и переиспользуется всеми бенчмарками этого размера
+Database& populatedDatabase(std::int64_t rows) {
+    static std::map<std::int64_t, std::unique_ptr<Database>> databases;
+    auto& db = databases[rows];
+    if (db) {
+        return *db;
+    }
+
+    std::string path = benchPath("hoka_bench_" + std::to_string(rows) + ".db");
+    db = std::make_unique<Database>();
+    if (!openBenchDatabase(*db, path)) {
+        std::fprintf(stderr, "Failed to open benchmark database %s\n", path.c_str());
+        std::exit(1);
+    }
+    db->setRetentionPolicy(keepEverything());
+
+    // Полная база узнается по числу нажатий в сводках; иначе заполняется заново
+    if (db->countPresses(0, INT64_MAX) != rows) {
+        std::fprintf(stderr, "Populating %s with %lld presses...\n", path.c_str(),
+                     static_cast<long long>(rows));
+        db->clearStatistics();
+        db->setWriteBufferPolicy(std::chrono::milliseconds(1000), 65536);
+        Workload workload(kWorkloadSeed);
+        for (std::int64_t i = 0; i < rows; ++i) {
+            WorkloadPress press = workload.next();
+            db->updateKeyStatistics(*press.appName, *press.keyCombination, press.timestamp);
+        }
+        db->flush();
+        db->setWriteBufferPolicy(std::chrono::milliseconds(1000), 256);
+    }
+    return *db;
+}
+
+void sizeArguments(benchmark::internal::Benchmark* bench) {
+    bench->Arg(1000)->Arg(100000)->Arg(10000000);
+}
+
+} // namespace
+
+// Пропускная способность записи: нажатия через буфер и поток записи,
+// включая финальный flush (время - реальное, работа идет в другом потоке)
+static void BM_UpdateKeyStatistics(benchmark::State& state) {
+    std::string path = benchPath("hoka_bench_write.db");
+    removeDatabase(path);
+    Database db;
+    // Снимки здесь не нужны: база пишется с нуля и удаляется
+    bool opened = inMemoryStorage() ? db.initialize(Database::kInMemory) : db.initialize(path);
+    if (!opened) {
+        state.SkipWithError("Failed to open database");
+        return;
+    }
+    db.setRetentionPolicy(keepEverything());
+    db.setWriteBufferPolicy(std::chrono::milliseconds(1000), static_cast<size_t>(state.range(0)));
+
+    Workload workload(kWorkloadSeed);
+    for (auto _ : state) {
+        WorkloadPress press = workload.next();
+        db.updateKeyStatistics(*press.appName, *press.keyCombination, press.timestamp);
+    }
+    db.flush();
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_UpdateKeyStatistics)->Arg(256)->Arg(4096)->UseRealTime();
+
+// Первая страница (50 строк) самого частого приложения за все время
+static void BM_QueryComboStatsFirstPage(benchmark::State& state) {
+    Database& db = populatedDatabase(state.range(0));
+    ComboStatsQuery query;
+    query.appName = Workload().hottestApp();
+    for (auto _ : state) {
+        ComboStatsPage page = db.queryComboStats(query);
+        benchmark::DoNotOptimize(page.rows.data());
+    }
+}
+BENCHMARK(BM_QueryComboStatsFirstPage)->Apply(sizeArguments);
+
+// Все комбинации приложения без постраничной выдачи
+static void BM_QueryComboStatsAll(benchmark::State& state) {
+    Database& db = populatedDatabase(state.range(0));
+    ComboStatsQuery query;
+    query.appName = Workload().hottestApp();
+    query.pageSize = 0;
+    size_t rows = 0;
+    for (auto _ : state) {
+        ComboStatsPage page = db.queryComboStats(query);
+        rows = page.rows.size();
+        benchmark::DoNotOptimize(page.rows.data());
+    }
+    state.counters["rows"] = static_cast<double>(rows);
+}
+BENCHMARK(BM_QueryComboStatsAll)->Apply(sizeArguments);
+
+// Временное окно не по границам суток: свертки разных уровней плюс сырые события
+static void BM_QueryComboStatsRange(benchmark::State& state) {
+    Database& db = populatedDatabase(state.range(0));
+    Workload workload(kWorkloadSeed);
+    ComboStatsQuery query;
+    query.appName = workload.hottestApp();
+    query.fromMs = Workload::kStartMs + 90 * 1000;
+    query.toMs = Workload::kStartMs + state.range(0) * 200 - 90 * 1000;
+    for (auto _ : state) {
+        ComboStatsPage page = db.queryComboStats(query);
+        benchmark::DoNotOptimize(page.rows.data());
+    }
+}
+BENCHMARK(BM_QueryComboStatsRange)->Apply(sizeArguments);
+
+static void BM_GetAllApps(benchmark::State& state) {
+    Database& db = populatedDatabase(state.range(0));
+    for (auto _ : state) {
+        std::vector<std::string> apps = db.getAllApps();
+        benchmark::DoNotOptimize(apps.data());
+    }
+}
+BENCHMARK(BM_GetAllApps)->Apply(sizeArguments);
+
+static void runExport(benchmark::State& state, ExportFormat format, ExportContent content) {
+    Database& db = populatedDatabase(state.range(0));
+    std::string path = benchPath("hoka_bench_export.out");
+    ExportOptions options;
+    options.format = format;
+    options.filter.content = content;
+
+    StatisticsExporter exporter(db);
+    std::uint64_t bytes = 0;
+    std::uint64_t records = 0;
+    for (auto _ : state) {
+        ExportResult result = exporter.exportToFile(path, options);
+        if (!result.success) {
+            state.SkipWithError("Export failed");
+            break;
+        }
+        bytes += result.bytes;
+        records += result.records;
+    }
+    std::remove(path.c_str());
+    state.SetBytesProcessed(static_cast<std::int64_t>(bytes));
+    state.SetItemsProcessed(static_cast<std::int64_t>(records));
+}
+
+static void BM_ExportCsvTotals(benchmark::State& state) {
+    runExport(state, ExportFormat::Csv, ExportContent::Totals);
+}
+BENCHMARK(BM_ExportCsvTotals)->Apply(sizeArguments)->Unit(benchmark::kMillisecond);
+
+static void BM_ExportJsonLinesEvents(benchmark::State& state) {
+    runExport(state, ExportFormat::JsonLines, ExportContent::Events);
+}
+BENCHMARK(BM_ExportJsonLinesEvents)->Apply(sizeArguments)->Unit(benchmark::kMillisecond);
+
+// Кэш подготовленных выражений: Connection::execute против
+// sqlite3_prepare_v2/finalize на каждый вызов, на одной и той же вставке
+namespace {
+
+const char* const kUpsertSql =
+    "INSERT INTO counters (name, value) VALUES (?1, 1) "
+    "ON CONFLICT(name) DO UPDATE SET value = value + 1";
+
+bool openScratchConnection(Connection& connection) {
+    return connection.open(":memory:", SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE) &&
+           connection.executeScript(
+               "CREATE TABLE counters (name TEXT PRIMARY KEY, value INTEGER) WITHOUT ROWID");
+}
+
+} // namespace
+
+static void BM_StatementCached(benchmark::State& state) {
+    Connection connection;
+    if (!openScratchConnection(connection)) {
+        state.SkipWithError("Failed to open :memory: database");
+        return;
+    }
+    Workload workload(kWorkloadSeed);
+    for (auto _ : state) {
+        connection.execute(kUpsertSql, *workload.next().keyCombination);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_StatementCached);
+
+static void BM_StatementUncached(benchmark::State& state) {
+    Connection connection;
+    if (!openScratchConnection(connection)) {
+        state.SkipWithError("Failed to open :memory: database");
+        return;
+    }
+    Workload workload(kWorkloadSeed);
+    for (auto _ : state) {
+        const std::string& combo = *workload.next().keyCombination;
+        sqlite3_stmt* stmt = nullptr;
+        sqlite3_prepare_v2(connection.get(), kUpsertSql, -1, &stmt, nullptr);
+        sqlite3_bind_text(stmt, 1, combo.c_str(), static_cast<int>(combo.size()), SQLITE_STATIC);
+        sqlite3_step(stmt);
+        sqlite3_finalize(stmt);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_StatementUncached);
+
+BENCHMARK_MAIN();
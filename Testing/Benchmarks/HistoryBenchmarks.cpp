@@ -0,0 +1,125 @@
+#include <benchmark/benchmark.h>
+#include "Benchmarks/Workload.h"
+#include "Models/KeyStatistics.h"
+#include "Storage/StatisticsSnapshot.h"
+#include <cstdio>
+
+// История нажатий в памяти (KeyStatistics): добавление в заполненную
+// историю должно стоить одинаково при любой емкости
+static void BM_HistoryAddKeyPress(benchmark::State& state) {
+    KeyStatistics stats(static_cast<size_t>(state.range(0)));
+    Workload workload;
+    // Заполняем до емкости, чтобы мерить именно вытеснение старых
+    for (std::int64_t i = 0; i < state.range(0); ++i) {
+        WorkloadPress press = workload.next();
+        stats.addKeyPress(*press.appName, *press.keyCombination, press.timestamp);
+    }
+
+    for (auto _ : state) {
+        WorkloadPress press = workload.next();
+        stats.addKeyPress(*press.appName, *press.keyCombination, press.timestamp);
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.counters["bytes_per_press"] = sizeof(KeyPress);
+}
+BENCHMARK(BM_HistoryAddKeyPress)->Arg(1000)->Arg(1000000);
+
+static void BM_HistoryRecentPresses(benchmark::State& state) {
+    KeyStatistics stats(1000000);
+    Workload workload;
+    for (int i = 0; i < 1500000; ++i) {
+        WorkloadPress press = workload.next();
+        stats.addKeyPress(*press.appName, *press.keyCombination, press.timestamp);
+    }
+    for (auto _ : state) {
+        auto recent = stats.getRecentPresses(static_cast<size_t>(state.range(0)));
+        benchmark::DoNotOptimize(recent.data());
+    }
+}
+BENCHMARK(BM_HistoryRecentPresses)->Arg(10)->Arg(1000);
+
+// Топ клавиш на каждое обновление окна: O(K) при любом размере истории
+static void BM_HistoryTopKeys(benchmark::State& state) {
+    KeyStatistics stats(static_cast<size_t>(state.range(0)));
+    Workload workload;
+    for (std::int64_t i = 0; i < state.range(0); ++i) {
+        WorkloadPress press = workload.next();
+        stats.addKeyPress(*press.appName, *press.keyCombination, press.timestamp);
+    }
+    for (auto _ : state) {
+        auto top = stats.getTopKeys(10);
+        benchmark::DoNotOptimize(top.data());
+    }
+}
+BENCHMARK(BM_HistoryTopKeys)->Arg(1000)->Arg(1000000);
+
+// Выборка по приложению и интервалу времени: проход по записям против
+// столбцов с векторными ядрами (аргумент 1); 10M нажатий в памяти
+static void BM_HistoryCountPresses(benchmark::State& state) {
+    constexpr size_t kPresses = 10000000;
+    KeyStatistics stats(kPresses);
+    stats.setColumnarHistory(state.range(0) != 0);
+    Workload workload;
+    for (size_t i = 0; i < kPresses; ++i) {
+        WorkloadPress press = workload.next();
+        stats.addKeyPress(*press.appName, *press.keyCombination, press.timestamp);
+    }
+    auto [from, to] = stats.getTimeRange();
+    std::int64_t middle = from + (to - from) / 2;
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(stats.countPresses(workload.hottestApp(), "", from, middle));
+    }
+    state.SetItemsProcessed(state.iterations() * kPresses);
+    state.SetBytesProcessed(state.iterations() * kPresses * (sizeof(SymbolId) + sizeof(std::int64_t)));
+}
+BENCHMARK(BM_HistoryCountPresses)->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond);
+
+// Топ комбинаций за последние N минут: сумма минутных корзин, без
+// прохода по нажатиям (~200 нажатий в минуту)
+static void BM_WindowTopKeys(benchmark::State& state) {
+    KeyStatistics stats(1000);
+    Workload workload;
+    for (int i = 0; i < 500000; ++i) {
+        WorkloadPress press = workload.next();
+        stats.addKeyPress(*press.appName, *press.keyCombination, press.timestamp);
+    }
+    std::int64_t duration = state.range(0) * 60000;
+    for (auto _ : state) {
+        auto top = stats.getTopKeysInWindow(duration, 10, workload.now());
+        benchmark::DoNotOptimize(top.data());
+    }
+}
+BENCHMARK(BM_WindowTopKeys)->Arg(15)->Arg(60)->Unit(benchmark::kMicrosecond);
+
+// Теплый старт из двоичного снимка: отображение, CRC и сборка истории
+// и счетчиков блоками; для сравнения - повтор тех же нажатий через
+// addKeyPress (аргумент 0)
+static void BM_SnapshotWarmStart(benchmark::State& state) {
+    const size_t presses = static_cast<size_t>(state.range(1));
+    const std::string path = "hoka_bench.snapshot";
+    KeyStatistics source(presses);
+    Workload workload;
+    for (size_t i = 0; i < presses; ++i) {
+        WorkloadPress press = workload.next();
+        source.addKeyPress(*press.appName, *press.keyCombination, press.timestamp);
+    }
+    StatisticsSnapshot::save(source, path);
+
+    for (auto _ : state) {
+        KeyStatistics stats(presses);
+        if (state.range(0) != 0) {
+            StatisticsSnapshot::load(path, stats);
+        } else {
+            for (const auto& press : source.getHistory()) {
+                stats.addKeyPress(source.getAppName(press), source.getKeyCombination(press),
+                                  press.timestamp);
+            }
+        }
+        benchmark::DoNotOptimize(stats.getCount());
+    }
+    std::remove(path.c_str());
+}
+BENCHMARK(BM_SnapshotWarmStart)
+    ->Args({0, 100000})->Args({1, 100000})->Args({0, 1000000})->Args({1, 1000000})
+    ->Unit(benchmark::kMillisecond);
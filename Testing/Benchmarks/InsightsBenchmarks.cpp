@@ -0,0 +1,33 @@
+#include <benchmark/benchmark.h>
+#include "Insights/RemapOptimizer.h"
+
+// Подбор раскладки для приложения с сотнями команд: время ответа при
+// фиксированном числе итераций на цепочку и разном числе потоков
+static void BM_RemapOptimize(benchmark::State& state) {
+    auto chords = ErgonomicModel().candidateChords(
+        {ModifierCtrl | ModifierAlt | ModifierShift, ModifierCtrl | ModifierAlt | ModifierWin,
+         ModifierAlt | ModifierShift | ModifierWin, ModifierCtrl | ModifierShift | ModifierWin,
+         ModifierAlt | ModifierWin, ModifierCtrl | ModifierWin, ModifierShift | ModifierWin});
+    RemapProblem problem;
+    for (size_t i = 0; i < 300; ++i) {
+        problem.shortcuts.push_back(
+            {formatChord(chords[i]), static_cast<std::int64_t>(100000 / (i + 1))});
+    }
+    for (size_t i = 0; i + 1 < problem.shortcuts.size(); ++i) {
+        problem.transitions.push_back({i, i + 1, problem.shortcuts[i + 1].pressCount / 4});
+    }
+
+    RemapOptions options;
+    options.threads = static_cast<size_t>(state.range(0));
+    options.iterationsPerThread = 500000;
+    options.timeBudget = std::chrono::minutes(1);
+    RemapOptimizer optimizer;
+    double saving = 0;
+    for (auto _ : state) {
+        RemapPlan plan = optimizer.optimize(problem, options);
+        saving = 1 - plan.optimizedCost / plan.currentCost;
+        benchmark::DoNotOptimize(plan);
+    }
+    state.counters["saving"] = saving;
+}
+BENCHMARK(BM_RemapOptimize)->Arg(1)->Arg(4)->Unit(benchmark::kMillisecond)->UseRealTime();
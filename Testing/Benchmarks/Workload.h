@@ -0,0 +1,78 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+// Распределение Ципфа на рангах [0, n): P(k) ~ 1 / (k + 1)^skew.
+// Выборка - бинарный поиск по заранее посчитанной функции распределения.
+class ZipfDistribution {
+private:
+  std::vector<double> cdf;
+
+public:
+  ZipfDistribution(size_t n, double skew) : cdf(n) {
+    double sum = 0;
+    for (size_t k = 0; k < n; ++k) {
+      sum += 1.0 / std::pow(static_cast<double>(k + 1), skew);
+      cdf[k] = sum;
+    }
+    for (auto &value : cdf) {
+      value /= sum;
+    }
+  }
+
+  template <typename Generator> size_t operator()(Generator &rng) {
+    double u = std::uniform_real_distribution<double>(0.0, 1.0)(rng);
+    auto it = std::lower_bound(cdf.begin(), cdf.end(), u);
+    return std::min(static_cast<size_t>(it - cdf.begin()), cdf.size() - 1);
+  }
+};
+
+struct WorkloadPress {
+  const std::string *appName;
+  const std::string *keyCombination;
+  std::int64_t timestamp;
+};
+
+// Воспроизводимый поток нажатий: приложения и комбинации с частотами по
+// Ципфу (несколько горячих, длинный хвост), время растет с шагом в
+// среднем 200 мс. Одинаковый seed - одинаковая последовательность.
+class Workload {
+private:
+  std::vector<std::string> apps;
+  std::vector<std::string> combos;
+  ZipfDistribution appRanks;
+  ZipfDistribution comboRanks;
+  std::mt19937_64 rng;
+  std::int64_t clock;
+
+public:
+  static constexpr std::int64_t kStartMs = 1704067200000; // 2024-01-01 UTC
+
+  explicit Workload(std::uint64_t seed = 42, size_t appCount = 64,
+                    size_t comboCount = 2000, double skew = 1.1)
+      : appRanks(appCount, skew), comboRanks(comboCount, skew), rng(seed),
+        clock(kStartMs) {
+    static const char *kModifiers[] = {"", "Ctrl+", "Shift+", "Alt+",
+                                       "Ctrl+Shift+", "Ctrl+Alt+", "Win+"};
+    for (size_t i = 0; i < appCount; ++i) {
+      apps.push_back("app_" + std::to_string(i) + ".exe");
+    }
+    for (size_t i = 0; i < comboCount; ++i) {
+      const char *modifier = kModifiers[i % (sizeof(kModifiers) / sizeof(kModifiers[0]))];
+      combos.push_back(std::string(modifier) + "K" + std::to_string(i));
+    }
+  }
+
+  WorkloadPress next() {
+    clock += std::uniform_int_distribution<std::int64_t>(1, 400)(rng);
+    return {&apps[appRanks(rng)], &combos[comboRanks(rng)], clock};
+  }
+
+  // Самое частое приложение - для запросов по "типичному" приложению
+  const std::string &hottestApp() const { return apps.front(); }
+  std::int64_t now() const { return clock; }
+};
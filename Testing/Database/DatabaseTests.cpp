@@ -1,14 +1,47 @@
 #include <gtest/gtest.h>
 #include <algorithm> // Добавлено для std::find
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Database/Connection.h"
 #include "Database/Database.h"
 
+namespace {
+
+// Все строки статистики приложения за все время
+std::vector<ComboStat> allCombos(Database& db, const std::string& app) {
+    ComboStatsQuery query;
+    query.appName = app;
+    query.pageSize = 0;
+    return db.queryComboStats(query).rows;
+}
+
+std::int64_t totalPresses(const std::vector<ComboStat>& rows) {
+    std::int64_t total = 0;
+    for (const auto& row : rows) {
+        total += row.pressCount;
+    }
+    return total;
+}
+
+bool hasCombo(const std::vector<ComboStat>& rows, const std::string& combo) {
+    return std::any_of(rows.begin(), rows.end(),
+                       [&](const ComboStat& row) { return row.keyCombination == combo; });
+}
+
+} // namespace
+
 // Test fixture for Database tests
 class DatabaseTest : public ::testing::Test {
 protected:
     Database db;
 
     void SetUp() override {
-        ASSERT_TRUE(db.initialize()) << "Failed to initialize database";
+        ASSERT_TRUE(db.initialize(Database::kInMemory)) << "Failed to initialize database";
     }
 
     void TearDown() override {
@@ -22,35 +55,684 @@ TEST_F(DatabaseTest, UpdateAndGetKeyStatistics) {
     std::string keyCombo = "Ctrl+S";
 
     db.updateKeyStatistics(appName, keyCombo);
+    ASSERT_TRUE(db.flush());
 
-    std::string stats = db.getAppStatistics(appName);
+    auto stats = allCombos(db, appName);
     EXPECT_FALSE(stats.empty()) << "Statistics should not be empty";
-    EXPECT_NE(stats.find(keyCombo), std::string::npos) << "Key combo not found in stats";
+    EXPECT_TRUE(hasCombo(stats, keyCombo)) << "Key combo not found in stats";
 }
 
 // Test case for clearing statistics
 TEST_F(DatabaseTest, ClearStatistics) {
     db.updateKeyStatistics("testApp", "Ctrl+C");
+    ASSERT_TRUE(db.flush());
     
     // Проверьте, что данные действительно добавились
-    std::string before = db.getAppStatistics("testApp");
-    std::cout << "Before clear: " << before << std::endl;
+    EXPECT_EQ(allCombos(db, "testApp").size(), 1u);
     
     EXPECT_TRUE(db.clearStatistics()) << "Failed to clear statistics";
     
     // Проверьте количество записей после очистки
-    std::string stats = db.getAppStatistics("testApp");
-    std::cout << "After clear: " << stats << std::endl;
-    
-    EXPECT_TRUE(stats.empty() || stats == "No key presses recorded for testApp yet.\n") << "Stats not cleared";
+    EXPECT_TRUE(allCombos(db, "testApp").empty()) << "Stats not cleared";
 }
 
 // Test case for retrieving all apps
 TEST_F(DatabaseTest, GetAllApps) {
     db.updateKeyStatistics("app1", "Ctrl+A");
     db.updateKeyStatistics("app2", "Ctrl+B");
+    ASSERT_TRUE(db.flush());
     auto apps = db.getAllApps();
     EXPECT_EQ(apps.size(), 2) << "Expected 2 apps";
     EXPECT_TRUE(std::find(apps.begin(), apps.end(), std::string("app1")) != apps.end()) << "app1 not found";
     EXPECT_TRUE(std::find(apps.begin(), apps.end(), std::string("app2")) != apps.end()) << "app2 not found";
-}
\ No newline at end of file
+}
+
+// Test case for write-behind buffering and group commit
+TEST_F(DatabaseTest, WriteBufferFlushesOnBatchSize) {
+    db.setWriteBufferPolicy(std::chrono::hours(1), 3);
+
+    db.updateKeyStatistics("bufApp", "Ctrl+Z");
+    db.updateKeyStatistics("bufApp", "Ctrl+Z");
+    EXPECT_EQ(db.getPendingCount(), 2) << "Presses should stay in the buffer";
+    EXPECT_TRUE(db.getAllApps().empty()) << "Nothing should be written before the batch is full";
+
+    db.updateKeyStatistics("bufApp", "Ctrl+Y");
+    // Полный пакет сбрасывает поток записи
+    for (int i = 0; i < 100 && db.getPendingCount() > 0; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    EXPECT_EQ(db.getPendingCount(), 0) << "Full batch should be flushed";
+    ASSERT_TRUE(db.flush());
+
+    auto stats = allCombos(db, "bufApp");
+    EXPECT_TRUE(hasCombo(stats, "Ctrl+Z"));
+    EXPECT_EQ(totalPresses(stats), 3);
+}
+
+// Test case for the periodic background flush
+TEST_F(DatabaseTest, WriteBufferFlushesOnTimer) {
+    db.setWriteBufferPolicy(std::chrono::milliseconds(20), 1000);
+    db.updateKeyStatistics("timerApp", "Alt+F4");
+
+    bool committed = false;
+    for (int i = 0; i < 100 && !committed; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        committed = hasCombo(allCombos(db, "timerApp"), "Alt+F4");
+    }
+    EXPECT_TRUE(committed) << "Background thread should flush the buffer";
+    EXPECT_EQ(db.getPendingCount(), 0);
+}
+
+// Test case for merging repeated presses of the same combination
+TEST_F(DatabaseTest, WriteBufferMergesIncrements) {
+    db.setWriteBufferPolicy(std::chrono::hours(1), 1000);
+
+    for (int i = 0; i < 100; ++i) {
+        db.updateKeyStatistics("mergeApp", "Ctrl+S");
+    }
+    ASSERT_TRUE(db.flush());
+    db.updateKeyStatistics("mergeApp", "Ctrl+S");
+    ASSERT_TRUE(db.flush());
+
+    auto stats = allCombos(db, "mergeApp");
+    EXPECT_EQ(stats.size(), 1u);
+    EXPECT_EQ(totalPresses(stats), 101);
+}
+
+// Test case for the forced flush on clear
+TEST_F(DatabaseTest, ClearDropsBufferedPresses) {
+    db.setWriteBufferPolicy(std::chrono::hours(1), 1000);
+    db.updateKeyStatistics("clearApp", "Ctrl+X");
+
+    EXPECT_TRUE(db.clearStatistics());
+    EXPECT_EQ(db.getPendingCount(), 0);
+    ASSERT_TRUE(db.flush());
+    EXPECT_TRUE(db.getAllApps().empty());
+}
+
+// Test fixture with a legacy database at a unique temporary path, away
+// from the default keypress_stats.db
+class DatabaseMigrationTest : public ::testing::Test {
+protected:
+    std::string path;
+
+    void SetUp() override {
+        path = (std::filesystem::temp_directory_path() /
+                ("hoka_legacy_test_" +
+                 std::to_string(std::chrono::steady_clock::now().time_since_epoch().count()) +
+                 ".db")).string();
+    }
+
+    void TearDown() override {
+        std::remove(path.c_str());
+        std::remove((path + "-wal").c_str());
+        std::remove((path + "-shm").c_str());
+    }
+};
+
+// Test case for converting a schema v1 file to the normalized schema
+TEST_F(DatabaseMigrationTest, MigratesLegacyKeyStatistics) {
+    {
+        sqlite3* legacy = nullptr;
+        ASSERT_EQ(sqlite3_open(path.c_str(), &legacy), SQLITE_OK);
+        ASSERT_EQ(sqlite3_exec(legacy,
+            "CREATE TABLE key_statistics ("
+            "id INTEGER PRIMARY KEY AUTOINCREMENT,"
+            "app_name TEXT NOT NULL,"
+            "key_combination TEXT NOT NULL,"
+            "press_count INTEGER DEFAULT 1,"
+            "last_pressed TIMESTAMP DEFAULT CURRENT_TIMESTAMP,"
+            "UNIQUE(app_name, key_combination));"
+            "WITH RECURSIVE n(i) AS (SELECT 1 UNION ALL SELECT i + 1 FROM n WHERE i < 2500) "
+            "INSERT INTO key_statistics (app_name, key_combination, press_count) "
+            "SELECT 'legacyApp' || (i % 5), 'Ctrl+' || i, i FROM n;",
+            nullptr, nullptr, nullptr), SQLITE_OK);
+        sqlite3_close(legacy);
+    }
+
+    Database db;
+    ASSERT_TRUE(db.initialize(path));
+    ASSERT_TRUE(db.finishMigration());
+    EXPECT_TRUE(db.isMigrationComplete());
+
+    auto apps = db.getAllApps();
+    EXPECT_EQ(apps.size(), 5u);
+
+    // Новые нажатия складываются с перенесенными счетчиками
+    db.updateKeyStatistics("legacyApp0", "Ctrl+2500");
+    ASSERT_TRUE(db.flush());
+    ComboStatsQuery query;
+    query.appName = "legacyApp0";
+    query.pageSize = 1;
+    auto top = db.queryComboStats(query).rows;
+    ASSERT_EQ(top.size(), 1u);
+    EXPECT_EQ(top[0].keyCombination, "Ctrl+2500");
+    EXPECT_EQ(top[0].pressCount, 2501);
+
+    EXPECT_TRUE(db.clearStatistics());
+}
+
+// Test case for readers running alongside the writer thread.
+// Readers must always see a committed snapshot: per-app totals only grow.
+TEST_F(DatabaseTest, ConcurrentReadersSeeConsistentSnapshots) {
+    db.setWriteBufferPolicy(std::chrono::milliseconds(5), 64);
+
+    constexpr int kWriters = 2;
+    constexpr int kPressesPerWriter = 2000;
+    std::atomic<bool> writing{true};
+    std::atomic<int> reads{0};
+    std::atomic<bool> snapshotsMonotonic{true};
+
+    std::vector<std::thread> readerThreads;
+    for (int r = 0; r < 3; ++r) {
+        readerThreads.emplace_back([&] {
+            std::int64_t lastTotal = 0;
+            while (writing) {
+                std::int64_t total = totalPresses(allCombos(db, "concurrentApp"));
+                if (total < lastTotal) {
+                    snapshotsMonotonic = false;
+                }
+                lastTotal = total;
+                db.getAllApps();
+                reads++;
+            }
+        });
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> writerThreads;
+    for (int w = 0; w < kWriters; ++w) {
+        writerThreads.emplace_back([&, w] {
+            for (int i = 0; i < kPressesPerWriter; ++i) {
+                db.updateKeyStatistics("concurrentApp", "Ctrl+" + std::to_string((i + w) % 20));
+            }
+        });
+    }
+    for (auto& t : writerThreads) {
+        t.join();
+    }
+    ASSERT_TRUE(db.flush());
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start);
+
+    writing = false;
+    for (auto& t : readerThreads) {
+        t.join();
+    }
+
+    EXPECT_TRUE(snapshotsMonotonic) << "Reader observed a total going backwards";
+    EXPECT_GT(reads.load(), 0);
+    EXPECT_EQ(totalPresses(allCombos(db, "concurrentApp")), kWriters * kPressesPerWriter);
+
+    RecordProperty("writes_per_sec", static_cast<int>(
+        kWriters * kPressesPerWriter * 1000.0 / std::max<long long>(1, elapsed.count())));
+    RecordProperty("reads_during_writes", reads.load());
+}
+
+// Test case for range counts served from rollups plus raw edges
+TEST_F(DatabaseTest, CountPressesMatchesRawEvents) {
+    db.setWriteBufferPolicy(std::chrono::hours(1), 100000);
+
+    // Нажатия на протяжении ~3 суток с неровным шагом
+    const sqlite3_int64 base = 1700000000000LL;
+    std::vector<std::pair<sqlite3_int64, std::string>> presses;
+    for (int i = 0; i < 3000; ++i) {
+        sqlite3_int64 ts = base + static_cast<sqlite3_int64>(i) * 86413 + (i % 7) * 1000;
+        std::string combo = (i % 3 == 0) ? "Ctrl+C" : "Ctrl+V";
+        presses.emplace_back(ts, combo);
+        db.updateKeyStatistics(i % 2 ? "seriesA" : "seriesB", combo, ts);
+    }
+    ASSERT_TRUE(db.flush());
+
+    auto bruteForce = [&](sqlite3_int64 from, sqlite3_int64 to, const std::string& combo) {
+        sqlite3_int64 count = 0;
+        for (const auto& [ts, c] : presses) {
+            if (ts >= from && ts < to && (combo.empty() || c == combo)) {
+                count++;
+            }
+        }
+        return count;
+    };
+
+    const std::pair<sqlite3_int64, sqlite3_int64> ranges[] = {
+        {base, base + 1},
+        {base + 59999, base + 60001},
+        {base + 12345, base + 3 * 3600000 + 777},
+        {base - 86400000, base + 4 * 86400000LL},
+        {base + 86400000 - 1234, base + 2 * 86400000 + 98765},
+    };
+    for (const auto& [from, to] : ranges) {
+        EXPECT_EQ(db.countPresses(from, to), bruteForce(from, to, "")) << from << ".." << to;
+        EXPECT_EQ(db.countPresses(from, to, "", "Ctrl+C"), bruteForce(from, to, "Ctrl+C"));
+    }
+
+    EXPECT_EQ(db.countPresses(base, base + 4 * 86400000LL, "seriesA"), 1500);
+    EXPECT_EQ(db.countPresses(base, base + 4 * 86400000LL, "missingApp"), 0);
+}
+
+// Test case for keyset pagination over lifetime counters
+TEST_F(DatabaseTest, QueryComboStatsPagesByCountAndCombo) {
+    db.setWriteBufferPolicy(std::chrono::hours(1), 100000);
+    // 30 комбинаций, у многих одинаковые счетчики
+    for (int i = 0; i < 30; ++i) {
+        for (int n = 0; n <= i / 3; ++n) {
+            db.updateKeyStatistics("pagedApp", "Ctrl+" + std::to_string(i));
+        }
+    }
+    ASSERT_TRUE(db.flush());
+
+    auto expected = allCombos(db, "pagedApp");
+    ASSERT_EQ(expected.size(), 30u);
+
+    ComboStatsQuery query;
+    query.appName = "pagedApp";
+    query.pageSize = 7;
+    std::vector<ComboStat> paged;
+    int pages = 0;
+    while (true) {
+        auto page = db.queryComboStats(query);
+        paged.insert(paged.end(), page.rows.begin(), page.rows.end());
+        pages++;
+        if (!page.next) {
+            break;
+        }
+        query.after = page.next;
+    }
+
+    EXPECT_EQ(pages, 5);
+    ASSERT_EQ(paged.size(), expected.size());
+    for (size_t i = 0; i < paged.size(); ++i) {
+        EXPECT_EQ(paged[i].comboId, expected[i].comboId) << i;
+        if (i > 0) {
+            EXPECT_GE(paged[i - 1].pressCount, paged[i].pressCount);
+        }
+    }
+}
+
+// Test case for range pages assembled from every rollup level
+TEST_F(DatabaseTest, QueryRangeComboStatsPagesAcrossRollups) {
+    db.setWriteBufferPolicy(std::chrono::hours(1), 100000);
+    const sqlite3_int64 base = 1700000000000LL + 12345;
+    // 20 комбинаций с повторяющимися счетчиками, нажатия разбросаны на
+    // несколько суток, чтобы окно с невыровненными краями задело все уровни
+    int press = 0;
+    for (int i = 0; i < 20; ++i) {
+        for (int n = 0; n <= i / 4; ++n, ++press) {
+            db.updateKeyStatistics("rangeApp", "Alt+" + std::to_string(i),
+                                   base + press * 3607001LL);
+        }
+    }
+    db.updateKeyStatistics("otherApp", "Alt+1", base);
+    ASSERT_TRUE(db.flush());
+
+    auto expected = allCombos(db, "rangeApp");
+    ASSERT_EQ(expected.size(), 20u);
+
+    ComboStatsQuery query;
+    query.appName = "rangeApp";
+    query.fromMs = base;
+    query.toMs = base + press * 3607001LL;
+    query.pageSize = 6;
+    std::vector<ComboStat> paged;
+    while (true) {
+        auto page = db.queryComboStats(query);
+        paged.insert(paged.end(), page.rows.begin(), page.rows.end());
+        if (!page.next) {
+            break;
+        }
+        query.after = page.next;
+    }
+
+    ASSERT_EQ(paged.size(), expected.size());
+    for (size_t i = 0; i < paged.size(); ++i) {
+        EXPECT_EQ(paged[i].comboId, expected[i].comboId) << i;
+        EXPECT_EQ(paged[i].pressCount, expected[i].pressCount) << i;
+        EXPECT_EQ(paged[i].lastPressed, expected[i].lastPressed) << i;
+    }
+}
+
+// Test case for time-window and modifier filters
+TEST_F(DatabaseTest, QueryComboStatsFiltersByTimeAndModifiers) {
+    db.setWriteBufferPolicy(std::chrono::hours(1), 100000);
+    const sqlite3_int64 base = 1700000000000LL;
+    const sqlite3_int64 hour = 3600000;
+
+    for (int i = 0; i < 10; ++i) {
+        db.updateKeyStatistics("windowApp", "Ctrl+S", base + i * 1000);
+        db.updateKeyStatistics("windowApp", "Ctrl+Shift+S", base + hour + i * 1000);
+        db.updateKeyStatistics("windowApp", "Alt+Tab", base + 2 * hour + i);
+    }
+    db.updateKeyStatistics("windowApp", "Ctrl+S", base + 3 * hour);
+    ASSERT_TRUE(db.flush());
+
+    ComboStatsQuery query;
+    query.appName = "windowApp";
+    query.fromMs = base + hour;
+    query.toMs = base + 3 * hour + 1;
+    auto rows = db.queryComboStats(query).rows;
+    ASSERT_EQ(rows.size(), 3u);
+    EXPECT_EQ(rows[0].pressCount, 10);
+    EXPECT_EQ(rows[2].keyCombination, "Ctrl+S");
+    EXPECT_EQ(rows[2].pressCount, 1);
+
+    query.modifiers = ModifierCtrl;
+    rows = db.queryComboStats(query).rows;
+    EXPECT_EQ(rows.size(), 2u);
+
+    query.exactModifiers = true;
+    rows = db.queryComboStats(query).rows;
+    ASSERT_EQ(rows.size(), 1u);
+    EXPECT_EQ(rows[0].keyCombination, "Ctrl+S");
+
+    query = ComboStatsQuery{};
+    query.appName = "windowApp";
+    query.modifiers = ModifierCtrl | ModifierShift;
+    rows = db.queryComboStats(query).rows;
+    ASSERT_EQ(rows.size(), 1u);
+    EXPECT_EQ(rows[0].keyCombination, "Ctrl+Shift+S");
+    EXPECT_EQ(rows[0].lastPressed, base + hour + 9000);
+}
+
+// Test case for retention tiers dropping expired detail only
+TEST_F(DatabaseTest, RetentionDropsExpiredTiersKeepsTotals) {
+    sqlite3_int64 day = 86400000;
+    sqlite3_int64 now = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    // Середина суток 40 дней назад: точно в пределах одних суток
+    sqlite3_int64 old = (now / day - 40) * day + day / 2;
+
+    for (int i = 0; i < 50; ++i) {
+        db.updateKeyStatistics("retentionApp", "Ctrl+S", old + i);
+    }
+    db.updateKeyStatistics("retentionApp", "Ctrl+S", now);
+    ASSERT_TRUE(db.flush());
+
+    RetentionPolicy policy;
+    policy.rawEvents = std::chrono::hours(24 * 30);
+    policy.minuteRollups = std::chrono::hours(24 * 30);
+    policy.hourRollups = std::chrono::hours(24 * 30);
+    db.setCompactionSchedule(std::chrono::hours(1), 7);
+    db.setRetentionPolicy(policy);
+    ASSERT_TRUE(db.compactNow());
+
+    // Сырые события и мелкие свертки удалены, сутки остались
+    EXPECT_EQ(db.countPresses(old, old + 50, "retentionApp"), 0);
+    EXPECT_EQ(db.countPresses(old - day / 2, old + day / 2, "retentionApp"), 50);
+    EXPECT_EQ(db.countPresses(now, now + 1, "retentionApp"), 1);
+    EXPECT_EQ(totalPresses(allCombos(db, "retentionApp")), 51);
+}
+
+// Test case for journal ids surviving retention, VACUUM and a clear
+TEST_F(DatabaseTest, EventIdsStayStable) {
+    auto eventIds = [&] {
+        HistoryQuery query;
+        query.pageSize = 0;
+        HistoryPage page;
+        EXPECT_TRUE(db.readHistoryPage(query, page));
+        std::vector<std::int64_t> ids;
+        for (const auto& row : page.rows) {
+            ids.push_back(row.eventId);
+        }
+        std::sort(ids.begin(), ids.end());
+        return ids;
+    };
+
+    sqlite3_int64 now = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    // Устаревшие нажатия вперемешку со свежими: удаление оставит дыры
+    for (int i = 0; i < 10; ++i) {
+        db.updateKeyStatistics("idApp", "Ctrl+S", i % 2 == 0 ? now + i : 1000 + i);
+    }
+    ASSERT_TRUE(db.flush());
+    auto before = eventIds();
+    ASSERT_EQ(before.size(), 10u);
+
+    db.setRetentionPolicy(RetentionPolicy{});
+    ASSERT_TRUE(db.compactNow());
+    ASSERT_TRUE(db.convertToIncrementalVacuum());
+    auto after = eventIds();
+    ASSERT_EQ(after.size(), 5u);
+    for (size_t i = 0; i < after.size(); ++i) {
+        EXPECT_EQ(after[i], before[i * 2]);
+    }
+
+    // После очистки номера не начинаются заново
+    ASSERT_TRUE(db.clearStatistics());
+    db.updateKeyStatistics("idApp", "Ctrl+S", now);
+    ASSERT_TRUE(db.flush());
+    auto regrown = eventIds();
+    ASSERT_EQ(regrown.size(), 1u);
+    EXPECT_GT(regrown[0], before.back());
+}
+
+// Test case for shortcut sequences being counted per batch and surviving a restart
+TEST(DatabaseSequenceTest, PersistsTopSequencesAcrossRestart) {
+    const std::string path = "hoka_sequences_test.db";
+    std::remove(path.c_str());
+    {
+        Database db;
+        ASSERT_TRUE(db.initialize(path));
+        db.setSequenceTimeout(std::chrono::milliseconds(1000));
+        // Копирование в редакторе и вставка в браузере, пять раз подряд
+        for (sqlite3_int64 i = 0; i < 5; ++i) {
+            sqlite3_int64 t = 100000 + i * 10000;
+            db.updateKeyStatistics("editor", "Ctrl+C", t);
+            db.updateKeyStatistics("editor", "Alt+Tab", t + 200);
+            db.updateKeyStatistics("browser", "Ctrl+V", t + 400);
+        }
+        // Пауза длиннее таймаута - не последовательность
+        db.updateKeyStatistics("browser", "Ctrl+T", 500000);
+        ASSERT_TRUE(db.flush());
+        db.updateKeyStatistics("browser", "Ctrl+W", 500300);
+        ASSERT_TRUE(db.flush());
+    }
+    {
+        Database db;
+        ASSERT_TRUE(db.initialize(path));
+        auto trigrams = db.getTopSequences(10, "", 3);
+        ASSERT_EQ(trigrams.size(), 1u);
+        EXPECT_EQ(trigrams[0].appName, "browser");
+        EXPECT_EQ(trigrams[0].combos,
+                  (std::vector<std::string>{"Ctrl+C", "Alt+Tab", "Ctrl+V"}));
+        EXPECT_EQ(trigrams[0].pressCount, 5);
+        EXPECT_EQ(trigrams[0].lastPressed, 140400);
+
+        auto editor = db.getTopSequences(10, "editor");
+        ASSERT_EQ(editor.size(), 1u);
+        EXPECT_EQ(editor[0].combos, (std::vector<std::string>{"Ctrl+C", "Alt+Tab"}));
+        EXPECT_EQ(editor[0].pressCount, 5);
+
+        auto browser = db.getTopSequences(10, "browser", 2);
+        ASSERT_EQ(browser.size(), 2u);
+        EXPECT_EQ(browser[0].combos, (std::vector<std::string>{"Alt+Tab", "Ctrl+V"}));
+        EXPECT_EQ(browser[1].combos, (std::vector<std::string>{"Ctrl+T", "Ctrl+W"}));
+        EXPECT_EQ(browser[1].pressCount, 1);
+
+        EXPECT_EQ(db.getTopSequences(2).size(), 2u);
+        EXPECT_TRUE(db.getTopSequences(10, "unknownApp").empty());
+        db.clearStatistics();
+        EXPECT_TRUE(db.getTopSequences().empty());
+    }
+    std::remove(path.c_str());
+    std::remove((path + "-wal").c_str());
+    std::remove((path + "-shm").c_str());
+}
+
+// Test case for the weekly heatmap following the configured time zone
+TEST_F(DatabaseTest, UsageHeatmapByHourOfWeek) {
+    // 2024-01-01 - понедельник; 22:30 и 23:30 UTC
+    const sqlite3_int64 monday = 1704067200000LL;
+    db.setHeatmapUtcOffset(std::chrono::minutes(0));
+    db.updateKeyStatistics("heatApp", "Ctrl+S", monday + 22 * 3600000 + 1800000);
+    db.updateKeyStatistics("heatApp", "Ctrl+S", monday + 23 * 3600000 + 1800000);
+
+    // В UTC+2 те же моменты - уже вторник, 0:30 и 1:30
+    db.setHeatmapUtcOffset(std::chrono::minutes(120));
+    db.updateKeyStatistics("heatApp", "Ctrl+S", monday + 22 * 3600000 + 1800000);
+    db.updateKeyStatistics("heatApp", "Ctrl+Z", monday + 23 * 3600000 + 1800000);
+    db.updateKeyStatistics("otherApp", "Ctrl+Z", monday + 23 * 3600000 + 1800000);
+    ASSERT_TRUE(db.flush());
+
+    UsageHeatmap app = db.getUsageHeatmap("heatApp");
+    EXPECT_EQ(app.at(0, 22), 1);
+    EXPECT_EQ(app.at(0, 23), 1);
+    EXPECT_EQ(app.at(1, 0), 1);
+    EXPECT_EQ(app.at(1, 1), 1);
+    EXPECT_EQ(app.total(), 4);
+
+    EXPECT_EQ(db.getUsageHeatmap("heatApp", "Ctrl+S").total(), 3);
+    EXPECT_EQ(db.getUsageHeatmap("", "Ctrl+Z").at(1, 1), 2);
+    EXPECT_EQ(db.getUsageHeatmap().total(), 5);
+    EXPECT_EQ(db.getUsageHeatmap("missingApp").total(), 0);
+
+    ASSERT_TRUE(db.clearStatistics());
+    EXPECT_EQ(db.getUsageHeatmap().total(), 0);
+}
+
+// Test case for the v8 heatmap seed taking each span from the finest retained level
+TEST(DatabaseHeatmapTest, SeedUsesFinestRetainedLevelAndOffset) {
+    const std::string path = "hoka_heatmap_seed_test.db";
+    std::remove(path.c_str());
+    // 2024-01-01 - понедельник
+    const sqlite3_int64 monday = 1704067200000LL;
+    const sqlite3_int64 minute = 60000;
+    const sqlite3_int64 hour = 3600000;
+    {
+        Database db;
+        ASSERT_TRUE(db.initialize(path));
+        db.updateKeyStatistics("editor", "Ctrl+S", monday + 10 * hour + 10 * minute);
+        db.updateKeyStatistics("editor", "Ctrl+S", monday + 13 * hour);
+        db.updateKeyStatistics("editor", "Ctrl+S", monday + 13 * hour + 50 * minute);
+        db.updateKeyStatistics("editor", "Ctrl+S", monday + 14 * hour + 40 * minute);
+        ASSERT_TRUE(db.flush());
+    }
+    {
+        // База до v8 после сжатия: журнал с 14:00, минутные свертки с 13:00
+        Connection connection;
+        ASSERT_TRUE(connection.open(path, SQLITE_OPEN_READWRITE));
+        std::string script =
+            "DELETE FROM key_events WHERE ts < " + std::to_string(monday + 14 * hour) + ";"
+            "DELETE FROM rollup_minute WHERE bucket < " + std::to_string(monday + 13 * hour) + ";"
+            "DROP TABLE heatmap;"
+            "DROP TABLE merge_rollups;"
+            "DROP TABLE merge_heatmap;"
+            "ALTER TABLE merge_sources DROP COLUMN clear_epoch;"
+            "PRAGMA user_version = 7;";
+        ASSERT_TRUE(connection.executeScript(script.c_str()));
+    }
+
+    {
+        Database db;
+        db.setHeatmapUtcOffset(std::chrono::minutes(5 * 60 + 30));
+        ASSERT_TRUE(db.initialize(path));
+        UsageHeatmap seeded = db.getUsageHeatmap();
+        // 10:10 UTC - только в часовой свертке 10:00-11:00, то есть 15:30-16:30
+        // местного; середина свертки - 16 часов
+        EXPECT_EQ(seeded.at(0, 16), 1);
+        // 13:00 и 13:50 UTC - из минутных сверток: 18:30 и 19:20 местного
+        EXPECT_EQ(seeded.at(0, 18), 1);
+        EXPECT_EQ(seeded.at(0, 19), 1);
+        // 14:40 UTC - из журнала: 20:10 местного
+        EXPECT_EQ(seeded.at(0, 20), 1);
+        EXPECT_EQ(seeded.total(), 4);
+
+        // Новые нажатия ложатся в тот же пояс
+        db.updateKeyStatistics("editor", "Ctrl+S", monday + 15 * hour + 5 * minute);
+        ASSERT_TRUE(db.flush());
+        EXPECT_EQ(db.getUsageHeatmap().at(0, 20), 2);
+    }
+    std::remove(path.c_str());
+    std::remove((path + "-wal").c_str());
+    std::remove((path + "-shm").c_str());
+}
+
+// Test case for in-memory databases not sharing data
+TEST(DatabaseSnapshotTest, InMemoryDatabasesAreIsolated) {
+    Database first;
+    Database second;
+    ASSERT_TRUE(first.initialize(Database::kInMemory));
+    ASSERT_TRUE(second.initialize(Database::kInMemory));
+
+    first.updateKeyStatistics("memoryApp", "Ctrl+S");
+    ASSERT_TRUE(first.flush());
+
+    EXPECT_EQ(first.getAllApps().size(), 1u);
+    EXPECT_TRUE(second.getAllApps().empty());
+}
+
+// Test case for snapshots of an in-memory database surviving a restart
+TEST(DatabaseSnapshotTest, RestoresInMemoryDatabaseFromSnapshot) {
+    const std::string snapshotPath = "hoka_snapshot_test.db";
+    std::remove(snapshotPath.c_str());
+
+    std::vector<std::uint64_t> confirmed;
+    {
+        Database db;
+        db.setSnapshotPolicy(snapshotPath, std::chrono::hours(1));
+        ASSERT_TRUE(db.initialize(Database::kInMemory));
+        db.setJournalCommitCallback([&](std::uint64_t sequence) { confirmed.push_back(sequence); });
+
+        db.updateKeyStatistics("snapshotApp", "Ctrl+S", 1000, 1);
+        ASSERT_TRUE(db.flush());
+        // В БД, но еще не на диске: журнал держит запись до снимка
+        EXPECT_TRUE(confirmed.empty());
+        ASSERT_TRUE(db.snapshotNow());
+        EXPECT_EQ(confirmed, std::vector<std::uint64_t>{1});
+
+        // Попадет на диск снимком при закрытии
+        db.updateKeyStatistics("snapshotApp", "Ctrl+S", 2000, 2);
+    }
+    EXPECT_EQ(confirmed.back(), 2u);
+
+    {
+        Database restored;
+        restored.setSnapshotPolicy(snapshotPath, std::chrono::hours(1));
+        ASSERT_TRUE(restored.initialize(Database::kInMemory));
+        EXPECT_EQ(totalPresses(allCombos(restored, "snapshotApp")), 2);
+        EXPECT_EQ(restored.getCommittedJournalSequence(), 2u);
+
+        restored.updateKeyStatistics("snapshotApp", "Ctrl+C", 3000);
+        ASSERT_TRUE(restored.flush());
+        EXPECT_EQ(restored.countPresses(0, 10000, "snapshotApp"), 3);
+    }
+    std::remove(snapshotPath.c_str());
+}
+
+// Test case for prepared statement reuse and typed binding
+TEST(StatementCacheTest, ReusesStatementsAndResetsBindings) {
+    sqlite3* conn = nullptr;
+    ASSERT_EQ(sqlite3_open(":memory:", &conn), SQLITE_OK);
+
+    {
+        StatementCache cache;
+        cache.attach(conn);
+
+        const char* sql = "SELECT ?1 || ':' || ?2, ?3 * 2;";
+        sqlite3_stmt* first = cache.acquire(sql);
+        ASSERT_NE(first, nullptr);
+
+        for (int i = 0; i < 3; ++i) {
+            sqlite3_stmt* stmt = cache.acquire(std::string(sql).c_str());
+            EXPECT_EQ(stmt, first) << "Same SQL text must hit the cache";
+            StatementGuard guard(stmt);
+
+            std::string app = "app" + std::to_string(i);
+            ASSERT_TRUE(bindParameters(stmt, app, std::string_view("Ctrl+S"), sqlite3_int64(i)));
+            ASSERT_EQ(sqlite3_step(stmt), SQLITE_ROW);
+
+            std::string text;
+            sqlite3_int64 doubled = -1;
+            auto onRow = [&](const std::string& value, sqlite3_int64 number) {
+                text = value;
+                doubled = number;
+            };
+            invokeRowHandler<std::string, sqlite3_int64>(stmt, onRow,
+                std::index_sequence_for<std::string, sqlite3_int64>{});
+            EXPECT_EQ(text, app + ":Ctrl+S");
+            EXPECT_EQ(doubled, i * 2);
+        }
+        EXPECT_EQ(cache.size(), 1u);
+    }
+
+    sqlite3_close(conn);
+}
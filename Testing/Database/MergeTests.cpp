@@ -0,0 +1,203 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include "Database/Database.h"
+
+namespace {
+
+void removeDatabaseFiles(const std::string& path) {
+    std::remove(path.c_str());
+    std::remove((path + "-wal").c_str());
+    std::remove((path + "-shm").c_str());
+}
+
+std::int64_t lifetimeCount(Database& db, const std::string& app, const std::string& combo) {
+    ComboStatsQuery query;
+    query.appName = app;
+    query.pageSize = 0;
+    for (const auto& row : db.queryComboStats(query).rows) {
+        if (row.keyCombination == combo) {
+            return row.pressCount;
+        }
+    }
+    return 0;
+}
+
+} // namespace
+
+// Test fixture with a target database and two source "machines"
+class DatabaseMergeTest : public ::testing::Test {
+protected:
+    const std::string targetPath = "merge_target_test.db";
+    const std::string sourcePathA = "merge_source_a_test.db";
+    const std::string sourcePathB = "merge_source_b_test.db";
+
+    void SetUp() override {
+        removeDatabaseFiles(targetPath);
+        removeDatabaseFiles(sourcePathA);
+        removeDatabaseFiles(sourcePathB);
+    }
+
+    void TearDown() override {
+        removeDatabaseFiles(targetPath);
+        removeDatabaseFiles(sourcePathA);
+        removeDatabaseFiles(sourcePathB);
+    }
+};
+
+// Test case for folding counts, events and rollups from several sources
+TEST_F(DatabaseMergeTest, MergesCountsAndTimeSeries) {
+    {
+        Database source;
+        ASSERT_TRUE(source.initialize(sourcePathA));
+        source.updateKeyStatistics("editor", "Ctrl+S", 1000);
+        source.updateKeyStatistics("editor", "Ctrl+S", 61000);
+        source.updateKeyStatistics("browser", "Ctrl+T", 2000);
+    }
+    {
+        Database source;
+        ASSERT_TRUE(source.initialize(sourcePathB));
+        source.updateKeyStatistics("editor", "Ctrl+S", 3000);
+    }
+
+    Database target;
+    ASSERT_TRUE(target.initialize(targetPath));
+    target.setHeatmapUtcOffset(std::chrono::minutes(0));
+    target.updateKeyStatistics("editor", "Ctrl+S", 4000);
+
+    MergeResult result = target.mergeDatabases({sourcePathA, sourcePathB});
+    ASSERT_TRUE(result.success);
+    EXPECT_EQ(result.sourcesMerged, 2);
+    EXPECT_EQ(result.pressesAdded, 4);
+    EXPECT_EQ(result.eventsAdded, 4);
+
+    EXPECT_EQ(lifetimeCount(target, "editor", "Ctrl+S"), 4);
+    EXPECT_EQ(lifetimeCount(target, "browser", "Ctrl+T"), 1);
+    EXPECT_EQ(target.countPresses(0, 86400000), 5);
+    EXPECT_EQ(target.countPresses(60000, 120000, "editor"), 1);
+    // 1970-01-01 - четверг, все нажатия в первый час
+    EXPECT_EQ(target.getUsageHeatmap("editor").at(3, 0), 4);
+    EXPECT_EQ(target.getUsageHeatmap().total(), 5);
+}
+
+// Test case for idempotent re-merge and incremental pickup
+TEST_F(DatabaseMergeTest, RemergeAddsOnlyNewData) {
+    Database source;
+    ASSERT_TRUE(source.initialize(sourcePathA));
+    source.updateKeyStatistics("editor", "Ctrl+S", 1000);
+    ASSERT_TRUE(source.flush());
+
+    Database target;
+    ASSERT_TRUE(target.initialize(targetPath));
+    ASSERT_TRUE(target.mergeDatabase(sourcePathA).success);
+
+    MergeResult again = target.mergeDatabase(sourcePathA);
+    ASSERT_TRUE(again.success);
+    EXPECT_EQ(again.pressesAdded, 0);
+    EXPECT_EQ(again.eventsAdded, 0);
+    EXPECT_EQ(lifetimeCount(target, "editor", "Ctrl+S"), 1);
+
+    source.updateKeyStatistics("editor", "Ctrl+S", 2000);
+    source.updateKeyStatistics("editor", "Ctrl+Z", 3000);
+    ASSERT_TRUE(source.flush());
+
+    MergeResult delta = target.mergeDatabase(sourcePathA);
+    ASSERT_TRUE(delta.success);
+    EXPECT_EQ(delta.pressesAdded, 2);
+    EXPECT_EQ(delta.eventsAdded, 2);
+    EXPECT_EQ(lifetimeCount(target, "editor", "Ctrl+S"), 2);
+    EXPECT_EQ(lifetimeCount(target, "editor", "Ctrl+Z"), 1);
+    EXPECT_EQ(target.countPresses(0, 86400000), 3);
+}
+
+// Test case for rejecting missing files and the database itself
+TEST_F(DatabaseMergeTest, RejectsMissingSourceAndSelf) {
+    Database target;
+    ASSERT_TRUE(target.initialize(targetPath));
+    EXPECT_FALSE(target.mergeDatabase("merge_missing_test.db").success);
+    EXPECT_FALSE(target.mergeDatabase(targetPath).success);
+}
+
+// Test case for a source cleared and regrown past the merged watermark
+TEST_F(DatabaseMergeTest, RemergeAfterSourceClearAndRegrowth) {
+    Database source;
+    ASSERT_TRUE(source.initialize(sourcePathA));
+    for (int i = 0; i < 3; ++i) {
+        source.updateKeyStatistics("editor", "Ctrl+S", 1000 + i);
+    }
+    ASSERT_TRUE(source.flush());
+
+    Database target;
+    ASSERT_TRUE(target.initialize(targetPath));
+    ASSERT_TRUE(target.mergeDatabase(sourcePathA).success);
+
+    // Очистка без новых нажатий ничего не добавляет и не повторяет
+    ASSERT_TRUE(source.clearStatistics());
+    MergeResult empty = target.mergeDatabase(sourcePathA);
+    ASSERT_TRUE(empty.success);
+    EXPECT_EQ(empty.pressesAdded, 0);
+    EXPECT_EQ(empty.eventsAdded, 0);
+
+    // Журнал и счетчик источника снова выросли дальше прежней отметки
+    for (int i = 0; i < 5; ++i) {
+        source.updateKeyStatistics("editor", "Ctrl+S", 5000 + i);
+    }
+    ASSERT_TRUE(source.flush());
+
+    MergeResult regrown = target.mergeDatabase(sourcePathA);
+    ASSERT_TRUE(regrown.success);
+    EXPECT_EQ(regrown.pressesAdded, 5);
+    EXPECT_EQ(regrown.eventsAdded, 5);
+    EXPECT_EQ(lifetimeCount(target, "editor", "Ctrl+S"), 8);
+    EXPECT_EQ(target.countPresses(5000, 6000), 5);
+    EXPECT_EQ(target.countPresses(0, 86400000), 8);
+
+    MergeResult again = target.mergeDatabase(sourcePathA);
+    ASSERT_TRUE(again.success);
+    EXPECT_EQ(again.pressesAdded, 0);
+    EXPECT_EQ(again.eventsAdded, 0);
+}
+
+// Test case for history the source keeps only in rollups
+TEST_F(DatabaseMergeTest, MergesRollupsBeyondRawRetention) {
+    sqlite3_int64 day = 86400000;
+    sqlite3_int64 now = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    // Середина суток 40 дней назад: старше журнала, но в минутных свертках;
+    // без журнала диапазон отвечается только целыми минутами
+    sqlite3_int64 old = (now / day - 40) * day + day / 2;
+
+    Database source;
+    ASSERT_TRUE(source.initialize(sourcePathA));
+    for (int i = 0; i < 50; ++i) {
+        source.updateKeyStatistics("editor", "Ctrl+S", old + i);
+    }
+    source.updateKeyStatistics("editor", "Ctrl+S", now);
+    ASSERT_TRUE(source.flush());
+    source.setRetentionPolicy(RetentionPolicy{});
+    ASSERT_TRUE(source.compactNow());
+    ASSERT_EQ(source.countPresses(old, old + 60000), 50);
+
+    Database target;
+    ASSERT_TRUE(target.initialize(targetPath));
+    MergeResult result = target.mergeDatabase(sourcePathA);
+    ASSERT_TRUE(result.success);
+    EXPECT_EQ(result.pressesAdded, 51);
+    EXPECT_EQ(result.eventsAdded, 1);
+    EXPECT_EQ(target.countPresses(old, old + 60000), 50);
+    EXPECT_EQ(target.countPresses(old - day / 2, old + day / 2), 50);
+    EXPECT_EQ(target.countPresses(now, now + 1), 1);
+    EXPECT_EQ(target.getUsageHeatmap().total(), 51);
+
+    // Повторное слияние свертки и карту не удваивает, прирост доливается
+    source.updateKeyStatistics("editor", "Ctrl+S", now + 1);
+    ASSERT_TRUE(source.flush());
+    MergeResult again = target.mergeDatabase(sourcePathA);
+    ASSERT_TRUE(again.success);
+    EXPECT_EQ(again.pressesAdded, 1);
+    EXPECT_EQ(again.eventsAdded, 1);
+    EXPECT_EQ(target.countPresses(old - day / 2, old + day / 2), 50);
+    EXPECT_EQ(target.countPresses(now, now + 2), 2);
+    EXPECT_EQ(target.getUsageHeatmap().total(), 52);
+}
@@ -0,0 +1,118 @@
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+#include "Database/PagedHistory.h"
+
+// Test fixture for the paged history view
+class PagedHistoryTest : public ::testing::Test {
+protected:
+    Database db;
+
+    // 1000 нажатий: editor и browser по очереди, с шагом 10 мс; каждое
+    // десятое - Ctrl+S, остальные - Ctrl+C
+    void SetUp() override {
+        ASSERT_TRUE(db.initialize(Database::kInMemory));
+        for (int i = 0; i < 1000; ++i) {
+            db.updateKeyStatistics(i % 2 == 0 ? "editor" : "browser",
+                                   i % 10 == 0 ? "Ctrl+S" : "Ctrl+C", 1000 + i * 10);
+        }
+        ASSERT_TRUE(db.flush());
+    }
+
+    static std::vector<HistoryEvent> collect(PagedHistory history) {
+        std::vector<HistoryEvent> events;
+        history.forEach([&](const HistoryEvent& event) { events.push_back(event); });
+        EXPECT_FALSE(history.hasFailed());
+        return events;
+    }
+};
+
+// Test case for pages following each other in time order without gaps
+TEST_F(PagedHistoryTest, StreamsAllPagesInTimeOrder) {
+    HistoryView view(db, 64);
+    PagedHistory history = view.findPresses("");
+    std::int64_t expected = 1000;
+    size_t count = history.forEach([&](const HistoryEvent& event) {
+        EXPECT_EQ(event.timestamp, expected);
+        expected += 10;
+    });
+    EXPECT_EQ(count, 1000u);
+    // 1000 / 64 - 16 страниц, без пустой в конце
+    EXPECT_EQ(history.getPagesRead(), 16u);
+    EXPECT_EQ(history.next(), nullptr);
+}
+
+// Test case for the same searches as KeyStatistics
+TEST_F(PagedHistoryTest, FindsByAppKeyAndTimeRange) {
+    HistoryView view(db, 37);
+
+    auto editor = collect(view.findPressesByApp("editor"));
+    ASSERT_EQ(editor.size(), 500u);
+    for (const auto& event : editor) {
+        EXPECT_EQ(event.appName, "editor");
+    }
+
+    auto saves = collect(view.findPressesByKey("Ctrl+S"));
+    ASSERT_EQ(saves.size(), 100u);
+    EXPECT_EQ(saves.front().keyCombination, "Ctrl+S");
+    EXPECT_EQ(saves.front().appName, "editor");
+
+    // [2000, 3000): нажатия 100..199
+    auto range = collect(view.findPresses("", "", 2000, 3000));
+    ASSERT_EQ(range.size(), 100u);
+    EXPECT_EQ(range.front().timestamp, 2000);
+    EXPECT_EQ(range.back().timestamp, 2990);
+
+    EXPECT_EQ(collect(view.findPresses("browser", "Ctrl+S")).size(), 0u);
+    EXPECT_EQ(collect(view.findPresses("editor", "Ctrl+S", 1000, 1100)).size(), 1u);
+    EXPECT_TRUE(collect(view.findPressesByApp("")).empty());
+    EXPECT_TRUE(collect(view.findPressesByApp("unknown")).empty());
+
+    auto timeRange = view.getTimeRange();
+    EXPECT_EQ(timeRange.first, 1000);
+    EXPECT_EQ(timeRange.second, 10990);
+}
+
+// Test case for read-ahead and synchronous reads returning the same events
+TEST_F(PagedHistoryTest, ReadAheadMatchesSynchronousReads) {
+    auto prefetched = collect(HistoryView(db, 50, true).findPressesByApp("browser"));
+    auto synchronous = collect(HistoryView(db, 50, false).findPressesByApp("browser"));
+    ASSERT_EQ(prefetched.size(), synchronous.size());
+    for (size_t i = 0; i < prefetched.size(); ++i) {
+        EXPECT_EQ(prefetched[i].eventId, synchronous[i].eventId);
+    }
+}
+
+// Test case for presses written during a pass staying out of it
+TEST_F(PagedHistoryTest, PassSeesSnapshotBoundary) {
+    PagedHistory history = HistoryView(db, 100).findPresses("");
+    ASSERT_NE(history.next(), nullptr);
+
+    // Новое нажатие раньше всех остальных по времени
+    db.updateKeyStatistics("editor", "Ctrl+Z", 500);
+    ASSERT_TRUE(db.flush());
+
+    size_t rest = history.forEach([](const HistoryEvent& event) {
+        EXPECT_NE(event.keyCombination, "Ctrl+Z");
+    });
+    EXPECT_EQ(rest, 999u);
+}
+
+// Test case for pages staying within the requested size
+TEST_F(PagedHistoryTest, PagesAreBounded) {
+    HistoryQuery query;
+    query.pageSize = 128;
+    HistoryPage page;
+    size_t total = 0;
+    size_t pages = 0;
+    do {
+        ASSERT_TRUE(db.readHistoryPage(query, page));
+        EXPECT_LE(page.rows.size(), 128u);
+        total += page.rows.size();
+        ++pages;
+        query.after = page.next;
+        query.lastEventId = page.lastEventId;
+    } while (page.next);
+    EXPECT_EQ(total, 1000u);
+    EXPECT_EQ(pages, 8u);
+}
@@ -0,0 +1,142 @@
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include "Database/Database.h"
+#include "Export/StatisticsExporter.h"
+
+namespace {
+
+std::string readFile(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    std::stringstream ss;
+    ss << file.rdbuf();
+    return ss.str();
+}
+
+size_t countLines(const std::string& text) {
+    size_t lines = 0;
+    for (char c : text) {
+        lines += c == '\n';
+    }
+    return lines;
+}
+
+} // namespace
+
+// Test fixture for streaming export
+class StatisticsExporterTest : public ::testing::Test {
+protected:
+    Database db;
+    const std::string exportPath = "hoka_export_test.out";
+
+    void SetUp() override {
+        ASSERT_TRUE(db.initialize(Database::kInMemory)) << "Failed to initialize database";
+        db.clearStatistics();
+    }
+
+    void TearDown() override {
+        db.clearStatistics();
+        std::remove(exportPath.c_str());
+    }
+};
+
+// Test case for the text report layout matching the window formatter
+TEST_F(StatisticsExporterTest, TextTotalsGroupedByApp) {
+    db.updateKeyStatistics("appB", "Ctrl+S", 1000);
+    db.updateKeyStatistics("appA", "Ctrl+C", 1000);
+    db.updateKeyStatistics("appA", "Ctrl+C", 2000);
+    db.updateKeyStatistics("appA", "Ctrl+V", 3000);
+
+    StatisticsExporter exporter(db);
+    auto result = exporter.exportToFile(exportPath, {});
+    ASSERT_TRUE(result.success);
+    EXPECT_EQ(result.records, 3u);
+
+    std::string text = readFile(exportPath);
+    EXPECT_EQ(result.bytes, text.size());
+    size_t appA = text.find("Statistics for appA:");
+    size_t appB = text.find("Statistics for appB:");
+    ASSERT_NE(appA, std::string::npos) << text;
+    ASSERT_NE(appB, std::string::npos) << text;
+    EXPECT_LT(appA, appB);
+    EXPECT_NE(text.find(" 1. Ctrl+C                        2 times"), std::string::npos) << text;
+    EXPECT_NE(text.find("Total key presses: 3"), std::string::npos) << text;
+}
+
+// Test case for CSV quoting and the app filter
+TEST_F(StatisticsExporterTest, CsvEscapesFieldsAndFiltersApp) {
+    db.updateKeyStatistics("my \"app\"", "Ctrl+,", 5000);
+    db.updateKeyStatistics("other", "Ctrl+S", 5000);
+
+    ExportOptions options;
+    options.format = ExportFormat::Csv;
+    options.filter.appName = "my \"app\"";
+
+    StatisticsExporter exporter(db);
+    ASSERT_TRUE(exporter.exportToFile(exportPath, options).success);
+    EXPECT_EQ(readFile(exportPath),
+              "app,combo,press_count,last_pressed\n"
+              "\"my \"\"app\"\"\",\"Ctrl+,\",1,5000\n");
+}
+
+// Test case for JSON Lines events limited to a time range
+TEST_F(StatisticsExporterTest, JsonLinesEventsInRange) {
+    db.updateKeyStatistics("testApp", "Ctrl+S", 1000);
+    db.updateKeyStatistics("testApp", "Ctrl+S", 2000);
+    db.updateKeyStatistics("testApp", "Ctrl+C", 3000);
+
+    ExportOptions options;
+    options.format = ExportFormat::JsonLines;
+    options.filter.content = ExportContent::Events;
+    options.filter.fromMs = 1500;
+    options.filter.toMs = 3500;
+
+    StatisticsExporter exporter(db);
+    ASSERT_TRUE(exporter.exportToFile(exportPath, options).success);
+    EXPECT_EQ(readFile(exportPath),
+              "{\"timestamp\":2000,\"app\":\"testApp\",\"combo\":\"Ctrl+S\"}\n"
+              "{\"timestamp\":3000,\"app\":\"testApp\",\"combo\":\"Ctrl+C\"}\n");
+}
+
+// Test case for incremental export with a named watermark
+TEST_F(StatisticsExporterTest, WatermarkExportsOnlyNewPresses) {
+    ExportOptions options;
+    options.format = ExportFormat::Csv;
+    options.filter.content = ExportContent::Events;
+    options.watermark = "test";
+
+    for (int i = 0; i < 10; ++i) {
+        db.updateKeyStatistics("testApp", "Ctrl+S", 1000 + i);
+    }
+
+    StatisticsExporter exporter(db);
+    auto first = exporter.exportToFile(exportPath, options);
+    ASSERT_TRUE(first.success);
+    EXPECT_EQ(first.records, 10u);
+
+    auto empty = exporter.exportToFile(exportPath, options);
+    ASSERT_TRUE(empty.success);
+    EXPECT_EQ(empty.records, 0u);
+    EXPECT_EQ(countLines(readFile(exportPath)), 1u) << "Only the header expected";
+
+    db.updateKeyStatistics("testApp", "Ctrl+C", 5000);
+    db.updateKeyStatistics("testApp", "Ctrl+C", 6000);
+
+    // Итоги с отметкой считаются только по новым нажатиям
+    ExportOptions totals = options;
+    totals.filter.content = ExportContent::Totals;
+    totals.watermark = "totals";
+    db.setExportWatermark("totals", db.getExportWatermark("test"));
+
+    auto delta = exporter.exportToFile(exportPath, totals);
+    ASSERT_TRUE(delta.success);
+    EXPECT_EQ(readFile(exportPath),
+              "app,combo,press_count,last_pressed\n"
+              "testApp,Ctrl+C,2,6000\n");
+
+    auto second = exporter.exportToFile(exportPath, options);
+    ASSERT_TRUE(second.success);
+    EXPECT_EQ(second.records, 2u);
+}
@@ -0,0 +1,192 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include <set>
+#include <string>
+#include <vector>
+#include "Insights/RemapOptimizer.h"
+
+namespace {
+
+// Итоговое размещение: исходные комбинации плюс рекомендации
+std::set<std::string> finalLayout(const RemapProblem& problem, const RemapPlan& plan) {
+    std::set<std::string> layout;
+    for (const auto& shortcut : problem.shortcuts) {
+        layout.insert(shortcut.combination);
+    }
+    for (const auto& suggestion : plan.suggestions) {
+        layout.erase(suggestion.from);
+    }
+    for (const auto& suggestion : plan.suggestions) {
+        layout.insert(suggestion.to);
+    }
+    return layout;
+}
+
+// Много команд на неудобных аккордах: нагрузка убывает с номером
+RemapProblem wideProblem(size_t count) {
+    auto chords = ErgonomicModel().candidateChords(
+        {ModifierCtrl | ModifierAlt | ModifierShift, ModifierCtrl | ModifierAlt | ModifierWin,
+         ModifierAlt | ModifierShift | ModifierWin, ModifierCtrl | ModifierShift | ModifierWin,
+         ModifierAlt | ModifierWin, ModifierCtrl | ModifierWin, ModifierShift | ModifierWin});
+    RemapProblem problem;
+    problem.appName = "editor";
+    for (size_t i = 0; i < count && i < chords.size(); ++i) {
+        problem.shortcuts.push_back(
+            {formatChord(chords[i]), static_cast<std::int64_t>(100000 / (i + 1))});
+    }
+    // Цепочки соседних команд
+    for (size_t i = 0; i + 1 < problem.shortcuts.size(); i += 2) {
+        problem.transitions.push_back({i, i + 1, problem.shortcuts[i + 1].pressCount / 2});
+    }
+    return problem;
+}
+
+} // namespace
+
+// Test case for parsing combinations in the KeyLogger format
+TEST(ErgonomicModelTest, ParsesAndFormatsChords) {
+    Chord chord = parseChord("Ctrl+Shift+S");
+    EXPECT_EQ(chord.modifiers, ModifierCtrl | ModifierShift);
+    EXPECT_EQ(chord.key, "S");
+    EXPECT_EQ(formatChord(chord), "Ctrl+Shift+S");
+
+    Chord plus = parseChord("Ctrl++");
+    EXPECT_EQ(plus.modifiers, ModifierCtrl);
+    EXPECT_EQ(plus.key, "+");
+    EXPECT_EQ(parseChord("Alt").key, "Alt");
+    EXPECT_EQ(formatChord(parseChord("Alt+Shift+Ctrl+F5")), "Ctrl+Shift+Alt+F5");
+    EXPECT_EQ(formatChord({ModifierWin | ModifierCtrl, "D"}), "Ctrl+Win+D");
+}
+
+// Test case for the cost model ranking home-row chords above stretched ones
+TEST(ErgonomicModelTest, HomeRowChordsAreCheaper) {
+    ErgonomicModel model;
+    auto cost = [&](const std::string& combination) {
+        return model.chordCost(*model.locate(parseChord(combination)));
+    };
+    EXPECT_LT(cost("Ctrl+F"), cost("Ctrl+T"));
+    EXPECT_LT(cost("Ctrl+J"), cost("Ctrl+F12"));
+    EXPECT_LT(cost("Ctrl+F"), cost("Ctrl+Alt+Shift+F"));
+    // Мизинец уже держит Ctrl
+    EXPECT_LT(cost("Ctrl+S"), cost("Ctrl+A"));
+    EXPECT_FALSE(model.locate(parseChord("Ctrl+MediaPlay")).has_value());
+
+    auto transition = [&](const std::string& from, const std::string& to) {
+        return model.transitionCost(*model.locate(parseChord(from)), *model.locate(parseChord(to)));
+    };
+    EXPECT_EQ(transition("Ctrl+K", "Ctrl+K"), 0);
+    EXPECT_GT(transition("Ctrl+R", "Ctrl+F"), transition("Ctrl+J", "Ctrl+F"));
+}
+
+// Test case for a heavy shortcut moving to a cheaper free chord
+TEST(RemapOptimizerTest, MovesHeavyShortcutToCheaperChord) {
+    RemapProblem problem;
+    problem.shortcuts = {{"Ctrl+Alt+Shift+F12", 5000}, {"Ctrl+S", 3000}, {"Alt+Tab", 9000},
+                         {"Ctrl+Shift+P", 2}, {"K", 100000}};
+    RemapOptions options;
+    options.threads = 2;
+    options.seed = 7;
+
+    RemapPlan plan = RemapOptimizer().optimize(problem, options);
+    EXPECT_FALSE(plan.cancelled);
+    EXPECT_EQ(plan.threads, 2u);
+    EXPECT_GT(plan.iterations, 0u);
+    EXPECT_LT(plan.optimizedCost, plan.currentCost);
+    ASSERT_FALSE(plan.suggestions.empty());
+    EXPECT_EQ(plan.suggestions[0].from, "Ctrl+Alt+Shift+F12");
+    EXPECT_GT(plan.suggestions[0].saving, 0);
+
+    for (const auto& suggestion : plan.suggestions) {
+        // Системные комбинации и набор текста не трогаются
+        EXPECT_NE(suggestion.from, "Alt+Tab");
+        EXPECT_NE(suggestion.from, "K");
+        EXPECT_NE(suggestion.to, "Alt+F4");
+    }
+    EXPECT_EQ(finalLayout(problem, plan).size(), problem.shortcuts.size());
+}
+
+// Test case for the change penalty keeping the current layout
+TEST(RemapOptimizerTest, LargeChangePenaltyKeepsLayout) {
+    RemapProblem problem;
+    problem.shortcuts = {{"Ctrl+Alt+Shift+F12", 5000}, {"Ctrl+S", 3000}};
+    RemapOptions options;
+    options.threads = 1;
+    options.changePenalty = 100;
+
+    RemapPlan plan = RemapOptimizer().optimize(problem, options);
+    EXPECT_TRUE(plan.suggestions.empty());
+    EXPECT_DOUBLE_EQ(plan.optimizedCost, plan.currentCost);
+}
+
+// Test case for shortcuts pressed in a row staying off the same finger
+TEST(RemapOptimizerTest, TransitionsSeparateFingers) {
+    RemapProblem problem;
+    // Ctrl+F и Ctrl+R - один палец; переход между ними частый
+    problem.shortcuts = {{"Ctrl+F", 1000}, {"Ctrl+R", 1000}};
+    problem.transitions = {{0, 1, 50000}, {1, 0, 50000}};
+    RemapOptions options;
+    options.threads = 2;
+    options.changePenalty = 0;
+
+    RemapPlan plan = RemapOptimizer().optimize(problem, options);
+    ErgonomicModel model;
+    auto layout = finalLayout(problem, plan);
+    ASSERT_EQ(layout.size(), 2u);
+    auto first = *model.locate(parseChord(*layout.begin()));
+    auto second = *model.locate(parseChord(*layout.rbegin()));
+    EXPECT_NE(first.key.finger, second.key.finger);
+    EXPECT_LT(plan.optimizedCost, plan.currentCost);
+}
+
+// Test case for hundreds of shortcuts finishing on all cores within the budget
+TEST(RemapOptimizerTest, HundredsOfShortcutsInParallel) {
+    RemapProblem problem = wideProblem(300);
+    RemapOptions options;
+    options.timeBudget = std::chrono::seconds(20);
+    options.maxSuggestions = 1000;
+
+    auto start = std::chrono::steady_clock::now();
+    RemapPlan plan = RemapOptimizer().optimize(problem, options);
+    auto elapsed = std::chrono::steady_clock::now() - start;
+
+    EXPECT_LT(elapsed, std::chrono::seconds(20));
+    EXPECT_GE(plan.threads, 1u);
+    EXPECT_LT(plan.optimizedCost, plan.currentCost * 0.9);
+    // Ни одна комбинация не досталась двум командам
+    EXPECT_EQ(finalLayout(problem, plan).size(), 300u);
+}
+
+// Test case for cancellation returning promptly without a worse plan
+TEST(RemapOptimizerTest, CancelledSearchStopsEarly) {
+    RemapProblem problem = wideProblem(80);
+    CancellationToken token;
+    token.cancel();
+    RemapOptions options;
+    options.iterationsPerThread = 100000000;
+
+    RemapPlan plan = RemapOptimizer().optimize(problem, options, token);
+    EXPECT_TRUE(plan.cancelled);
+    EXPECT_LE(plan.optimizedCost, plan.currentCost);
+    EXPECT_LT(plan.iterations, 1000000u);
+}
+
+// Test case for loading counts and transitions from the database
+TEST(RemapOptimizerTest, LoadsProblemFromDatabase) {
+    Database db;
+    ASSERT_TRUE(db.initialize(Database::kInMemory));
+    db.setSequenceTimeout(std::chrono::milliseconds(1000));
+    for (std::int64_t i = 0; i < 3; ++i) {
+        db.updateKeyStatistics("editor", "Ctrl+K", 10000 * (i + 1));
+        db.updateKeyStatistics("editor", "Ctrl+C", 10000 * (i + 1) + 100);
+    }
+    db.updateKeyStatistics("browser", "Ctrl+T", 50000);
+
+    RemapProblem problem = RemapOptimizer::loadProblem(db, "editor");
+    EXPECT_EQ(problem.appName, "editor");
+    ASSERT_EQ(problem.shortcuts.size(), 2u);
+    EXPECT_EQ(problem.shortcuts[0].pressCount, 3);
+    ASSERT_EQ(problem.transitions.size(), 1u);
+    EXPECT_EQ(problem.shortcuts[problem.transitions[0].from].combination, "Ctrl+K");
+    EXPECT_EQ(problem.shortcuts[problem.transitions[0].to].combination, "Ctrl+C");
+    EXPECT_EQ(problem.transitions[0].count, 3);
+}
@@ -0,0 +1,114 @@
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+#include "Models/ColumnarHistory.h"
+#include "Models/FilterKernels.h"
+#include "Models/KeyStatistics.h"
+
+namespace {
+
+std::vector<FilterKernels::SimdLevel> availableLevels() {
+    std::vector<FilterKernels::SimdLevel> levels{FilterKernels::SimdLevel::Scalar};
+    if (FilterKernels::bestLevel() != FilterKernels::SimdLevel::Scalar) {
+        levels.push_back(FilterKernels::SimdLevel::SSE2);
+    }
+    if (FilterKernels::bestLevel() == FilterKernels::SimdLevel::AVX2) {
+        levels.push_back(FilterKernels::SimdLevel::AVX2);
+    }
+    return levels;
+}
+
+} // namespace
+
+// Test case for every kernel variant matching a plain loop, including tails
+TEST(FilterKernelsTest, VariantsAgreeWithPlainLoop) {
+    std::mt19937_64 random(7);
+    for (size_t count : {0u, 1u, 63u, 64u, 65u, 200u, 1000u}) {
+        std::vector<std::uint32_t> ids(count);
+        std::vector<std::int64_t> times(count);
+        for (size_t i = 0; i < count; ++i) {
+            ids[i] = static_cast<std::uint32_t>(random() % 4);
+            times[i] = static_cast<std::int64_t>(random() % 1000) - 500;
+        }
+
+        size_t expected = 0;
+        for (size_t i = 0; i < count; ++i) {
+            expected += ids[i] == 2 && times[i] >= -100 && times[i] < 250;
+        }
+
+        for (auto level : availableLevels()) {
+            std::vector<std::uint64_t> mask(FilterKernels::maskWords(count));
+            FilterKernels::fillMask(mask.data(), count);
+            FilterKernels::andEqual(ids.data(), count, 2, mask.data(), level);
+            FilterKernels::andInRange(times.data(), count, -100, 250, mask.data(), level);
+
+            EXPECT_EQ(FilterKernels::countMask(mask.data(), mask.size()), expected)
+                << "count " << count << ", level " << static_cast<int>(level);
+            FilterKernels::forEachSet(mask.data(), mask.size(), [&](size_t i) {
+                ASSERT_LT(i, count);
+                EXPECT_EQ(ids[i], 2u);
+                EXPECT_GE(times[i], -100);
+                EXPECT_LT(times[i], 250);
+            });
+        }
+    }
+}
+
+// Test case for column scans following the ring order after wrap-around
+TEST(ColumnarHistoryTest, SelectsInLogicalOrderAfterWrap) {
+    ColumnarHistory history(5000);
+    for (std::int64_t t = 0; t < 12000; ++t) {
+        history.push_back(KeyPress(static_cast<SymbolId>(t % 3), static_cast<SymbolId>(t % 7), t));
+    }
+    ASSERT_EQ(history.size(), 5000u);
+    EXPECT_EQ(history[0].timestamp, 7000);
+
+    HistoryFilter filter;
+    filter.appId = 1;
+    filter.from = 7000;
+    filter.to = 7100;
+    auto selected = history.select(filter);
+    ASSERT_FALSE(selected.empty());
+    EXPECT_EQ(history.count(filter), selected.size());
+    for (size_t i = 0; i < selected.size(); ++i) {
+        KeyPress press = history[selected[i]];
+        EXPECT_TRUE(filter.matches(press));
+        if (i > 0) {
+            EXPECT_LT(history[selected[i - 1]].timestamp, press.timestamp);
+        }
+    }
+
+    history.setCapacity(10);
+    EXPECT_EQ(history[0].timestamp, 11990);
+    EXPECT_EQ(history.count(HistoryFilter()), 10u);
+}
+
+// Test case for columnar and row-wise filters giving the same answers
+TEST(KeyStatisticsTest, ColumnarHistoryMatchesRowScan) {
+    KeyStatistics rows(3000);
+    KeyStatistics columnar(3000);
+    columnar.setColumnarHistory(true);
+    const char* apps[] = {"editor", "browser", "terminal"};
+    const char* combos[] = {"Ctrl+S", "Ctrl+C", "Ctrl+V", "Alt+Tab"};
+    for (std::int64_t t = 0; t < 5000; ++t) {
+        rows.addKeyPress(apps[t % 3], combos[t % 4], t);
+        columnar.addKeyPress(apps[t % 3], combos[t % 4], t);
+    }
+
+    EXPECT_EQ(columnar.countPresses("editor"), rows.countPresses("editor"));
+    EXPECT_EQ(columnar.countPresses("", "Ctrl+V", 2500, 4000),
+              rows.countPresses("", "Ctrl+V", 2500, 4000));
+    EXPECT_EQ(columnar.countPresses("browser", "Alt+Tab", 3000, 3100), 8u);
+    EXPECT_EQ(columnar.countPresses("unknown"), 0u);
+    EXPECT_EQ(columnar.findPressesByKey("Ctrl+C").size(), rows.findPressesByKey("Ctrl+C").size());
+    EXPECT_EQ(columnar.getAppKeyStats("terminal", 4000, 4012),
+              (std::map<std::string, int>{{"Ctrl+S", 1}, {"Ctrl+C", 1}, {"Ctrl+V", 1}, {"Alt+Tab", 1}}));
+
+    // Включение на заполненной истории переносит ее в столбцы
+    rows.setColumnarHistory(true);
+    rows.setMaxHistorySize(100);
+    EXPECT_EQ(rows.countPresses("", "", 4900, 5000), 100u);
+    EXPECT_EQ(rows.countPresses("", "", 0, 4900), 0u);
+}
@@ -0,0 +1,130 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Models/ConcurrentKeyStatistics.h"
+
+// Test case for readers always seeing a self-consistent, advancing snapshot
+TEST(ConcurrentKeyStatisticsTest, ReadersSeeConsistentSnapshots) {
+    ConcurrentKeyStatistics stats(500);
+    std::atomic<bool> done{false};
+    std::atomic<int> inconsistent{0};
+    std::atomic<int> reads{0};
+
+    std::vector<std::thread> readers;
+    for (int r = 0; r < 3; ++r) {
+        readers.emplace_back([&] {
+            std::uint64_t lastVersion = 0;
+            while (!done.load()) {
+                auto snapshot = stats.read();
+                int total = 0;
+                for (const auto& [app, count] : snapshot->apps) {
+                    total += count;
+                }
+                int keyTotal = 0;
+                for (const auto& [key, count] : snapshot->keys) {
+                    keyTotal += count;
+                }
+                if (total != static_cast<int>(snapshot->count) || keyTotal != total ||
+                    snapshot->version < lastVersion) {
+                    ++inconsistent;
+                }
+                lastVersion = snapshot->version;
+                ++reads;
+            }
+        });
+    }
+
+    const char* apps[] = {"editor", "browser", "terminal"};
+    for (std::int64_t t = 0; t < 20000; ++t) {
+        stats.addKeyPress(apps[t % 3], "Ctrl+" + std::to_string(t % 17), t);
+    }
+    // Читатели успевают хотя бы раз прочитать до остановки
+    while (reads.load() < 3) {
+        std::this_thread::yield();
+    }
+    done = true;
+    for (auto& reader : readers) {
+        reader.join();
+    }
+
+    EXPECT_EQ(inconsistent.load(), 0);
+    auto last = stats.read();
+    EXPECT_EQ(last->version, 20000u);
+    EXPECT_EQ(last->getCount(), 500u);
+    EXPECT_EQ(last->recent.back().timestamp, 19999);
+    EXPECT_EQ(last->timeRange, (std::pair<std::int64_t, std::int64_t>{19500, 19999}));
+}
+
+// Test case for a held snapshot surviving publications without blocking the writer
+TEST(ConcurrentKeyStatisticsTest, HeldSnapshotStaysValid) {
+    ConcurrentKeyStatistics stats(100, 1);
+    stats.addKeyPress("editor", "Ctrl+S", 1);
+    {
+        auto held = stats.read();
+        for (std::int64_t t = 2; t < 50; ++t) {
+            stats.addKeyPress("browser", "Ctrl+T", t);
+        }
+        // Версия, которую держит читатель, не изменилась и не освобождена
+        EXPECT_EQ(held->version, 1u);
+        EXPECT_EQ(held->getTopApps(), (KeyStatisticsSnapshot::Ranking{{"editor", 1}}));
+        EXPECT_GT(stats.retainedSnapshots(), 0u);
+    }
+    stats.publish();
+    EXPECT_EQ(stats.retainedSnapshots(), 0u);
+    EXPECT_EQ(stats.read()->getTopApps(1), (KeyStatisticsSnapshot::Ranking{{"browser", 48}}));
+}
+
+// Test case for a published state copy staying frozen while the writer goes on
+TEST(ConcurrentKeyStatisticsTest, PublishedStateIsImmutableCopy) {
+    ConcurrentKeyStatistics stats(100, 64);
+    stats.writer().setHeatmaps(true, std::chrono::minutes(0));
+    for (std::int64_t t = 0; t < 10; ++t) {
+        stats.addKeyPress("editor", "Ctrl+S", 1000 + t);
+    }
+    EXPECT_EQ(stats.read()->state, nullptr);
+
+    stats.publishState();
+    std::shared_ptr<const KeyStatistics> state = stats.read()->state;
+    ASSERT_NE(state, nullptr);
+
+    // Та же минутная корзина окна и та же ячейка карты, что в копии
+    for (std::int64_t t = 0; t < 5; ++t) {
+        stats.addKeyPress("browser", "Ctrl+T", 2000 + t);
+    }
+    stats.publish();
+    EXPECT_EQ(stats.read()->state, state) << "Regular publications share the last copy";
+
+    EXPECT_EQ(state->getCount(), 10u);
+    EXPECT_EQ(state->getTopAppsInWindow(60000, 10, 5000),
+              (std::vector<std::pair<std::string, int>>{{"editor", 10}}));
+    EXPECT_EQ(state->getAppHeatmap("browser").total(), 0);
+    EXPECT_EQ(state->getSketches(), nullptr);
+
+    EXPECT_EQ(stats.writer().getCount(), 15u);
+    EXPECT_EQ(stats.writer().getTopAppsInWindow(60000, 10, 5000),
+              (std::vector<std::pair<std::string, int>>{{"editor", 10}, {"browser", 5}}));
+}
+
+// Test case for the O(1) time range switching to a scan only while presses are out of order
+TEST(KeyStatisticsTest, TimeRangeTracksOrderThroughEviction) {
+    KeyStatistics stats(3);
+    stats.addKeyPress("editor", "Ctrl+S", 10);
+    stats.addKeyPress("editor", "Ctrl+S", 5);
+    stats.addKeyPress("editor", "Ctrl+S", 20);
+    EXPECT_EQ(stats.getTimeRange(), (std::pair<std::int64_t, std::int64_t>{5, 20}));
+
+    // Пара (10, 5) вытеснена - история снова упорядочена
+    stats.addKeyPress("editor", "Ctrl+S", 30);
+    stats.addKeyPress("editor", "Ctrl+S", 40);
+    EXPECT_EQ(stats.getTimeRange(), (std::pair<std::int64_t, std::int64_t>{20, 40}));
+
+    stats.addKeyPress("editor", "Ctrl+S", 35);
+    EXPECT_EQ(stats.getTimeRange(), (std::pair<std::int64_t, std::int64_t>{30, 40}));
+    stats.setMaxHistorySize(1);
+    EXPECT_EQ(stats.getTimeRange(), (std::pair<std::int64_t, std::int64_t>{35, 35}));
+}
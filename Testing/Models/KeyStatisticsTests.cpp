@@ -0,0 +1,201 @@
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+#include "Models/KeyStatistics.h"
+
+namespace {
+
+std::vector<std::int64_t> timestamps(const KeyStatistics& stats) {
+    std::vector<std::int64_t> result;
+    for (const auto& press : stats.getHistory()) {
+        result.push_back(press.timestamp);
+    }
+    return result;
+}
+
+} // namespace
+
+// Test case for the history keeping only the newest presses once full
+TEST(KeyStatisticsTest, HistoryWrapsAroundKeepingNewest) {
+    KeyStatistics stats(3);
+    for (std::int64_t t = 1; t <= 5; ++t) {
+        stats.addKeyPress("editor", "Ctrl+" + std::to_string(t), t);
+    }
+
+    EXPECT_EQ(stats.getCount(), 3u);
+    EXPECT_EQ(timestamps(stats), (std::vector<std::int64_t>{3, 4, 5}));
+    EXPECT_EQ(stats.getTimeRange(), (std::pair<std::int64_t, std::int64_t>{3, 5}));
+
+    auto recent = stats.getRecentPresses(2);
+    ASSERT_EQ(recent.size(), 2u);
+    EXPECT_EQ(stats.getKeyCombination(recent[0]), "Ctrl+4");
+    EXPECT_EQ(stats.getKeyCombination(recent[1]), "Ctrl+5");
+    EXPECT_EQ(stats.getKeyUsageStats().count("Ctrl+1"), 0u);
+}
+
+// Test case for resizing a wrapped history
+TEST(KeyStatisticsTest, SetMaxHistorySizeKeepsOrder) {
+    KeyStatistics stats(4);
+    for (std::int64_t t = 1; t <= 6; ++t) {
+        stats.addKeyPress("editor", "Ctrl+S", t);
+    }
+
+    stats.setMaxHistorySize(2);
+    EXPECT_EQ(timestamps(stats), (std::vector<std::int64_t>{5, 6}));
+
+    // После увеличения новые нажатия дописываются, ничего не вытесняя
+    stats.setMaxHistorySize(4);
+    stats.addKeyPress("editor", "Ctrl+S", 7);
+    stats.addKeyPress("editor", "Ctrl+S", 8);
+    EXPECT_EQ(timestamps(stats), (std::vector<std::int64_t>{5, 6, 7, 8}));
+    stats.addKeyPress("editor", "Ctrl+S", 9);
+    EXPECT_EQ(timestamps(stats), (std::vector<std::int64_t>{6, 7, 8, 9}));
+
+    stats.clearHistory();
+    EXPECT_TRUE(stats.isEmpty());
+    EXPECT_EQ(stats.getTimeRange(), (std::pair<std::int64_t, std::int64_t>{0, 0}));
+}
+
+// Test case for counters and top lists following the history window
+TEST(KeyStatisticsTest, CountersTrackEvictedPresses) {
+    KeyStatistics stats(4);
+    stats.addKeyPress("editor", "Ctrl+S", 1);
+    stats.addKeyPress("editor", "Ctrl+S", 2);
+    stats.addKeyPress("browser", "Ctrl+T", 3);
+    stats.addKeyPress("editor", "Ctrl+C", 4);
+
+    EXPECT_EQ(stats.getTopApps(1), (std::vector<std::pair<std::string, int>>{{"editor", 3}}));
+    EXPECT_EQ(stats.getAppKeyStats("editor"), (std::map<std::string, int>{{"Ctrl+C", 1}, {"Ctrl+S", 2}}));
+
+    // Два новых нажатия вытесняют оба старых Ctrl+S
+    stats.addKeyPress("browser", "Ctrl+T", 5);
+    stats.addKeyPress("browser", "Ctrl+W", 6);
+    EXPECT_EQ(stats.getTopApps(), (std::vector<std::pair<std::string, int>>{{"browser", 3}, {"editor", 1}}));
+    auto topKeys = stats.getTopKeys();
+    ASSERT_EQ(topKeys.size(), 3u);
+    EXPECT_EQ(topKeys[0], (std::pair<std::string, int>{"Ctrl+T", 2}));
+    EXPECT_EQ(topKeys[1].second, 1);
+    EXPECT_EQ(topKeys[2].second, 1);
+    EXPECT_EQ(stats.getTopKeysForApp("editor"), (std::vector<std::pair<std::string, int>>{{"Ctrl+C", 1}}));
+    EXPECT_EQ(stats.getKeyUsageStats().count("Ctrl+S"), 0u);
+
+    // Уменьшение окна вычитает выпавшие нажатия
+    stats.setMaxHistorySize(1);
+    EXPECT_EQ(stats.getAppUsageStats(), (std::map<std::string, int>{{"browser", 1}}));
+    EXPECT_TRUE(stats.getTopKeysForApp("editor").empty());
+
+    stats.clearHistory();
+    EXPECT_TRUE(stats.getTopApps().empty());
+}
+
+// Test case for interned names sharing one id and resolving back
+TEST(KeyStatisticsTest, InternsNamesIntoCompactPresses) {
+    KeyStatistics stats(8);
+    stats.addKeyPress("editor", "Ctrl+S", 1);
+    stats.addKeyPress(std::string("editor"), std::string("Ctrl+S"), 2);
+    stats.addKeyPress("browser", "Ctrl+S", 3);
+
+    const auto& history = stats.getHistory();
+    EXPECT_EQ(history[0].appId, history[1].appId);
+    EXPECT_NE(history[0].appId, history[2].appId);
+    EXPECT_EQ(history[0].comboId, history[2].comboId);
+    EXPECT_EQ(stats.getSymbols().size(), 3u);
+    EXPECT_EQ(stats.getAppName(history[2]), "browser");
+
+    // Поиск по неизвестному имени не добавляет его в таблицу
+    EXPECT_TRUE(stats.findPressesByApp("terminal").empty());
+    EXPECT_EQ(stats.getSymbols().size(), 3u);
+    EXPECT_EQ(stats.findPressesByKey("Ctrl+S").size(), 3u);
+    EXPECT_EQ(stats.findPressesByApp("editor").size(), 2u);
+
+    // Номера остаются действительными после очистки истории
+    stats.clearHistory();
+    stats.addKeyPress("editor", "Ctrl+Z", 4);
+    EXPECT_EQ(stats.getSymbols().find("editor"), stats.getHistory()[0].appId);
+}
+
+// Test case for window queries expiring old buckets as the clock advances
+TEST(KeyStatisticsTest, WindowStatisticsExpireOldBuckets) {
+    constexpr std::int64_t kMinute = 60000;
+    KeyStatistics stats(2);
+    stats.setWindowBuckets(kMinute, 60);
+
+    // Минута 0: редактор, минута 30: браузер, минута 50: снова редактор
+    stats.addKeyPress("editor", "Ctrl+S", 0);
+    stats.addKeyPress("editor", "Ctrl+S", 1000);
+    stats.addKeyPress("browser", "Ctrl+T", 30 * kMinute);
+    stats.addKeyPress("editor", "Ctrl+Z", 50 * kMinute + 10);
+
+    // Окно не ограничено емкостью истории (2 нажатия)
+    EXPECT_EQ(stats.getTopAppsInWindow(60 * kMinute, 10, 50 * kMinute + 10),
+              (std::vector<std::pair<std::string, int>>{{"editor", 3}, {"browser", 1}}));
+    EXPECT_EQ(stats.getTopKeysInWindow(15 * kMinute, 10, 50 * kMinute + 10),
+              (std::vector<std::pair<std::string, int>>{{"Ctrl+Z", 1}}));
+    EXPECT_EQ(stats.getTopKeysForAppInWindow("editor", 60 * kMinute, 10, 50 * kMinute + 10),
+              (std::vector<std::pair<std::string, int>>{{"Ctrl+S", 2}, {"Ctrl+Z", 1}}));
+
+    // Через час после начала минута 0 вышла из окна
+    std::int64_t later = 61 * kMinute;
+    auto topApps = stats.getTopAppsInWindow(60 * kMinute, 10, later);
+    EXPECT_EQ((std::map<std::string, int>(topApps.begin(), topApps.end())),
+              (std::map<std::string, int>{{"browser", 1}, {"editor", 1}}));
+    EXPECT_DOUBLE_EQ(stats.getPressRate("", 60 * kMinute, later - 1), 2.0 / 60.0);
+
+    // Нажатие из минуты 0 в переиспользованный слот не возвращается
+    stats.addKeyPress("terminal", "Ctrl+D", 60 * kMinute);
+    stats.addKeyPress("editor", "Ctrl+S", 500);
+    EXPECT_EQ(stats.getTopKeysInWindow(kMinute, 10, 60 * kMinute),
+              (std::vector<std::pair<std::string, int>>{{"Ctrl+D", 1}}));
+}
+
+// Test case for time range ignoring arrival order
+TEST(KeyStatisticsTest, TimeRangeHandlesOutOfOrderPresses) {
+    KeyStatistics stats(4);
+    stats.addKeyPress("editor", "Ctrl+S", 50);
+    stats.addKeyPress("editor", "Ctrl+S", 10);
+    stats.addKeyPress("editor", "Ctrl+S", 30);
+    EXPECT_EQ(stats.getTimeRange(), (std::pair<std::int64_t, std::int64_t>{10, 50}));
+}
+
+// Test case for rank order surviving increments and decrements
+TEST(RankedCounterTest, KeepsKeysOrderedByCount) {
+    RankedCounter<std::string> counter;
+    for (const char* key : {"a", "b", "b", "c", "c", "c", "d"}) {
+        counter.add(key);
+    }
+    counter.remove("c");
+    counter.remove("c");
+    counter.add("d", 3);
+    counter.remove("a");
+
+    EXPECT_EQ(counter.size(), 3u);
+    EXPECT_EQ(counter.count("a"), 0);
+    EXPECT_EQ(counter.top(2), (std::vector<std::pair<std::string, int>>{{"d", 4}, {"b", 2}}));
+
+    int previous = INT32_MAX;
+    counter.forEach([&](const std::string&, int count) {
+        EXPECT_LE(count, previous);
+        previous = count;
+    });
+}
+
+// Test case for restoring a ranking in bulk and updating it afterwards
+TEST(RankedCounterTest, AssignsRankingInBulk) {
+    RankedCounter<std::string> counter;
+    counter.add("old");
+    counter.assign({{"b", 2}, {"c", 5}, {"a", 2}, {"zero", 0}, {"c", 9}});
+
+    EXPECT_EQ(counter.size(), 3u);
+    EXPECT_EQ(counter.count("old"), 0);
+    EXPECT_EQ(counter.count("c"), 9);
+    EXPECT_EQ(counter.top(1), (std::vector<std::pair<std::string, int>>{{"c", 9}}));
+
+    // Корзины собраны верно: изменения по одному сохраняют порядок
+    counter.add("a", 4);
+    counter.remove("c");
+    counter.remove("b");
+    counter.remove("b");
+    EXPECT_EQ(counter.top(3), (std::vector<std::pair<std::string, int>>{{"c", 8}, {"a", 6}}));
+}
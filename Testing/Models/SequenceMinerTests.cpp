@@ -0,0 +1,70 @@
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "Models/KeyStatistics.h"
+#include "Models/SequenceMiner.h"
+
+// Test case for the chain emitting bigrams and trigrams and breaking on a long pause
+TEST(SequenceTrackerTest, EmitsWithinTimeoutOnly) {
+    SequenceTracker<int> tracker(100);
+    std::vector<KeySequenceOf<int>> emitted;
+    auto collect = [&](const KeySequenceOf<int>& sequence) { emitted.push_back(sequence); };
+
+    tracker.observe(1, 10, 0, collect);
+    tracker.observe(1, 20, 50, collect);
+    tracker.observe(2, 30, 150, collect);
+    ASSERT_EQ(emitted.size(), 3u);
+    EXPECT_EQ(emitted[0], (KeySequenceOf<int>{1, {10, 20, 0}, 2}));
+    EXPECT_EQ(emitted[1], (KeySequenceOf<int>{2, {20, 30, 0}, 2}));
+    EXPECT_EQ(emitted[2], (KeySequenceOf<int>{2, {10, 20, 30}, 3}));
+
+    // Пауза 101 мс рвет цепочку, время назад - тоже
+    emitted.clear();
+    tracker.observe(1, 40, 251, collect);
+    tracker.observe(1, 50, 200, collect);
+    EXPECT_TRUE(emitted.empty());
+    tracker.observe(1, 60, 220, collect);
+    ASSERT_EQ(emitted.size(), 1u);
+    EXPECT_EQ(emitted[0], (KeySequenceOf<int>{1, {50, 60, 0}, 2}));
+}
+
+// Test case for top sequences and the transition matrix staying current per press
+TEST(KeyStatisticsTest, MinesSequencesIncrementally) {
+    KeyStatistics stats(10);
+    EXPECT_TRUE(stats.getTopSequences(2).empty());
+    stats.setSequenceMining(true, 1000);
+
+    for (std::int64_t i = 0; i < 4; ++i) {
+        std::int64_t t = i * 10000;
+        stats.addKeyPress("editor", "Ctrl+C", t);
+        stats.addKeyPress("editor", "Alt+Tab", t + 100);
+        stats.addKeyPress("browser", "Ctrl+V", t + 200);
+    }
+    stats.addKeyPress("editor", "Ctrl+C", 50000);
+    stats.addKeyPress("editor", "Ctrl+S", 50100);
+
+    // История короче числа нажатий: счетчики не зависят от нее
+    auto trigrams = stats.getTopSequences(3);
+    ASSERT_EQ(trigrams.size(), 1u);
+    EXPECT_EQ(trigrams[0].appName, "browser");
+    EXPECT_EQ(trigrams[0].combos, (std::vector<std::string>{"Ctrl+C", "Alt+Tab", "Ctrl+V"}));
+    EXPECT_EQ(trigrams[0].pressCount, 4);
+
+    auto editor = stats.getTopSequences(2, 10, "editor");
+    ASSERT_EQ(editor.size(), 2u);
+    EXPECT_EQ(editor[0].combos, (std::vector<std::string>{"Ctrl+C", "Alt+Tab"}));
+    EXPECT_EQ(editor[0].pressCount, 4);
+    EXPECT_EQ(editor[1].combos, (std::vector<std::string>{"Ctrl+C", "Ctrl+S"}));
+
+    auto next = stats.getLikelyNextCombos("editor", "Ctrl+C");
+    EXPECT_EQ(next, (std::vector<std::pair<std::string, int>>{{"Alt+Tab", 4}, {"Ctrl+S", 1}}));
+    EXPECT_TRUE(stats.getLikelyNextCombos("terminal", "Ctrl+C").empty());
+
+    stats.clearHistory();
+    EXPECT_TRUE(stats.getTopSequences(2).empty());
+    stats.setSequenceMining(false);
+    stats.addKeyPress("editor", "Ctrl+C", 60000);
+    stats.addKeyPress("editor", "Ctrl+V", 60100);
+    EXPECT_TRUE(stats.getTopSequences(2).empty());
+}
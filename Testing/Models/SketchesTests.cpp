@@ -0,0 +1,146 @@
+#include <gtest/gtest.h>
+#include <cmath>
+#include <cstdint>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+#include "Models/KeyStatistics.h"
+#include "Models/Sketches.h"
+
+namespace {
+
+// Поток с перекосом: ключ k встречается примерно в 1 / (k + 1) раз чаще
+std::vector<std::string> skewedStream(size_t length, size_t keys, std::uint64_t seed) {
+    std::mt19937_64 random(seed);
+    std::vector<double> weights;
+    for (size_t k = 0; k < keys; ++k) {
+        weights.push_back(1.0 / static_cast<double>(k + 1));
+    }
+    std::discrete_distribution<size_t> pick(weights.begin(), weights.end());
+    std::vector<std::string> stream;
+    for (size_t i = 0; i < length; ++i) {
+        stream.push_back("key" + std::to_string(pick(random)));
+    }
+    return stream;
+}
+
+std::map<std::string, std::uint64_t> exactCounts(const std::vector<std::string>& stream) {
+    std::map<std::string, std::uint64_t> counts;
+    for (const auto& key : stream) {
+        ++counts[key];
+    }
+    return counts;
+}
+
+} // namespace
+
+// Test case for Count-Min never underestimating and staying within epsilon * N
+TEST(SketchesTest, CountMinStaysWithinErrorBound) {
+    auto stream = skewedStream(50000, 5000, 1);
+    auto sketch = CountMinSketch::withError(0.001, 0.01);
+    for (const auto& key : stream) {
+        sketch.add(key);
+    }
+
+    size_t outside = 0;
+    for (const auto& [key, count] : exactCounts(stream)) {
+        std::uint64_t estimate = sketch.estimate(key);
+        EXPECT_GE(estimate, count);
+        outside += estimate > count + sketch.errorBound();
+    }
+    EXPECT_LE(outside, 50u) << "More than delta of the keys exceed epsilon * N";
+}
+
+// Test case for Space-Saving keeping every key above N / k with bounded error
+TEST(SketchesTest, SpaceSavingFindsHeavyHitters) {
+    auto stream = skewedStream(50000, 5000, 2);
+    SpaceSaving<std::string> summary(64);
+    for (const auto& key : stream) {
+        summary.add(key);
+    }
+
+    auto exact = exactCounts(stream);
+    auto top = summary.top(64);
+    std::map<std::string, SpaceSaving<std::string>::Entry> found;
+    for (const auto& entry : top) {
+        found.emplace(entry.key, entry);
+        EXPECT_GE(entry.count, exact[entry.key]);
+        EXPECT_LE(entry.count - entry.error, exact[entry.key]);
+        EXPECT_LE(static_cast<double>(entry.error), summary.errorBound());
+    }
+    for (const auto& [key, count] : exact) {
+        if (static_cast<double>(count) > summary.errorBound()) {
+            EXPECT_EQ(found.count(key), 1u) << key << " is a heavy hitter";
+        }
+    }
+    EXPECT_EQ(top.front().key, "key0");
+}
+
+// Test case for HyperLogLog staying within a few standard errors
+TEST(SketchesTest, HyperLogLogEstimatesDistinctCount) {
+    for (size_t distinct : {100u, 20000u}) {
+        HyperLogLog sketch(12);
+        for (int pass = 0; pass < 3; ++pass) {
+            for (size_t i = 0; i < distinct; ++i) {
+                sketch.add("combo" + std::to_string(i));
+            }
+        }
+        double error = std::abs(sketch.estimate() - static_cast<double>(distinct)) / distinct;
+        EXPECT_LT(error, 4 * sketch.relativeError()) << distinct << " distinct keys";
+    }
+}
+
+// Test case for merged sketches matching a sketch over the whole stream
+TEST(SketchesTest, MergedSketchesMatchCombinedStream) {
+    SketchConfig config;
+    config.heavyHitters = 32;
+    KeySketches machineA(config);
+    KeySketches machineB(config);
+    KeySketches combined(config);
+    auto streamA = skewedStream(20000, 500, 3);
+    auto streamB = skewedStream(20000, 500, 4);
+    for (const auto& combo : streamA) {
+        machineA.add("editor", combo);
+        combined.add("editor", combo);
+    }
+    for (const auto& combo : streamB) {
+        machineB.add(combo == "key1" ? "browser" : "editor", combo);
+        combined.add(combo == "key1" ? "browser" : "editor", combo);
+    }
+
+    machineA.merge(machineB);
+    EXPECT_EQ(machineA.totalCount(), 40000u);
+    EXPECT_EQ(machineA.estimatePair("editor", "key3"), combined.estimatePair("editor", "key3"));
+    EXPECT_EQ(machineA.estimateCombo("key1"), combined.estimateCombo("key1"));
+    EXPECT_DOUBLE_EQ(machineA.distinctComboCount(), combined.distinctComboCount());
+    EXPECT_DOUBLE_EQ(machineA.distinctPairCount(), combined.distinctPairCount());
+
+    auto top = machineA.topPairs(2);
+    ASSERT_EQ(top.size(), 2u);
+    EXPECT_EQ(top[0].appName, "editor");
+    EXPECT_EQ(top[0].keyCombination, "key0");
+    EXPECT_EQ(top[1].keyCombination, "key1");
+
+    KeySketches otherSize(SketchConfig{0.01, 0.01, 32, 12});
+    EXPECT_THROW(machineA.merge(otherSize), std::invalid_argument);
+}
+
+// Test case for sketches counting presses the history has already evicted
+TEST(KeyStatisticsTest, SketchesOutliveHistory) {
+    KeyStatistics stats(10);
+    stats.setSketches(true);
+    for (std::int64_t t = 0; t < 1000; ++t) {
+        stats.addKeyPress("editor", t % 4 == 0 ? "Ctrl+S" : "Ctrl+" + std::to_string(t % 50), t);
+    }
+
+    const KeySketches* sketches = stats.getSketches();
+    ASSERT_NE(sketches, nullptr);
+    EXPECT_EQ(sketches->totalCount(), 1000u);
+    EXPECT_GE(sketches->estimatePair("editor", "Ctrl+S"), 250u);
+    EXPECT_EQ(sketches->topPairs(1).front().keyCombination, "Ctrl+S");
+    EXPECT_NEAR(sketches->distinctComboCount(), 51.0, 3.0);
+
+    stats.setSketches(false);
+    EXPECT_EQ(stats.getSketches(), nullptr);
+}
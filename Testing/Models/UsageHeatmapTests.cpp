@@ -0,0 +1,62 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include <cstdint>
+#include <ctime>
+#include "Models/KeyStatistics.h"
+#include "Models/UsageHeatmap.h"
+
+namespace {
+
+// 2024-01-01 00:00 UTC, понедельник
+const std::int64_t kMonday = 1704067200000LL;
+const std::int64_t kHour = 3600000;
+
+} // namespace
+
+// Test case for mapping timestamps to hour-of-week cells in fixed time zones
+TEST(HeatmapClockTest, FixedOffsets) {
+    std::int64_t ts = kMonday + kHour / 2;
+    EXPECT_EQ(HeatmapClock(std::chrono::minutes(0)).cellOf(ts), 0u);
+    EXPECT_EQ(HeatmapClock(std::chrono::minutes(180)).cellOf(ts), 3u);
+    EXPECT_EQ(HeatmapClock(std::chrono::minutes(330)).cellOf(ts), 6u);
+    // К западу от Гринвича это еще воскресенье
+    EXPECT_EQ(HeatmapClock(std::chrono::minutes(-60)).cellOf(ts), 6u * 24 + 23);
+    // 1969-12-31 23:00 UTC - среда
+    EXPECT_EQ(HeatmapClock(std::chrono::minutes(0)).cellOf(-kHour), 2u * 24 + 23);
+}
+
+// Test case for the system time zone agreeing with the C library
+TEST(HeatmapClockTest, LocalTimeMatchesLocaltime) {
+    HeatmapClock clock;
+    EXPECT_TRUE(clock.isLocal());
+    for (std::int64_t ts = kMonday; ts < kMonday + 400 * 24 * kHour; ts += 7 * kHour + 123457) {
+        std::time_t seconds = static_cast<std::time_t>(ts / 1000);
+        std::tm local = *std::localtime(&seconds);
+        size_t expected = static_cast<size_t>((local.tm_wday + 6) % 7 * 24 + local.tm_hour);
+        ASSERT_EQ(clock.cellOf(ts), expected) << ts;
+    }
+}
+
+// Test case for per-app and per-combo heatmaps updated on every press
+TEST(KeyStatisticsTest, MaintainsHeatmaps) {
+    KeyStatistics stats(2);
+    stats.addKeyPress("editor", "Ctrl+S", kMonday);
+    EXPECT_EQ(stats.getAppHeatmap("editor").total(), 0);
+
+    stats.setHeatmaps(true, std::chrono::minutes(60));
+    stats.addKeyPress("editor", "Ctrl+S", kMonday + 9 * kHour);
+    stats.addKeyPress("editor", "Ctrl+Z", kMonday + 9 * kHour + 1);
+    stats.addKeyPress("browser", "Ctrl+Z", kMonday + 24 * kHour);
+
+    // История на два нажатия, карта - за все время
+    UsageHeatmap editor = stats.getAppHeatmap("editor");
+    EXPECT_EQ(editor.at(0, 10), 2);
+    EXPECT_EQ(editor.total(), 2);
+    UsageHeatmap undo = stats.getComboHeatmap("Ctrl+Z");
+    EXPECT_EQ(undo.at(0, 10), 1);
+    EXPECT_EQ(undo.at(1, 1), 1);
+    EXPECT_EQ(stats.getAppHeatmap("terminal"), UsageHeatmap());
+
+    stats.clearHistory();
+    EXPECT_EQ(stats.getComboHeatmap("Ctrl+Z").total(), 0);
+}
@@ -0,0 +1,125 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "Database/Database.h"
+#include "Storage/EventJournal.h"
+
+namespace {
+
+struct ReplayedPress {
+    std::uint64_t sequence;
+    std::int64_t timestamp;
+    std::string appName;
+    std::string keyCombination;
+};
+
+std::vector<ReplayedPress> replayAll(EventJournal& journal) {
+    std::vector<ReplayedPress> presses;
+    journal.replay([&](const JournalRecord& record) {
+        presses.push_back({record.sequence, record.timestamp,
+                           std::string(record.appName), std::string(record.keyCombination)});
+    });
+    return presses;
+}
+
+} // namespace
+
+// Test fixture with a scratch journal file
+class EventJournalTest : public ::testing::Test {
+protected:
+    const std::string journalPath = "hoka_journal_test.journal";
+
+    void SetUp() override { std::remove(journalPath.c_str()); }
+    void TearDown() override { std::remove(journalPath.c_str()); }
+};
+
+// Test case for replaying unconsumed presses after reopening
+TEST_F(EventJournalTest, ReplaysUnconsumedTailAfterReopen) {
+    {
+        EventJournal journal;
+        ASSERT_TRUE(journal.open(journalPath, 16));
+        EXPECT_EQ(journal.append("editor", "Ctrl+S", 1000), 1u);
+        EXPECT_EQ(journal.append("editor", "Ctrl+C", 2000), 2u);
+        EXPECT_EQ(journal.append("browser", "Ctrl+T", 3000), 3u);
+        journal.markConsumed(1);
+    }
+
+    EventJournal journal;
+    ASSERT_TRUE(journal.open(journalPath, 16));
+    auto presses = replayAll(journal);
+    ASSERT_EQ(presses.size(), 2u);
+    EXPECT_EQ(presses[0].sequence, 2u);
+    EXPECT_EQ(presses[0].keyCombination, "Ctrl+C");
+    EXPECT_EQ(presses[1].appName, "browser");
+    EXPECT_EQ(presses[1].timestamp, 3000);
+
+    // Новые записи продолжают нумерацию
+    EXPECT_EQ(journal.append("editor", "Ctrl+V", 4000), 4u);
+}
+
+// Test case for a torn record ending the journal
+TEST_F(EventJournalTest, CorruptRecordEndsReplay) {
+    {
+        EventJournal journal;
+        ASSERT_TRUE(journal.open(journalPath, 16));
+        journal.append("editor", "Ctrl+S", 1000);
+        journal.append("editor", "Ctrl+C", 2000);
+        journal.append("editor", "Ctrl+V", 3000);
+    }
+
+    // Портим байт текста во второй записи
+    {
+        std::fstream file(journalPath, std::ios::in | std::ios::out | std::ios::binary);
+        file.seekp(EventJournal::kHeaderSize + EventJournal::kRecordSize + 30);
+        file.put('X');
+    }
+
+    EventJournal journal;
+    ASSERT_TRUE(journal.open(journalPath, 16));
+    auto presses = replayAll(journal);
+    ASSERT_EQ(presses.size(), 1u);
+    EXPECT_EQ(presses[0].keyCombination, "Ctrl+S");
+    EXPECT_EQ(journal.append("editor", "Ctrl+Z", 4000), 2u);
+}
+
+// Test case for rewinding once everything is consumed and for a full journal
+TEST_F(EventJournalTest, RewindsWhenConsumedAndRejectsWhenFull) {
+    EventJournal journal;
+    ASSERT_TRUE(journal.open(journalPath, 2));
+    EXPECT_EQ(journal.append("editor", "Ctrl+S", 1000), 1u);
+    EXPECT_EQ(journal.append("editor", "Ctrl+S", 2000), 2u);
+    EXPECT_EQ(journal.append("editor", "Ctrl+S", 3000), 0u) << "No free slots left";
+    EXPECT_EQ(journal.getFreeSlots(), 0u);
+
+    journal.markConsumed(2);
+    EXPECT_EQ(journal.getFreeSlots(), 2u);
+    EXPECT_EQ(journal.append("editor", "Ctrl+C", 4000), 3u);
+    auto presses = replayAll(journal);
+    ASSERT_EQ(presses.size(), 1u);
+    EXPECT_EQ(presses[0].keyCombination, "Ctrl+C");
+}
+
+// Test case for the database confirming journal records on commit
+TEST_F(EventJournalTest, DatabaseCommitConfirmsJournal) {
+    Database db;
+    ASSERT_TRUE(db.initialize(Database::kInMemory));
+
+    EventJournal journal;
+    ASSERT_TRUE(journal.open(journalPath, 16, db.getCommittedJournalSequence() + 1));
+    db.setJournalCommitCallback([&](std::uint64_t sequence) { journal.markConsumed(sequence); });
+
+    std::uint64_t first = journal.append("journalApp", "Ctrl+S", 1000);
+    std::uint64_t second = journal.append("journalApp", "Ctrl+S", 2000);
+    db.updateKeyStatistics("journalApp", "Ctrl+S", 1000, first);
+    db.updateKeyStatistics("journalApp", "Ctrl+S", 2000, second);
+    ASSERT_TRUE(db.flush());
+
+    EXPECT_EQ(journal.getConsumedSequence(), second);
+    EXPECT_EQ(db.getCommittedJournalSequence(), second);
+    EXPECT_TRUE(replayAll(journal).empty());
+
+    db.setJournalCommitCallback(nullptr);
+}
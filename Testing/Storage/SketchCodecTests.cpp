@@ -0,0 +1,109 @@
+#include <gtest/gtest.h>
+#include <stdexcept>
+#include <string>
+#include "Storage/SketchCodec.h"
+
+namespace {
+
+// Нажатия "машины": приложение и комбинация по номеру, с перекосом к
+// первым комбинациям
+void fill(KeySketches& sketches, int presses, int seed) {
+    for (int i = 0; i < presses; ++i) {
+        int combo = (i * seed) % 97 % (1 + i % 13);
+        sketches.add(i % 3 == 0 ? "browser" : "editor", "Ctrl+" + std::to_string(combo));
+    }
+}
+
+void expectSameSketches(const KeySketches& expected, const KeySketches& actual) {
+    EXPECT_EQ(actual.totalCount(), expected.totalCount());
+    for (int combo = 0; combo < 13; ++combo) {
+        std::string key = "Ctrl+" + std::to_string(combo);
+        EXPECT_EQ(actual.estimatePair("editor", key), expected.estimatePair("editor", key));
+        EXPECT_EQ(actual.estimateCombo(key), expected.estimateCombo(key));
+    }
+    EXPECT_DOUBLE_EQ(actual.distinctComboCount(), expected.distinctComboCount());
+    EXPECT_DOUBLE_EQ(actual.distinctPairCount(), expected.distinctPairCount());
+
+    auto expectedTop = expected.topPairs(5);
+    auto actualTop = actual.topPairs(5);
+    ASSERT_EQ(actualTop.size(), expectedTop.size());
+    for (size_t i = 0; i < actualTop.size(); ++i) {
+        EXPECT_EQ(actualTop[i].appName, expectedTop[i].appName);
+        EXPECT_EQ(actualTop[i].keyCombination, expectedTop[i].keyCombination);
+        EXPECT_EQ(actualTop[i].count, expectedTop[i].count);
+        EXPECT_EQ(actualTop[i].error, expectedTop[i].error);
+    }
+}
+
+} // namespace
+
+// Test case for an image restoring the sketches with their parameters
+TEST(SketchCodecTest, RoundTripsSketchesAndConfig) {
+    KeySketches original(SketchConfig{0.01, 0.01, 8, 10});
+    fill(original, 5000, 7);
+
+    std::string image = SketchCodec::encode(original);
+    // Магия записана побайтно, независимо от порядка байт машины
+    EXPECT_EQ(image.substr(0, 8), "HOKASKCH");
+
+    KeySketches restored;
+    ASSERT_TRUE(SketchCodec::decode(image.data(), image.size(), restored));
+    expectSameSketches(original, restored);
+
+    // Параметры пришли из образа: набор того же размера вливается
+    KeySketches sameSize(SketchConfig{0.01, 0.01, 8, 10});
+    EXPECT_NO_THROW(restored.merge(sameSize));
+    EXPECT_THROW(restored.merge(KeySketches()), std::invalid_argument);
+}
+
+// Test case for merging an image from another machine
+TEST(SketchCodecTest, DecodedImageMergesLikeLocalSketches) {
+    SketchConfig config{0.01, 0.01, 16, 12};
+    KeySketches machineA(config);
+    KeySketches machineB(config);
+    fill(machineA, 4000, 3);
+    fill(machineB, 6000, 11);
+
+    KeySketches local = machineA;
+    local.merge(machineB);
+
+    KeySketches remote;
+    std::string image = SketchCodec::encode(machineB);
+    ASSERT_TRUE(SketchCodec::decode(image.data(), image.size(), remote));
+    machineA.merge(remote);
+    expectSameSketches(local, machineA);
+
+    // Образ с другими размерами декодируется, но не вливается
+    KeySketches otherSize(SketchConfig{0.001, 0.01, 16, 12});
+    fill(otherSize, 100, 5);
+    image = SketchCodec::encode(otherSize);
+    ASSERT_TRUE(SketchCodec::decode(image.data(), image.size(), remote));
+    EXPECT_THROW(machineA.merge(remote), std::invalid_argument);
+    EXPECT_EQ(machineA.totalCount(), 10000u);
+}
+
+// Test case for damaged, truncated and foreign images leaving sketches untouched
+TEST(SketchCodecTest, RejectsDamagedImages) {
+    KeySketches original(SketchConfig{0.01, 0.01, 8, 10});
+    fill(original, 1000, 7);
+    std::string image = SketchCodec::encode(original);
+
+    KeySketches target;
+    target.add("player", "Space");
+    auto expectRejected = [&](const std::string& damaged) {
+        EXPECT_FALSE(SketchCodec::decode(damaged.data(), damaged.size(), target));
+        EXPECT_EQ(target.totalCount(), 1u);
+        EXPECT_EQ(target.topPairs(1).front().appName, "player");
+    };
+
+    std::string flipped = image;
+    flipped[image.size() / 2] ^= 0x40;
+    expectRejected(flipped);
+    expectRejected(image.substr(0, image.size() - 1));
+    expectRejected(image.substr(0, 10));
+    expectRejected(image + "x");
+
+    std::string newerVersion = image;
+    newerVersion[8] = static_cast<char>(SketchCodec::kVersion + 1);
+    expectRejected(newerVersion);
+}
@@ -0,0 +1,149 @@
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+#include "Storage/StatisticsSnapshot.h"
+
+namespace {
+
+// Нажатия истории в виде строк: номера в разных таблицах имен не сравнимы
+std::vector<std::string> historyOf(const KeyStatistics& stats) {
+    std::vector<std::string> presses;
+    for (const auto& press : stats.getHistory()) {
+        presses.push_back(std::string(stats.getAppName(press)) + "|" +
+                          std::string(stats.getKeyCombination(press)) + "|" +
+                          std::to_string(press.timestamp));
+    }
+    return presses;
+}
+
+// Все, что видно снаружи после теплого старта
+void expectSameStatistics(const KeyStatistics& expected, const KeyStatistics& actual,
+                          std::int64_t now) {
+    EXPECT_EQ(historyOf(actual), historyOf(expected));
+    EXPECT_EQ(actual.getMaxHistorySize(), expected.getMaxHistorySize());
+    EXPECT_EQ(actual.getTimeRange(), expected.getTimeRange());
+    EXPECT_EQ(actual.getAppUsageStats(), expected.getAppUsageStats());
+    EXPECT_EQ(actual.getKeyUsageStats(), expected.getKeyUsageStats());
+    EXPECT_EQ(actual.getAppKeyStats("editor"), expected.getAppKeyStats("editor"));
+    EXPECT_EQ(actual.getTopApps(1), expected.getTopApps(1));
+    EXPECT_EQ(actual.getTopKeysInWindow(3600000, 10, now).size(),
+              expected.getTopKeysInWindow(3600000, 10, now).size());
+    EXPECT_DOUBLE_EQ(actual.getPressRate("browser", 3600000, now),
+                     expected.getPressRate("browser", 3600000, now));
+    EXPECT_EQ(actual.getAppHeatmap("editor"), expected.getAppHeatmap("editor"));
+    EXPECT_EQ(actual.getComboHeatmap("Ctrl+S"), expected.getComboHeatmap("Ctrl+S"));
+}
+
+} // namespace
+
+// Test fixture with a scratch snapshot file
+class StatisticsSnapshotTest : public ::testing::Test {
+protected:
+    const std::string snapshotPath = "hoka_stats_test.snapshot";
+    const std::int64_t start = 1700000000000;
+    KeyStatistics stats{64};
+
+    // Больше нажатий, чем емкость истории, и одно не по порядку
+    void SetUp() override {
+        std::remove(snapshotPath.c_str());
+        stats.setHeatmaps(true, std::chrono::minutes(180));
+        const char* apps[] = {"editor", "browser", "terminal"};
+        const char* combos[] = {"Ctrl+S", "Ctrl+C", "Ctrl+V", "Alt+Tab", "Ctrl+Shift+P"};
+        for (int i = 0; i < 100; ++i) {
+            stats.addKeyPress(apps[i % 3], combos[(i * 7) % 5], start + i * 60000);
+        }
+        stats.addKeyPress("editor", "Ctrl+Z", start + 50 * 60000);
+    }
+
+    void TearDown() override {
+        std::remove(snapshotPath.c_str());
+        std::remove((snapshotPath + ".tmp").c_str());
+    }
+
+    std::string readFile() const {
+        std::ifstream in(snapshotPath, std::ios::binary);
+        return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+
+    void writeFile(const std::string& image) const {
+        std::ofstream(snapshotPath, std::ios::binary | std::ios::trunc) << image;
+    }
+};
+
+// Test case for a snapshot restoring history, counters, window and heatmaps
+TEST_F(StatisticsSnapshotTest, RoundTripsFullState) {
+    ASSERT_TRUE(StatisticsSnapshot::save(stats, snapshotPath));
+
+    KeyStatistics restored;
+    ASSERT_TRUE(StatisticsSnapshot::load(snapshotPath, restored));
+    std::int64_t now = start + 101 * 60000;
+    expectSameStatistics(stats, restored, now);
+
+    // Восстановленные счетчики продолжают вытеснение как исходные
+    for (int i = 0; i < 80; ++i) {
+        stats.addKeyPress("terminal", "Ctrl+L", now + i);
+        restored.addKeyPress("terminal", "Ctrl+L", now + i);
+    }
+    expectSameStatistics(stats, restored, now + 100);
+    EXPECT_EQ(restored.getAppUsageStats().count("editor"), 0u);
+}
+
+// Test case for loading into statistics that already know other names
+TEST_F(StatisticsSnapshotTest, RemapsNamesIntoExistingTable) {
+    std::string image = StatisticsSnapshot::encode(stats);
+
+    KeyStatistics restored(10);
+    restored.setColumnarHistory(true);
+    restored.addKeyPress("player", "Space", start);
+    ASSERT_TRUE(StatisticsSnapshot::decode(image.data(), image.size(), restored));
+
+    expectSameStatistics(stats, restored, start + 101 * 60000);
+    EXPECT_TRUE(restored.hasColumnarHistory());
+    EXPECT_EQ(restored.countPresses("editor", "Ctrl+S"), stats.countPresses("editor", "Ctrl+S"));
+    EXPECT_TRUE(restored.findPressesByApp("player").empty());
+}
+
+// Test case for damaged, truncated and foreign files leaving statistics untouched
+TEST_F(StatisticsSnapshotTest, RejectsDamagedSnapshots) {
+    ASSERT_TRUE(StatisticsSnapshot::save(stats, snapshotPath));
+    std::string image = readFile();
+    ASSERT_GT(image.size(), 64u);
+
+    KeyStatistics target;
+    target.addKeyPress("player", "Space", start);
+    auto expectRejected = [&](const std::string& damaged) {
+        writeFile(damaged);
+        EXPECT_FALSE(StatisticsSnapshot::load(snapshotPath, target));
+        EXPECT_EQ(target.getCount(), 1u);
+        EXPECT_EQ(target.getAppUsageStats().size(), 1u);
+    };
+
+    std::string flipped = image;
+    flipped[image.size() / 2] ^= 0x40;
+    expectRejected(flipped);
+    expectRejected(image.substr(0, image.size() - 1));
+    expectRejected(image.substr(0, 10));
+
+    std::string newerVersion = image;
+    newerVersion[8] = static_cast<char>(StatisticsSnapshot::kVersion + 1);
+    expectRejected(newerVersion);
+
+    std::remove(snapshotPath.c_str());
+    EXPECT_FALSE(StatisticsSnapshot::load(snapshotPath, target));
+}
+
+// Test case for replacing an existing snapshot with a smaller one
+TEST_F(StatisticsSnapshotTest, OverwritesPreviousSnapshot) {
+    ASSERT_TRUE(StatisticsSnapshot::save(stats, snapshotPath));
+    KeyStatistics empty;
+    ASSERT_TRUE(StatisticsSnapshot::save(empty, snapshotPath));
+
+    KeyStatistics restored;
+    ASSERT_TRUE(StatisticsSnapshot::load(snapshotPath, restored));
+    EXPECT_TRUE(restored.isEmpty());
+    EXPECT_EQ(restored.getMaxHistorySize(), 1000u);
+    EXPECT_EQ(restored.getAppHeatmap("editor").total(), 0);
+}
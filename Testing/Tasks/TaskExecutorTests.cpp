@@ -0,0 +1,149 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Tasks/TaskExecutor.h"
+
+namespace {
+
+// Задача, держащая рабочий поток, пока тест не откроет ворота
+struct Gate {
+    std::promise<void> opened;
+    std::shared_future<void> wait = opened.get_future().share();
+    std::promise<void> entered;
+
+    TaskExecutor::Task task() {
+        return [this](const CancellationToken&) {
+            entered.set_value();
+            wait.wait();
+        };
+    }
+};
+
+} // namespace
+
+// Test case for queued tasks running by priority, not by submission order
+TEST(TaskExecutorTest, RunsHigherPriorityFirst) {
+    TaskExecutor executor(1);
+    Gate gate;
+    executor.submit(TaskPriority::Maintenance, gate.task());
+    gate.entered.get_future().wait();
+
+    std::mutex mutex;
+    std::vector<std::string> order;
+    auto record = [&](const std::string& name) {
+        return [&, name](const CancellationToken&) {
+            std::lock_guard<std::mutex> lock(mutex);
+            order.push_back(name);
+        };
+    };
+    executor.submit(TaskPriority::Maintenance, record("maintenance"));
+    executor.submit(TaskPriority::Export, record("export"));
+    executor.submit(TaskPriority::Analytics, record("analytics"));
+    executor.submit(TaskPriority::Interactive, record("interactive"));
+
+    gate.opened.set_value();
+    executor.waitIdle();
+    EXPECT_EQ(order, (std::vector<std::string>{"interactive", "export", "analytics", "maintenance"}));
+}
+
+// Test case for a newer task with the same key cancelling the older one
+TEST(TaskExecutorTest, SupersededTasksAreCancelled) {
+    TaskExecutor executor(1);
+    std::atomic<int> delivered{0};
+    std::string lastResult;
+
+    // Выполняющаяся задача видит отмену и не доставляет результат
+    std::promise<void> started;
+    std::promise<void> superseded;
+    executor.submit<std::string>(TaskPriority::Interactive, "stats",
+        [&](const CancellationToken& token) {
+            started.set_value();
+            superseded.get_future().wait();
+            EXPECT_TRUE(token.isCancelled());
+            return std::string("first");
+        },
+        [&](std::string result) { lastResult = result; ++delivered; });
+    started.get_future().wait();
+
+    // Ожидающая в очереди задача не запускается вовсе
+    std::atomic<bool> queuedRan{false};
+    executor.submit(TaskPriority::Interactive,
+                    [&](const CancellationToken&) { queuedRan = true; }, "stats");
+    executor.submit<std::string>(TaskPriority::Interactive, "stats",
+        [](const CancellationToken&) { return std::string("latest"); },
+        [&](std::string result) { lastResult = result; ++delivered; });
+    superseded.set_value();
+
+    executor.waitIdle();
+    EXPECT_FALSE(queuedRan);
+    EXPECT_EQ(delivered.load(), 1);
+    EXPECT_EQ(lastResult, "latest");
+}
+
+// Test case for results going through the deliverer (Fl::awake in the app)
+TEST(TaskExecutorTest, DeliversResultsThroughDeliverer) {
+    TaskExecutor executor(2);
+    std::mutex mutex;
+    std::vector<std::function<void()>> uiQueue;
+    executor.setDeliverer([&](std::function<void()> action) {
+        std::lock_guard<std::mutex> lock(mutex);
+        uiQueue.push_back(std::move(action));
+    });
+
+    int result = 0;
+    executor.submit<int>(TaskPriority::Export, "",
+        [](const CancellationToken&) { return 42; },
+        [&](int value) { result = value; });
+    executor.waitIdle();
+    EXPECT_EQ(result, 0) << "Result must wait for the UI thread";
+
+    for (auto& action : uiQueue) {
+        action();
+    }
+    EXPECT_EQ(result, 42);
+}
+
+// Test case for interactive tasks running while a long export holds a worker
+TEST(TaskExecutorTest, InteractiveRunsWhileExportIsBusy) {
+    TaskExecutor executor(2);
+    Gate exportGate;
+    executor.submit(TaskPriority::Export, exportGate.task());
+    executor.submit(TaskPriority::Analytics, [](const CancellationToken&) {});
+    exportGate.entered.get_future().wait();
+
+    std::promise<void> answered;
+    executor.submit(TaskPriority::Interactive,
+                    [&](const CancellationToken&) { answered.set_value(); });
+    EXPECT_EQ(answered.get_future().wait_for(std::chrono::seconds(5)),
+              std::future_status::ready);
+
+    // Анализ ждет своей очереди на потоке не для окна
+    EXPECT_EQ(executor.pendingCount(), 1u);
+    exportGate.opened.set_value();
+    executor.waitIdle();
+    EXPECT_EQ(executor.pendingCount(), 0u);
+}
+
+// Test case for waitIdle returning once the only queued task is cancelled
+TEST(TaskExecutorTest, WaitIdleReturnsAfterQueuedTaskIsCancelled) {
+    TaskExecutor executor(1);
+    Gate gate;
+    executor.submit(TaskPriority::Maintenance, gate.task());
+    gate.entered.get_future().wait();
+
+    std::atomic<bool> queuedRan{false};
+    executor.submit(TaskPriority::Export,
+                    [&](const CancellationToken&) { queuedRan = true; }, "export");
+    executor.cancel("export");
+
+    auto idle = std::async(std::launch::async, [&] { executor.waitIdle(); });
+    gate.opened.set_value();
+    EXPECT_EQ(idle.wait_for(std::chrono::seconds(5)), std::future_status::ready);
+    EXPECT_FALSE(queuedRan);
+    EXPECT_EQ(executor.pendingCount(), 0u);
+}
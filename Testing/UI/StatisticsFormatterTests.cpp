@@ -0,0 +1,33 @@
+#include <gtest/gtest.h>
+#include "UI/StatisticsFormatter.h"
+
+// Test case for the empty statistics message
+TEST(StatisticsFormatterTest, EmptyRows) {
+    EXPECT_EQ(formatAppStatistics("testApp", {}), "No key presses recorded for testApp yet.\n");
+}
+
+// Test case for ranked rows and totals
+TEST(StatisticsFormatterTest, RanksRowsAndSumsTotals) {
+    std::vector<ComboStat> rows = {
+        {1, "Ctrl+S", 12, 0},
+        {2, "Ctrl+C", 5, 0},
+    };
+
+    std::string text = formatAppStatistics("testApp", rows);
+    EXPECT_NE(text.find(" 1. Ctrl+S"), std::string::npos) << text;
+    EXPECT_NE(text.find(" 2. Ctrl+C"), std::string::npos) << text;
+    EXPECT_NE(text.find("    12 times"), std::string::npos) << text;
+    EXPECT_NE(text.find("Total combinations: 2"), std::string::npos) << text;
+    EXPECT_NE(text.find("Total key presses: 17"), std::string::npos) << text;
+}
+
+// Test case for the recent section from in-memory statistics
+TEST(StatisticsFormatterTest, FormatsRecentKeys) {
+    EXPECT_EQ(formatRecentKeys(0, {}), "");
+
+    std::string text = formatRecentKeys(100, {{"Ctrl+Z", 7}, {"Ctrl+S", 3}});
+    EXPECT_EQ(text.find("\nRecent (last 100 presses):\n"), 0u) << text;
+    EXPECT_NE(text.find(" 1. Ctrl+Z"), std::string::npos) << text;
+    EXPECT_NE(text.find(" 2. Ctrl+S"), std::string::npos) << text;
+    EXPECT_NE(text.find("     7 times"), std::string::npos) << text;
+}
@@ -0,0 +1,42 @@
+#include "Connection.h"
+
+bool Connection::open(const std::string& path, int flags) {
+    close();
+
+    int rc = sqlite3_open_v2(path.c_str(), &handle, flags, nullptr);
+    if (rc != SQLITE_OK) {
+        std::cerr << "Cannot open database: " << sqlite3_errmsg(handle) << std::endl;
+        sqlite3_close(handle);
+        handle = nullptr;
+        return false;
+    }
+
+    // Короткие блокировки (контрольные точки WAL) пережидаем, а не падаем
+    sqlite3_busy_timeout(handle, 5000);
+    statements.attach(handle);
+    return true;
+}
+
+void Connection::close() {
+    statements.clear();
+    if (handle) {
+        sqlite3_close(handle);
+        handle = nullptr;
+    }
+}
+
+bool Connection::executeScript(const char* sql) {
+    if (!handle) {
+        std::cerr << "Database not initialized!" << std::endl;
+        return false;
+    }
+
+    char* errorMessage = nullptr;
+    if (sqlite3_exec(handle, sql, nullptr, nullptr, &errorMessage) != SQLITE_OK) {
+        std::cerr << "Failed to execute script: "
+                  << (errorMessage ? errorMessage : "unknown error") << std::endl;
+        sqlite3_free(errorMessage);
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,104 @@
+#pragma once
+#include "Statement.h"
+#include <sqlite3.h>
+#include <iostream>
+#include <string>
+#include <utility>
+
+// Одно соединение SQLite со своим кэшем подготовленных выражений.
+// Соединение не потокобезопасно: в каждый момент им пользуется один поток.
+class Connection {
+private:
+  sqlite3 *handle = nullptr;
+  StatementCache statements;
+
+public:
+  Connection() = default;
+  ~Connection() { close(); }
+
+  Connection(const Connection &) = delete;
+  Connection &operator=(const Connection &) = delete;
+
+  bool open(const std::string &path, int flags);
+  void close();
+  bool isOpen() const { return handle != nullptr; }
+  sqlite3 *get() const { return handle; }
+
+  // Скрипт из нескольких выражений (DDL, PRAGMA), мимо кэша
+  bool executeScript(const char *sql);
+
+  // Выражения, подготовленные под старую схему, больше не нужны
+  void clearStatements() { statements.clear(); }
+
+  // Выполнение без результата. Выражение берется из кэша, параметры
+  // типизируются на этапе компиляции.
+  template <typename... Args>
+  bool execute(const char *sql, const Args &...params);
+
+  // Чтение строк: onRow получает типизированные столбцы Columns...
+  template <typename... Columns, typename RowHandler, typename... Args>
+  bool select(const char *sql, RowHandler &&onRow, const Args &...params);
+};
+
+template <typename... Args>
+bool Connection::execute(const char *sql, const Args &...params) {
+  if (!handle) {
+    std::cerr << "Database not initialized!" << std::endl;
+    return false;
+  }
+
+  sqlite3_stmt *stmt = statements.acquire(sql);
+  if (!stmt) {
+    return false;
+  }
+  StatementGuard guard(stmt);
+
+  if (!bindParameters(stmt, params...)) {
+    std::cerr << "Failed to bind parameters: " << sqlite3_errmsg(handle)
+              << std::endl;
+    return false;
+  }
+
+  int rc;
+  while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+  }
+  if (rc != SQLITE_DONE) {
+    std::cerr << "Failed to execute statement: " << sqlite3_errmsg(handle)
+              << std::endl;
+    return false;
+  }
+  return true;
+}
+
+template <typename... Columns, typename RowHandler, typename... Args>
+bool Connection::select(const char *sql, RowHandler &&onRow,
+                        const Args &...params) {
+  if (!handle) {
+    std::cerr << "Database not initialized!" << std::endl;
+    return false;
+  }
+
+  sqlite3_stmt *stmt = statements.acquire(sql);
+  if (!stmt) {
+    return false;
+  }
+  StatementGuard guard(stmt);
+
+  if (!bindParameters(stmt, params...)) {
+    std::cerr << "Failed to bind parameters: " << sqlite3_errmsg(handle)
+              << std::endl;
+    return false;
+  }
+
+  int rc;
+  while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+    invokeRowHandler<Columns...>(stmt, onRow,
+                                 std::index_sequence_for<Columns...>{});
+  }
+  if (rc != SQLITE_DONE) {
+    std::cerr << "Failed to read rows: " << sqlite3_errmsg(handle)
+              << std::endl;
+    return false;
+  }
+  return true;
+}
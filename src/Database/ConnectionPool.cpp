@@ -0,0 +1,61 @@
+#include "ConnectionPool.h"
+
+bool ConnectionPool::open(const std::string& dbPath, size_t poolSize, int openFlags) {
+    close();
+
+    std::lock_guard<std::mutex> lock(mutex);
+    path = dbPath;
+    flags = openFlags;
+    maxIdle = poolSize;
+
+    for (size_t i = 0; i < poolSize; ++i) {
+        auto connection = std::make_unique<Connection>();
+        if (!connection->open(path, flags)) {
+            idle.clear();
+            return false;
+        }
+        idle.push_back(std::move(connection));
+    }
+
+    isOpen = true;
+    return true;
+}
+
+void ConnectionPool::close() {
+    std::lock_guard<std::mutex> lock(mutex);
+    isOpen = false;
+    idle.clear();
+}
+
+ConnectionPool::Lease ConnectionPool::acquire() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!isOpen) {
+            return Lease();
+        }
+        if (!idle.empty()) {
+            auto connection = std::move(idle.back());
+            idle.pop_back();
+            return Lease(this, std::move(connection));
+        }
+    }
+
+    // Открываем вне мьютекса, чтобы не задерживать других читателей
+    auto connection = std::make_unique<Connection>();
+    if (!connection->open(path, flags)) {
+        return Lease();
+    }
+    return Lease(this, std::move(connection));
+}
+
+void ConnectionPool::release(std::unique_ptr<Connection> connection) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (isOpen && idle.size() < maxIdle) {
+        idle.push_back(std::move(connection));
+    }
+}
+
+size_t ConnectionPool::idleCount() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return idle.size();
+}
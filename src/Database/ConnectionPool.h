@@ -0,0 +1,65 @@
+#pragma once
+#include "Connection.h"
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Пул соединений только для чтения. Если свободных соединений нет,
+// открывается новое, поэтому читатели никогда не ждут друг друга.
+// Лишние соединения закрываются при возврате сверх maxIdle.
+class ConnectionPool {
+private:
+  std::string path;
+  int flags = 0;
+  size_t maxIdle = 0;
+  bool isOpen = false;
+
+  std::mutex mutex;
+  std::vector<std::unique_ptr<Connection>> idle;
+
+  void release(std::unique_ptr<Connection> connection);
+
+public:
+  // Соединение, взятое из пула; возвращается в пул в деструкторе
+  class Lease {
+  private:
+    ConnectionPool *pool = nullptr;
+    std::unique_ptr<Connection> connection;
+
+  public:
+    Lease() = default;
+    Lease(ConnectionPool *owner, std::unique_ptr<Connection> conn)
+        : pool(owner), connection(std::move(conn)) {}
+    ~Lease() {
+      if (pool && connection) {
+        pool->release(std::move(connection));
+      }
+    }
+
+    Lease(Lease &&) = default;
+    Lease &operator=(Lease &&) = delete;
+    Lease(const Lease &) = delete;
+    Lease &operator=(const Lease &) = delete;
+
+    explicit operator bool() const { return connection != nullptr; }
+    Connection *operator->() const { return connection.get(); }
+    Connection &operator*() const { return *connection; }
+  };
+
+  ConnectionPool() = default;
+  ~ConnectionPool() { close(); }
+
+  ConnectionPool(const ConnectionPool &) = delete;
+  ConnectionPool &operator=(const ConnectionPool &) = delete;
+
+  // Открывает poolSize соединений заранее
+  bool open(const std::string &dbPath, size_t poolSize,
+            int openFlags = SQLITE_OPEN_READONLY | SQLITE_OPEN_URI);
+  void close();
+
+  // Пустой Lease, если пул закрыт или соединение не открылось
+  Lease acquire();
+
+  size_t idleCount();
+};
@@ -1,180 +1,493 @@
 #include "Database.h"
-#include <iomanip>
+#include <algorithm>
+#include <atomic>
+#include <limits>
 #include <iostream>
-#include <sstream>
-#include <variant>
 
-Database::Database() : db(nullptr) {}
+namespace {
+
+// БД в памяти, общая для соединений процесса: VFS memdb с именем на "/"
+std::string makeInMemoryPath() {
+    static std::atomic<unsigned> counter{0};
+    return "file:/hoka-memdb-" + std::to_string(++counter) + "?vfs=memdb";
+}
+
+} // namespace
+
+Database::Database() {}
 
 Database::~Database() {
-  if (db) {
-    sqlite3_close(db);
-  }
+  // Поток записи сам сбрасывает буфер перед выходом
+  stopWriterThread();
+  readers.close();
+  writer.close();
 }
 
-bool Database::executePreparedQuery(const char* sql, 
-                                   const std::vector<std::variant<std::string, int>>& params, 
-                                   std::function<bool(sqlite3_stmt*)> processor) {
-    if (!db) {
-        std::cerr << "Database not initialized!" << std::endl;
+bool Database::openDatabase(const std::string& dbPath) {
+    if (!writer.open(dbPath, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE | SQLITE_OPEN_URI)) {
         return false;
     }
+    databasePath = dbPath;
+
+    // WAL: читатели работают со снимком и не блокируются записью.
+    // auto_vacuum действует только для нового файла, старые переводятся
+    // явно (convertToIncrementalVacuum)
+    return writer.executeScript("PRAGMA auto_vacuum = INCREMENTAL;"
+                                "PRAGMA journal_mode = WAL;"
+                                "PRAGMA synchronous = NORMAL;");
+}
 
-    sqlite3_stmt* stmt;
-    int rc = sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr);
-    if (rc != SQLITE_OK) {
-        std::cerr << "Failed to prepare statement: " << sqlite3_errmsg(db) << std::endl;
+bool Database::initialize() {
+    return initialize("keypress_stats.db");
+}
+
+bool Database::initialize(const std::string& path) {
+    if (writerThread.joinable()) {
+        return true;
+    }
+
+    bool inMemory = path == kInMemory;
+    if (!openDatabase(inMemory ? makeInMemoryPath() : path)) {
         return false;
     }
+    if (inMemory) {
+        // memdb по умолчанию ограничена 1 ГБ; пусть предел задает память процесса
+        sqlite3_int64 sizeLimit = std::numeric_limits<sqlite3_int64>::max();
+        sqlite3_file_control(writer.get(), "main", SQLITE_FCNTL_SIZE_LIMIT, &sizeLimit);
+    }
 
-    // Биндим параметры с учетом типа
-    for (size_t i = 0; i < params.size(); ++i) {
-        std::visit([stmt, i](auto&& value) {
-            using T = std::decay_t<decltype(value)>;
-            if constexpr (std::is_same_v<T, std::string>) {
-                sqlite3_bind_text(stmt, i + 1, value.c_str(), -1, SQLITE_STATIC);
-            } else if constexpr (std::is_same_v<T, int>) {
-                sqlite3_bind_int(stmt, i + 1, value);
-            }
-        }, params[i]);
+    if (!snapshotPath.empty() && !loadSnapshot()) {
+        return false;
     }
 
-    bool success = true;
-    if (processor) {
-        success = processor(stmt);
-    } else {
-        rc = sqlite3_step(stmt);
-        if (rc != SQLITE_DONE) {
-            std::cerr << "Failed to execute statement: " << sqlite3_errmsg(db) << std::endl;
-            success = false;
+    if (!applyMigrations()) {
+        return false;
+    }
+
+    // Читатели открываются после миграций, когда схема уже на месте
+    if (!readers.open(databasePath, readerPoolSize)) {
+        return false;
+    }
+
+    stopWriter = false;
+    nextCompaction = std::chrono::steady_clock::now() + compactionInterval;
+    nextSnapshot = std::chrono::steady_clock::now() + snapshotInterval;
+    writerThread = std::thread(&Database::writerLoop, this);
+
+    std::cout << "Database initialized successfully" << std::endl;
+    return true;
+}
+
+void Database::updateKeyStatistics(const std::string &appName,
+                                   const std::string &keyCombination,
+                                   sqlite3_int64 timestampMs,
+                                   std::uint64_t journalSequence) {
+    if (timestampMs == 0) {
+        timestampMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+    }
+
+    bool batchFull;
+    {
+        std::lock_guard<std::mutex> lock(writerMutex);
+        auto& entry = *pendingDeltas.try_emplace({appName, keyCombination}).first;
+        entry.second.count++;
+        entry.second.lastPressed = std::max(entry.second.lastPressed, timestampMs);
+        pendingEvents.push_back({&entry, timestampMs});
+        if (sequenceTracker.getTimeout() > 0) {
+            sequenceTracker.observe(appName, keyCombination, timestampMs,
+                [&](const KeySequenceOf<std::string>& sequence) {
+                    auto& delta = pendingSequences[sequence];
+                    delta.count++;
+                    delta.lastPressed = std::max(delta.lastPressed, timestampMs);
+                });
         }
+        pendingJournalSequence = std::max(pendingJournalSequence, journalSequence);
+        batchFull = ++pendingPresses >= flushBatchSize;
+        flushRequested = flushRequested || batchFull;
     }
 
-    sqlite3_finalize(stmt);
-    return success;
+    // Пакет набран - будим поток записи, не дожидаясь таймера
+    if (batchFull) {
+        writerCondition.notify_one();
+    }
 }
 
-bool Database::openDatabase(const std::string& dbPath) {
-    int rc = sqlite3_open(dbPath.c_str(), &db);
-    if (rc != SQLITE_OK) {
-        std::cerr << "Cannot open database: " << sqlite3_errmsg(db) << std::endl;
-        return false;
+void Database::setWriteBufferPolicy(std::chrono::milliseconds interval,
+                                    size_t batchSize) {
+    {
+        std::lock_guard<std::mutex> lock(writerMutex);
+        flushInterval = interval;
+        flushBatchSize = batchSize > 0 ? batchSize : 1;
     }
-    return true;
+    // Будим поток записи, чтобы новый интервал вступил в силу сразу
+    writerCondition.notify_all();
 }
 
-bool Database::createTables() {
-    return executePreparedQuery("CREATE TABLE IF NOT EXISTS key_statistics ("
-        "id INTEGER PRIMARY KEY AUTOINCREMENT,"
-        "app_name TEXT NOT NULL,"
-        "key_combination TEXT NOT NULL,"
-        "press_count INTEGER DEFAULT 1,"
-        "last_pressed TIMESTAMP DEFAULT CURRENT_TIMESTAMP,"
-        "UNIQUE(app_name, key_combination)"
-        ");", {});
-}
-
-std::vector<std::pair<std::string, int>> Database::fetchAppKeyData(const std::string& appName, int limit) {
-    std::vector<std::pair<std::string, int>> data;
-
-    auto processor = [&](sqlite3_stmt* stmt) -> bool {
-        int rc;
-        while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
-            const char *keyCombination =
-                reinterpret_cast<const char *>(sqlite3_column_text(stmt, 0));
-            int pressCount = sqlite3_column_int(stmt, 1);
-            
-            if (keyCombination) {
-                data.emplace_back(std::string(keyCombination), pressCount);
-            }
+void Database::setJournalCommitCallback(std::function<void(std::uint64_t)> callback) {
+    std::lock_guard<std::mutex> lock(writerMutex);
+    onJournalCommitted = std::move(callback);
+}
+
+std::uint64_t Database::getCommittedJournalSequence() {
+    auto reader = readers.acquire();
+    sqlite3_int64 sequence = 0;
+    if (reader) {
+        reader->select<sqlite3_int64>(
+            "SELECT value FROM database_info WHERE key = 'journal_sequence';",
+            [&](sqlite3_int64 value) { sequence = value; });
+    }
+    return static_cast<std::uint64_t>(sequence);
+}
+
+size_t Database::getPendingCount() {
+    std::lock_guard<std::mutex> lock(writerMutex);
+    return pendingPresses;
+}
+
+// Выполняет команду в потоке записи и ждет результата. До запуска и после
+// остановки потока команда выполняется в вызывающем потоке.
+bool Database::runOnWriter(std::function<bool()> command) {
+    std::packaged_task<bool()> task(std::move(command));
+    auto result = task.get_future();
+    {
+        std::lock_guard<std::mutex> lock(writerMutex);
+        if (writerThread.joinable() && !stopWriter) {
+            writeCommands.push(std::move(task));
         }
-        return rc == SQLITE_DONE;
-    };
+    }
 
-    executePreparedQuery("SELECT key_combination, press_count "
-                           "FROM key_statistics "
-                           "WHERE app_name = ? "
-                           "ORDER BY press_count DESC "
-                           "LIMIT ?;", {appName, limit}, processor);
-    return data;
+    if (task.valid()) {
+        task();
+    } else {
+        writerCondition.notify_one();
+    }
+    return result.get();
 }
 
-std::string Database::formatStatisticsOutput(const std::vector<std::pair<std::string, int>>& data, 
-                                           const std::string& appName) {
-    std::stringstream ss;
-    
-    if (data.empty()) {
-        ss << "No key presses recorded for " << appName << " yet.\n";
-        return ss.str();
+sqlite3_int64 Database::resolveId(std::unordered_map<std::string, sqlite3_int64>& cache,
+                                 const char* insertSql, const char* selectSql,
+                                 const std::string& value) {
+    auto it = cache.find(value);
+    if (it != cache.end()) {
+        return it->second;
     }
 
-    int rank = 1;
-    int totalPresses = 0;
-    
-    for (const auto& [keyCombination, pressCount] : data) {
-        totalPresses += pressCount;
-        ss << std::setw(2) << rank << ". " << std::setw(25) << std::left
-           << keyCombination << std::setw(6) << std::right << pressCount
-           << " times\n";
-        rank++;
+    sqlite3_int64 id = 0;
+    if (writer.execute(insertSql, value)) {
+        writer.select<sqlite3_int64>(selectSql, [&](sqlite3_int64 rowId) { id = rowId; }, value);
+    }
+    if (id != 0) {
+        cache.emplace(value, id);
     }
+    return id;
+}
 
-    ss << "\n" << std::string(40, '-') << "\n";
-    ss << "Total combinations: " << data.size() << "\n";
-    ss << "Total key presses: " << totalPresses << "\n";
-    
-    return ss.str();
+sqlite3_int64 Database::resolveAppId(const std::string& appName) {
+    return resolveId(appIds,
+        "INSERT OR IGNORE INTO apps (name) VALUES (?);",
+        "SELECT id FROM apps WHERE name = ?;", appName);
 }
 
-bool Database::initialize() {
-    if (!openDatabase("keypress_stats.db")) {
-        return false;
+sqlite3_int64 Database::resolveComboId(const std::string& keyCombination) {
+    return resolveId(comboIds,
+        // Маска модификаторов: Ctrl=1, Shift=2, Alt=4, Win=8 (ModifierMask)
+        "INSERT OR IGNORE INTO combos (combo, modifiers) VALUES (?1, "
+        "(instr(?1, 'Ctrl+') > 0) + (instr(?1, 'Shift+') > 0) * 2 + "
+        "(instr(?1, 'Alt+') > 0) * 4 + (instr(?1, 'Win+') > 0) * 8);",
+        "SELECT id FROM combos WHERE combo = ?;", keyCombination);
+}
+
+bool Database::flush() {
+    return runOnWriter([this] { return writePendingDeltas(); });
+}
+
+// Выполняется в потоке записи
+bool Database::writePendingDeltas() {
+    PendingMap batch;
+    std::vector<PendingEvent> events;
+    PendingSequenceMap sequences;
+    std::uint64_t journalSequence;
+    std::function<void(std::uint64_t)> onCommitted;
+    {
+        std::lock_guard<std::mutex> lock(writerMutex);
+        batch.swap(pendingDeltas);
+        events.swap(pendingEvents);
+        sequences.swap(pendingSequences);
+        pendingPresses = 0;
+        journalSequence = pendingJournalSequence;
+        pendingJournalSequence = 0;
+        onCommitted = onJournalCommitted;
     }
-    
-    if (!createTables()) {
+
+    if (batch.empty()) {
+        return true;
+    }
+
+    // Все приращения пакета - одна транзакция и одна синхронизация с диском
+    bool success = writer.isOpen() && writer.execute("BEGIN;");
+    for (auto it = batch.begin(); success && it != batch.end(); ++it) {
+        const auto& [appName, keyCombination] = it->first;
+        auto& delta = it->second;
+        delta.appId = resolveAppId(appName);
+        delta.comboId = resolveComboId(keyCombination);
+
+        success = delta.appId != 0 && delta.comboId != 0 && writer.execute(
+            "INSERT INTO key_counts (app_id, combo_id, press_count, last_pressed) "
+            "VALUES (?, ?, ?, ?) "
+            "ON CONFLICT(app_id, combo_id) DO UPDATE SET "
+            "press_count = press_count + excluded.press_count, "
+            "last_pressed = MAX(last_pressed, excluded.last_pressed);",
+            delta.appId, delta.comboId, delta.count, delta.lastPressed);
+    }
+    success = success && writeEventBatch(events);
+    success = success && writeHeatmapBatch(events);
+    success = success && writeSequenceBatch(sequences);
+    // Номер журнала фиксируется в той же транзакции: при восстановлении
+    // записи до него не применяются повторно
+    if (success && journalSequence != 0) {
+        success = writer.execute(
+            "INSERT INTO database_info (key, value) VALUES ('journal_sequence', ?) "
+            "ON CONFLICT(key) DO UPDATE SET value = excluded.value;",
+            sqlite3_int64(journalSequence));
+    }
+    if (success) {
+        success = writer.execute("COMMIT;");
+    }
+
+    if (!success) {
+        if (writer.isOpen()) {
+            writer.execute("ROLLBACK;");
+        }
+        // Идентификаторы из откаченной транзакции недействительны
+        appIds.clear();
+        comboIds.clear();
+
+        // Возвращаем приращения в буфер, чтобы не потерять нажатия
+        std::lock_guard<std::mutex> lock(writerMutex);
+        for (const auto& [key, delta] : batch) {
+            auto& pending = pendingDeltas[key];
+            pending.count += delta.count;
+            pending.lastPressed = std::max(pending.lastPressed, delta.lastPressed);
+            pendingPresses += delta.count;
+        }
+        for (const auto& event : events) {
+            auto& entry = *pendingDeltas.find(event.entry->first);
+            pendingEvents.push_back({&entry, event.timestamp});
+        }
+        for (const auto& [sequence, delta] : sequences) {
+            auto& pending = pendingSequences[sequence];
+            pending.count += delta.count;
+            pending.lastPressed = std::max(pending.lastPressed, delta.lastPressed);
+        }
+        pendingJournalSequence = std::max(pendingJournalSequence, journalSequence);
         return false;
     }
-    
-    std::cout << "Database initialized successfully" << std::endl;
+
+    // Пакет в БД - соответствующие записи журнала больше не нужны.
+    // Со снимками они нужны до следующего снимка (writeSnapshot).
+    if (journalSequence != 0 && !snapshotPath.empty()) {
+        unsnapshottedJournalSequence = journalSequence;
+    } else if (journalSequence != 0 && onCommitted) {
+        onCommitted(journalSequence);
+    }
     return true;
 }
 
-void Database::updateKeyStatistics(const std::string &appName,
-                                   const std::string &keyCombination) {
-    executePreparedQuery("INSERT OR REPLACE INTO key_statistics (app_name, key_combination, "
-        "press_count, last_pressed) "
-        "VALUES (?, ?, COALESCE((SELECT press_count FROM key_statistics "
-        "WHERE app_name = ? AND key_combination = ?) + 1, 1), "
-        "CURRENT_TIMESTAMP);", {appName, keyCombination, appName, keyCombination});
+void Database::writerLoop() {
+    std::unique_lock<std::mutex> lock(writerMutex);
+    while (true) {
+        if (!stopWriter && !flushRequested && writeCommands.empty()) {
+            // Пока идет перенос старой схемы, просыпаемся часто и переносим
+            // по порции. Пробуждение раньше срока (смена политики) дает
+            // лишний, но безвредный сброс
+            // То же для незаконченного сжатия; плановое сжатие не
+            // откладывается дольше, чем до своего срока
+            auto wait = legacyMigrationPending || compactionBacklog
+                ? std::min(flushInterval, std::chrono::milliseconds(10))
+                : flushInterval;
+            auto now = std::chrono::steady_clock::now();
+            auto untilCompaction = std::chrono::duration_cast<std::chrono::milliseconds>(
+                nextCompaction - now);
+            wait = std::min(wait, untilCompaction);
+            if (!snapshotPath.empty()) {
+                wait = std::min(wait, std::chrono::duration_cast<std::chrono::milliseconds>(
+                    nextSnapshot - now));
+            }
+            wait = std::max(std::chrono::milliseconds(0), wait);
+            writerCondition.wait_for(lock, wait);
+        }
+
+        std::queue<std::packaged_task<bool()>> commands;
+        commands.swap(writeCommands);
+        bool stopping = stopWriter;
+        bool compactionDue = compactionBacklog ||
+            std::chrono::steady_clock::now() >= nextCompaction;
+        bool snapshotDue = !snapshotPath.empty() &&
+            std::chrono::steady_clock::now() >= nextSnapshot;
+        flushRequested = false;
+        lock.unlock();
+
+        // Команды и сброс выполняются без writerMutex: нажатия продолжают
+        // копиться в буфере
+        for (; !commands.empty(); commands.pop()) {
+            commands.front()();
+        }
+        writePendingDeltas();
+        if (legacyMigrationPending && !stopping) {
+            migrateLegacyChunk(1000);
+        } else if (compactionDue && !stopping) {
+            compactStep();
+        }
+        if (snapshotDue && !stopping) {
+            writeSnapshot();
+        }
+
+        lock.lock();
+        if (stopping && writeCommands.empty()) {
+            break;
+        }
+    }
+
+    // Последний снимок - после финального сброса буфера
+    lock.unlock();
+    if (!snapshotPath.empty()) {
+        writeSnapshot();
+    }
 }
 
-std::string Database::getAppStatistics(const std::string &appName, int limit) {
-    auto data = fetchAppKeyData(appName, limit);
-    if (data.empty() && !db) {
-        return "Database not initialized!";
+void Database::stopWriterThread() {
+    {
+        std::lock_guard<std::mutex> lock(writerMutex);
+        stopWriter = true;
+    }
+    writerCondition.notify_all();
+
+    if (writerThread.joinable()) {
+        writerThread.join();
     }
-    return formatStatisticsOutput(data, appName);
 }
 
 std::vector<std::string> Database::getAllApps() {
     std::vector<std::string> apps;
-    auto processor = [&](sqlite3_stmt* stmt) -> bool {
-        int rc;
-        while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
-            const char *appName =
-                reinterpret_cast<const char *>(sqlite3_column_text(stmt, 0));
-            if (appName) {
-                apps.push_back(std::string(appName));
-            }
-        }
-        return rc == SQLITE_DONE;
-    };
+    auto reader = readers.acquire();
+    if (!reader) {
+        return apps;
+    }
 
-    executePreparedQuery("SELECT DISTINCT app_name FROM key_statistics "
-                           "ORDER BY app_name;", {}, processor);
+    reader->select<std::string_view>("SELECT name FROM apps "
+                           "WHERE EXISTS (SELECT 1 FROM key_counts WHERE app_id = apps.id) "
+                           "ORDER BY name;",
+        [&](std::string_view appName) {
+            apps.emplace_back(appName);
+        });
     return apps;
 }
 
+ComboStatsPage Database::queryComboStats(const ComboStatsQuery& query) {
+    auto reader = readers.acquire();
+    if (!reader) {
+        return {};
+    }
+
+    sqlite3_int64 appId = 0;
+    reader->select<sqlite3_int64>("SELECT id FROM apps WHERE name = ?;",
+        [&](sqlite3_int64 id) { appId = id; }, query.appName);
+    if (appId == 0) {
+        return {};
+    }
+
+    if (query.fromMs || query.toMs) {
+        return queryRangeComboStats(*reader, appId, query);
+    }
+    return queryLifetimeComboStats(*reader, appId, query);
+}
+
+// Счетчики за все время: поиск по индексу
+// (app_id, press_count DESC, combo_id, last_pressed) с продолжения курсора
+ComboStatsPage Database::queryLifetimeComboStats(Connection& connection, sqlite3_int64 appId,
+                                                 const ComboStatsQuery& query) {
+    ComboStatsPage page;
+    int limit = pageFetchLimit(query.pageSize);
+    int mask = static_cast<int>(query.modifiers);
+    int exact = query.exactModifiers ? 1 : 0;
+
+    auto onRow = [&](sqlite3_int64 comboId, std::string_view combo,
+                     sqlite3_int64 pressCount, sqlite3_int64 lastPressed) {
+        page.rows.push_back({comboId, std::string(combo), pressCount, lastPressed});
+    };
+
+    if (query.after) {
+        connection.select<sqlite3_int64, std::string_view, sqlite3_int64, sqlite3_int64>(
+            "SELECT k.combo_id, c.combo, k.press_count, k.last_pressed "
+            "FROM key_counts k JOIN combos c ON c.id = k.combo_id "
+            "WHERE k.app_id = ?1 "
+            "AND (c.modifiers & ?2) = ?2 AND (?3 = 0 OR c.modifiers = ?2) "
+            "AND k.press_count <= ?4 AND (k.press_count < ?4 OR k.combo_id > ?5) "
+            "ORDER BY k.press_count DESC, k.combo_id ASC LIMIT ?6;",
+            onRow, appId, mask, exact, sqlite3_int64(query.after->pressCount),
+            sqlite3_int64(query.after->comboId), limit);
+    } else {
+        connection.select<sqlite3_int64, std::string_view, sqlite3_int64, sqlite3_int64>(
+            "SELECT k.combo_id, c.combo, k.press_count, k.last_pressed "
+            "FROM key_counts k JOIN combos c ON c.id = k.combo_id "
+            "WHERE k.app_id = ?1 "
+            "AND (c.modifiers & ?2) = ?2 AND (?3 = 0 OR c.modifiers = ?2) "
+            "ORDER BY k.press_count DESC, k.combo_id ASC LIMIT ?4;",
+            onRow, appId, mask, exact, limit);
+    }
+
+    if (query.pageSize > 0 && page.rows.size() > query.pageSize) {
+        page.rows.pop_back();
+        page.next = ComboStatsCursor{page.rows.back().pressCount, page.rows.back().comboId};
+    }
+    return page;
+}
+
+// Выполняется в потоке записи
+bool Database::deleteAllStatistics() {
+    // Сначала сбрасываем буфер, чтобы отложенные нажатия не пережили очистку
+    writePendingDeltas();
+    bool success = writer.execute("BEGIN;")
+        && writer.execute("DELETE FROM key_counts;")
+        && writer.execute("DELETE FROM key_sequences;")
+        && writer.execute("DELETE FROM heatmap;")
+        && writer.execute("DELETE FROM key_events;")
+        && writer.execute("DELETE FROM rollup_minute;")
+        && writer.execute("DELETE FROM rollup_hour;")
+        && writer.execute("DELETE FROM rollup_day;")
+        && writer.execute("DELETE FROM export_watermarks;")
+        && writer.execute("DELETE FROM merge_counts;")
+        && writer.execute("DELETE FROM merge_rollups;")
+        && writer.execute("DELETE FROM merge_heatmap;")
+        && writer.execute("DELETE FROM merge_sources;")
+        && writer.execute("DELETE FROM combos;")
+        && writer.execute("DELETE FROM apps;")
+        // Для БД, в которые эта сливается: счетчики начались заново
+        && writer.execute(
+            "INSERT INTO database_info (key, value) VALUES ('clear_epoch', 1) "
+            "ON CONFLICT(key) DO UPDATE SET value = CAST(value AS INTEGER) + 1;");
+    if (success && legacyMigrationPending) {
+        success = writer.execute("DELETE FROM legacy_key_statistics;");
+    }
+    success = success && writer.execute("COMMIT;");
+    if (!success && writer.isOpen()) {
+        writer.execute("ROLLBACK;");
+    }
+
+    appIds.clear();
+    comboIds.clear();
+    {
+        std::lock_guard<std::mutex> lock(writerMutex);
+        sequenceTracker.reset();
+    }
+    if (success && legacyMigrationPending) {
+        // Перенос дойдет до пустой таблицы и удалит ее
+        migrateLegacyChunk(1);
+    }
+    return success;
+}
+
 bool Database::clearStatistics() {
-    return executePreparedQuery("DELETE FROM key_statistics;", {});
-}
\ No newline at end of file
+    return runOnWriter([this] { return deleteAllStatistics(); });
+}
@@ -1,42 +1,310 @@
 #pragma once
+#include "Connection.h"
+#include "ConnectionPool.h"
+#include "Models/ComboStats.h"
+#include "Models/ExportRecord.h"
+#include "Models/HistoryPage.h"
+#include "Models/KeySequence.h"
+#include "Models/MergeResult.h"
+#include "Models/RetentionPolicy.h"
+#include "Models/SequenceMiner.h"
+#include "Models/UsageHeatmap.h"
 #include <sqlite3.h>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <condition_variable>
+#include <future>
+#include <mutex>
+#include <queue>
 #include <string>
+#include <thread>
+#include <unordered_map>
 #include <vector>
-#include <variant>
 #include <functional>
 #include <utility>
 
+// Хранилище статистики. Все записи выполняет один поток записи через
+// очередь команд; чтение идет через пул соединений только для чтения
+// (режим WAL), поэтому читатели не ждут ни писателя, ни друг друга.
 class Database {
 private:
-  sqlite3 *db;
+  std::string databasePath;
+
+  // Соединение для записи принадлежит потоку записи
+  Connection writer;
+  ConnectionPool readers;
+  size_t readerPoolSize = 2;
+
+  // Ключ буфера отложенной записи: (приложение, комбинация)
+  using PendingKey = std::pair<std::string, std::string>;
+  struct PendingKeyHash {
+    size_t operator()(const PendingKey &key) const {
+      size_t h = std::hash<std::string>()(key.first);
+      return h ^ (std::hash<std::string>()(key.second) + 0x9e3779b9 +
+                  (h << 6) + (h >> 2));
+    }
+  };
+
+  // Накопленное приращение и время последнего нажатия (мс от эпохи).
+  // Идентификаторы заполняются потоком записи при сбросе.
+  struct PendingDelta {
+    int count = 0;
+    sqlite3_int64 lastPressed = 0;
+    sqlite3_int64 appId = 0;
+    sqlite3_int64 comboId = 0;
+  };
+  using PendingMap = std::unordered_map<PendingKey, PendingDelta, PendingKeyHash>;
+
+  // Отдельное нажатие для журнала событий. Ссылается на узел
+  // pendingDeltas (адреса узлов unordered_map стабильны), чтобы не
+  // копировать строки на каждое нажатие.
+  struct PendingEvent {
+    PendingMap::value_type *entry;
+    sqlite3_int64 timestamp;
+  };
+
+  // Последовательности комбинаций (Sequences.cpp): цепочка последних
+  // нажатий и приращения биграмм/триграмм, сбрасываемые тем же пакетом
+  using PendingSequenceMap = std::unordered_map<KeySequenceOf<std::string>, PendingDelta,
+                                                KeySequenceHash<std::string>>;
+  SequenceTracker<std::string> sequenceTracker;
+  PendingSequenceMap pendingSequences;
+
+  // Буфер отложенной записи: накопленные приращения счетчиков и
+  // события, которые сбрасываются в БД одной транзакцией
+  PendingMap pendingDeltas;
+  std::vector<PendingEvent> pendingEvents;
+  size_t pendingPresses = 0;
+  // Наибольший номер записи журнала нажатий среди буферизованных
+  std::uint64_t pendingJournalSequence = 0;
+  std::function<void(std::uint64_t)> onJournalCommitted;
+  std::chrono::milliseconds flushInterval{1000};
+  size_t flushBatchSize = 256;
+  bool flushRequested = false;
+
+  // Очередь команд потока записи. writerMutex защищает очередь,
+  // буфер и флаги; само соединение используется без блокировок.
+  std::queue<std::packaged_task<bool()>> writeCommands;
+  std::mutex writerMutex;
+  std::condition_variable writerCondition;
+  std::thread writerThread;
+  bool stopWriter = false;
+
+  // Кэш идентификаторов словарей apps/combos (только поток записи)
+  std::unordered_map<std::string, sqlite3_int64> appIds;
+  std::unordered_map<std::string, sqlite3_int64> comboIds;
+
+  // Перенос строк схемы v1 идет порциями в потоке записи
+  std::atomic<bool> legacyMigrationPending{false};
+
+  // Фоновое сжатие: удаление устаревших уровней порциями и возврат
+  // страниц файлу. Настройки защищены writerMutex.
+  RetentionPolicy retention;
+  std::chrono::milliseconds compactionInterval{60000};
+  size_t compactionChunkRows = 5000;
+  std::chrono::steady_clock::time_point nextCompaction;
+  std::atomic<bool> compactionBacklog{false};
+
+  // Снимки основной БД на диск (Snapshot.cpp). Путь задается до
+  // initialize(); номер журнала, попавший в БД, но еще не в снимок,
+  // принадлежит потоку записи.
+  std::string snapshotPath;
+  std::chrono::milliseconds snapshotInterval{60000};
+  std::chrono::steady_clock::time_point nextSnapshot;
+  std::uint64_t unsnapshottedJournalSequence = 0;
+
+  // Пояс тепловой карты (Heatmap.cpp); только поток записи
+  HeatmapClock heatmapClock;
 
-  // Общий вспомогательный метод для разных запросов
-  bool executePreparedQuery(const char* sql, 
-                           const std::vector<std::variant<std::string, int>>& params, 
-                           std::function<bool(sqlite3_stmt*)> processor = nullptr);
-  
   // Методы для инициализации
   bool openDatabase(const std::string& dbPath);
-  bool createTables();
-  
+
+  // Версионные миграции схемы (Migrations.cpp)
+  int getSchemaVersion();
+  bool applyMigrations();
+  bool migrateLegacyChunk(int maxRows);
+
+  // Идентификаторы словарей, запись создается при первом обращении
+  sqlite3_int64 resolveId(std::unordered_map<std::string, sqlite3_int64> &cache,
+                          const char *insertSql, const char *selectSql,
+                          const std::string &value);
+
+  sqlite3_int64 resolveAppId(const std::string &appName);
+  sqlite3_int64 resolveComboId(const std::string &keyCombination);
+
+  // Поток записи и буфер отложенной записи
+  void writerLoop();
+  void stopWriterThread();
+  bool runOnWriter(std::function<bool()> command);
+  bool writePendingDeltas();
+  bool deleteAllStatistics();
+
+  // Журнал событий и свертки по минутам/часам/дням, в том числе
+  // свертки источника слияния (TimeSeries.cpp)
+  bool writeEventBatch(const std::vector<PendingEvent> &events);
+  bool mergeSourceRollups(sqlite3_int64 sourceId);
+
+  // Тепловая карта "час x день недели" (Heatmap.cpp): ячейки событий
+  // пакета, событий, влитых пачкой, и карты источника (слияние)
+  bool writeHeatmapBatch(const std::vector<PendingEvent> &events);
+  bool heatmapEventsAfter(sqlite3_int64 afterEventId);
+  bool mergeSourceHeatmap(sqlite3_int64 sourceId);
+  bool seedHeatmap();
+
+  // Счетчики последовательностей пакета (Sequences.cpp)
+  bool writeSequenceBatch(const PendingSequenceMap &sequences);
+
+  // Удаление устаревших данных по RetentionPolicy (Retention.cpp)
+  bool compactStep();
+
+  // Слияние подключенной БД merge_src (Merge.cpp)
+  bool mergeAttachedSource(const std::string &sourcePath, MergeResult &result);
+
+  // Копирование через sqlite3_backup (Snapshot.cpp)
+  bool loadSnapshot();
+  bool writeSnapshot();
+
   // Методы работы с данными
-  std::vector<std::pair<std::string, int>> fetchAppKeyData(const std::string& appName, int limit);
-  std::string formatStatisticsOutput(const std::vector<std::pair<std::string, int>>& data, 
-                                    const std::string& appName);
+  ComboStatsPage queryLifetimeComboStats(Connection &connection, sqlite3_int64 appId,
+                                         const ComboStatsQuery &query);
+  // За окно времени - по сверткам одним запросом (TimeSeries.cpp)
+  ComboStatsPage queryRangeComboStats(Connection &connection, sqlite3_int64 appId,
+                                      const ComboStatsQuery &query);
 
 public:
+  // Путь для initialize(): основная БД только в памяти процесса
+  static constexpr const char *kInMemory = ":memory:";
+
   Database();
   ~Database();
 
   // Основные модифицирующие методы
   bool initialize();
+  // path - файл, URI SQLite или kInMemory. Каждая БД kInMemory своя
+  // (memdb с уникальным именем), ее видят только читатели этого объекта.
+  bool initialize(const std::string &path);
+  // timestampMs - время нажатия в мс от эпохи (UTC), 0 = сейчас;
+  // journalSequence - номер нажатия в журнале перед БД (EventJournal)
   void updateKeyStatistics(const std::string &appName,
-                           const std::string &keyCombination);
+                           const std::string &keyCombination,
+                           sqlite3_int64 timestampMs = 0,
+                           std::uint64_t journalSequence = 0);
   bool clearStatistics();
 
+  // Настройка буфера: сброс по таймеру interval или по накоплении
+  // batchSize нажатий (что наступит раньше)
+  void setWriteBufferPolicy(std::chrono::milliseconds interval,
+                            size_t batchSize);
+  // Вызывается в потоке записи после фиксации пакета с наибольшим
+  // номером журнала в нем; записи журнала до него можно освобождать
+  void setJournalCommitCallback(std::function<void(std::uint64_t)> callback);
+  // Наибольший номер журнала, зафиксированный в БД
+  std::uint64_t getCommittedJournalSequence();
+  // Принудительный сброс буфера в БД (ждет фиксации)
+  bool flush();
+  size_t getPendingCount();
+
+  // Последовательности комбинаций: нажатия подряд с паузами не длиннее
+  // timeout складываются в биграммы и триграммы (0 - не считать).
+  // Счетчики пишутся в той же транзакции, что и нажатия.
+  void setSequenceTimeout(std::chrono::milliseconds timeout);
+
+  // Самые частые последовательности: length 2 или 3 (0 - обе), пустое
+  // имя - по всем приложениям. Выдача по индексу, без прохода по журналу.
+  std::vector<KeySequence> getTopSequences(size_t limit = 10,
+                                           const std::string &appName = "",
+                                           size_t length = 0);
+
+  // Сроки хранения журнала и сверток. Сжатие идет в потоке записи
+  // раз в interval порциями по chunkRows строк на уровень, плюс
+  // PRAGMA incremental_vacuum, чтобы файл уменьшался без долгих пауз.
+  void setRetentionPolicy(const RetentionPolicy &policy);
+  void setCompactionSchedule(std::chrono::milliseconds interval, size_t chunkRows);
+  // Синхронное сжатие до конца (ждет завершения)
+  bool compactNow();
+  // Перевод файла, созданного без auto_vacuum, в режим INCREMENTAL полным
+  // VACUUM. Переписывает весь файл и на это время останавливает запись,
+  // поэтому сжатие само его не запускает; без перевода удаленное
+  // переиспользуется внутри файла, но файл не уменьшается.
+  bool convertToIncrementalVacuum();
+
+  // Снимки основной БД в файл path онлайн-копированием (sqlite3_backup):
+  // раз в interval и при закрытии; initialize() загружает снимок, если
+  // основная БД пуста. Так БД в памяти теряет при падении не больше
+  // interval, а запись не касается диска. Подтверждение журнала нажатий
+  // откладывается до снимка, поэтому с журналом не теряется ничего.
+  // Пустой путь выключает снимки; действует при следующем initialize().
+  void setSnapshotPolicy(const std::string &path, std::chrono::milliseconds interval);
+  // Сброс буфера и внеочередной снимок (ждет завершения)
+  bool snapshotNow();
+
+  // Размер пула читателей; действует при следующем initialize()
+  void setReaderPoolSize(size_t size) { readerPoolSize = size; }
+
+  // Данные старой схемы переносятся в фоне и становятся видны по мере
+  // переноса; finishMigration дожимает перенос синхронно
+  bool isMigrationComplete() const { return !legacyMigrationPending; }
+  bool finishMigration();
+
   // Немодифицирующие методы для работы с приложениями
-  bool isConnected() const { return db != nullptr; }
-  std::string getAppStatistics(const std::string &appName,
-                               int limit = -1); // -1 = без ограничений
+  bool isConnected() const { return writer.isOpen(); }
   std::vector<std::string> getAllApps();
-};
\ No newline at end of file
+
+  // Статистика комбинаций приложения: типизированные строки,
+  // постраничная выдача по ключу (pressCount DESC, comboId ASC),
+  // необязательные фильтры по времени и модификаторам
+  ComboStatsPage queryComboStats(const ComboStatsQuery &query);
+
+  // Число нажатий в [fromMs, toMs); пустое имя - без фильтра.
+  // Диапазон собирается из самых крупных сверток, которые в него
+  // помещаются, и лишь края читаются из сырого журнала. За пределами
+  // срока хранения точность ограничена оставшимся уровнем сверток.
+  sqlite3_int64 countPresses(sqlite3_int64 fromMs, sqlite3_int64 toMs,
+                             const std::string &appName = "",
+                             const std::string &keyCombination = "");
+
+  // Тепловая карта нажатий по часам недели в местном времени момента
+  // записи; пустые имена - по всем приложениям/комбинациям. Читается
+  // из сверток heatmap, не из журнала. utcOffset - фиксированный пояс
+  // для новых нажатий (пусто - системный местный); заданный до
+  // initialize(), он же действует при первичном заполнении карты.
+  // Карта базы, перешедшей на схему v8, заполняется тем, что тогда
+  // хранилось: журналом, минутными и часовыми свертками. Раньше срока
+  // хранения часовых сверток (год по умолчанию) нажатий в ней нет, а по
+  // часовым сверткам час определен с точностью до их границ.
+  void setHeatmapUtcOffset(std::optional<std::chrono::minutes> utcOffset);
+  UsageHeatmap getUsageHeatmap(const std::string &appName = "",
+                               const std::string &keyCombination = "");
+
+  // Страница журнала нажатий (History.cpp) в порядке (время, id) с
+  // продолжения query.after; память - на одну страницу. Все страницы
+  // одного прохода читаются по границе lastEventId первой, поэтому
+  // нажатия, записанные во время прохода, в него не попадают.
+  bool readHistoryPage(const HistoryQuery &query, HistoryPage &page);
+  // Время первого и последнего нажатия в журнале; {0, 0} - журнал пуст
+  std::pair<std::int64_t, std::int64_t> getHistoryTimeRange();
+
+  // Потоковый проход для выгрузки (Export.cpp): один упорядоченный курсор
+  // на снимке, строки отдаются по одной и нигде не накапливаются.
+  // lastEventId - последний id журнала в снимке, годится как отметка.
+  bool scanExportRecords(const ExportFilter &filter,
+                         const std::function<void(const ExportRecord &)> &onRecord,
+                         sqlite3_int64 &lastEventId);
+
+  // Именованные отметки "выгружено до события N"; 0 - выгрузок не было
+  sqlite3_int64 getExportWatermark(const std::string &name);
+  bool setExportWatermark(const std::string &name, sqlite3_int64 eventId);
+
+  // Слияние статистики других БД (например, с других машин) в эту:
+  // ATTACH и несколько запросов над множествами строк в одной транзакции
+  // на источник. Счетчики, свертки всех уровней и тепловая карта
+  // вливаются из одноименных таблиц источника, поэтому история старше
+  // срока хранения его журнала тоже переносится; журнал копируется
+  // только в том объеме, что источник еще хранит. Для каждого источника
+  // хранятся влитые значения и отметка журнала, поэтому повторное
+  // слияние добавляет только новое. Карта источника до схемы v8
+  // строится по его журналу.
+  MergeResult mergeDatabase(const std::string &sourcePath);
+  MergeResult mergeDatabases(const std::vector<std::string> &sourcePaths);
+};
@@ -0,0 +1,115 @@
+#include "Database.h"
+#include <algorithm>
+#include <limits>
+
+namespace {
+
+// Итоги за все время: приложения по имени (уникальный индекс), внутри -
+// индекс idx_key_counts_app_rank, поэтому сортировки в памяти нет.
+// CROSS JOIN закрепляет этот порядок обхода за планировщиком.
+const char* kLifetimeTotalsSql =
+    "SELECT a.name, c.combo, k.press_count, k.last_pressed "
+    "FROM apps a CROSS JOIN key_counts k ON k.app_id = a.id "
+    "JOIN combos c ON c.id = k.combo_id "
+    "WHERE (?1 = '' OR a.name = ?1) "
+    "ORDER BY a.name, k.press_count DESC, k.combo_id;";
+
+// Итоги за окно или с отметки: группировка журнала. Промежуточный
+// результат - по числу пар (приложение, комбинация), а не событий.
+const char* kEventTotalsSql =
+    "SELECT a.name, c.combo, COUNT(*) AS presses, MAX(e.ts) "
+    "FROM key_events e JOIN apps a ON a.id = e.app_id "
+    "JOIN combos c ON c.id = e.combo_id "
+    "WHERE e.id > ?1 AND e.id <= ?2 AND e.ts >= ?3 AND e.ts < ?4 "
+    "AND (?5 = '' OR a.name = ?5) "
+    "GROUP BY e.app_id, e.combo_id "
+    "ORDER BY a.name, presses DESC, e.combo_id;";
+
+// Отдельные нажатия: без окна - по id с отметки, с окном - по индексу ts
+const char* kEventsByIdSql =
+    "SELECT a.name, c.combo, e.ts "
+    "FROM key_events e JOIN apps a ON a.id = e.app_id "
+    "JOIN combos c ON c.id = e.combo_id "
+    "WHERE e.id > ?1 AND e.id <= ?2 AND (?3 = '' OR a.name = ?3) "
+    "ORDER BY e.id;";
+
+const char* kEventsByTimeSql =
+    "SELECT a.name, c.combo, e.ts "
+    "FROM key_events e JOIN apps a ON a.id = e.app_id "
+    "JOIN combos c ON c.id = e.combo_id "
+    "WHERE e.ts >= ?3 AND e.ts < ?4 AND e.id > ?1 AND e.id <= ?2 "
+    "AND (?5 = '' OR a.name = ?5) "
+    "ORDER BY e.ts, e.id;";
+
+} // namespace
+
+bool Database::scanExportRecords(const ExportFilter& filter,
+                                 const std::function<void(const ExportRecord&)>& onRecord,
+                                 sqlite3_int64& lastEventId) {
+    auto reader = readers.acquire();
+    if (!reader) {
+        return false;
+    }
+
+    bool hasRange = filter.fromMs || filter.toMs;
+    sqlite3_int64 fromMs = filter.fromMs.value_or(std::numeric_limits<sqlite3_int64>::min() / 2);
+    sqlite3_int64 toMs = filter.toMs.value_or(std::numeric_limits<sqlite3_int64>::max() / 2);
+    sqlite3_int64 afterId = filter.afterEventId;
+
+    auto onTotal = [&](std::string_view app, std::string_view combo,
+                       sqlite3_int64 pressCount, sqlite3_int64 lastPressed) {
+        onRecord(ExportRecord{app, combo, pressCount, lastPressed});
+    };
+    auto onEvent = [&](std::string_view app, std::string_view combo, sqlite3_int64 ts) {
+        onRecord(ExportRecord{app, combo, 1, ts});
+    };
+
+    // Граница журнала и сами строки читаются из одного снимка, чтобы
+    // отметка точно соответствовала выгруженному
+    bool success = reader->execute("BEGIN;");
+    lastEventId = afterId;
+    success = success && reader->select<sqlite3_int64>(
+        "SELECT COALESCE(MAX(id), 0) FROM key_events;",
+        [&](sqlite3_int64 id) { lastEventId = std::max(id, afterId); });
+
+    if (success) {
+        if (filter.content == ExportContent::Events) {
+            success = hasRange
+                ? reader->select<std::string_view, std::string_view, sqlite3_int64>(
+                      kEventsByTimeSql, onEvent, afterId, lastEventId, fromMs, toMs, filter.appName)
+                : reader->select<std::string_view, std::string_view, sqlite3_int64>(
+                      kEventsByIdSql, onEvent, afterId, lastEventId, filter.appName);
+        } else if (hasRange || afterId > 0) {
+            success = reader->select<std::string_view, std::string_view, sqlite3_int64, sqlite3_int64>(
+                kEventTotalsSql, onTotal, afterId, lastEventId, fromMs, toMs, filter.appName);
+        } else {
+            success = reader->select<std::string_view, std::string_view, sqlite3_int64, sqlite3_int64>(
+                kLifetimeTotalsSql, onTotal, filter.appName);
+        }
+    }
+
+    reader->execute("COMMIT;");
+    return success;
+}
+
+sqlite3_int64 Database::getExportWatermark(const std::string& name) {
+    auto reader = readers.acquire();
+    sqlite3_int64 eventId = 0;
+    if (reader) {
+        reader->select<sqlite3_int64>("SELECT event_id FROM export_watermarks WHERE name = ?;",
+            [&](sqlite3_int64 id) { eventId = id; }, name);
+    }
+    return eventId;
+}
+
+bool Database::setExportWatermark(const std::string& name, sqlite3_int64 eventId) {
+    return runOnWriter([this, name, eventId] {
+        sqlite3_int64 exportedAt = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+        return writer.execute(
+            "INSERT INTO export_watermarks (name, event_id, exported_at) VALUES (?, ?, ?) "
+            "ON CONFLICT(name) DO UPDATE SET "
+            "event_id = excluded.event_id, exported_at = excluded.exported_at;",
+            name, eventId, exportedAt);
+    });
+}
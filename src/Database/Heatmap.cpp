@@ -0,0 +1,216 @@
+#include "Database.h"
+#include <algorithm>
+#include <limits>
+#include <map>
+#include <tuple>
+
+namespace {
+
+const char* const kHeatmapUpsertSql =
+    "INSERT INTO heatmap (app_id, combo_id, cell, press_count) VALUES (?, ?, ?, ?) "
+    "ON CONFLICT(app_id, combo_id, cell) DO UPDATE SET "
+    "press_count = press_count + excluded.press_count;";
+
+// События журнала с id > ?1. ?2 - фиксированное смещение в мс, ?3 -
+// модификатор пояса: 'localtime' или ничего не меняющий '+0 seconds'
+const char* const kHeatmapEventsSql =
+    "INSERT INTO heatmap (app_id, combo_id, cell, press_count) "
+    "SELECT app_id, combo_id, "
+    "((CAST(strftime('%w', (ts + ?2) / 1000, 'unixepoch', ?3) AS INTEGER) + 6) % 7) * 24 "
+    "+ CAST(strftime('%H', (ts + ?2) / 1000, 'unixepoch', ?3) AS INTEGER), COUNT(*) "
+    "FROM key_events WHERE id > ?1 GROUP BY 1, 2, 3 "
+    "ON CONFLICT(app_id, combo_id, cell) DO UPDATE SET "
+    "press_count = press_count + excluded.press_count;";
+
+// Прирост ячеек карты источника merge_src (v8+) с прошлого слияния ?1:
+// merge_heatmap помнит влитое значение ячейки, как merge_counts.
+// Ячейки источника уже посчитаны в его поясе и берутся как есть.
+const char* const kHeatmapMergeSql =
+    "WITH delta AS ("
+    "SELECT am.dst_id AS app_id, cm.dst_id AS combo_id, s.cell AS cell, "
+    "CASE WHEN s.press_count >= COALESCE(m.press_count, 0) "
+    "THEN s.press_count - COALESCE(m.press_count, 0) ELSE s.press_count END AS added "
+    "FROM merge_src.heatmap s "
+    "JOIN temp.merge_app_map am ON am.src_id = s.app_id "
+    "JOIN temp.merge_combo_map cm ON cm.src_id = s.combo_id "
+    "LEFT JOIN merge_heatmap m ON m.source_id = ?1 AND m.app_id = am.dst_id "
+    "AND m.combo_id = cm.dst_id AND m.cell = s.cell) "
+    "INSERT INTO heatmap (app_id, combo_id, cell, press_count) "
+    "SELECT app_id, combo_id, cell, added FROM delta WHERE added > 0 "
+    "ON CONFLICT(app_id, combo_id, cell) DO UPDATE SET "
+    "press_count = press_count + excluded.press_count;";
+
+const char* const kHeatmapRememberMergedSql =
+    "INSERT INTO merge_heatmap (source_id, app_id, combo_id, cell, press_count) "
+    "SELECT ?1, am.dst_id, cm.dst_id, s.cell, s.press_count "
+    "FROM merge_src.heatmap s "
+    "JOIN temp.merge_app_map am ON am.src_id = s.app_id "
+    "JOIN temp.merge_combo_map cm ON cm.src_id = s.combo_id "
+    "WHERE true "
+    "ON CONFLICT(source_id, app_id, combo_id, cell) DO UPDATE SET "
+    "press_count = excluded.press_count;";
+
+// Первичное заполнение карты при переходе на схему v8: каждый участок
+// времени берется с самого подробного уровня, где он еще хранится -
+// журнал с ?3, минутные свертки на [?4, ?3), часовые до ?4. ?1 и ?2 -
+// смещение и модификатор пояса, как в kHeatmapEventsSql. Час свертки
+// относится к местному часу своей середины: при поясе с получасом
+// свертка делится между двумя часами, и середина выбирает тот, где
+// большая ее часть. Дневные свертки часа не знают и не учитываются.
+const char* const kHeatmapSeedSql =
+    "INSERT INTO heatmap (app_id, combo_id, cell, press_count) "
+    "SELECT app_id, combo_id, "
+    "((CAST(strftime('%w', (ts + ?1) / 1000, 'unixepoch', ?2) AS INTEGER) + 6) % 7) * 24 "
+    "+ CAST(strftime('%H', (ts + ?1) / 1000, 'unixepoch', ?2) AS INTEGER), SUM(presses) "
+    "FROM ("
+    "SELECT ts, app_id, combo_id, 1 AS presses FROM key_events WHERE ts >= ?3 "
+    "UNION ALL "
+    "SELECT bucket, app_id, combo_id, press_count FROM rollup_minute "
+    "WHERE bucket >= ?4 AND bucket < ?3 "
+    "UNION ALL "
+    "SELECT bucket + 1800000, app_id, combo_id, press_count FROM rollup_hour "
+    "WHERE bucket < ?4"
+    ") GROUP BY 1, 2, 3;";
+
+constexpr sqlite3_int64 kMinuteMs = 60000;
+constexpr sqlite3_int64 kHourMs = 3600000;
+constexpr sqlite3_int64 kForever = std::numeric_limits<sqlite3_int64>::max();
+
+sqlite3_int64 ceilTo(sqlite3_int64 ts, sqlite3_int64 stepMs) {
+    sqlite3_int64 floor = ts - ts % stepMs - (ts % stepMs < 0 ? stepMs : 0);
+    return floor == ts ? floor : floor + stepMs;
+}
+
+// Выборки по фильтру; каждая идет по своему ключу, без условий вида
+// (?1 = 0 OR ...)
+const char* const kHeatmapAllSql =
+    "SELECT cell, SUM(press_count) FROM heatmap GROUP BY cell;";
+const char* const kHeatmapAppSql =
+    "SELECT cell, SUM(press_count) FROM heatmap WHERE app_id = ? GROUP BY cell;";
+const char* const kHeatmapComboSql =
+    "SELECT cell, SUM(press_count) FROM heatmap WHERE combo_id = ? GROUP BY cell;";
+const char* const kHeatmapAppComboSql =
+    "SELECT cell, press_count FROM heatmap WHERE app_id = ? AND combo_id = ?;";
+
+} // namespace
+
+void Database::setHeatmapUtcOffset(std::optional<std::chrono::minutes> utcOffset) {
+    runOnWriter([this, utcOffset] {
+        // Накопленные нажатия записываются еще в прежнем поясе
+        bool written = writePendingDeltas();
+        heatmapClock = HeatmapClock(utcOffset);
+        return written;
+    });
+}
+
+// Выполняется в потоке записи внутри транзакции сброса. Идентификаторы
+// в узлах пакета уже заполнены writePendingDeltas.
+bool Database::writeHeatmapBatch(const std::vector<PendingEvent>& events) {
+    // (приложение, комбинация, ячейка) -> приращение
+    std::map<std::tuple<sqlite3_int64, sqlite3_int64, size_t>, int> cells;
+    for (const auto& event : events) {
+        const auto& delta = event.entry->second;
+        cells[{delta.appId, delta.comboId, heatmapClock.cellOf(event.timestamp)}]++;
+    }
+
+    for (const auto& [key, count] : cells) {
+        const auto& [appId, comboId, cell] = key;
+        if (!writer.execute(kHeatmapUpsertSql, appId, comboId,
+                            static_cast<sqlite3_int64>(cell), count)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Досчитывает карту по событиям, добавленным в журнал пачкой (слияние).
+// Выполняется в потоке записи внутри транзакции.
+bool Database::heatmapEventsAfter(sqlite3_int64 afterEventId) {
+    if (heatmapClock.isLocal()) {
+        return writer.execute(kHeatmapEventsSql, afterEventId, sqlite3_int64{0}, "localtime");
+    }
+    return writer.execute(kHeatmapEventsSql, afterEventId,
+                          static_cast<sqlite3_int64>(heatmapClock.getFixedOffsetMs()),
+                          "+0 seconds");
+}
+
+// Доливает карту источника (слияние). Выполняется в потоке записи
+// внутри транзакции слияния, после заполнения temp.merge_*_map.
+bool Database::mergeSourceHeatmap(sqlite3_int64 sourceId) {
+    return writer.execute(kHeatmapMergeSql, sourceId) &&
+           writer.execute(kHeatmapRememberMergedSql, sourceId);
+}
+
+// Выполняется в транзакции миграции на v8, до запуска потока записи.
+// Хвосты журнала и минутных сверток могут начинаться с середины минуты
+// или часа, поэтому границы уровней выравниваются вверх: неполный
+// интервал берется с более грубого, но полного уровня.
+bool Database::seedHeatmap() {
+    sqlite3_int64 eventsFrom = kForever;
+    sqlite3_int64 minutesFrom = kForever;
+    bool success = writer.select<sqlite3_int64>(
+        "SELECT ts FROM key_events ORDER BY ts LIMIT 1;",
+        [&](sqlite3_int64 first) { eventsFrom = ceilTo(first, kMinuteMs); });
+    success = success && writer.select<sqlite3_int64>(
+        "SELECT bucket FROM rollup_minute ORDER BY bucket LIMIT 1;",
+        [&](sqlite3_int64 first) { minutesFrom = ceilTo(first, kHourMs); });
+    if (!success) {
+        return false;
+    }
+    // Журнал хранится дольше минутных сверток - с него и начинаем
+    if (eventsFrom != kForever) {
+        minutesFrom = std::min(minutesFrom, ceilTo(eventsFrom, kHourMs));
+    }
+    eventsFrom = std::max(eventsFrom, minutesFrom);
+
+    if (heatmapClock.isLocal()) {
+        return writer.execute(kHeatmapSeedSql, sqlite3_int64{0}, "localtime",
+                              eventsFrom, minutesFrom);
+    }
+    return writer.execute(kHeatmapSeedSql,
+                          static_cast<sqlite3_int64>(heatmapClock.getFixedOffsetMs()),
+                          "+0 seconds", eventsFrom, minutesFrom);
+}
+
+UsageHeatmap Database::getUsageHeatmap(const std::string& appName,
+                                       const std::string& keyCombination) {
+    UsageHeatmap heatmap;
+    auto reader = readers.acquire();
+    if (!reader) {
+        return heatmap;
+    }
+
+    // Неизвестное имя означает, что нажатий нет
+    sqlite3_int64 appId = 0;
+    sqlite3_int64 comboId = 0;
+    if (!appName.empty()) {
+        reader->select<sqlite3_int64>("SELECT id FROM apps WHERE name = ?;",
+            [&](sqlite3_int64 id) { appId = id; }, appName);
+        if (appId == 0) {
+            return heatmap;
+        }
+    }
+    if (!keyCombination.empty()) {
+        reader->select<sqlite3_int64>("SELECT id FROM combos WHERE combo = ?;",
+            [&](sqlite3_int64 id) { comboId = id; }, keyCombination);
+        if (comboId == 0) {
+            return heatmap;
+        }
+    }
+
+    auto addCell = [&](sqlite3_int64 cell, sqlite3_int64 count) {
+        if (cell >= 0 && cell < static_cast<sqlite3_int64>(UsageHeatmap::kCells)) {
+            heatmap.add(static_cast<size_t>(cell), count);
+        }
+    };
+    if (appId != 0 && comboId != 0) {
+        reader->select<sqlite3_int64, sqlite3_int64>(kHeatmapAppComboSql, addCell, appId, comboId);
+    } else if (appId != 0) {
+        reader->select<sqlite3_int64, sqlite3_int64>(kHeatmapAppSql, addCell, appId);
+    } else if (comboId != 0) {
+        reader->select<sqlite3_int64, sqlite3_int64>(kHeatmapComboSql, addCell, comboId);
+    } else {
+        reader->select<sqlite3_int64, sqlite3_int64>(kHeatmapAllSql, addCell);
+    }
+    return heatmap;
+}
@@ -0,0 +1,93 @@
+#include "Database.h"
+#include <limits>
+
+namespace {
+
+// Страница журнала по индексу idx_key_events_ts: id - последний
+// столбец индекса, поэтому порядок (ts, id) не требует сортировки,
+// а продолжение с курсора - поиск, а не пропуск прочитанного.
+// CROSS JOIN оставляет журнал внешним циклом.
+const char* const kHistoryPageSql =
+    "SELECT e.id, a.name, c.combo, e.ts "
+    "FROM key_events e CROSS JOIN apps a ON a.id = e.app_id "
+    "CROSS JOIN combos c ON c.id = e.combo_id "
+    "WHERE e.ts >= ?1 AND e.ts < ?2 AND (e.ts > ?1 OR e.id > ?3) AND e.id <= ?4 "
+    "AND (?5 = 0 OR e.app_id = ?5) AND (?6 = 0 OR e.combo_id = ?6) "
+    "ORDER BY e.ts, e.id LIMIT ?7;";
+
+} // namespace
+
+bool Database::readHistoryPage(const HistoryQuery& query, HistoryPage& page) {
+    page = HistoryPage();
+    auto reader = readers.acquire();
+    if (!reader) {
+        return false;
+    }
+
+    sqlite3_int64 fromMs = query.fromMs.value_or(std::numeric_limits<sqlite3_int64>::min() / 2);
+    sqlite3_int64 toMs = query.toMs.value_or(std::numeric_limits<sqlite3_int64>::max() / 2);
+    sqlite3_int64 afterId = 0;
+    if (query.after && query.after->timestamp >= fromMs) {
+        fromMs = query.after->timestamp;
+        afterId = query.after->eventId;
+    }
+    int limit = pageFetchLimit(query.pageSize);
+
+    // Граница журнала, имена и строки читаются из одного снимка
+    bool success = reader->execute("BEGIN;");
+    page.lastEventId = query.lastEventId;
+    if (success && page.lastEventId == 0) {
+        success = reader->select<sqlite3_int64>(
+            "SELECT COALESCE(MAX(id), 0) FROM key_events;",
+            [&](sqlite3_int64 id) { page.lastEventId = id; });
+    }
+
+    // Неизвестное имя означает, что нажатий нет
+    sqlite3_int64 appId = 0;
+    sqlite3_int64 comboId = 0;
+    bool known = true;
+    if (success && !query.appName.empty()) {
+        success = reader->select<sqlite3_int64>("SELECT id FROM apps WHERE name = ?;",
+            [&](sqlite3_int64 id) { appId = id; }, query.appName);
+        known = appId != 0;
+    }
+    if (success && known && !query.keyCombination.empty()) {
+        success = reader->select<sqlite3_int64>("SELECT id FROM combos WHERE combo = ?;",
+            [&](sqlite3_int64 id) { comboId = id; }, query.keyCombination);
+        known = comboId != 0;
+    }
+
+    if (success && known && fromMs < toMs) {
+        if (query.pageSize > 0) {
+            page.rows.reserve(query.pageSize + 1);
+        }
+        success = reader->select<sqlite3_int64, std::string_view, std::string_view, sqlite3_int64>(
+            kHistoryPageSql,
+            [&](sqlite3_int64 eventId, std::string_view app, std::string_view combo,
+                sqlite3_int64 ts) {
+                page.rows.push_back({eventId, std::string(app), std::string(combo), ts});
+            },
+            fromMs, toMs, afterId, static_cast<sqlite3_int64>(page.lastEventId),
+            appId, comboId, limit);
+    }
+    reader->execute("COMMIT;");
+
+    if (query.pageSize > 0 && page.rows.size() > query.pageSize) {
+        page.rows.pop_back();
+        page.next = HistoryCursor{page.rows.back().timestamp, page.rows.back().eventId};
+    }
+    return success;
+}
+
+std::pair<std::int64_t, std::int64_t> Database::getHistoryTimeRange() {
+    std::pair<std::int64_t, std::int64_t> range{0, 0};
+    auto reader = readers.acquire();
+    if (reader) {
+        // Отдельные подзапросы: MIN и MAX берутся с краев индекса по ts
+        reader->select<sqlite3_int64, sqlite3_int64>(
+            "SELECT COALESCE((SELECT MIN(ts) FROM key_events), 0), "
+            "COALESCE((SELECT MAX(ts) FROM key_events), 0);",
+            [&](sqlite3_int64 first, sqlite3_int64 last) { range = {first, last}; });
+    }
+    return range;
+}
@@ -0,0 +1,227 @@
+#include "Database.h"
+#include <algorithm>
+#include <filesystem>
+#include <iostream>
+
+namespace {
+
+// Соответствие идентификаторов источника и текущей БД. Временные
+// таблицы живут в соединении записи и переиспользуются между слияниями.
+const char* kMergeMapsScript =
+    "CREATE TEMP TABLE IF NOT EXISTS merge_app_map ("
+    "src_id INTEGER PRIMARY KEY, dst_id INTEGER NOT NULL);"
+    "CREATE TEMP TABLE IF NOT EXISTS merge_combo_map ("
+    "src_id INTEGER PRIMARY KEY, dst_id INTEGER NOT NULL);"
+    "DELETE FROM temp.merge_app_map;"
+    "DELETE FROM temp.merge_combo_map;";
+
+// Прирост счетчика: разница с уже влитым значением. После очистки
+// источника влитые значения сбрасываются по эпохе очистки; счетчик меньше
+// влитого - та же очистка в источнике без эпох (схема до v10).
+const char* kCountDeltasCte =
+    "WITH delta AS ("
+    "SELECT am.dst_id AS app_id, cm.dst_id AS combo_id, s.last_pressed AS last_pressed, "
+    "CASE WHEN s.press_count >= COALESCE(m.press_count, 0) "
+    "THEN s.press_count - COALESCE(m.press_count, 0) ELSE s.press_count END AS added "
+    "FROM merge_src.key_counts s "
+    "JOIN temp.merge_app_map am ON am.src_id = s.app_id "
+    "JOIN temp.merge_combo_map cm ON cm.src_id = s.combo_id "
+    "LEFT JOIN merge_counts m ON m.source_id = ?1 "
+    "AND m.app_id = am.dst_id AND m.combo_id = cm.dst_id) ";
+
+} // namespace
+
+MergeResult Database::mergeDatabases(const std::vector<std::string>& sourcePaths) {
+    MergeResult total;
+    total.success = true;
+    for (const auto& path : sourcePaths) {
+        MergeResult result = mergeDatabase(path);
+        total.success = total.success && result.success;
+        total.sourcesMerged += result.sourcesMerged;
+        total.pressesAdded += result.pressesAdded;
+        total.eventsAdded += result.eventsAdded;
+    }
+    return total;
+}
+
+MergeResult Database::mergeDatabase(const std::string& sourcePath) {
+    MergeResult result;
+    // ATTACH создал бы пустой файл на месте опечатки в пути
+    std::error_code error;
+    if (!std::filesystem::is_regular_file(sourcePath, error)) {
+        std::cerr << "Merge source not found: " << sourcePath << std::endl;
+        return result;
+    }
+
+    runOnWriter([&] {
+        // Собственные отложенные нажатия фиксируются до слияния
+        writePendingDeltas();
+        if (!writer.execute("ATTACH DATABASE ? AS merge_src;", sourcePath)) {
+            return false;
+        }
+        bool success = mergeAttachedSource(sourcePath, result);
+        writer.execute("DETACH DATABASE merge_src;");
+        return success;
+    });
+    return result;
+}
+
+// Выполняется в потоке записи, источник подключен как merge_src.
+// Все шаги - запросы над множествами строк в одной транзакции, без
+// построчного прохода в C++.
+bool Database::mergeAttachedSource(const std::string& sourcePath, MergeResult& result) {
+    int sourceVersion = 0;
+    writer.select<int>("PRAGMA merge_src.user_version;", [&](int value) { sourceVersion = value; });
+    if (sourceVersion < 3) {
+        // До v3 нет журнала событий, а до v2 - словарей
+        std::cerr << "Merge source " << sourcePath << " has schema v" << sourceVersion
+                  << ", at least v3 is required" << std::endl;
+        return false;
+    }
+
+    // Источник узнается по идентификатору экземпляра, а не по пути:
+    // копия с другой машины может лежать где угодно
+    std::string sourceKey = "path:" + sourcePath;
+    sqlite3_int64 sourceClearEpoch = 0;
+    if (sourceVersion >= 6) {
+        writer.select<std::string>(
+            "SELECT value FROM merge_src.database_info WHERE key = 'instance_id';",
+            [&](std::string value) { sourceKey = value; });
+        writer.select<sqlite3_int64>(
+            "SELECT value FROM merge_src.database_info WHERE key = 'clear_epoch';",
+            [&](sqlite3_int64 value) { sourceClearEpoch = value; });
+    }
+    bool isSelf = false;
+    writer.select<int>("SELECT 1 FROM main.database_info WHERE key = 'instance_id' AND value = ?;",
+        [&](int) { isSelf = true; }, sourceKey);
+    if (isSelf) {
+        std::cerr << "Refusing to merge database into itself: " << sourcePath << std::endl;
+        return false;
+    }
+
+    if (!writer.executeScript(kMergeMapsScript)) {
+        return false;
+    }
+
+    bool success = writer.execute("BEGIN;");
+    success = success && writer.execute(
+        "INSERT INTO merge_sources (source_key) VALUES (?) "
+        "ON CONFLICT(source_key) DO NOTHING;", sourceKey);
+
+    sqlite3_int64 sourceId = 0;
+    sqlite3_int64 mergedEventId = 0;
+    sqlite3_int64 mergedClearEpoch = 0;
+    success = success && writer.select<sqlite3_int64, sqlite3_int64, sqlite3_int64>(
+        "SELECT id, event_id, clear_epoch FROM merge_sources WHERE source_key = ?;",
+        [&](sqlite3_int64 id, sqlite3_int64 eventId, sqlite3_int64 clearEpoch) {
+            sourceId = id;
+            mergedEventId = eventId;
+            mergedClearEpoch = clearEpoch;
+        }, sourceKey);
+
+    // Источник очищали после прошлого слияния: его счетчики начались с нуля
+    if (success && sourceClearEpoch != mergedClearEpoch) {
+        success = writer.execute("DELETE FROM merge_counts WHERE source_id = ?;", sourceId)
+            && writer.execute("DELETE FROM merge_rollups WHERE source_id = ?;", sourceId)
+            && writer.execute("DELETE FROM merge_heatmap WHERE source_id = ?;", sourceId);
+    }
+
+    // Словари: недостающие имена добавляются, затем строится соответствие id
+    success = success && writer.execute(
+        "INSERT OR IGNORE INTO apps (name) SELECT name FROM merge_src.apps;");
+    success = success && writer.execute(
+        "INSERT OR IGNORE INTO combos (combo, modifiers) "
+        "SELECT combo, "
+        "(instr(combo, 'Ctrl+') > 0) + (instr(combo, 'Shift+') > 0) * 2 + "
+        "(instr(combo, 'Alt+') > 0) * 4 + (instr(combo, 'Win+') > 0) * 8 "
+        "FROM merge_src.combos;");
+    success = success && writer.execute(
+        "INSERT INTO temp.merge_app_map (src_id, dst_id) "
+        "SELECT s.id, t.id FROM merge_src.apps s JOIN main.apps t ON t.name = s.name;");
+    success = success && writer.execute(
+        "INSERT INTO temp.merge_combo_map (src_id, dst_id) "
+        "SELECT s.id, t.id FROM merge_src.combos s JOIN main.combos t ON t.combo = s.combo;");
+
+    // Счетчики за все время (включая перенесенные из схемы v1, у которых
+    // нет журнала): добавляется только прирост с прошлого слияния
+    std::string deltaSum = std::string(kCountDeltasCte) +
+        "SELECT COALESCE(SUM(added), 0) FROM delta;";
+    std::string deltaUpsert = std::string(kCountDeltasCte) +
+        "INSERT INTO key_counts (app_id, combo_id, press_count, last_pressed) "
+        "SELECT app_id, combo_id, added, last_pressed FROM delta WHERE added > 0 "
+        "ON CONFLICT(app_id, combo_id) DO UPDATE SET "
+        "press_count = press_count + excluded.press_count, "
+        "last_pressed = MAX(last_pressed, excluded.last_pressed);";
+    success = success && writer.select<sqlite3_int64>(deltaSum.c_str(),
+        [&](sqlite3_int64 added) { result.pressesAdded = added; }, sourceId);
+    success = success && writer.execute(deltaUpsert.c_str(), sourceId);
+    success = success && writer.execute(
+        "INSERT INTO merge_counts (source_id, app_id, combo_id, press_count) "
+        "SELECT ?1, am.dst_id, cm.dst_id, s.press_count "
+        "FROM merge_src.key_counts s "
+        "JOIN temp.merge_app_map am ON am.src_id = s.app_id "
+        "JOIN temp.merge_combo_map cm ON cm.src_id = s.combo_id "
+        "WHERE true "
+        "ON CONFLICT(source_id, app_id, combo_id) DO UPDATE SET "
+        "press_count = excluded.press_count;", sourceId);
+
+    // Журнал: события источника после отметки. С v9 id журнала не
+    // переиспользуются и после очистки, поэтому отметка остается верной;
+    // rowid - тот же id, а в старых схемах - единственный номер события.
+    // В старой схеме отметка выше конца журнала означает, что источник
+    // очищали, и журнал читается с начала.
+    sqlite3_int64 sourceLastEventId = 0;
+    success = success && writer.select<sqlite3_int64>(
+        "SELECT COALESCE(MAX(rowid), 0) FROM merge_src.key_events;",
+        [&](sqlite3_int64 id) { sourceLastEventId = id; });
+    if (sourceVersion < 9 && sourceLastEventId < mergedEventId) {
+        mergedEventId = 0;
+    }
+
+    sqlite3_int64 localLastEventId = 0;
+    success = success && writer.select<sqlite3_int64>(
+        "SELECT COALESCE(MAX(id), 0) FROM main.key_events;",
+        [&](sqlite3_int64 id) { localLastEventId = id; });
+    if (success) {
+        success = writer.execute(
+            "INSERT INTO main.key_events (ts, app_id, combo_id) "
+            "SELECT e.ts, am.dst_id, cm.dst_id FROM merge_src.key_events e "
+            "JOIN temp.merge_app_map am ON am.src_id = e.app_id "
+            "JOIN temp.merge_combo_map cm ON cm.src_id = e.combo_id "
+            "WHERE e.rowid > ?1 AND e.rowid <= ?2 ORDER BY e.rowid;",
+            mergedEventId, sourceLastEventId);
+        if (success) {
+            result.eventsAdded = sqlite3_changes(writer.get());
+        }
+    }
+
+    // Свертки берутся из источника, а не из влитой части журнала: в них
+    // есть и история, которую источник из журнала уже удалил. Карта до
+    // v8 есть только в журнале.
+    success = success && mergeSourceRollups(sourceId);
+    if (sourceVersion >= 8) {
+        success = success && mergeSourceHeatmap(sourceId);
+    } else {
+        success = success && heatmapEventsAfter(localLastEventId);
+    }
+
+    sqlite3_int64 mergedAt = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    success = success && writer.execute(
+        "UPDATE merge_sources SET event_id = ?, clear_epoch = ?, merged_at = ? WHERE id = ?;",
+        std::max(sourceLastEventId, mergedEventId), sourceClearEpoch, mergedAt, sourceId);
+    success = success && writer.execute("COMMIT;");
+
+    if (!success) {
+        writer.execute("ROLLBACK;");
+        result = MergeResult{};
+        std::cerr << "Merge of " << sourcePath << " failed" << std::endl;
+        return false;
+    }
+
+    result.success = true;
+    result.sourcesMerged = 1;
+    std::cout << "Merged " << sourcePath << ": +" << result.pressesAdded
+              << " presses, +" << result.eventsAdded << " events" << std::endl;
+    return true;
+}
@@ -0,0 +1,313 @@
+#include "Database.h"
+#include <iostream>
+
+namespace {
+
+// Одна миграция: скрипт, переводящий схему на версию version.
+// Скрипт выполняется в транзакции вместе с PRAGMA user_version;
+// seedsHeatmap - в той же транзакции заполнить карту (Heatmap.cpp):
+// ей нужен пояс объекта, а не только SQL.
+struct Migration {
+    int version;
+    const char* description;
+    const char* script;
+    bool seedsHeatmap = false;
+};
+
+const Migration kMigrations[] = {
+    {1, "legacy key_statistics table",
+        "CREATE TABLE IF NOT EXISTS key_statistics ("
+        "id INTEGER PRIMARY KEY AUTOINCREMENT,"
+        "app_name TEXT NOT NULL,"
+        "key_combination TEXT NOT NULL,"
+        "press_count INTEGER DEFAULT 1,"
+        "last_pressed TIMESTAMP DEFAULT CURRENT_TIMESTAMP,"
+        "UNIQUE(app_name, key_combination)"
+        ");"},
+
+    // Словари приложений и комбинаций плюс счетчики с целочисленным ключом.
+    // Старая таблица переименовывается и переносится порциями в фоне.
+    {2, "normalized apps/combos/key_counts",
+        "CREATE TABLE apps ("
+        "id INTEGER PRIMARY KEY,"
+        "name TEXT NOT NULL UNIQUE"
+        ");"
+        "CREATE TABLE combos ("
+        "id INTEGER PRIMARY KEY,"
+        "combo TEXT NOT NULL UNIQUE"
+        ");"
+        "CREATE TABLE key_counts ("
+        "app_id INTEGER NOT NULL REFERENCES apps(id),"
+        "combo_id INTEGER NOT NULL REFERENCES combos(id),"
+        "press_count INTEGER NOT NULL DEFAULT 0,"
+        "last_pressed INTEGER NOT NULL DEFAULT 0," // мс от эпохи
+        "PRIMARY KEY (app_id, combo_id)"
+        ") WITHOUT ROWID;"
+        "CREATE INDEX idx_key_counts_app_count "
+        "ON key_counts(app_id, press_count DESC);"
+        "ALTER TABLE key_statistics RENAME TO legacy_key_statistics;"},
+
+    // Журнал отдельных нажатий и свертки с началом интервала в bucket (мс).
+    // Старые счетчики не имеют истории, поэтому журнал начинается пустым.
+    {3, "key_events journal and minute/hour/day rollups",
+        "CREATE TABLE key_events ("
+        "ts INTEGER NOT NULL," // мс от эпохи (UTC)
+        "app_id INTEGER NOT NULL REFERENCES apps(id),"
+        "combo_id INTEGER NOT NULL REFERENCES combos(id)"
+        ");"
+        "CREATE INDEX idx_key_events_ts ON key_events(ts);"
+        "CREATE TABLE rollup_minute ("
+        "bucket INTEGER NOT NULL, app_id INTEGER NOT NULL, combo_id INTEGER NOT NULL,"
+        "press_count INTEGER NOT NULL,"
+        "PRIMARY KEY (bucket, app_id, combo_id)"
+        ") WITHOUT ROWID;"
+        "CREATE TABLE rollup_hour ("
+        "bucket INTEGER NOT NULL, app_id INTEGER NOT NULL, combo_id INTEGER NOT NULL,"
+        "press_count INTEGER NOT NULL,"
+        "PRIMARY KEY (bucket, app_id, combo_id)"
+        ") WITHOUT ROWID;"
+        "CREATE TABLE rollup_day ("
+        "bucket INTEGER NOT NULL, app_id INTEGER NOT NULL, combo_id INTEGER NOT NULL,"
+        "press_count INTEGER NOT NULL,"
+        "PRIMARY KEY (bucket, app_id, combo_id)"
+        ") WITHOUT ROWID;"},
+
+    // Маска модификаторов для фильтров и покрывающие индексы для
+    // постраничных запросов по приложению
+    {4, "combo modifiers and covering query indexes",
+        "ALTER TABLE combos ADD COLUMN modifiers INTEGER NOT NULL DEFAULT 0;"
+        "UPDATE combos SET modifiers = "
+        "(instr(combo, 'Ctrl+') > 0) + (instr(combo, 'Shift+') > 0) * 2 + "
+        "(instr(combo, 'Alt+') > 0) * 4 + (instr(combo, 'Win+') > 0) * 8;"
+        "DROP INDEX idx_key_counts_app_count;"
+        "CREATE INDEX idx_key_counts_app_rank "
+        "ON key_counts(app_id, press_count DESC, combo_id, last_pressed);"
+        "CREATE INDEX idx_rollup_minute_app ON rollup_minute(app_id, bucket, combo_id, press_count);"
+        "CREATE INDEX idx_rollup_hour_app ON rollup_hour(app_id, bucket, combo_id, press_count);"
+        "CREATE INDEX idx_rollup_day_app ON rollup_day(app_id, bucket, combo_id, press_count);"},
+
+    // Отметки выгрузок: последний выгруженный id журнала для режима
+    // "только новое с прошлого экспорта"
+    {5, "export watermarks",
+        "CREATE TABLE export_watermarks ("
+        "name TEXT PRIMARY KEY,"
+        "event_id INTEGER NOT NULL,"
+        "exported_at INTEGER NOT NULL" // мс от эпохи
+        ");"},
+
+    // Идентификатор экземпляра БД и учет слияний: для каждого источника -
+    // последний влитый id журнала и уже влитые счетчики, чтобы повторное
+    // слияние добавляло только разницу
+    {6, "instance id and merge watermarks",
+        "CREATE TABLE database_info ("
+        "key TEXT PRIMARY KEY,"
+        "value TEXT NOT NULL"
+        ");"
+        "INSERT INTO database_info (key, value) "
+        "VALUES ('instance_id', lower(hex(randomblob(16))));"
+        "CREATE TABLE merge_sources ("
+        "id INTEGER PRIMARY KEY,"
+        "source_key TEXT NOT NULL UNIQUE,"
+        "event_id INTEGER NOT NULL DEFAULT 0,"
+        "merged_at INTEGER NOT NULL DEFAULT 0" // мс от эпохи
+        ");"
+        "CREATE TABLE merge_counts ("
+        "source_id INTEGER NOT NULL REFERENCES merge_sources(id),"
+        "app_id INTEGER NOT NULL,"
+        "combo_id INTEGER NOT NULL,"
+        "press_count INTEGER NOT NULL,"
+        "PRIMARY KEY (source_id, app_id, combo_id)"
+        ") WITHOUT ROWID;"},
+
+    // Счетчики биграмм и триграмм комбинаций (third_id = 0 - биграмма);
+    // индексы по числу нажатий отдают топ без сортировки всей таблицы
+    {7, "key sequences",
+        "CREATE TABLE key_sequences ("
+        "app_id INTEGER NOT NULL REFERENCES apps(id),"
+        "first_id INTEGER NOT NULL,"
+        "second_id INTEGER NOT NULL,"
+        "third_id INTEGER NOT NULL DEFAULT 0,"
+        "press_count INTEGER NOT NULL DEFAULT 0,"
+        "last_pressed INTEGER NOT NULL DEFAULT 0," // мс от эпохи
+        "PRIMARY KEY (app_id, first_id, second_id, third_id)"
+        ") WITHOUT ROWID;"
+        "CREATE INDEX idx_key_sequences_count ON key_sequences(press_count DESC);"
+        "CREATE INDEX idx_key_sequences_app_count "
+        "ON key_sequences(app_id, press_count DESC);"},
+
+    // Тепловая карта: нажатия по ячейкам "день недели * 24 + час" местного
+    // времени (0 - понедельник, 0:00). Заполняется в поясе карты из
+    // журнала, минутных и часовых сверток - что из них еще хранится;
+    // раньше часовых сверток истории нет.
+    {8, "usage heatmap",
+        "CREATE TABLE heatmap ("
+        "app_id INTEGER NOT NULL,"
+        "combo_id INTEGER NOT NULL,"
+        "cell INTEGER NOT NULL,"
+        "press_count INTEGER NOT NULL,"
+        "PRIMARY KEY (app_id, combo_id, cell)"
+        ") WITHOUT ROWID;"
+        "CREATE INDEX idx_heatmap_combo ON heatmap(combo_id, cell, press_count);",
+        true},
+
+    // Явный id журнала вместо неявного rowid: VACUUM вправе перенумеровать
+    // rowid, а на id событий опираются отметки выгрузки, слияния и курсор
+    // истории. AUTOINCREMENT не отдает номера повторно и после очистки
+    // журнала. Прежние rowid переносятся как есть, поэтому сохраненные
+    // отметки остаются верными; копирование журнала - разовое.
+    {9, "stable key_events ids",
+        "CREATE TABLE key_events_v9 ("
+        "id INTEGER PRIMARY KEY AUTOINCREMENT,"
+        "ts INTEGER NOT NULL," // мс от эпохи (UTC)
+        "app_id INTEGER NOT NULL REFERENCES apps(id),"
+        "combo_id INTEGER NOT NULL REFERENCES combos(id)"
+        ");"
+        "INSERT INTO key_events_v9 (id, ts, app_id, combo_id) "
+        "SELECT rowid, ts, app_id, combo_id FROM key_events ORDER BY rowid;"
+        "DROP TABLE key_events;"
+        "ALTER TABLE key_events_v9 RENAME TO key_events;"
+        "CREATE INDEX idx_key_events_ts ON key_events(ts);"},
+
+    // Эпоха очистки источника, при которой влиты его счетчики: после
+    // clearStatistics счет в источнике начинается заново, и влитые
+    // значения больше не служат базой для разницы
+    {10, "merge source clear epochs",
+        "ALTER TABLE merge_sources ADD COLUMN clear_epoch INTEGER NOT NULL DEFAULT 0;"},
+
+    // Влитые свертки (bucket_ms - шаг уровня) и ячейки карты каждого
+    // источника: как и merge_counts, служат базой для разницы, так что
+    // история старше журнала источника вливается без повторов
+    {11, "merged rollups and heatmap",
+        "CREATE TABLE merge_rollups ("
+        "source_id INTEGER NOT NULL REFERENCES merge_sources(id),"
+        "bucket_ms INTEGER NOT NULL,"
+        "bucket INTEGER NOT NULL,"
+        "app_id INTEGER NOT NULL,"
+        "combo_id INTEGER NOT NULL,"
+        "press_count INTEGER NOT NULL,"
+        "PRIMARY KEY (source_id, bucket_ms, bucket, app_id, combo_id)"
+        ") WITHOUT ROWID;"
+        "CREATE TABLE merge_heatmap ("
+        "source_id INTEGER NOT NULL REFERENCES merge_sources(id),"
+        "app_id INTEGER NOT NULL,"
+        "combo_id INTEGER NOT NULL,"
+        "cell INTEGER NOT NULL,"
+        "press_count INTEGER NOT NULL,"
+        "PRIMARY KEY (source_id, app_id, combo_id, cell)"
+        ") WITHOUT ROWID;"},
+};
+
+} // namespace
+
+int Database::getSchemaVersion() {
+    int version = 0;
+    writer.select<int>("PRAGMA user_version;", [&](int value) { version = value; });
+    return version;
+}
+
+bool Database::applyMigrations() {
+    int version = getSchemaVersion();
+
+    for (const auto& migration : kMigrations) {
+        if (migration.version <= version) {
+            continue;
+        }
+
+        std::string script = "BEGIN;";
+        script += migration.script;
+        script += "PRAGMA user_version = " + std::to_string(migration.version) + ";";
+
+        bool applied = writer.executeScript(script.c_str());
+        applied = applied && (!migration.seedsHeatmap || seedHeatmap());
+        if (!applied || !writer.executeScript("COMMIT;")) {
+            writer.executeScript("ROLLBACK;");
+            std::cerr << "Migration to schema v" << migration.version
+                      << " (" << migration.description << ") failed" << std::endl;
+            return false;
+        }
+        std::cout << "Database migrated to schema v" << migration.version
+                  << " (" << migration.description << ")" << std::endl;
+        version = migration.version;
+    }
+
+    // Выражения, подготовленные под старую схему, больше не нужны
+    writer.clearStatements();
+
+    bool legacyExists = false;
+    writer.select<int>("SELECT 1 FROM sqlite_master "
+                       "WHERE type = 'table' AND name = 'legacy_key_statistics';",
+        [&](int) { legacyExists = true; });
+    legacyMigrationPending = legacyExists;
+    return true;
+}
+
+// Переносит до maxRows строк старой таблицы одной транзакцией.
+// Вставка и удаление берут одну и ту же порцию, поэтому прерванный
+// перенос безопасно продолжается с того же места. Выполняется в потоке
+// записи.
+bool Database::migrateLegacyChunk(int maxRows) {
+    if (!legacyMigrationPending) {
+        return true;
+    }
+
+    bool success = writer.execute("BEGIN;");
+    success = success && writer.execute(
+        "INSERT OR IGNORE INTO apps (name) "
+        "SELECT app_name FROM (SELECT app_name FROM legacy_key_statistics "
+        "ORDER BY id LIMIT ?);", maxRows);
+    success = success && writer.execute(
+        "INSERT OR IGNORE INTO combos (combo, modifiers) "
+        "SELECT key_combination, "
+        "(instr(key_combination, 'Ctrl+') > 0) + (instr(key_combination, 'Shift+') > 0) * 2 + "
+        "(instr(key_combination, 'Alt+') > 0) * 4 + (instr(key_combination, 'Win+') > 0) * 8 "
+        "FROM (SELECT key_combination "
+        "FROM legacy_key_statistics ORDER BY id LIMIT ?);", maxRows);
+    success = success && writer.execute(
+        "INSERT INTO key_counts (app_id, combo_id, press_count, last_pressed) "
+        "SELECT a.id, c.id, l.press_count, "
+        "COALESCE(CAST(strftime('%s', l.last_pressed) AS INTEGER), 0) * 1000 "
+        "FROM (SELECT * FROM legacy_key_statistics ORDER BY id LIMIT ?) l "
+        "JOIN apps a ON a.name = l.app_name "
+        "JOIN combos c ON c.combo = l.key_combination "
+        "WHERE true "
+        "ON CONFLICT(app_id, combo_id) DO UPDATE SET "
+        "press_count = press_count + excluded.press_count, "
+        "last_pressed = MAX(last_pressed, excluded.last_pressed);", maxRows);
+    success = success && writer.execute(
+        "DELETE FROM legacy_key_statistics WHERE id IN "
+        "(SELECT id FROM legacy_key_statistics ORDER BY id LIMIT ?);", maxRows);
+
+    bool finished = true;
+    success = success && writer.select<int>(
+        "SELECT 1 FROM legacy_key_statistics LIMIT 1;",
+        [&](int) { finished = false; });
+    success = success && writer.execute("COMMIT;");
+
+    if (!success) {
+        writer.execute("ROLLBACK;");
+        appIds.clear();
+        comboIds.clear();
+        return false;
+    }
+
+    if (finished) {
+        writer.clearStatements();
+        if (!writer.executeScript("DROP TABLE legacy_key_statistics;")) {
+            return false;
+        }
+        legacyMigrationPending = false;
+        std::cout << "Legacy statistics migration completed" << std::endl;
+    }
+    return true;
+}
+
+bool Database::finishMigration() {
+    return runOnWriter([this] {
+        while (legacyMigrationPending) {
+            if (!migrateLegacyChunk(1000)) {
+                return false;
+            }
+        }
+        return true;
+    });
+}
@@ -0,0 +1,96 @@
+#include "PagedHistory.h"
+
+PagedHistory::PagedHistory(Database& database, HistoryQuery historyQuery, bool prefetch)
+    : db(&database), query(std::move(historyQuery)), readAhead(prefetch) {
+    // Пустое окно не читается совсем
+    if (query.fromMs && query.toMs && *query.fromMs >= *query.toMs) {
+        finished = true;
+        return;
+    }
+    requestPage();
+}
+
+PagedHistory::~PagedHistory() {
+    // Фоновое чтение обращается к db - дожидаемся его
+    if (pending.valid()) {
+        pending.wait();
+    }
+}
+
+void PagedHistory::requestPage() {
+    auto read = [database = db, request = query]() {
+        HistoryPage result;
+        if (!database->readHistoryPage(request, result)) {
+            // Пустая граница отличает ошибку от пустой страницы
+            result.lastEventId = -1;
+        }
+        return result;
+    };
+    pending = std::async(readAhead ? std::launch::async : std::launch::deferred, read);
+}
+
+bool PagedHistory::advancePage() {
+    if (finished || !pending.valid()) {
+        return false;
+    }
+
+    page = pending.get();
+    position = 0;
+    ++pagesRead;
+    if (page.lastEventId < 0) {
+        failed = true;
+        finished = true;
+        page = HistoryPage();
+        return false;
+    }
+
+    // Следующие страницы - по границе первой и с ее продолжения
+    query.lastEventId = page.lastEventId;
+    query.after = page.next;
+    if (page.next) {
+        requestPage();
+    } else {
+        finished = true;
+    }
+    return !page.rows.empty();
+}
+
+const HistoryEvent* PagedHistory::next() {
+    while (position >= page.rows.size()) {
+        if (!advancePage()) {
+            return nullptr;
+        }
+    }
+    return &page.rows[position++];
+}
+
+PagedHistory HistoryView::findPresses(const std::string& appName,
+                                      const std::string& keyCombination,
+                                      std::int64_t from, std::int64_t to) const {
+    db.flush();
+    HistoryQuery query;
+    query.appName = appName;
+    query.keyCombination = keyCombination;
+    if (from != std::numeric_limits<std::int64_t>::min()) {
+        query.fromMs = from;
+    }
+    if (to != std::numeric_limits<std::int64_t>::max()) {
+        query.toMs = to;
+    }
+    query.pageSize = pageSize;
+    return PagedHistory(db, std::move(query), readAhead);
+}
+
+PagedHistory HistoryView::findPressesByApp(const std::string& appName) const {
+    // Пустое имя - пустой результат, как в KeyStatistics
+    return appName.empty() ? findPresses("", "", 0, 0) : findPresses(appName);
+}
+
+PagedHistory HistoryView::findPressesByKey(const std::string& keyCombination) const {
+    return keyCombination.empty() ? findPresses("", "", 0, 0) : findPresses("", keyCombination);
+}
+
+std::pair<std::int64_t, std::int64_t> HistoryView::getTimeRange() const {
+    db.flush();
+    return db.getHistoryTimeRange();
+}
@@ -0,0 +1,86 @@
+#pragma once
+#include "Database.h"
+#include <cstdint>
+#include <future>
+#include <limits>
+#include <string>
+#include <utility>
+
+// Проход по журналу нажатий в БД страницами в порядке времени. В памяти
+// не больше двух страниц: текущая и следующая, которую фоновая задача
+// читает, пока обрабатывается текущая. Поэтому объем памяти не зависит
+// от размера истории, в отличие от KeyStatistics::getHistory().
+// Database должна пережить проход.
+class PagedHistory {
+private:
+  Database *db = nullptr;
+  HistoryQuery query;
+  bool readAhead = true;
+
+  HistoryPage page;
+  size_t position = 0;
+  std::future<HistoryPage> pending;
+  bool finished = false;
+  bool failed = false;
+  size_t pagesRead = 0;
+
+  void requestPage();
+  bool advancePage();
+
+public:
+  PagedHistory(Database &db, HistoryQuery query, bool readAhead = true);
+  ~PagedHistory();
+
+  PagedHistory(PagedHistory &&) = default;
+  PagedHistory &operator=(PagedHistory &&) = delete;
+  PagedHistory(const PagedHistory &) = delete;
+  PagedHistory &operator=(const PagedHistory &) = delete;
+
+  // Следующее нажатие или nullptr в конце. Указатель действителен до
+  // следующего вызова.
+  const HistoryEvent *next();
+
+  // Обход оставшихся нажатий; возвращает их число
+  template <typename Handler> size_t forEach(Handler &&handler) {
+    size_t count = 0;
+    while (const HistoryEvent *event = next()) {
+      handler(*event);
+      ++count;
+    }
+    return count;
+  }
+
+  // Ошибка чтения страницы: проход остановлен раньше конца
+  bool hasFailed() const { return failed; }
+  size_t getPagesRead() const { return pagesRead; }
+  std::int64_t getLastEventId() const { return query.lastEventId; }
+};
+
+// Те же поиски, что у KeyStatistics, но по всему журналу в БД, а не по
+// окну в памяти. Перед проходом буфер записи сбрасывается, чтобы в
+// журнале были все уже учтенные нажатия.
+class HistoryView {
+private:
+  Database &db;
+  size_t pageSize;
+  bool readAhead;
+
+public:
+  explicit HistoryView(Database &db, size_t pageSize = 1000, bool readAhead = true)
+      : db(db), pageSize(pageSize), readAhead(readAhead) {}
+
+  // Нажатия по приложению, комбинации и интервалу [from, to);
+  // пустое имя не ограничивает
+  PagedHistory findPresses(const std::string &appName, const std::string &keyCombination = "",
+                           std::int64_t from = std::numeric_limits<std::int64_t>::min(),
+                           std::int64_t to = std::numeric_limits<std::int64_t>::max()) const;
+
+  // Поиск по приложению
+  PagedHistory findPressesByApp(const std::string &appName) const;
+
+  // Поиск по клавише
+  PagedHistory findPressesByKey(const std::string &keyCombination) const;
+
+  // Получение временного диапазона
+  std::pair<std::int64_t, std::int64_t> getTimeRange() const;
+};
@@ -0,0 +1,136 @@
+#include "Database.h"
+#include <iostream>
+
+namespace {
+
+// Уровень хранения: удаление порции устаревших строк одним выражением.
+// ?1 - граница (мс от эпохи), ?2 - размер порции.
+struct RetentionTier {
+    std::optional<std::chrono::milliseconds> RetentionPolicy::*age;
+    const char* deleteSql;
+};
+
+const RetentionTier kRetentionTiers[] = {
+    {&RetentionPolicy::rawEvents,
+        "DELETE FROM key_events WHERE id IN "
+        "(SELECT id FROM key_events WHERE ts < ?1 ORDER BY ts LIMIT ?2);"},
+    {&RetentionPolicy::minuteRollups,
+        "DELETE FROM rollup_minute WHERE (bucket, app_id, combo_id) IN "
+        "(SELECT bucket, app_id, combo_id FROM rollup_minute "
+        "WHERE bucket < ?1 ORDER BY bucket LIMIT ?2);"},
+    {&RetentionPolicy::hourRollups,
+        "DELETE FROM rollup_hour WHERE (bucket, app_id, combo_id) IN "
+        "(SELECT bucket, app_id, combo_id FROM rollup_hour "
+        "WHERE bucket < ?1 ORDER BY bucket LIMIT ?2);"},
+    {&RetentionPolicy::dayRollups,
+        "DELETE FROM rollup_day WHERE (bucket, app_id, combo_id) IN "
+        "(SELECT bucket, app_id, combo_id FROM rollup_day "
+        "WHERE bucket < ?1 ORDER BY bucket LIMIT ?2);"},
+};
+
+} // namespace
+
+void Database::setRetentionPolicy(const RetentionPolicy& policy) {
+    {
+        std::lock_guard<std::mutex> lock(writerMutex);
+        retention = policy;
+        nextCompaction = std::chrono::steady_clock::now();
+    }
+    writerCondition.notify_all();
+}
+
+void Database::setCompactionSchedule(std::chrono::milliseconds interval, size_t chunkRows) {
+    {
+        std::lock_guard<std::mutex> lock(writerMutex);
+        compactionInterval = interval;
+        compactionChunkRows = chunkRows > 0 ? chunkRows : 1;
+    }
+    writerCondition.notify_all();
+}
+
+// Полная перезапись файла: одна долгая транзакция в потоке записи.
+// Только по явному вызову; id журнала VACUUM не меняет (схема v9).
+bool Database::convertToIncrementalVacuum() {
+    return runOnWriter([this] {
+        int autoVacuum = 0;
+        writer.select<int>("PRAGMA auto_vacuum;", [&](int mode) { autoVacuum = mode; });
+        if (autoVacuum == 2) {
+            return true;
+        }
+        writePendingDeltas();
+        std::cout << "Converting database to incremental auto_vacuum" << std::endl;
+        writer.clearStatements();
+        return writer.executeScript("PRAGMA auto_vacuum = INCREMENTAL; VACUUM;");
+    });
+}
+
+bool Database::compactNow() {
+    return runOnWriter([this] {
+        // Порции те же, что и в фоне, просто без пауз между ними
+        do {
+            if (!compactStep()) {
+                return false;
+            }
+        } while (compactionBacklog);
+        return true;
+    });
+}
+
+// Выполняется в потоке записи между сбросами буфера: одна порция на
+// каждый уровень и ограниченный шаг incremental_vacuum. Если работа
+// осталась, compactionBacklog заставляет цикл записи вернуться быстро.
+bool Database::compactStep() {
+    RetentionPolicy policy;
+    sqlite3_int64 chunkRows;
+    {
+        std::lock_guard<std::mutex> lock(writerMutex);
+        policy = retention;
+        chunkRows = static_cast<sqlite3_int64>(compactionChunkRows);
+        nextCompaction = std::chrono::steady_clock::now() + compactionInterval;
+    }
+
+    sqlite3_int64 now = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+
+    bool backlog = false;
+    for (const auto& tier : kRetentionTiers) {
+        const auto& age = policy.*tier.age;
+        if (!age) {
+            continue;
+        }
+
+        // Каждая порция - своя короткая транзакция, запись не ждет долго
+        sqlite3_int64 horizon = now - age->count();
+        if (!writer.execute("BEGIN;")) {
+            return false;
+        }
+        if (!writer.execute(tier.deleteSql, horizon, chunkRows)) {
+            writer.execute("ROLLBACK;");
+            return false;
+        }
+        sqlite3_int64 removed = sqlite3_changes(writer.get());
+        if (!writer.execute("COMMIT;")) {
+            writer.execute("ROLLBACK;");
+            return false;
+        }
+        backlog = backlog || removed >= chunkRows;
+    }
+
+    // Файл, созданный до incremental auto_vacuum, здесь не переводится:
+    // полный VACUUM долог и блокирует запись (convertToIncrementalVacuum)
+    int autoVacuum = 0;
+    writer.select<int>("PRAGMA auto_vacuum;", [&](int mode) { autoVacuum = mode; });
+
+    // Возврат свободных страниц файлу ограниченными шагами
+    if (autoVacuum == 2) {
+        int freePages = 0;
+        writer.select<int>("PRAGMA freelist_count;", [&](int count) { freePages = count; });
+        if (freePages > 0) {
+            writer.executeScript("PRAGMA incremental_vacuum(256);");
+            backlog = backlog || freePages > 256;
+        }
+    }
+
+    compactionBacklog = backlog;
+    return true;
+}
@@ -0,0 +1,92 @@
+#include "Database.h"
+
+namespace {
+
+// ?1 - приложение (только во втором запросе), ?2 - длина (0 - любая),
+// ?3 - лимит. Топ берется по индексу press_count, без сортировки таблицы.
+const char* const kTopSequencesSql =
+    "SELECT a.name, c1.combo, c2.combo, c3.combo, s.press_count, s.last_pressed "
+    "FROM key_sequences s "
+    "JOIN apps a ON a.id = s.app_id "
+    "JOIN combos c1 ON c1.id = s.first_id "
+    "JOIN combos c2 ON c2.id = s.second_id "
+    "LEFT JOIN combos c3 ON c3.id = s.third_id "
+    "WHERE (?2 = 0 OR (s.third_id <> 0) = (?2 = 3)) "
+    "ORDER BY s.press_count DESC LIMIT ?3;";
+
+const char* const kTopAppSequencesSql =
+    "SELECT a.name, c1.combo, c2.combo, c3.combo, s.press_count, s.last_pressed "
+    "FROM key_sequences s "
+    "JOIN apps a ON a.id = s.app_id "
+    "JOIN combos c1 ON c1.id = s.first_id "
+    "JOIN combos c2 ON c2.id = s.second_id "
+    "LEFT JOIN combos c3 ON c3.id = s.third_id "
+    "WHERE s.app_id = ?1 AND (?2 = 0 OR (s.third_id <> 0) = (?2 = 3)) "
+    "ORDER BY s.press_count DESC LIMIT ?3;";
+
+} // namespace
+
+void Database::setSequenceTimeout(std::chrono::milliseconds timeout) {
+    std::lock_guard<std::mutex> lock(writerMutex);
+    sequenceTracker.setTimeout(timeout.count());
+    sequenceTracker.reset();
+}
+
+// Выполняется в потоке записи внутри транзакции сброса
+bool Database::writeSequenceBatch(const PendingSequenceMap& sequences) {
+    for (const auto& [sequence, delta] : sequences) {
+        sqlite3_int64 appId = resolveAppId(sequence.app);
+        sqlite3_int64 ids[3] = {0, 0, 0};
+        for (size_t i = 0; i < sequence.length; ++i) {
+            ids[i] = resolveComboId(sequence.combos[i]);
+        }
+        if (appId == 0 || ids[0] == 0 || ids[1] == 0 || (sequence.length == 3 && ids[2] == 0)) {
+            return false;
+        }
+
+        if (!writer.execute(
+                "INSERT INTO key_sequences "
+                "(app_id, first_id, second_id, third_id, press_count, last_pressed) "
+                "VALUES (?, ?, ?, ?, ?, ?) "
+                "ON CONFLICT(app_id, first_id, second_id, third_id) DO UPDATE SET "
+                "press_count = press_count + excluded.press_count, "
+                "last_pressed = MAX(last_pressed, excluded.last_pressed);",
+                appId, ids[0], ids[1], ids[2], delta.count, delta.lastPressed)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::vector<KeySequence> Database::getTopSequences(size_t limit, const std::string& appName,
+                                                   size_t length) {
+    std::vector<KeySequence> sequences;
+    auto reader = readers.acquire();
+    if (!reader || limit == 0) {
+        return sequences;
+    }
+
+    sqlite3_int64 appId = 0;
+    if (!appName.empty()) {
+        reader->select<sqlite3_int64>("SELECT id FROM apps WHERE name = ?;",
+            [&](sqlite3_int64 id) { appId = id; }, appName);
+        if (appId == 0) {
+            return sequences;
+        }
+    }
+
+    reader->select<std::string_view, std::string_view, std::string_view, std::string_view,
+                   sqlite3_int64, sqlite3_int64>(
+        appId != 0 ? kTopAppSequencesSql : kTopSequencesSql,
+        [&](std::string_view app, std::string_view first, std::string_view second,
+            std::string_view third, sqlite3_int64 count, sqlite3_int64 lastPressed) {
+            KeySequence sequence{std::string(app), {std::string(first), std::string(second)},
+                                 count, lastPressed};
+            if (!third.empty()) {
+                sequence.combos.emplace_back(third);
+            }
+            sequences.push_back(std::move(sequence));
+        },
+        appId, static_cast<sqlite3_int64>(length), static_cast<sqlite3_int64>(limit));
+    return sequences;
+}
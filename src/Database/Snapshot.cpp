@@ -0,0 +1,105 @@
+#include "Database.h"
+#include <filesystem>
+#include <iostream>
+
+namespace {
+
+// Копирует основную БД source в destination целиком. Пока копирование
+// занято другим соединением, ждем и продолжаем с того же места.
+bool backupDatabase(sqlite3* source, sqlite3* destination) {
+    sqlite3_backup* backup = sqlite3_backup_init(destination, "main", source, "main");
+    if (!backup) {
+        std::cerr << "Failed to start backup: " << sqlite3_errmsg(destination) << std::endl;
+        return false;
+    }
+
+    int rc;
+    while ((rc = sqlite3_backup_step(backup, -1)) == SQLITE_BUSY || rc == SQLITE_LOCKED) {
+        sqlite3_sleep(10);
+    }
+    sqlite3_backup_finish(backup);
+
+    if (rc != SQLITE_DONE) {
+        std::cerr << "Backup failed: " << sqlite3_errstr(rc) << std::endl;
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+void Database::setSnapshotPolicy(const std::string& path, std::chrono::milliseconds interval) {
+    std::lock_guard<std::mutex> lock(writerMutex);
+    // Поток записи читает настройки без блокировки
+    if (writerThread.joinable()) {
+        std::cerr << "Snapshot policy must be set before initialize()" << std::endl;
+        return;
+    }
+    snapshotPath = path;
+    snapshotInterval = interval;
+}
+
+bool Database::snapshotNow() {
+    if (snapshotPath.empty()) {
+        return false;
+    }
+    return runOnWriter([this] { return writePendingDeltas() && writeSnapshot(); });
+}
+
+// Выполняется до запуска потока записи. Снимок не перекрывает данные:
+// загружается только в пустую основную БД (новую в памяти или новый файл).
+bool Database::loadSnapshot() {
+    if (!std::filesystem::exists(snapshotPath)) {
+        return true;
+    }
+
+    int objects = 0;
+    writer.select<int>("SELECT count(*) FROM sqlite_master;",
+                       [&](int count) { objects = count; });
+    if (objects > 0) {
+        return true;
+    }
+
+    // Флаг WAL из заголовка снимка копируется вместе со страницами, а memdb
+    // не умеет WAL: сначала переводим файл (например, бывшую основную БД)
+    // в обычный журнал
+    Connection source;
+    if (!source.open(snapshotPath, SQLITE_OPEN_READWRITE) ||
+        !source.executeScript("PRAGMA journal_mode = DELETE;")) {
+        return false;
+    }
+    if (!backupDatabase(source.get(), writer.get())) {
+        return false;
+    }
+    // Выражения кэша подготовлены для старой схемы
+    writer.clearStatements();
+    std::cout << "Database loaded from snapshot " << snapshotPath << std::endl;
+    return true;
+}
+
+// Выполняется в потоке записи: источник - само соединение записи, поэтому
+// снимок согласован и не ждет читателей. Файл снимка обновляется одной
+// транзакцией и при сбое посреди копирования остается прежним.
+bool Database::writeSnapshot() {
+    nextSnapshot = std::chrono::steady_clock::now() + snapshotInterval;
+
+    Connection destination;
+    if (!destination.open(snapshotPath, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE) ||
+        !destination.executeScript("PRAGMA journal_mode = DELETE;") ||
+        !backupDatabase(writer.get(), destination.get())) {
+        std::cerr << "Failed to write snapshot " << snapshotPath << std::endl;
+        return false;
+    }
+
+    // Нажатия до этого номера теперь на диске - журнал может их отпустить
+    std::function<void(std::uint64_t)> onCommitted;
+    {
+        std::lock_guard<std::mutex> lock(writerMutex);
+        onCommitted = onJournalCommitted;
+    }
+    if (unsnapshottedJournalSequence != 0 && onCommitted) {
+        onCommitted(unsnapshottedJournalSequence);
+    }
+    unsnapshottedJournalSequence = 0;
+    return true;
+}
@@ -0,0 +1,145 @@
+#pragma once
+#include <sqlite3.h>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+
+// Кэш подготовленных выражений одного соединения.
+// Ключ - текст SQL, который хранит сам sqlite3_stmt (sqlite3_sql),
+// поэтому повторный поиск не выделяет память.
+class StatementCache {
+private:
+  sqlite3 *db = nullptr;
+  std::unordered_map<std::string_view, sqlite3_stmt *> statements;
+
+public:
+  StatementCache() = default;
+  ~StatementCache() { clear(); }
+
+  StatementCache(const StatementCache &) = delete;
+  StatementCache &operator=(const StatementCache &) = delete;
+
+  // Привязка к соединению (старые выражения финализируются)
+  void attach(sqlite3 *connection) {
+    clear();
+    db = connection;
+  }
+
+  // Возвращает готовое к привязке выражение или nullptr при ошибке
+  sqlite3_stmt *acquire(const char *sql) {
+    auto it = statements.find(std::string_view(sql));
+    if (it != statements.end()) {
+      return it->second;
+    }
+
+    sqlite3_stmt *stmt = nullptr;
+    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
+      std::cerr << "Failed to prepare statement: " << sqlite3_errmsg(db)
+                << std::endl;
+      return nullptr;
+    }
+    statements.emplace(std::string_view(sqlite3_sql(stmt)), stmt);
+    return stmt;
+  }
+
+  void clear() {
+    for (auto &[sql, stmt] : statements) {
+      sqlite3_finalize(stmt);
+    }
+    statements.clear();
+  }
+
+  size_t size() const { return statements.size(); }
+};
+
+// Возвращает выражение в кэш: сброс состояния и привязок
+class StatementGuard {
+private:
+  sqlite3_stmt *stmt;
+
+public:
+  explicit StatementGuard(sqlite3_stmt *statement) : stmt(statement) {}
+  ~StatementGuard() {
+    if (stmt) {
+      sqlite3_reset(stmt);
+      sqlite3_clear_bindings(stmt);
+    }
+  }
+
+  StatementGuard(const StatementGuard &) = delete;
+  StatementGuard &operator=(const StatementGuard &) = delete;
+};
+
+// Типизированная привязка параметров. Строки привязываются как
+// SQLITE_STATIC: они живут до сброса выражения в StatementGuard.
+inline int bindParameter(sqlite3_stmt *stmt, int index, int value) {
+  return sqlite3_bind_int(stmt, index, value);
+}
+
+inline int bindParameter(sqlite3_stmt *stmt, int index, sqlite3_int64 value) {
+  return sqlite3_bind_int64(stmt, index, value);
+}
+
+inline int bindParameter(sqlite3_stmt *stmt, int index, std::string_view value) {
+  return sqlite3_bind_text(stmt, index, value.data(),
+                           static_cast<int>(value.size()), SQLITE_STATIC);
+}
+
+inline int bindParameter(sqlite3_stmt *stmt, int index,
+                         const std::string &value) {
+  return bindParameter(stmt, index, std::string_view(value));
+}
+
+inline int bindParameter(sqlite3_stmt *stmt, int index, const char *value) {
+  return bindParameter(stmt, index, std::string_view(value));
+}
+
+template <typename... Args>
+bool bindParameters([[maybe_unused]] sqlite3_stmt *stmt, const Args &...args) {
+  int index = 0;
+  bool success = true;
+  ((success = success && bindParameter(stmt, ++index, args) == SQLITE_OK),
+   ...);
+  return success;
+}
+
+// Типизированное чтение столбцов текущей строки.
+// std::string_view действителен только до следующего sqlite3_step.
+template <typename T> T readColumn(sqlite3_stmt *stmt, int index);
+
+template <> inline int readColumn<int>(sqlite3_stmt *stmt, int index) {
+  return sqlite3_column_int(stmt, index);
+}
+
+template <>
+inline sqlite3_int64 readColumn<sqlite3_int64>(sqlite3_stmt *stmt, int index) {
+  return sqlite3_column_int64(stmt, index);
+}
+
+template <>
+inline std::string_view readColumn<std::string_view>(sqlite3_stmt *stmt,
+                                                     int index) {
+  const char *text =
+      reinterpret_cast<const char *>(sqlite3_column_text(stmt, index));
+  if (!text) {
+    return {};
+  }
+  return std::string_view(text, sqlite3_column_bytes(stmt, index));
+}
+
+template <>
+inline std::string readColumn<std::string>(sqlite3_stmt *stmt, int index) {
+  return std::string(readColumn<std::string_view>(stmt, index));
+}
+
+// Вызов обработчика строки с типизированными столбцами
+template <typename... Columns, typename RowHandler, size_t... Indexes>
+void invokeRowHandler([[maybe_unused]] sqlite3_stmt *stmt, RowHandler &onRow,
+                      std::index_sequence<Indexes...>) {
+  onRow(readColumn<Columns>(stmt, static_cast<int>(Indexes))...);
+}
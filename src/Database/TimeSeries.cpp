@@ -0,0 +1,284 @@
+#include "Database.h"
+#include <array>
+#include <limits>
+#include <map>
+#include <string>
+#include <tuple>
+
+namespace {
+
+// Уровень свертки: ширина интервала и выражения для его таблицы
+struct RollupLevel {
+    sqlite3_int64 bucketMs;
+    const char* upsertSql;
+    const char* sumSql;
+    const char* table;
+};
+
+// От крупного к мелкому: запрос диапазона спускается по уровням.
+// Последний элемент - сырой журнал (bucketMs = 1, без upsert).
+const RollupLevel kRollupLevels[] = {
+    {86400000,
+        "INSERT INTO rollup_day (bucket, app_id, combo_id, press_count) "
+        "VALUES (?, ?, ?, ?) "
+        "ON CONFLICT(bucket, app_id, combo_id) DO UPDATE SET "
+        "press_count = press_count + excluded.press_count;",
+        "SELECT COALESCE(SUM(press_count), 0) FROM rollup_day "
+        "WHERE bucket >= ?1 AND bucket < ?2 "
+        "AND (?3 = 0 OR app_id = ?3) AND (?4 = 0 OR combo_id = ?4);",
+        "rollup_day"},
+    {3600000,
+        "INSERT INTO rollup_hour (bucket, app_id, combo_id, press_count) "
+        "VALUES (?, ?, ?, ?) "
+        "ON CONFLICT(bucket, app_id, combo_id) DO UPDATE SET "
+        "press_count = press_count + excluded.press_count;",
+        "SELECT COALESCE(SUM(press_count), 0) FROM rollup_hour "
+        "WHERE bucket >= ?1 AND bucket < ?2 "
+        "AND (?3 = 0 OR app_id = ?3) AND (?4 = 0 OR combo_id = ?4);",
+        "rollup_hour"},
+    {60000,
+        "INSERT INTO rollup_minute (bucket, app_id, combo_id, press_count) "
+        "VALUES (?, ?, ?, ?) "
+        "ON CONFLICT(bucket, app_id, combo_id) DO UPDATE SET "
+        "press_count = press_count + excluded.press_count;",
+        "SELECT COALESCE(SUM(press_count), 0) FROM rollup_minute "
+        "WHERE bucket >= ?1 AND bucket < ?2 "
+        "AND (?3 = 0 OR app_id = ?3) AND (?4 = 0 OR combo_id = ?4);",
+        "rollup_minute"},
+    {1,
+        nullptr,
+        "SELECT COUNT(*) FROM key_events "
+        "WHERE ts >= ?1 AND ts < ?2 "
+        "AND (?3 = 0 OR app_id = ?3) AND (?4 = 0 OR combo_id = ?4);",
+        nullptr},
+};
+constexpr size_t kRollupLevelCount = sizeof(kRollupLevels) / sizeof(kRollupLevels[0]) - 1;
+
+// Итоги комбинаций приложения за окно одним запросом. Куски диапазона -
+// по два на уровень в порядке kRollupLevels (?8..?23, пустой кусок -
+// [0, 0)); свертки читаются по покрывающим индексам idx_rollup_*_app.
+// Сначала суммы по комбинациям, затем фильтр модификаторов и курсор
+// (?4 - есть ли курсор) и сортировка только итогов с LIMIT.
+const char* const kRangeComboStatsSql =
+    "WITH segments (combo_id, presses) AS ("
+    "SELECT combo_id, press_count FROM rollup_day "
+    "WHERE app_id = ?1 AND bucket >= ?8 AND bucket < ?9 "
+    "UNION ALL SELECT combo_id, press_count FROM rollup_day "
+    "WHERE app_id = ?1 AND bucket >= ?10 AND bucket < ?11 "
+    "UNION ALL SELECT combo_id, press_count FROM rollup_hour "
+    "WHERE app_id = ?1 AND bucket >= ?12 AND bucket < ?13 "
+    "UNION ALL SELECT combo_id, press_count FROM rollup_hour "
+    "WHERE app_id = ?1 AND bucket >= ?14 AND bucket < ?15 "
+    "UNION ALL SELECT combo_id, press_count FROM rollup_minute "
+    "WHERE app_id = ?1 AND bucket >= ?16 AND bucket < ?17 "
+    "UNION ALL SELECT combo_id, press_count FROM rollup_minute "
+    "WHERE app_id = ?1 AND bucket >= ?18 AND bucket < ?19 "
+    "UNION ALL SELECT combo_id, 1 FROM key_events "
+    "WHERE ts >= ?20 AND ts < ?21 AND app_id = ?1 "
+    "UNION ALL SELECT combo_id, 1 FROM key_events "
+    "WHERE ts >= ?22 AND ts < ?23 AND app_id = ?1), "
+    "totals (combo_id, presses) AS ("
+    "SELECT combo_id, SUM(presses) FROM segments GROUP BY combo_id) "
+    "SELECT t.combo_id, c.combo, t.presses, COALESCE(k.last_pressed, 0) "
+    "FROM totals t JOIN combos c ON c.id = t.combo_id "
+    "LEFT JOIN key_counts k ON k.app_id = ?1 AND k.combo_id = t.combo_id "
+    "WHERE (c.modifiers & ?2) = ?2 AND (?3 = 0 OR c.modifiers = ?2) "
+    "AND (?4 = 0 OR t.presses < ?5 OR (t.presses = ?5 AND t.combo_id > ?6)) "
+    "ORDER BY t.presses DESC, t.combo_id ASC LIMIT ?7;";
+
+// Начало интервала, в который попадает ts (с учетом отрицательных ts)
+sqlite3_int64 floorToBucket(sqlite3_int64 ts, sqlite3_int64 bucketMs) {
+    sqlite3_int64 bucket = ts - ts % bucketMs;
+    return ts % bucketMs < 0 ? bucket - bucketMs : bucket;
+}
+
+sqlite3_int64 ceilToBucket(sqlite3_int64 ts, sqlite3_int64 bucketMs) {
+    sqlite3_int64 bucket = floorToBucket(ts, bucketMs);
+    return bucket == ts ? bucket : bucket + bucketMs;
+}
+
+// Разбивает [fromMs, toMs) на куски: выровненная середина берется с
+// уровня level, невыровненные края - с более мелких уровней, остаток -
+// из журнала. onSegment(const RollupLevel&, from, to)
+template <typename SegmentHandler>
+void forEachSegment(size_t level, sqlite3_int64 fromMs, sqlite3_int64 toMs,
+                    SegmentHandler& onSegment) {
+    if (fromMs >= toMs) {
+        return;
+    }
+
+    const auto& rollup = kRollupLevels[level];
+    if (level == kRollupLevelCount) {
+        onSegment(rollup, fromMs, toMs);
+        return;
+    }
+
+    sqlite3_int64 alignedFrom = ceilToBucket(fromMs, rollup.bucketMs);
+    sqlite3_int64 alignedTo = floorToBucket(toMs, rollup.bucketMs);
+    if (alignedFrom >= alignedTo) {
+        forEachSegment(level + 1, fromMs, toMs, onSegment);
+        return;
+    }
+
+    onSegment(rollup, alignedFrom, alignedTo);
+    forEachSegment(level + 1, fromMs, alignedFrom, onSegment);
+    forEachSegment(level + 1, alignedTo, toMs, onSegment);
+}
+
+} // namespace
+
+// Выполняется в потоке записи внутри транзакции сброса. Идентификаторы
+// в узлах пакета уже заполнены writePendingDeltas.
+bool Database::writeEventBatch(const std::vector<PendingEvent>& events) {
+    // (уровень, начало интервала, приложение, комбинация) -> приращение
+    std::map<std::tuple<size_t, sqlite3_int64, sqlite3_int64, sqlite3_int64>, int> rollups;
+
+    for (const auto& event : events) {
+        const auto& delta = event.entry->second;
+        if (!writer.execute("INSERT INTO key_events (ts, app_id, combo_id) VALUES (?, ?, ?);",
+                            event.timestamp, delta.appId, delta.comboId)) {
+            return false;
+        }
+
+        for (size_t level = 0; level < kRollupLevelCount; ++level) {
+            sqlite3_int64 bucket = floorToBucket(event.timestamp, kRollupLevels[level].bucketMs);
+            rollups[{level, bucket, delta.appId, delta.comboId}]++;
+        }
+    }
+
+    for (const auto& [key, count] : rollups) {
+        const auto& [level, bucket, appId, comboId] = key;
+        if (!writer.execute(kRollupLevels[level].upsertSql, bucket, appId, comboId, count)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Доливает свертки источника merge_src (слияние): журнал источника
+// хранится недолго, и история за его сроком есть только в свертках.
+// Как и для счетчиков, merge_rollups помнит влитое значение каждой
+// корзины, поэтому добавляется только прирост; корзины, которые источник
+// уже удалил по сроку хранения, из памяти убираются. Выполняется в потоке
+// записи внутри транзакции слияния, после заполнения temp.merge_*_map.
+bool Database::mergeSourceRollups(sqlite3_int64 sourceId) {
+    for (size_t level = 0; level < kRollupLevelCount; ++level) {
+        const RollupLevel& rollup = kRollupLevels[level];
+        std::string table = rollup.table;
+        std::string source =
+            "FROM merge_src." + table + " s "
+            "JOIN temp.merge_app_map am ON am.src_id = s.app_id "
+            "JOIN temp.merge_combo_map cm ON cm.src_id = s.combo_id ";
+        std::string addDeltas =
+            "WITH delta AS ("
+            "SELECT s.bucket AS bucket, am.dst_id AS app_id, cm.dst_id AS combo_id, "
+            "CASE WHEN s.press_count >= COALESCE(m.press_count, 0) "
+            "THEN s.press_count - COALESCE(m.press_count, 0) ELSE s.press_count END AS added " +
+            source +
+            "LEFT JOIN merge_rollups m ON m.source_id = ?1 AND m.bucket_ms = ?2 "
+            "AND m.bucket = s.bucket AND m.app_id = am.dst_id AND m.combo_id = cm.dst_id) "
+            "INSERT INTO main." + table + " (bucket, app_id, combo_id, press_count) "
+            "SELECT bucket, app_id, combo_id, added FROM delta WHERE added > 0 "
+            "ON CONFLICT(bucket, app_id, combo_id) DO UPDATE SET "
+            "press_count = press_count + excluded.press_count;";
+        std::string remember =
+            "INSERT INTO merge_rollups (source_id, bucket_ms, bucket, app_id, combo_id, press_count) "
+            "SELECT ?1, ?2, s.bucket, am.dst_id, cm.dst_id, s.press_count " + source +
+            "WHERE true "
+            "ON CONFLICT(source_id, bucket_ms, bucket, app_id, combo_id) DO UPDATE SET "
+            "press_count = excluded.press_count;";
+        std::string forgetRetired =
+            "DELETE FROM merge_rollups WHERE source_id = ?1 AND bucket_ms = ?2 AND bucket < "
+            "COALESCE((SELECT MIN(bucket) FROM merge_src." + table + "), ?3);";
+        if (!writer.execute(addDeltas.c_str(), sourceId, rollup.bucketMs) ||
+            !writer.execute(remember.c_str(), sourceId, rollup.bucketMs) ||
+            !writer.execute(forgetRetired.c_str(), sourceId, rollup.bucketMs,
+                            std::numeric_limits<sqlite3_int64>::max())) {
+            return false;
+        }
+    }
+    return true;
+}
+
+sqlite3_int64 Database::countPresses(sqlite3_int64 fromMs, sqlite3_int64 toMs,
+                                     const std::string& appName,
+                                     const std::string& keyCombination) {
+    auto reader = readers.acquire();
+    if (!reader) {
+        return 0;
+    }
+
+    // Фильтр по имени превращается в фильтр по идентификатору;
+    // неизвестное имя означает, что нажатий нет
+    sqlite3_int64 appId = 0;
+    sqlite3_int64 comboId = 0;
+    if (!appName.empty()) {
+        reader->select<sqlite3_int64>("SELECT id FROM apps WHERE name = ?;",
+            [&](sqlite3_int64 id) { appId = id; }, appName);
+        if (appId == 0) {
+            return 0;
+        }
+    }
+    if (!keyCombination.empty()) {
+        reader->select<sqlite3_int64>("SELECT id FROM combos WHERE combo = ?;",
+            [&](sqlite3_int64 id) { comboId = id; }, keyCombination);
+        if (comboId == 0) {
+            return 0;
+        }
+    }
+
+    // Все части диапазона читаются из одного снимка
+    sqlite3_int64 total = 0;
+    auto sumSegment = [&](const RollupLevel& rollup, sqlite3_int64 from, sqlite3_int64 to) {
+        reader->select<sqlite3_int64>(rollup.sumSql,
+            [&](sqlite3_int64 value) { total += value; }, from, to, appId, comboId);
+    };
+    reader->execute("BEGIN;");
+    forEachSegment(0, fromMs, toMs, sumSegment);
+    reader->execute("COMMIT;");
+    return total;
+}
+
+// Счетчики за окно времени: суммы по комбинациям собираются из сверток
+// в SQL, как и фильтры и продолжение с курсора. Память - на страницу.
+ComboStatsPage Database::queryRangeComboStats(Connection& connection, sqlite3_int64 appId,
+                                              const ComboStatsQuery& query) {
+    ComboStatsPage page;
+    sqlite3_int64 fromMs = query.fromMs.value_or(std::numeric_limits<sqlite3_int64>::min() / 2);
+    sqlite3_int64 toMs = query.toMs.value_or(std::numeric_limits<sqlite3_int64>::max() / 2);
+
+    // Границы кусков: на каждом уровне не больше двух (середина
+    // диапазона и по краю с каждой стороны)
+    std::array<sqlite3_int64, (kRollupLevelCount + 1) * 4> bounds{};
+    std::array<size_t, kRollupLevelCount + 1> used{};
+    auto addSegment = [&](const RollupLevel& rollup, sqlite3_int64 from, sqlite3_int64 to) {
+        size_t level = static_cast<size_t>(&rollup - kRollupLevels);
+        size_t slot = level * 4 + used[level]++ * 2;
+        bounds[slot] = from;
+        bounds[slot + 1] = to;
+    };
+    forEachSegment(0, fromMs, toMs, addSegment);
+
+    int limit = pageFetchLimit(query.pageSize);
+    int mask = static_cast<int>(query.modifiers);
+    int exact = query.exactModifiers ? 1 : 0;
+    int hasCursor = query.after ? 1 : 0;
+    sqlite3_int64 afterCount = query.after ? query.after->pressCount : 0;
+    sqlite3_int64 afterCombo = query.after ? query.after->comboId : 0;
+
+    auto onRow = [&](sqlite3_int64 comboId, std::string_view combo,
+                     sqlite3_int64 pressCount, sqlite3_int64 lastPressed) {
+        page.rows.push_back({comboId, std::string(combo), pressCount, lastPressed});
+    };
+    std::apply([&](auto... bound) {
+        connection.select<sqlite3_int64, std::string_view, sqlite3_int64, sqlite3_int64>(
+            kRangeComboStatsSql, onRow, appId, mask, exact, hasCursor, afterCount, afterCombo,
+            limit, bound...);
+    }, bounds);
+
+    if (query.pageSize > 0 && page.rows.size() > query.pageSize) {
+        page.rows.pop_back();
+        page.next = ComboStatsCursor{page.rows.back().pressCount, page.rows.back().comboId};
+    }
+    return page;
+}
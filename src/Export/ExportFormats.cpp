@@ -0,0 +1,231 @@
+#include "ExportFormats.h"
+#include <cstdio>
+#include <string>
+
+namespace {
+
+// Поле CSV: в кавычках, только если есть запятая, кавычка или перевод строки
+void appendCsvField(ExportWriter& out, std::string_view value) {
+    if (value.find_first_of(",\"\r\n") == std::string_view::npos) {
+        out.append(value);
+        return;
+    }
+    out.append('"');
+    for (char c : value) {
+        if (c == '"') {
+            out.append('"');
+        }
+        out.append(c);
+    }
+    out.append('"');
+}
+
+// Строка JSON; UTF-8 передается как есть, управляющие символы - \uXXXX
+void appendJsonString(ExportWriter& out, std::string_view value) {
+    out.append('"');
+    for (char c : value) {
+        switch (c) {
+        case '"': out.append("\\\""); break;
+        case '\\': out.append("\\\\"); break;
+        case '\n': out.append("\\n"); break;
+        case '\r': out.append("\\r"); break;
+        case '\t': out.append("\\t"); break;
+        default:
+            if (static_cast<unsigned char>(c) < 0x20) {
+                char escaped[8];
+                std::snprintf(escaped, sizeof(escaped), "\\u%04x", static_cast<unsigned>(c));
+                out.append(escaped);
+            } else {
+                out.append(c);
+            }
+        }
+    }
+    out.append('"');
+}
+
+void appendPadded(ExportWriter& out, std::string_view value, size_t width, bool alignLeft) {
+    size_t padding = value.size() < width ? width - value.size() : 0;
+    if (!alignLeft) {
+        out.append(std::string(padding, ' '));
+    }
+    out.append(value);
+    if (alignLeft) {
+        out.append(std::string(padding, ' '));
+    }
+}
+
+// Время в мс от эпохи как "YYYY-MM-DD HH:MM:SS.mmm" (UTC), без gmtime
+void appendUtcTimestamp(ExportWriter& out, std::int64_t ms) {
+    std::int64_t days = ms / 86400000;
+    std::int64_t msOfDay = ms % 86400000;
+    if (msOfDay < 0) {
+        msOfDay += 86400000;
+        days -= 1;
+    }
+
+    // Гражданская дата по числу дней (алгоритм civil_from_days)
+    std::int64_t z = days + 719468;
+    std::int64_t era = (z >= 0 ? z : z - 146096) / 146097;
+    std::int64_t doe = z - era * 146097;
+    std::int64_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    std::int64_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    std::int64_t mp = (5 * doy + 2) / 153;
+    std::int64_t day = doy - (153 * mp + 2) / 5 + 1;
+    std::int64_t month = mp < 10 ? mp + 3 : mp - 9;
+    std::int64_t year = yoe + era * 400 + (month <= 2 ? 1 : 0);
+
+    char text[96];
+    std::snprintf(text, sizeof(text), "%04lld-%02lld-%02lld %02lld:%02lld:%02lld.%03lld",
+                  static_cast<long long>(year), static_cast<long long>(month),
+                  static_cast<long long>(day), static_cast<long long>(msOfDay / 3600000),
+                  static_cast<long long>(msOfDay / 60000 % 60),
+                  static_cast<long long>(msOfDay / 1000 % 60),
+                  static_cast<long long>(msOfDay % 1000));
+    out.append(text);
+}
+
+class CsvFormatter : public RecordFormatter {
+private:
+    ExportContent content;
+
+public:
+    CsvFormatter(ExportWriter& writer, ExportContent content)
+        : RecordFormatter(writer), content(content) {}
+
+    void begin() override {
+        out.append(content == ExportContent::Events ? "timestamp,app,combo\n"
+                                                    : "app,combo,press_count,last_pressed\n");
+    }
+
+    void write(const ExportRecord& record) override {
+        if (content == ExportContent::Events) {
+            out.appendInt(record.timestamp);
+            out.append(',');
+            appendCsvField(out, record.appName);
+            out.append(',');
+            appendCsvField(out, record.keyCombination);
+        } else {
+            appendCsvField(out, record.appName);
+            out.append(',');
+            appendCsvField(out, record.keyCombination);
+            out.append(',');
+            out.appendInt(record.pressCount);
+            out.append(',');
+            out.appendInt(record.timestamp);
+        }
+        out.append('\n');
+    }
+};
+
+class JsonLinesFormatter : public RecordFormatter {
+private:
+    ExportContent content;
+
+public:
+    JsonLinesFormatter(ExportWriter& writer, ExportContent content)
+        : RecordFormatter(writer), content(content) {}
+
+    void write(const ExportRecord& record) override {
+        if (content == ExportContent::Events) {
+            out.append("{\"timestamp\":");
+            out.appendInt(record.timestamp);
+            out.append(",\"app\":");
+            appendJsonString(out, record.appName);
+            out.append(",\"combo\":");
+            appendJsonString(out, record.keyCombination);
+        } else {
+            out.append("{\"app\":");
+            appendJsonString(out, record.appName);
+            out.append(",\"combo\":");
+            appendJsonString(out, record.keyCombination);
+            out.append(",\"press_count\":");
+            out.appendInt(record.pressCount);
+            out.append(",\"last_pressed\":");
+            out.appendInt(record.timestamp);
+        }
+        out.append("}\n");
+    }
+};
+
+// Отчет в прежнем виде: раздел на приложение, строки по убыванию
+// счетчика, итоги раздела. Строки приходят сгруппированными по приложению.
+class TextTotalsFormatter : public RecordFormatter {
+private:
+    std::string currentApp;
+    bool inSection = false;
+    int rank = 0;
+    std::int64_t sectionPresses = 0;
+
+    void closeSection() {
+        if (!inSection) {
+            return;
+        }
+        out.append('\n');
+        out.append(std::string(40, '-'));
+        out.append("\nTotal combinations: ");
+        out.appendInt(rank);
+        out.append("\nTotal key presses: ");
+        out.appendInt(sectionPresses);
+        out.append('\n');
+        inSection = false;
+    }
+
+public:
+    using RecordFormatter::RecordFormatter;
+
+    void write(const ExportRecord& record) override {
+        if (!inSection || record.appName != currentApp) {
+            closeSection();
+            currentApp.assign(record.appName);
+            inSection = true;
+            rank = 0;
+            sectionPresses = 0;
+            out.append("\nStatistics for ");
+            out.append(record.appName);
+            out.append(":\n");
+        }
+
+        ++rank;
+        sectionPresses += record.pressCount;
+        appendPadded(out, std::to_string(rank), 2, false);
+        out.append(". ");
+        appendPadded(out, record.keyCombination, 25, true);
+        appendPadded(out, std::to_string(record.pressCount), 6, false);
+        out.append(" times\n");
+    }
+
+    void end() override { closeSection(); }
+};
+
+class TextEventsFormatter : public RecordFormatter {
+public:
+    using RecordFormatter::RecordFormatter;
+
+    void write(const ExportRecord& record) override {
+        appendUtcTimestamp(out, record.timestamp);
+        out.append("  ");
+        out.append(record.appName);
+        out.append("  ");
+        out.append(record.keyCombination);
+        out.append('\n');
+    }
+};
+
+} // namespace
+
+std::unique_ptr<RecordFormatter> makeRecordFormatter(ExportFormat format,
+                                                     ExportContent content,
+                                                     ExportWriter& writer) {
+    switch (format) {
+    case ExportFormat::Csv:
+        return std::make_unique<CsvFormatter>(writer, content);
+    case ExportFormat::JsonLines:
+        return std::make_unique<JsonLinesFormatter>(writer, content);
+    case ExportFormat::Text:
+    default:
+        if (content == ExportContent::Events) {
+            return std::make_unique<TextEventsFormatter>(writer);
+        }
+        return std::make_unique<TextTotalsFormatter>(writer);
+    }
+}
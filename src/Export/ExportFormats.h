@@ -0,0 +1,29 @@
+#pragma once
+#include "ExportWriter.h"
+#include "Models/ExportRecord.h"
+#include <memory>
+
+enum class ExportFormat {
+  Text,      // прежний человекочитаемый отчет
+  Csv,       // RFC 4180, первая строка - заголовок
+  JsonLines, // один JSON-объект на строку
+};
+
+// Форматирование потока строк выгрузки. Состояние - только текущая
+// группа (для текстового отчета), сами строки не накапливаются.
+class RecordFormatter {
+protected:
+  ExportWriter &out;
+
+public:
+  explicit RecordFormatter(ExportWriter &writer) : out(writer) {}
+  virtual ~RecordFormatter() = default;
+
+  virtual void begin() {}
+  virtual void write(const ExportRecord &record) = 0;
+  virtual void end() {}
+};
+
+std::unique_ptr<RecordFormatter> makeRecordFormatter(ExportFormat format,
+                                                     ExportContent content,
+                                                     ExportWriter &writer);
@@ -0,0 +1,84 @@
+#include "ExportWriter.h"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+ExportWriter::ExportWriter(size_t bufferSize) : buffer(bufferSize > 0 ? bufferSize : 1) {}
+
+ExportWriter::~ExportWriter() {
+    close();
+}
+
+bool ExportWriter::open(const std::string& path) {
+    close();
+    file = std::fopen(path.c_str(), "wb");
+    if (!file) {
+        std::cerr << "Failed to open export file: " << path << std::endl;
+        error = true;
+        return false;
+    }
+    used = 0;
+    bytesWritten = 0;
+    error = false;
+    return true;
+}
+
+bool ExportWriter::close() {
+    if (!file) {
+        return !error;
+    }
+    flushBuffer();
+    if (std::fclose(file) != 0) {
+        error = true;
+    }
+    file = nullptr;
+    return !error;
+}
+
+void ExportWriter::flushBuffer() {
+    if (used == 0 || error || !file) {
+        used = 0;
+        return;
+    }
+    if (std::fwrite(buffer.data(), 1, used, file) != used) {
+        std::cerr << "Failed to write export file" << std::endl;
+        error = true;
+    }
+    bytesWritten += used;
+    used = 0;
+}
+
+void ExportWriter::append(std::string_view text) {
+    while (!text.empty() && !error) {
+        if (used == buffer.size()) {
+            flushBuffer();
+        }
+        size_t chunk = std::min(text.size(), buffer.size() - used);
+        std::memcpy(buffer.data() + used, text.data(), chunk);
+        used += chunk;
+        text.remove_prefix(chunk);
+    }
+}
+
+void ExportWriter::append(char c) {
+    if (used == buffer.size()) {
+        flushBuffer();
+    }
+    buffer[used++] = c;
+}
+
+void ExportWriter::appendInt(std::int64_t value) {
+    // Без локали и без временных строк
+    char digits[24];
+    size_t pos = sizeof(digits);
+    std::uint64_t magnitude = value < 0 ? 0 - static_cast<std::uint64_t>(value)
+                                        : static_cast<std::uint64_t>(value);
+    do {
+        digits[--pos] = static_cast<char>('0' + magnitude % 10);
+        magnitude /= 10;
+    } while (magnitude != 0);
+    if (value < 0) {
+        digits[--pos] = '-';
+    }
+    append(std::string_view(digits + pos, sizeof(digits) - pos));
+}
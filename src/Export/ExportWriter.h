@@ -0,0 +1,38 @@
+#pragma once
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Буферизованная запись в файл: данные копируются в буфер фиксированного
+// размера и уходят на диск крупными блоками. Память не зависит от объема
+// выгрузки. После первой ошибки запись прекращается, failed() = true.
+class ExportWriter {
+private:
+  std::FILE *file = nullptr;
+  std::vector<char> buffer;
+  size_t used = 0;
+  std::uint64_t bytesWritten = 0;
+  bool error = false;
+
+  void flushBuffer();
+
+public:
+  explicit ExportWriter(size_t bufferSize = 64 * 1024);
+  ~ExportWriter();
+
+  ExportWriter(const ExportWriter &) = delete;
+  ExportWriter &operator=(const ExportWriter &) = delete;
+
+  bool open(const std::string &path);
+  // Сбрасывает остаток буфера и закрывает файл
+  bool close();
+
+  void append(std::string_view text);
+  void append(char c);
+  void appendInt(std::int64_t value);
+
+  bool failed() const { return error; }
+  std::uint64_t size() const { return bytesWritten + used; }
+};
@@ -0,0 +1,50 @@
+#include "StatisticsExporter.h"
+#include <iostream>
+
+ExportResult StatisticsExporter::exportToFile(const std::string& path,
+                                              const ExportOptions& options) {
+    ExportResult result;
+
+    // Нажатия из буфера отложенной записи тоже попадают в выгрузку
+    db.flush();
+
+    ExportFilter filter = options.filter;
+    if (!options.watermark.empty()) {
+        filter.afterEventId = db.getExportWatermark(options.watermark);
+    }
+
+    ExportWriter writer(bufferSize);
+    if (!writer.open(path)) {
+        return result;
+    }
+
+    auto formatter = makeRecordFormatter(options.format, filter.content, writer);
+    formatter->begin();
+
+    sqlite3_int64 lastEventId = 0;
+    bool scanned = db.scanExportRecords(filter,
+        [&](const ExportRecord& record) {
+            if (!writer.failed()) {
+                formatter->write(record);
+                ++result.records;
+            }
+        },
+        lastEventId);
+
+    formatter->end();
+    bool written = writer.close();
+    result.bytes = writer.size();
+
+    if (!scanned || !written) {
+        std::cerr << "Export to " << path << " failed" << std::endl;
+        return result;
+    }
+
+    // Отметка сдвигается только после того, как файл целиком записан
+    if (!options.watermark.empty() && !db.setExportWatermark(options.watermark, lastEventId)) {
+        return result;
+    }
+
+    result.success = true;
+    return result;
+}
@@ -0,0 +1,36 @@
+#pragma once
+#include "Database/Database.h"
+#include "ExportFormats.h"
+#include <cstdint>
+#include <string>
+
+struct ExportOptions {
+  ExportFormat format = ExportFormat::Text;
+  ExportFilter filter;
+
+  // Непустое имя включает режим "только новое с прошлой выгрузки":
+  // отметка с этим именем читается перед выгрузкой и сдвигается после
+  // успешной записи файла
+  std::string watermark;
+};
+
+struct ExportResult {
+  bool success = false;
+  std::uint64_t records = 0;
+  std::uint64_t bytes = 0;
+};
+
+// Потоковая выгрузка статистики в файл: один курсор по БД, форматирование
+// на лету и запись через буфер фиксированного размера. Время и память не
+// зависят от числа строк, кроме самой записи на диск.
+class StatisticsExporter {
+private:
+  Database &db;
+  size_t bufferSize;
+
+public:
+  explicit StatisticsExporter(Database &database, size_t bufferSize = 64 * 1024)
+      : db(database), bufferSize(bufferSize) {}
+
+  ExportResult exportToFile(const std::string &path, const ExportOptions &options);
+};
@@ -0,0 +1,192 @@
+#include "ErgonomicModel.h"
+#include <bitset>
+#include <cmath>
+#include <utility>
+
+namespace {
+
+struct ModifierName {
+    unsigned mask;
+    std::string_view prefix;
+};
+
+// Порядок KeyLogger
+const ModifierName kModifierNames[] = {
+    {ModifierCtrl, "Ctrl+"},
+    {ModifierShift, "Shift+"},
+    {ModifierAlt, "Alt+"},
+    {ModifierWin, "Win+"},
+};
+
+// Домашние позиции пальцев (столбец, ряд); большие пальцы - на пробеле
+const double kHomeColumn[10] = {1.75, 2.75, 3.75, 4.75, 5.5, 7.5, 7.75, 8.75, 9.75, 10.75};
+const double kHomeRow[10] = {2, 2, 2, 2, 4, 4, 2, 2, 2, 2};
+
+// Палец по номеру столбца основного блока, считая от Q/A/Z/1
+int fingerForColumn(int column) {
+    static const int fingers[] = {0, 1, 2, 3, 3, 6, 6, 7, 8};
+    if (column < 0) {
+        return 0;
+    }
+    return column < 9 ? fingers[column] : 9;
+}
+
+// Ближайший по домашней позиции палец (кроме больших)
+int nearestFinger(double column) {
+    int best = 0;
+    for (int finger = 1; finger < 10; ++finger) {
+        if (finger == 4 || finger == 5) {
+            continue;
+        }
+        if (std::abs(kHomeColumn[finger] - column) < std::abs(kHomeColumn[best] - column)) {
+            best = finger;
+        }
+    }
+    return best;
+}
+
+double distance(const KeyPlacement& a, double row, double column) {
+    return std::hypot(a.row - row, a.column - column);
+}
+
+} // namespace
+
+Chord parseChord(std::string_view combination) {
+    Chord chord;
+    // Порядок модификаторов в строке не важен. Префикс снимается, только
+    // если после него что-то остается: "Ctrl++" - это Ctrl и клавиша "+"
+    bool found = true;
+    while (found) {
+        found = false;
+        for (const auto& modifier : kModifierNames) {
+            if (combination.size() > modifier.prefix.size() &&
+                combination.substr(0, modifier.prefix.size()) == modifier.prefix) {
+                chord.modifiers |= modifier.mask;
+                combination.remove_prefix(modifier.prefix.size());
+                found = true;
+            }
+        }
+    }
+    chord.key = std::string(combination);
+    return chord;
+}
+
+std::string formatChord(const Chord& chord) {
+    std::string combination;
+    for (const auto& modifier : kModifierNames) {
+        if (chord.modifiers & modifier.mask) {
+            combination += modifier.prefix;
+        }
+    }
+    return combination + chord.key;
+}
+
+ErgonomicModel::ErgonomicModel(const ErgonomicWeights& weights) : weights(weights) {
+    // Ряды основного блока со сдвигом относительно ряда цифр
+    const std::pair<const char*, double> rows[] = {
+        {"1234567890-=", 1.0}, // перед "1" стоит "`"
+        {"QWERTYUIOP[]\\", 1.5},
+        {"ASDFGHJKL;'", 1.75},
+        {"ZXCVBNM,./", 2.25},
+    };
+    for (int row = 0; row < 4; ++row) {
+        const auto& [layout, offset] = rows[row];
+        for (int column = 0; layout[column] != '\0'; ++column) {
+            std::string key(1, layout[column]);
+            keys[key] = {static_cast<double>(row), offset + column, fingerForColumn(column)};
+            candidateKeys.push_back(key);
+        }
+    }
+    keys["`"] = {0, 0, 0};
+    candidateKeys.push_back("`");
+
+    // Ряд F-клавиш группами по четыре
+    for (int n = 1; n <= 12; ++n) {
+        double column = 1 + n + (n > 4 ? 0.5 : 0) + (n > 8 ? 0.5 : 0);
+        std::string key = "F" + std::to_string(n);
+        keys[key] = {-1, column, nearestFinger(column)};
+        candidateKeys.push_back(key);
+    }
+
+    // Остальные клавиши известны модели, но не предлагаются
+    keys["Esc"] = {-1, 0, 0};
+    keys["Tab"] = {1, 0.5, 0};
+    keys["Backspace"] = {0, 13.5, 9};
+    keys["Enter"] = {2, 12.5, 9};
+    keys["Space"] = {4, 6.5, 5};
+    keys["Insert"] = {0, 15.5, 6};
+    keys["Home"] = {0, 16.5, 6};
+    keys["PageUp"] = {0, 17.5, 6};
+    keys["Delete"] = {1, 15.5, 6};
+    keys["End"] = {1, 16.5, 6};
+    keys["PageDown"] = {1, 17.5, 6};
+    keys["↑"] = {3, 16.5, 6};
+    keys["←"] = {4, 15.5, 6};
+    keys["↓"] = {4, 16.5, 6};
+    keys["→"] = {4, 17.5, 6};
+}
+
+std::optional<ChordGeometry> ErgonomicModel::locate(const Chord& chord) const {
+    auto it = keys.find(chord.key);
+    if (it == keys.end()) {
+        return std::nullopt;
+    }
+    return ChordGeometry{chord.modifiers, it->second};
+}
+
+double ErgonomicModel::chordCost(const ChordGeometry& chord) const {
+    const auto& key = chord.key;
+    double cost = weights.travel * distance(key, kHomeRow[key.finger], kHomeColumn[key.finger]);
+    if (key.finger == 0 || key.finger == 9) {
+        cost += weights.pinky;
+    } else if (key.finger == 1 || key.finger == 8) {
+        cost += weights.ring;
+    }
+
+    const std::pair<unsigned, double> modifierCosts[] = {
+        {ModifierCtrl, weights.ctrl},
+        {ModifierShift, weights.shift},
+        {ModifierAlt, weights.alt},
+        {ModifierWin, weights.win},
+    };
+    size_t held = 0;
+    for (const auto& [mask, modifierCost] : modifierCosts) {
+        if (chord.modifiers & mask) {
+            cost += modifierCost;
+            ++held;
+        }
+    }
+    if (held > 1) {
+        cost += weights.extraModifier * static_cast<double>(held - 1);
+    }
+    if ((chord.modifiers & (ModifierCtrl | ModifierShift)) && key.finger == 0) {
+        cost += weights.pinkyConflict;
+    }
+    return cost;
+}
+
+double ErgonomicModel::transitionCost(const ChordGeometry& from, const ChordGeometry& to) const {
+    bool sameKey = from.key.row == to.key.row && from.key.column == to.key.column;
+    double cost = weights.modifierChange *
+                  static_cast<double>(std::bitset<4>(from.modifiers ^ to.modifiers).count());
+    if (sameKey) {
+        return cost;
+    }
+    if (from.key.finger == to.key.finger) {
+        cost += weights.sameFinger;
+    } else if (from.key.leftHand() == to.key.leftHand()) {
+        cost += weights.sameHand;
+    }
+    return cost;
+}
+
+std::vector<Chord> ErgonomicModel::candidateChords(const std::vector<unsigned>& modifierSets) const {
+    std::vector<Chord> chords;
+    chords.reserve(modifierSets.size() * candidateKeys.size());
+    for (unsigned modifiers : modifierSets) {
+        for (const auto& key : candidateKeys) {
+            chords.push_back({modifiers, key});
+        }
+    }
+    return chords;
+}
@@ -0,0 +1,82 @@
+#pragma once
+#include "Models/ComboStats.h"
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Комбинация, разобранная на модификаторы и основную клавишу
+struct Chord {
+  unsigned modifiers = ModifierNone;
+  std::string key;
+
+  bool operator==(const Chord &other) const {
+    return modifiers == other.modifiers && key == other.key;
+  }
+};
+
+// "Ctrl+Shift+S" -> {Ctrl | Shift, "S"}. formatChord пишет модификаторы в
+// порядке KeyLogger: Ctrl+Shift+Alt+Win+клавиша.
+Chord parseChord(std::string_view combination);
+std::string formatChord(const Chord &chord);
+
+// Место клавиши на клавиатуре ANSI (в ширинах клавиши; ряд 2 - домашний)
+// и палец, которым ее нажимают при слепой печати: 0-3 - левые мизинец,
+// безымянный, средний, указательный; 4-5 - большие; 6-9 - правые
+// указательный ... мизинец
+struct KeyPlacement {
+  double row = 0;
+  double column = 0;
+  int finger = 0;
+
+  bool leftHand() const { return finger <= 4; }
+};
+
+// Размещение комбинации: модификаторы плюс место основной клавиши
+struct ChordGeometry {
+  unsigned modifiers = ModifierNone;
+  KeyPlacement key;
+};
+
+// Веса модели; стоимость - условные единицы на одно нажатие
+struct ErgonomicWeights {
+  double travel = 0.5;        // за ширину клавиши от домашней позиции пальца
+  double pinky = 0.4;         // слабые пальцы
+  double ring = 0.2;
+  double ctrl = 0.5;          // удержание модификатора
+  double shift = 0.4;
+  double alt = 0.7;
+  double win = 1.0;
+  double extraModifier = 0.4; // за каждый модификатор после первого
+  double pinkyConflict = 0.8; // клавиша под левым мизинцем, который держит Ctrl/Shift
+  // Переходы между соседними нажатиями
+  double sameFinger = 1.0;    // другая клавиша тем же пальцем
+  double sameHand = 0.2;
+  double modifierChange = 0.3; // за каждый отпущенный или добавленный модификатор
+};
+
+// Эргономическая стоимость нажатий: путь пальца до клавиши, сила пальца,
+// сложность аккорда модификаторов и неудобные переходы между
+// комбинациями. Модификаторы считаются нажатыми левой рукой.
+class ErgonomicModel {
+private:
+  ErgonomicWeights weights;
+  std::unordered_map<std::string, KeyPlacement> keys;
+  std::vector<std::string> candidateKeys; // порядок выдачи candidateChords
+
+public:
+  explicit ErgonomicModel(const ErgonomicWeights &weights = ErgonomicWeights());
+
+  const ErgonomicWeights &getWeights() const { return weights; }
+
+  // Пусто для клавиш, которых модель не знает
+  std::optional<ChordGeometry> locate(const Chord &chord) const;
+
+  double chordCost(const ChordGeometry &chord) const;
+  double transitionCost(const ChordGeometry &from, const ChordGeometry &to) const;
+
+  // Варианты для переназначения: буквы, цифры, знаки основного блока и
+  // F1-F12 с каждым из наборов модификаторов
+  std::vector<Chord> candidateChords(const std::vector<unsigned> &modifierSets) const;
+};
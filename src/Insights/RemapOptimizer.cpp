@@ -0,0 +1,444 @@
+#include "RemapOptimizer.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <random>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace {
+
+constexpr size_t kNone = std::numeric_limits<size_t>::max();
+// Отмена и время проверяются раз в порцию итераций
+constexpr std::uint64_t kCheckInterval = 1024;
+constexpr size_t kDescentPasses = 8;
+
+// Место, которое может занять комбинация
+struct Slot {
+    Chord chord;
+    ChordGeometry geometry;
+    double cost = 0;
+    bool blocked = false; // занято неподвижной комбинацией или зарезервировано
+};
+
+struct Neighbor {
+    size_t other;
+    double weight;
+    bool outgoing; // this -> other
+};
+
+// Комбинация задачи; повторяющиеся имена сливаются в одну
+struct Node {
+    std::string combination;
+    std::int64_t pressCount = 0;
+    size_t origin = 0;
+    bool movable = false;
+    std::vector<Neighbor> neighbors;
+};
+
+// Общие для всех цепочек неизменяемые данные
+struct Layout {
+    const ErgonomicModel* model = nullptr;
+    std::vector<Slot> slots;
+    std::vector<size_t> openSlots;
+    std::vector<Node> nodes;
+    std::vector<size_t> movable;
+    double changePenalty = 0;
+};
+
+// Полная стоимость размещения: нажатия, плата за переназначения, переходы
+double assignmentCost(const Layout& layout, const std::vector<size_t>& slotOf) {
+    double total = 0;
+    for (size_t node = 0; node < layout.nodes.size(); ++node) {
+        const auto& n = layout.nodes[node];
+        const auto& slot = layout.slots[slotOf[node]];
+        total += static_cast<double>(n.pressCount) * slot.cost;
+        if (slotOf[node] != n.origin) {
+            total += static_cast<double>(n.pressCount) * layout.changePenalty;
+        }
+        for (const auto& neighbor : n.neighbors) {
+            if (neighbor.outgoing) {
+                total += neighbor.weight * layout.model->transitionCost(
+                    slot.geometry, layout.slots[slotOf[neighbor.other]].geometry);
+            }
+        }
+    }
+    return total;
+}
+
+// Одна цепочка отжига: размещение комбинаций по местам. Стоимость
+// ведется приращениями, O(соседей) на ход.
+class Chain {
+private:
+    const Layout& layout;
+    std::vector<size_t> slotOf;
+    std::vector<size_t> occupant; // по местам; kNone - свободно
+    double cost = 0;
+    std::mt19937_64 random;
+
+    double transition(size_t fromSlot, size_t toSlot) const {
+        return layout.model->transitionCost(layout.slots[fromSlot].geometry,
+                                            layout.slots[toSlot].geometry);
+    }
+
+    // Вклад комбинации на месте slot; ребра к skip не считаются, чтобы
+    // при обмене двух соседей их общие переходы не учитывались дважды
+    double nodeCost(size_t node, size_t slot, size_t skip) const {
+        const auto& n = layout.nodes[node];
+        double weight = static_cast<double>(n.pressCount);
+        double result = weight * layout.slots[slot].cost;
+        if (slot != n.origin) {
+            result += weight * layout.changePenalty;
+        }
+        for (const auto& neighbor : n.neighbors) {
+            if (neighbor.other == skip) {
+                continue;
+            }
+            size_t otherSlot = slotOf[neighbor.other];
+            result += neighbor.weight * (neighbor.outgoing ? transition(slot, otherSlot)
+                                                           : transition(otherSlot, slot));
+        }
+        return result;
+    }
+
+    // Перенос node на место target с обменом, если место занято.
+    // Возвращает изменение стоимости; apply = false - только оценка.
+    double move(size_t node, size_t target, bool apply) {
+        size_t source = slotOf[node];
+        size_t other = occupant[target];
+        double before = nodeCost(node, source, kNone);
+        if (other != kNone) {
+            before += nodeCost(other, target, node);
+        }
+
+        slotOf[node] = target;
+        if (other != kNone) {
+            slotOf[other] = source;
+        }
+        double after = nodeCost(node, target, kNone);
+        if (other != kNone) {
+            after += nodeCost(other, source, node);
+        }
+
+        if (apply) {
+            occupant[target] = node;
+            occupant[source] = other;
+            cost += after - before;
+        } else {
+            slotOf[node] = source;
+            if (other != kNone) {
+                slotOf[other] = target;
+            }
+        }
+        return after - before;
+    }
+
+    bool randomMove(size_t& node, size_t& target) {
+        node = layout.movable[random() % layout.movable.size()];
+        target = layout.openSlots[random() % layout.openSlots.size()];
+        return target != slotOf[node];
+    }
+
+public:
+    Chain(const Layout& layout, std::uint64_t seed)
+        : layout(layout), occupant(layout.slots.size(), kNone), random(seed) {
+        for (const auto& node : layout.nodes) {
+            slotOf.push_back(node.origin);
+        }
+        for (size_t node = 0; node < layout.nodes.size(); ++node) {
+            occupant[slotOf[node]] = node;
+        }
+        cost = assignmentCost(layout, slotOf);
+    }
+
+    // Начальная температура - средний проигрыш случайного хода: вначале
+    // принимается примерно треть ухудшений
+    double initialTemperature(size_t samples) {
+        double sum = 0;
+        size_t count = 0;
+        for (size_t i = 0; i < samples; ++i) {
+            size_t node, target;
+            if (randomMove(node, target)) {
+                double delta = move(node, target, false);
+                if (delta > 0) {
+                    sum += delta;
+                    ++count;
+                }
+            }
+        }
+        return count > 0 ? sum / static_cast<double>(count) : 1.0;
+    }
+
+    // Возвращает число выполненных итераций; лучшее размещение - в best
+    std::uint64_t anneal(std::uint64_t iterations, const std::function<bool()>& shouldStop,
+                         std::vector<size_t>& best, double& bestCost) {
+        std::uniform_real_distribution<double> uniform(0.0, 1.0);
+        double temperature = initialTemperature(std::min<size_t>(200, layout.movable.size() * 4));
+        // Геометрическое охлаждение до тысячной доли начальной температуры
+        double cooling =
+            std::pow(1e-3, 1.0 / static_cast<double>(std::max<std::uint64_t>(iterations, 1)));
+
+        best = slotOf;
+        bestCost = cost;
+        std::uint64_t done = 0;
+        for (; done < iterations; ++done) {
+            if (done % kCheckInterval == 0 && shouldStop()) {
+                break;
+            }
+            temperature *= cooling;
+
+            size_t node, target;
+            if (!randomMove(node, target)) {
+                continue;
+            }
+            size_t source = slotOf[node];
+            double delta = move(node, target, true);
+            if (delta > 0 && uniform(random) >= std::exp(-delta / temperature)) {
+                move(node, source, true); // откат
+                continue;
+            }
+            if (cost < bestCost - 1e-9) {
+                bestCost = cost;
+                best = slotOf;
+            }
+        }
+
+        // Под конец отжига легкие комбинации перемещаются почти случайно:
+        // доводим лучшее размещение жадным спуском
+        restore(best);
+        descend(shouldStop);
+        best = slotOf;
+        bestCost = cost;
+        return done;
+    }
+
+    void restore(const std::vector<size_t>& slots) {
+        slotOf = slots;
+        std::fill(occupant.begin(), occupant.end(), kNone);
+        for (size_t node = 0; node < slotOf.size(); ++node) {
+            occupant[slotOf[node]] = node;
+        }
+        cost = assignmentCost(layout, slotOf);
+    }
+
+    // Лучший ход для каждой комбинации, пока есть выигрыш
+    void descend(const std::function<bool()>& shouldStop) {
+        for (size_t pass = 0; pass < kDescentPasses && !shouldStop(); ++pass) {
+            bool improved = false;
+            for (size_t node : layout.movable) {
+                size_t bestTarget = kNone;
+                double bestDelta = -1e-9;
+                for (size_t target : layout.openSlots) {
+                    if (target == slotOf[node]) {
+                        continue;
+                    }
+                    double delta = move(node, target, false);
+                    if (delta < bestDelta) {
+                        bestDelta = delta;
+                        bestTarget = target;
+                    }
+                }
+                if (bestTarget != kNone) {
+                    move(node, bestTarget, true);
+                    improved = true;
+                }
+            }
+            if (!improved) {
+                break;
+            }
+        }
+    }
+};
+
+Layout buildLayout(const ErgonomicModel& model, const RemapProblem& problem,
+                   const RemapOptions& options, std::vector<size_t>& nodeOfShortcut) {
+    Layout layout;
+    layout.model = &model;
+    layout.changePenalty = options.changePenalty;
+
+    std::unordered_set<std::string> reserved;
+    for (const auto& combination : options.reserved) {
+        reserved.insert(formatChord(parseChord(combination)));
+    }
+
+    std::unordered_map<std::string, size_t> slotIndex;
+    auto slotFor = [&](const Chord& chord, const ChordGeometry& geometry) {
+        auto [it, inserted] = slotIndex.try_emplace(formatChord(chord), layout.slots.size());
+        if (inserted) {
+            layout.slots.push_back({chord, geometry, model.chordCost(geometry), false});
+        }
+        return it->second;
+    };
+
+    // Текущие комбинации занимают свои места; неподвижные - навсегда
+    std::unordered_map<std::string, size_t> nodeIndex;
+    nodeOfShortcut.assign(problem.shortcuts.size(), kNone);
+    for (size_t i = 0; i < problem.shortcuts.size(); ++i) {
+        const auto& shortcut = problem.shortcuts[i];
+        Chord chord = parseChord(shortcut.combination);
+        auto geometry = model.locate(chord);
+        if (!geometry || shortcut.pressCount <= 0) {
+            continue;
+        }
+        std::string name = formatChord(chord);
+        auto [it, inserted] = nodeIndex.try_emplace(name, layout.nodes.size());
+        if (inserted) {
+            Node node;
+            node.combination = shortcut.combination;
+            node.origin = slotFor(chord, *geometry);
+            node.movable = (chord.modifiers & (ModifierCtrl | ModifierAlt | ModifierWin)) &&
+                           !reserved.count(name);
+            layout.slots[node.origin].blocked = !node.movable;
+            layout.nodes.push_back(std::move(node));
+        }
+        layout.nodes[it->second].pressCount += shortcut.pressCount;
+        nodeOfShortcut[i] = it->second;
+    }
+
+    for (const auto& chord : model.candidateChords(options.modifierSets)) {
+        std::string name = formatChord(chord);
+        if (!reserved.count(name)) {
+            slotFor(chord, *model.locate(chord));
+        }
+    }
+    for (size_t slot = 0; slot < layout.slots.size(); ++slot) {
+        if (!layout.slots[slot].blocked) {
+            layout.openSlots.push_back(slot);
+        }
+    }
+    for (size_t node = 0; node < layout.nodes.size(); ++node) {
+        if (layout.nodes[node].movable) {
+            layout.movable.push_back(node);
+        }
+    }
+
+    // Повтор одной комбинации ничего не стоит при любом размещении
+    for (const auto& transition : problem.transitions) {
+        if (transition.from >= nodeOfShortcut.size() || transition.to >= nodeOfShortcut.size()) {
+            continue;
+        }
+        size_t from = nodeOfShortcut[transition.from];
+        size_t to = nodeOfShortcut[transition.to];
+        if (from == kNone || to == kNone || from == to || transition.count <= 0) {
+            continue;
+        }
+        double weight = static_cast<double>(transition.count);
+        layout.nodes[from].neighbors.push_back({to, weight, true});
+        layout.nodes[to].neighbors.push_back({from, weight, false});
+    }
+    return layout;
+}
+
+} // namespace
+
+RemapPlan RemapOptimizer::optimize(const RemapProblem& problem, const RemapOptions& options,
+                                   const CancellationToken& token) const {
+    std::vector<size_t> nodeOfShortcut;
+    Layout layout = buildLayout(model, problem, options, nodeOfShortcut);
+
+    RemapPlan plan;
+    std::vector<size_t> origins;
+    for (const auto& node : layout.nodes) {
+        origins.push_back(node.origin);
+    }
+    plan.currentCost = plan.optimizedCost = assignmentCost(layout, origins);
+    if (layout.movable.empty() || layout.openSlots.empty()) {
+        plan.cancelled = token.isCancelled();
+        return plan;
+    }
+
+    size_t threadCount = options.threads > 0
+        ? options.threads
+        : std::max<size_t>(std::thread::hardware_concurrency(), 1);
+    std::uint64_t iterations = options.iterationsPerThread > 0
+        ? options.iterationsPerThread
+        : std::clamp<std::uint64_t>(4000 * layout.movable.size(), 20000, 4000000);
+
+    auto deadline = std::chrono::steady_clock::now() + options.timeBudget;
+    std::function<bool()> shouldStop = [&] {
+        return token.isCancelled() || std::chrono::steady_clock::now() >= deadline;
+    };
+
+    // Цепочки независимы: общих данных на запись нет, кроме счетчика
+    std::vector<std::vector<size_t>> best(threadCount);
+    std::vector<double> bestCost(threadCount, plan.currentCost);
+    std::atomic<std::uint64_t> totalIterations{0};
+    std::vector<std::thread> workers;
+    for (size_t t = 0; t < threadCount; ++t) {
+        workers.emplace_back([&, t] {
+            Chain chain(layout, options.seed + 0x9e3779b97f4a7c15ULL * (t + 1));
+            totalIterations += chain.anneal(iterations, shouldStop, best[t], bestCost[t]);
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    // Приращения копят ошибку округления - победителя выбираем по точной стоимости
+    size_t winner = 0;
+    for (size_t t = 0; t < threadCount; ++t) {
+        bestCost[t] = assignmentCost(layout, best[t]);
+        if (bestCost[t] < bestCost[winner]) {
+            winner = t;
+        }
+    }
+    plan.threads = threadCount;
+    plan.iterations = totalIterations.load();
+    plan.cancelled = token.isCancelled();
+    if (bestCost[winner] >= plan.currentCost) {
+        return plan;
+    }
+    plan.optimizedCost = bestCost[winner];
+
+    for (size_t node = 0; node < layout.nodes.size(); ++node) {
+        const auto& n = layout.nodes[node];
+        size_t slot = best[winner][node];
+        if (slot == n.origin) {
+            continue;
+        }
+        RemapSuggestion suggestion;
+        suggestion.from = n.combination;
+        suggestion.to = formatChord(layout.slots[slot].chord);
+        suggestion.pressCount = n.pressCount;
+        suggestion.saving = static_cast<double>(n.pressCount) *
+                            (layout.slots[n.origin].cost - layout.slots[slot].cost);
+        plan.suggestions.push_back(std::move(suggestion));
+    }
+    // Обмен двух комбинаций - две рекомендации; лимит может оставить одну
+    std::sort(plan.suggestions.begin(), plan.suggestions.end(),
+              [](const RemapSuggestion& a, const RemapSuggestion& b) { return a.saving > b.saving; });
+    if (plan.suggestions.size() > options.maxSuggestions) {
+        plan.suggestions.resize(options.maxSuggestions);
+    }
+    return plan;
+}
+
+RemapProblem RemapOptimizer::loadProblem(Database& db, const std::string& appName,
+                                         size_t transitionLimit) {
+    RemapProblem problem;
+    problem.appName = appName;
+
+    // Нажатия из буфера отложенной записи тоже учитываются
+    db.flush();
+
+    ComboStatsQuery query;
+    query.appName = appName;
+    query.pageSize = 0;
+    std::unordered_map<std::string, size_t> index;
+    for (auto& row : db.queryComboStats(query).rows) {
+        index.emplace(row.keyCombination, problem.shortcuts.size());
+        problem.shortcuts.push_back({std::move(row.keyCombination), row.pressCount});
+    }
+
+    for (const auto& sequence : db.getTopSequences(transitionLimit, appName, 2)) {
+        auto from = index.find(sequence.combos[0]);
+        auto to = index.find(sequence.combos[1]);
+        if (from != index.end() && to != index.end()) {
+            problem.transitions.push_back({from->second, to->second, sequence.pressCount});
+        }
+    }
+    return problem;
+}
@@ -0,0 +1,89 @@
+#pragma once
+#include "Database/Database.h"
+#include "ErgonomicModel.h"
+#include "Tasks/TaskExecutor.h"
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Комбинация приложения и ее нагрузка
+struct RemapShortcut {
+  std::string combination;
+  std::int64_t pressCount = 0;
+};
+
+// Комбинации, нажатые подряд (индексы в RemapProblem::shortcuts)
+struct RemapTransition {
+  size_t from = 0;
+  size_t to = 0;
+  std::int64_t count = 0;
+};
+
+struct RemapProblem {
+  std::string appName;
+  std::vector<RemapShortcut> shortcuts;
+  std::vector<RemapTransition> transitions;
+};
+
+struct RemapOptions {
+  size_t threads = 0;             // 0 - по числу ядер
+  size_t iterationsPerThread = 0; // 0 - по размеру задачи
+  std::chrono::milliseconds timeBudget{5000};
+  std::uint64_t seed = 1;
+
+  // Переназначение оправдано, если экономит больше changePenalty на
+  // каждое нажатие: привыкание к новой комбинации тоже чего-то стоит
+  double changePenalty = 0.3;
+
+  // Наборы модификаторов для новых комбинаций
+  std::vector<unsigned> modifierSets = {ModifierCtrl, ModifierAlt, ModifierCtrl | ModifierShift,
+                                        ModifierCtrl | ModifierAlt, ModifierAlt | ModifierShift};
+
+  // Системные комбинации: не предлагаются и сами не переносятся
+  std::vector<std::string> reserved = {"Alt+Tab", "Alt+F4", "Ctrl+Esc", "Ctrl+Shift+Esc",
+                                       "Ctrl+Alt+Delete", "Win+L", "Win+D", "Win+Tab"};
+
+  size_t maxSuggestions = 20;
+};
+
+struct RemapSuggestion {
+  std::string from;
+  std::string to;
+  std::int64_t pressCount = 0;
+  double saving = 0; // выигрыш на самих нажатиях, без учета переходов
+};
+
+struct RemapPlan {
+  std::vector<RemapSuggestion> suggestions; // по убыванию выигрыша
+  double currentCost = 0;
+  double optimizedCost = 0; // с учетом платы за переназначения
+  std::uint64_t iterations = 0;
+  size_t threads = 0;
+  bool cancelled = false; // прерван: план - лучший найденный к этому моменту
+};
+
+// Подбор более удобных комбинаций для команд приложения. Стоимость
+// раскладки - эргономика каждой комбинации, умноженная на число ее
+// нажатий, плюс неудобные переходы между комбинациями, нажатыми подряд
+// (это делает задачу квадратичной задачей о назначениях). Поиск - имитация
+// отжига: независимые цепочки с разными зернами на всех ядрах, результат -
+// лучшая из них. Комбинации без Ctrl/Alt/Win (набор текста) и неизвестные
+// модели клавиши остаются на месте, но занимают свои места.
+class RemapOptimizer {
+private:
+  ErgonomicModel model;
+
+public:
+  explicit RemapOptimizer(const ErgonomicModel &model = ErgonomicModel()) : model(model) {}
+
+  // Отмена проверяется между порциями итераций; по истечении timeBudget
+  // поиск тоже останавливается и возвращает лучшее найденное
+  RemapPlan optimize(const RemapProblem &problem, const RemapOptions &options,
+                     const CancellationToken &token = CancellationToken()) const;
+
+  // Нагрузка приложения из БД: счетчики за все время и до transitionLimit
+  // самых частых пар комбинаций
+  static RemapProblem loadProblem(Database &db, const std::string &appName,
+                                  size_t transitionLimit = 5000);
+};
@@ -1,4 +1,6 @@
 #include "KeyLogger.h"
+#include "Storage/EventJournal.h"
+#include <chrono>
 #include <iostream>
 #include <psapi.h>
 #include <sstream>
@@ -75,8 +77,19 @@ bool KeyLogger::isActive() const {
 }
 
 void KeyLogger::addEvent(const KeyPressEvent& event) {
+    KeyPressEvent journaled = event;
+    journaled.timestamp = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    if (journal) {
+        // Одно копирование в отображенный файл; при заполненном журнале
+        // нажатие идет дальше с номером 0, а обработчик сбрасывает БД,
+        // чтобы журнал освободился
+        journaled.journalSequence = journal->append(
+            journaled.appName, journaled.keyCombination, journaled.timestamp);
+    }
+
     std::unique_lock<std::mutex> lock(queueMutex);
-    eventQueue.push(event);
+    eventQueue.push(std::move(journaled));
     queueCondition.notify_one();
 }
 
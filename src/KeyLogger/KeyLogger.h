@@ -1,6 +1,7 @@
 #pragma once
 #include <atomic>
 #include <condition_variable>
+#include <cstdint>
 #include <functional>
 #include <mutex>
 #include <queue>
@@ -8,9 +9,13 @@
 #include <thread>
 #include <windows.h>
 
+class EventJournal;
+
 struct KeyPressEvent {
     std::string appName;
     std::string keyCombination;
+    std::int64_t timestamp = 0;          // мс от эпохи (UTC)
+    std::uint64_t journalSequence = 0;   // 0 - нажатие не попало в журнал
 };
 
 // Callback для обработки событий клавиш
@@ -33,6 +38,9 @@ private:
     // Callback для уведомления о новых событиях
     KeyEventCallback eventCallback;
     
+    // Журнал, в который нажатие пишется до постановки в очередь
+    EventJournal* journal = nullptr;
+    
     // Статический указатель для hook callback
     static KeyLogger* instance;
     
@@ -57,6 +65,10 @@ public:
     // Установка callback для обработки событий
     void setEventCallback(KeyEventCallback callback);
     
+    // Нажатия из очереди не теряются при падении: каждое сразу пишется
+    // в журнал (устанавливается до start())
+    void setJournal(EventJournal* eventJournal) { journal = eventJournal; }
+    
     // Utility методы
     static std::string getProcessName(DWORD processId);
     static std::string virtualKeyToString(UINT vkCode);
@@ -0,0 +1,151 @@
+#pragma once
+#include "FilterKernels.h"
+#include "KeyPress.h"
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <vector>
+
+// Условие отбора нажатий: пустые поля не ограничивают, время - [from, to)
+struct HistoryFilter {
+  std::optional<SymbolId> appId;
+  std::optional<SymbolId> comboId;
+  std::int64_t from = std::numeric_limits<std::int64_t>::min();
+  std::int64_t to = std::numeric_limits<std::int64_t>::max();
+
+  bool hasTimeRange() const {
+    return from != std::numeric_limits<std::int64_t>::min() ||
+           to != std::numeric_limits<std::int64_t>::max();
+  }
+
+  bool matches(const KeyPress &press) const {
+    return (!appId || press.appId == *appId) &&
+           (!comboId || press.comboId == *comboId) &&
+           press.timestamp >= from && press.timestamp < to;
+  }
+};
+
+// История нажатий по столбцам: номера приложений, номера комбинаций и
+// время лежат в отдельных непрерывных массивах. Фильтр читает только
+// нужные столбцы и сравнивает их векторно (FilterKernels), поэтому
+// анализ десятков миллионов нажатий упирается в пропускную способность
+// памяти. Кольцевая семантика та же, что у RingBuffer: индекс 0 -
+// самое старое нажатие, при заполнении новое замещает самое старое.
+class ColumnarHistory {
+private:
+  // Блок сканирования: маска блока (512 байт) остается в L1
+  static constexpr size_t kBlockSize = 4096;
+
+  std::vector<SymbolId> appIds;
+  std::vector<SymbolId> comboIds;
+  std::vector<std::int64_t> timestamps;
+  size_t head = 0; // слот самого старого нажатия, когда история полна
+  size_t maxSize;
+
+  // Отбирает блок [begin, begin + count) физических слотов в mask
+  void filterBlock(const HistoryFilter &filter, size_t begin, size_t count,
+                   std::uint64_t *mask) const {
+    FilterKernels::fillMask(mask, count);
+    if (filter.appId) {
+      FilterKernels::andEqual(appIds.data() + begin, count, *filter.appId, mask);
+    }
+    if (filter.comboId) {
+      FilterKernels::andEqual(comboIds.data() + begin, count, *filter.comboId, mask);
+    }
+    if (filter.hasTimeRange()) {
+      FilterKernels::andInRange(timestamps.data() + begin, count, filter.from,
+                                filter.to, mask);
+    }
+  }
+
+  // Обходит физические слоты в логическом порядке: сначала [head, size),
+  // затем [0, head). visit(logicalIndex, mask, count) вызывается по блокам.
+  template <typename Visitor>
+  void scanBlocks(const HistoryFilter &filter, Visitor &&visit) const {
+    std::uint64_t mask[FilterKernels::maskWords(kBlockSize)];
+    size_t logical = 0;
+    auto scanSegment = [&](size_t begin, size_t end) {
+      for (size_t block = begin; block < end; block += kBlockSize) {
+        size_t count = std::min(kBlockSize, end - block);
+        filterBlock(filter, block, count, mask);
+        visit(logical, mask, count);
+        logical += count;
+      }
+    };
+    scanSegment(head, appIds.size());
+    scanSegment(0, head);
+  }
+
+public:
+  explicit ColumnarHistory(size_t capacity) : maxSize(capacity) {}
+
+  void push_back(const KeyPress &press) {
+    if (maxSize == 0) {
+      return;
+    }
+    if (appIds.size() < maxSize) {
+      appIds.push_back(press.appId);
+      comboIds.push_back(press.comboId);
+      timestamps.push_back(press.timestamp);
+      return;
+    }
+    appIds[head] = press.appId;
+    comboIds[head] = press.comboId;
+    timestamps[head] = press.timestamp;
+    head = head + 1 == appIds.size() ? 0 : head + 1;
+  }
+
+  KeyPress operator[](size_t index) const {
+    size_t slot = head + index;
+    slot = slot < appIds.size() ? slot : slot - appIds.size();
+    return KeyPress(appIds[slot], comboIds[slot], timestamps[slot]);
+  }
+
+  // Число нажатий, подходящих под условие
+  size_t count(const HistoryFilter &filter) const {
+    size_t total = 0;
+    scanBlocks(filter, [&](size_t, const std::uint64_t *mask, size_t count) {
+      total += FilterKernels::countMask(mask, FilterKernels::maskWords(count));
+    });
+    return total;
+  }
+
+  // Логические индексы подходящих нажатий, от старых к новым
+  std::vector<size_t> select(const HistoryFilter &filter) const {
+    std::vector<size_t> indices;
+    scanBlocks(filter, [&](size_t logical, const std::uint64_t *mask, size_t count) {
+      FilterKernels::forEachSet(mask, FilterKernels::maskWords(count),
+                                [&](size_t i) { indices.push_back(logical + i); });
+    });
+    return indices;
+  }
+
+  size_t size() const { return appIds.size(); }
+  size_t capacity() const { return maxSize; }
+  bool empty() const { return appIds.empty(); }
+
+  void clear() {
+    appIds.clear();
+    comboIds.clear();
+    timestamps.clear();
+    head = 0;
+  }
+
+  // Новая емкость; при уменьшении остаются самые новые нажатия
+  void setCapacity(size_t capacity) {
+    auto resize = [&](auto &column) {
+      size_t keep = std::min(column.size(), capacity);
+      std::rotate(column.begin(), column.begin() + head, column.end());
+      column.erase(column.begin(), column.begin() + (column.size() - keep));
+      if (column.capacity() > capacity) {
+        column.shrink_to_fit();
+      }
+    };
+    resize(appIds);
+    resize(comboIds);
+    resize(timestamps);
+    head = 0;
+    maxSize = capacity;
+  }
+};
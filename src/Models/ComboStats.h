@@ -0,0 +1,52 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+#include "PageLimit.h"
+
+// Маска модификаторов комбинации (совпадает со столбцом combos.modifiers)
+enum ModifierMask : unsigned {
+  ModifierNone = 0,
+  ModifierCtrl = 1 << 0,
+  ModifierShift = 1 << 1,
+  ModifierAlt = 1 << 2,
+  ModifierWin = 1 << 3,
+};
+
+// Строка статистики по комбинации клавиш
+struct ComboStat {
+  std::int64_t comboId = 0;
+  std::string keyCombination;
+  std::int64_t pressCount = 0;
+  std::int64_t lastPressed = 0; // последнее нажатие за все время, мс от эпохи
+};
+
+// Позиция для постраничной выдачи: последняя строка прошлой страницы.
+// Строки упорядочены по (pressCount DESC, comboId ASC).
+struct ComboStatsCursor {
+  std::int64_t pressCount = 0;
+  std::int64_t comboId = 0;
+};
+
+struct ComboStatsQuery {
+  std::string appName;
+
+  // Временное окно [fromMs, toMs); без него - счетчики за все время
+  std::optional<std::int64_t> fromMs;
+  std::optional<std::int64_t> toMs;
+
+  // Все модификаторы из маски должны присутствовать;
+  // exactModifiers - набор модификаторов совпадает с маской
+  unsigned modifiers = ModifierNone;
+  bool exactModifiers = false;
+
+  size_t pageSize = 50; // 0 = без ограничений
+  std::optional<ComboStatsCursor> after;
+};
+
+struct ComboStatsPage {
+  std::vector<ComboStat> rows;
+  std::optional<ComboStatsCursor> next; // пусто на последней странице
+};
@@ -0,0 +1,71 @@
+#pragma once
+#include "KeyStatistics.h"
+#include "KeyStatisticsSnapshot.h"
+#include "SnapshotCell.h"
+#include <cstdint>
+#include <memory>
+#include <string>
+
+// KeyStatistics для одного писателя (поток KeyLogger) и любого числа
+// читателей (окно, фоновые задачи). Писатель меняет собственную копию и
+// публикует неизменяемые снимки через SnapshotCell; читатели берут
+// последний снимок без блокировок и не видят частично обновленных
+// данных. Снимок публикуется каждые publishInterval нажатий и по
+// publish(); между публикациями читатели видят предыдущую версию.
+class ConcurrentKeyStatistics {
+private:
+  KeyStatistics stats; // только писатель
+  SnapshotCell<KeyStatisticsSnapshot> published;
+  size_t publishInterval;
+  size_t recentCount;
+  std::shared_ptr<const KeyStatistics> state; // последняя publishState()
+  size_t unpublished = 0;
+  std::uint64_t version = 0;
+
+public:
+  using ReadGuard = SnapshotCell<KeyStatisticsSnapshot>::ReadGuard;
+
+  explicit ConcurrentKeyStatistics(size_t maxHistorySize = 1000,
+                                   size_t publishInterval = 1, size_t recentCount = 20)
+      : stats(maxHistorySize), publishInterval(std::max<size_t>(publishInterval, 1)),
+        recentCount(recentCount) {}
+
+  // --- Поток писателя ---
+
+  void addKeyPress(const std::string &appName, const std::string &keyCombination,
+                   std::int64_t timestamp = KeyPress::now()) {
+    stats.addKeyPress(appName, keyCombination, timestamp);
+    if (++unpublished >= publishInterval) {
+      publish();
+    }
+  }
+
+  // Публикует текущее состояние; стоимость - O(различных ключей)
+  void publish() {
+    auto snapshot = std::make_unique<KeyStatisticsSnapshot>(stats.makeSnapshot(recentCount));
+    snapshot->version = ++version;
+    snapshot->state = state;
+    published.publish(std::move(snapshot));
+    unpublished = 0;
+  }
+
+  // Публикует вместе со снимком копию состояния для StatisticsSnapshot:
+  // писатель только копирует, а кодирует и пишет файл читатель в фоне
+  void publishState() {
+    state = stats.copyPersistentState();
+    publish();
+  }
+
+  // Прямой доступ для настройки и редких операций; изменения видны
+  // читателям после publish()
+  KeyStatistics &writer() { return stats; }
+
+  // Замененные снимки, которые еще держат читатели
+  size_t retainedSnapshots() const { return published.retiredCount(); }
+
+  // --- Любой поток ---
+
+  // Последний опубликованный снимок; держите guard только на время
+  // чтения - пока он жив, писатель не освобождает эту версию
+  ReadGuard read() const { return published.read(); }
+};
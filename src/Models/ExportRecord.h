@@ -0,0 +1,33 @@
+#pragma once
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+
+// Что выгружается: итоговые счетчики по комбинациям или отдельные нажатия
+enum class ExportContent {
+  Totals,
+  Events,
+};
+
+struct ExportFilter {
+  ExportContent content = ExportContent::Totals;
+  std::string appName; // пусто - все приложения
+
+  // Временное окно [fromMs, toMs) по времени нажатия
+  std::optional<std::int64_t> fromMs;
+  std::optional<std::int64_t> toMs;
+
+  // Только события журнала с id > afterEventId (отметка прошлой выгрузки).
+  // Итоги без окна и без отметки берутся из счетчиков за все время.
+  std::int64_t afterEventId = 0;
+};
+
+// Строка выгрузки. Строки указывают в буфер курсора и действительны
+// только внутри обработчика.
+struct ExportRecord {
+  std::string_view appName;
+  std::string_view keyCombination;
+  std::int64_t pressCount = 0; // Events: всегда 1
+  std::int64_t timestamp = 0;  // Totals: последнее нажатие; Events: время нажатия
+};
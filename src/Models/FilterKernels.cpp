@@ -0,0 +1,201 @@
+#include "FilterKernels.h"
+#include <algorithm>
+#include <bitset>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define HOKA_FILTER_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+// MSVC разрешает AVX2-интринсики без флагов компиляции
+#define HOKA_TARGET_AVX2
+#else
+// Только эти функции собираются с AVX2; остальной код остается
+// совместимым с любым x86-64
+#define HOKA_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+namespace FilterKernels {
+
+namespace {
+
+// Число элементов, покрываемых словом w маски
+size_t wordLength(size_t count, size_t w) {
+    return std::min<size_t>(64, count - w * 64);
+}
+
+void andEqualScalar(const std::uint32_t* values, size_t count, std::uint32_t value,
+                    std::uint64_t* mask) {
+    for (size_t w = 0; w < maskWords(count); ++w) {
+        if (mask[w] == 0) {
+            continue;
+        }
+        const std::uint32_t* chunk = values + w * 64;
+        std::uint64_t bits = 0;
+        for (size_t i = 0, n = wordLength(count, w); i < n; ++i) {
+            bits |= static_cast<std::uint64_t>(chunk[i] == value) << i;
+        }
+        mask[w] &= bits;
+    }
+}
+
+void andInRangeScalar(const std::int64_t* values, size_t count, std::int64_t from,
+                      std::int64_t to, std::uint64_t* mask) {
+    for (size_t w = 0; w < maskWords(count); ++w) {
+        if (mask[w] == 0) {
+            continue;
+        }
+        const std::int64_t* chunk = values + w * 64;
+        std::uint64_t bits = 0;
+        for (size_t i = 0, n = wordLength(count, w); i < n; ++i) {
+            bits |= static_cast<std::uint64_t>(chunk[i] >= from && chunk[i] < to) << i;
+        }
+        mask[w] &= bits;
+    }
+}
+
+#ifdef HOKA_FILTER_X86
+
+// Полные слова маски считаются векторно, неполное последнее - скалярно
+void andEqualSse2(const std::uint32_t* values, size_t count, std::uint32_t value,
+                  std::uint64_t* mask) {
+    const __m128i needle = _mm_set1_epi32(static_cast<int>(value));
+    size_t fullWords = count / 64;
+    for (size_t w = 0; w < fullWords; ++w) {
+        if (mask[w] == 0) {
+            continue;
+        }
+        const std::uint32_t* chunk = values + w * 64;
+        std::uint64_t bits = 0;
+        for (size_t j = 0; j < 16; ++j) {
+            __m128i lanes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(chunk + j * 4));
+            auto matched = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(lanes, needle)));
+            bits |= static_cast<std::uint64_t>(matched) << (j * 4);
+        }
+        mask[w] &= bits;
+    }
+    andEqualScalar(values + fullWords * 64, count - fullWords * 64, value, mask + fullWords);
+}
+
+HOKA_TARGET_AVX2
+void andEqualAvx2(const std::uint32_t* values, size_t count, std::uint32_t value,
+                  std::uint64_t* mask) {
+    const __m256i needle = _mm256_set1_epi32(static_cast<int>(value));
+    size_t fullWords = count / 64;
+    for (size_t w = 0; w < fullWords; ++w) {
+        if (mask[w] == 0) {
+            continue;
+        }
+        const std::uint32_t* chunk = values + w * 64;
+        std::uint64_t bits = 0;
+        for (size_t j = 0; j < 8; ++j) {
+            __m256i lanes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(chunk + j * 8));
+            auto matched = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(lanes, needle)));
+            bits |= static_cast<std::uint64_t>(static_cast<unsigned>(matched)) << (j * 8);
+        }
+        mask[w] &= bits;
+    }
+    andEqualScalar(values + fullWords * 64, count - fullWords * 64, value, mask + fullWords);
+}
+
+// from <= v < to  <=>  !(from > v) && (to > v)
+HOKA_TARGET_AVX2
+void andInRangeAvx2(const std::int64_t* values, size_t count, std::int64_t from,
+                    std::int64_t to, std::uint64_t* mask) {
+    const __m256i lower = _mm256_set1_epi64x(from);
+    const __m256i upper = _mm256_set1_epi64x(to);
+    size_t fullWords = count / 64;
+    for (size_t w = 0; w < fullWords; ++w) {
+        if (mask[w] == 0) {
+            continue;
+        }
+        const std::int64_t* chunk = values + w * 64;
+        std::uint64_t bits = 0;
+        for (size_t j = 0; j < 16; ++j) {
+            __m256i lanes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(chunk + j * 4));
+            __m256i inside = _mm256_andnot_si256(_mm256_cmpgt_epi64(lower, lanes),
+                                                 _mm256_cmpgt_epi64(upper, lanes));
+            auto matched = _mm256_movemask_pd(_mm256_castsi256_pd(inside));
+            bits |= static_cast<std::uint64_t>(matched) << (j * 4);
+        }
+        mask[w] &= bits;
+    }
+    andInRangeScalar(values + fullWords * 64, count - fullWords * 64, from, to,
+                     mask + fullWords);
+}
+
+bool cpuHasAvx2() {
+#if defined(_MSC_VER) && !defined(__clang__)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) {
+        return false;
+    }
+    // ОС должна сохранять YMM-регистры (OSXSAVE и XCR0)
+    __cpuid(info, 1);
+    bool osSavesYmm = (info[2] & (1 << 27)) != 0 && (_xgetbv(0) & 0x6) == 0x6;
+    __cpuidex(info, 7, 0);
+    return osSavesYmm && (info[1] & (1 << 5)) != 0;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+
+#endif // HOKA_FILTER_X86
+
+} // namespace
+
+SimdLevel bestLevel() {
+#ifdef HOKA_FILTER_X86
+    static const SimdLevel level = cpuHasAvx2() ? SimdLevel::AVX2 : SimdLevel::SSE2;
+    return level;
+#else
+    return SimdLevel::Scalar;
+#endif
+}
+
+void fillMask(std::uint64_t* mask, size_t count) {
+    size_t words = maskWords(count);
+    std::fill(mask, mask + words, ~std::uint64_t{0});
+    if (count % 64 != 0) {
+        mask[words - 1] = (std::uint64_t{1} << (count % 64)) - 1;
+    }
+}
+
+void andEqual(const std::uint32_t* values, size_t count, std::uint32_t value,
+              std::uint64_t* mask, SimdLevel level) {
+#ifdef HOKA_FILTER_X86
+    if (level == SimdLevel::AVX2) {
+        return andEqualAvx2(values, count, value, mask);
+    }
+    if (level == SimdLevel::SSE2) {
+        return andEqualSse2(values, count, value, mask);
+    }
+#endif
+    (void)level;
+    andEqualScalar(values, count, value, mask);
+}
+
+void andInRange(const std::int64_t* values, size_t count, std::int64_t from,
+                std::int64_t to, std::uint64_t* mask, SimdLevel level) {
+#ifdef HOKA_FILTER_X86
+    // В SSE2 нет сравнения 64-битных чисел - для него скалярный вариант
+    if (level == SimdLevel::AVX2) {
+        return andInRangeAvx2(values, count, from, to, mask);
+    }
+#endif
+    (void)level;
+    andInRangeScalar(values, count, from, to, mask);
+}
+
+size_t countMask(const std::uint64_t* mask, size_t words) {
+    size_t total = 0;
+    for (size_t w = 0; w < words; ++w) {
+        total += std::bitset<64>(mask[w]).count();
+    }
+    return total;
+}
+
+} // namespace FilterKernels
@@ -0,0 +1,62 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+
+// Ядра фильтрации столбцов истории. Результат - маска выборки: бит i
+// слова i / 64 соответствует элементу i. Ядра сужают уже заполненную
+// маску (AND), поэтому составной фильтр - последовательные вызовы по
+// одной маске, а подсчет - popcount по словам.
+//
+// Вариант выбирается при первом вызове по возможностям процессора:
+// AVX2, затем SSE2 (всегда есть на x86-64), иначе скалярный.
+namespace FilterKernels {
+
+enum class SimdLevel { Scalar, SSE2, AVX2 };
+
+// Лучший доступный вариант на этом процессоре
+SimdLevel bestLevel();
+
+// Число слов маски для count элементов
+constexpr size_t maskWords(size_t count) { return (count + 63) / 64; }
+
+// Заполняет маску единицами для count элементов (хвост последнего
+// слова обнулен)
+void fillMask(std::uint64_t *mask, size_t count);
+
+// mask &= (values[i] == value)
+void andEqual(const std::uint32_t *values, size_t count, std::uint32_t value,
+              std::uint64_t *mask, SimdLevel level = bestLevel());
+
+// mask &= (from <= values[i] < to)
+void andInRange(const std::int64_t *values, size_t count, std::int64_t from,
+                std::int64_t to, std::uint64_t *mask,
+                SimdLevel level = bestLevel());
+
+// Число единиц в маске
+size_t countMask(const std::uint64_t *mask, size_t words);
+
+// Номер младшего установленного бита; word != 0
+inline unsigned lowestBit(std::uint64_t word) {
+#if defined(_MSC_VER) && !defined(__clang__)
+  unsigned long index;
+  _BitScanForward64(&index, word);
+  return static_cast<unsigned>(index);
+#else
+  return static_cast<unsigned>(__builtin_ctzll(word));
+#endif
+}
+
+// Вызывает visit(i) для каждого установленного бита по возрастанию
+template <typename Visitor>
+void forEachSet(const std::uint64_t *mask, size_t words, Visitor &&visit) {
+  for (size_t w = 0; w < words; ++w) {
+    for (std::uint64_t word = mask[w]; word != 0; word &= word - 1) {
+      visit(w * 64 + lowestBit(word));
+    }
+  }
+}
+
+} // namespace FilterKernels
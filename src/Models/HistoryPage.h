@@ -0,0 +1,44 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+#include "PageLimit.h"
+
+// Нажатие из журнала key_events
+struct HistoryEvent {
+  std::int64_t eventId = 0; // id в журнале
+  std::string appName;
+  std::string keyCombination;
+  std::int64_t timestamp = 0; // мс от эпохи (UTC)
+};
+
+// Позиция для постраничной выдачи: последняя строка прошлой страницы.
+// Строки упорядочены по (timestamp ASC, eventId ASC).
+struct HistoryCursor {
+  std::int64_t timestamp = 0;
+  std::int64_t eventId = 0;
+};
+
+struct HistoryQuery {
+  std::string appName;        // пусто - все приложения
+  std::string keyCombination; // пусто - все комбинации
+
+  // Временное окно [fromMs, toMs) по времени нажатия
+  std::optional<std::int64_t> fromMs;
+  std::optional<std::int64_t> toMs;
+
+  size_t pageSize = 1000; // 0 = без ограничений
+  std::optional<HistoryCursor> after;
+
+  // Граница снимка: только события с id <= lastEventId. 0 - граница
+  // берется при чтении страницы и возвращается в HistoryPage.
+  std::int64_t lastEventId = 0;
+};
+
+struct HistoryPage {
+  std::vector<HistoryEvent> rows;
+  std::optional<HistoryCursor> next; // пусто на последней странице
+  std::int64_t lastEventId = 0;      // граница, по которой читалась страница
+};
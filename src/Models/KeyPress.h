@@ -1,22 +1,26 @@
 #pragma once
+#include "SymbolTable.h"
 #include <chrono>
+#include <cstdint>
 #include <string>
 
+// Нажатие в истории: номера приложения и комбинации в SymbolTable и
+// время. 16 байт без указателей - история копируется и сравнивается
+// как обычный массив, строки разрешаются через таблицу по требованию.
 struct KeyPress {
-  std::string appName;
-  std::string keyCombination;
-  unsigned long timestamp;
+  SymbolId appId = 0;
+  SymbolId comboId = 0;
+  std::int64_t timestamp = 0; // мс от эпохи (UTC)
 
-  // Конструктор, определенный прямо в заголовке
-  KeyPress(const std::string &app, const std::string &keys, unsigned long time)
-      : appName(app), keyCombination(keys), timestamp(time) {}
+  KeyPress() = default;
+  KeyPress(SymbolId app, SymbolId combo, std::int64_t time)
+      : appId(app), comboId(combo), timestamp(time) {}
 
-  // Дополнительный конструктор с текущим временем
-  KeyPress(const std::string &app, const std::string &keys)
-      : appName(app), keyCombination(keys),
-        timestamp(std::chrono::duration_cast<std::chrono::milliseconds>(
-                      std::chrono::system_clock::now().time_since_epoch())
-                      .count()) {}
+  static std::int64_t now() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+               std::chrono::system_clock::now().time_since_epoch())
+        .count();
+  }
 
   // Метод для удобного форматирования времени
   std::string getFormattedTime() const {
@@ -28,4 +32,6 @@ struct KeyPress {
   bool operator<(const KeyPress &other) const {
     return timestamp < other.timestamp;
   }
-};
\ No newline at end of file
+};
+
+static_assert(sizeof(KeyPress) == 16, "KeyPress must stay a compact 16-byte record");
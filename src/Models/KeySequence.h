@@ -0,0 +1,13 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Строка статистики по последовательности комбинаций (биграмма или
+// триграмма), нажатых подряд; appName - приложение последнего нажатия
+struct KeySequence {
+  std::string appName;
+  std::vector<std::string> combos;
+  std::int64_t pressCount = 0;
+  std::int64_t lastPressed = 0; // мс от эпохи; 0 - неизвестно
+};
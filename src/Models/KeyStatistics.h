@@ -1,176 +1,537 @@
 #pragma once
+#include "ColumnarHistory.h"
 #include "KeyPress.h"
+#include "KeySequence.h"
+#include "KeyStatisticsSnapshot.h"
+#include "RankedCounter.h"
+#include "RingBuffer.h"
+#include "SequenceMiner.h"
+#include "Sketches.h"
+#include "SlidingWindowStats.h"
+#include "SymbolTable.h"
+#include "UsageHeatmap.h"
 #include <algorithm>
+#include <cstdint>
 #include <functional>
+#include <limits>
 #include <map>
+#include <memory>
+#include <optional>
+#include <sstream>
 #include <string>
+#include <string_view>
+#include <unordered_map>
 #include <vector>
 
+class StatisticsSnapshot;
+
 class KeyStatistics {
 private:
-  std::vector<KeyPress> keyPressHistory;
-  size_t maxHistorySize;
+  // Двоичный снимок (Storage/StatisticsSnapshot) сохраняет и
+  // восстанавливает состояние целиком, минуя addKeyPress
+  friend class StatisticsSnapshot;
+
+  // Имена приложений и комбинаций; история и счетчики хранят их номера
+  SymbolTable symbols;
+
+  // История фиксированной емкости: новое нажатие замещает самое старое
+  // за O(1), поэтому история в 1M+ нажатий не замедляет добавление
+  RingBuffer<KeyPress> keyPressHistory;
+
+  // Счетчики по окну истории: обновляются при добавлении и вытеснении
+  // нажатия, поэтому статистика и топы не пересчитываются по истории
+  RankedCounter<SymbolId> appCounts;
+  RankedCounter<SymbolId> keyCounts;
+  std::unordered_map<SymbolId, RankedCounter<SymbolId>> appKeyCounts;
+
+  // Число соседних пар в истории, где более новое нажатие имеет меньшее
+  // время. Пока их нет, диапазон времени - края истории, O(1).
+  size_t outOfOrder = 0;
+
+  // Пара (index, index + 1) покидает историю вместе с index
+  void dropOrderPair(size_t index) {
+    if (index + 1 < keyPressHistory.size() &&
+        keyPressHistory[index + 1].timestamp < keyPressHistory[index].timestamp) {
+      --outOfOrder;
+    }
+  }
 
-public:
-  // Конструктор с настройкой размера истории
-  explicit KeyStatistics(size_t maxSize = 1000) : maxHistorySize(maxSize) {}
+  // Счетчики за последние минуты/часы, не зависят от емкости истории
+  SlidingWindowStats window;
+
+  // Необязательная копия истории по столбцам для векторных фильтров
+  std::optional<ColumnarHistory> columns;
+
+  // Необязательные оценки по всем нажатиям, без вытеснения
+  std::optional<KeySketches> sketches;
+
+  // Необязательный подсчет последовательностей комбинаций
+  std::optional<SequenceMiner> sequences;
+
+  // Необязательные тепловые карты "час x день недели", без вытеснения
+  struct Heatmaps {
+    HeatmapClock clock;
+    std::unordered_map<SymbolId, UsageHeatmap> apps;
+    std::unordered_map<SymbolId, UsageHeatmap> combos;
+  };
+  std::optional<Heatmaps> heatmaps;
+
+  // Копия только того, что сохраняет StatisticsSnapshot
+  struct PersistentCopy {};
+  KeyStatistics(const KeyStatistics &other, PersistentCopy)
+      : symbols(other.symbols), keyPressHistory(other.keyPressHistory),
+        appCounts(other.appCounts), keyCounts(other.keyCounts),
+        appKeyCounts(other.appKeyCounts), outOfOrder(other.outOfOrder),
+        window(other.window), heatmaps(other.heatmaps) {}
+
+  void countPress(const KeyPress &press, int delta) {
+    appCounts.add(press.appId, delta);
+    keyCounts.add(press.comboId, delta);
+    auto &appKeys = appKeyCounts[press.appId];
+    appKeys.add(press.comboId, delta);
+    if (appKeys.empty()) {
+      appKeyCounts.erase(press.appId);
+    }
+  }
 
-  // Добавление нового нажатия
-  void addKeyPress(const KeyPress &keyPress) {
-    keyPressHistory.push_back(keyPress);
+  std::map<std::string, int> toMap(const RankedCounter<SymbolId> &counter) const {
+    std::map<std::string, int> result;
+    counter.forEach([&](SymbolId id, int count) {
+      result.emplace(std::string(symbols.resolve(id)), count);
+    });
+    return result;
+  }
 
-    // Ограничиваем размер истории
-    if (keyPressHistory.size() > maxHistorySize) {
-      keyPressHistory.erase(keyPressHistory.begin());
+  // Топ по несортированным счетчикам окна: O(n log limit)
+  std::vector<std::pair<std::string, int>>
+  toTop(const std::unordered_map<SymbolId, int> &counts, size_t limit) const {
+    std::vector<std::pair<SymbolId, int>> ranked(counts.begin(), counts.end());
+    limit = std::min(limit, ranked.size());
+    std::partial_sort(ranked.begin(), ranked.begin() + limit, ranked.end(),
+                      [](const auto &a, const auto &b) { return a.second > b.second; });
+    std::vector<std::pair<std::string, int>> result;
+    for (size_t i = 0; i < limit; ++i) {
+      result.emplace_back(std::string(symbols.resolve(ranked[i].first)), ranked[i].second);
     }
+    return result;
   }
 
-  void addKeyPress(const std::string &appName,
-                   const std::string &keyCombination) {
-    addKeyPress(KeyPress(appName, keyCombination));
+  UsageHeatmap findHeatmap(const std::unordered_map<SymbolId, UsageHeatmap> *maps,
+                           const std::string &name) const {
+    auto id = symbols.find(name);
+    if (!maps || !id) {
+      return UsageHeatmap();
+    }
+    auto it = maps->find(*id);
+    return it != maps->end() ? it->second : UsageHeatmap();
   }
 
-  // Получение всей истории
-  const std::vector<KeyPress> &getHistory() const { return keyPressHistory; }
-
-  // Получение последних N нажатий
-  std::vector<KeyPress> getRecentPresses(size_t count = 10) const {
-    size_t startIndex =
-        (keyPressHistory.size() > count) ? keyPressHistory.size() - count : 0;
+  KeyStatisticsSnapshot::Ranking toRanking(const RankedCounter<SymbolId> &counter) const {
+    KeyStatisticsSnapshot::Ranking ranking;
+    ranking.reserve(counter.size());
+    counter.forEach([&](SymbolId id, int count) {
+      ranking.emplace_back(std::string(symbols.resolve(id)), count);
+    });
+    return ranking;
+  }
 
-    return std::vector<KeyPress>(keyPressHistory.begin() + startIndex,
-                                 keyPressHistory.end());
+  std::vector<std::pair<std::string, int>> toTop(const RankedCounter<SymbolId> &counter,
+                                                 size_t limit) const {
+    std::vector<std::pair<std::string, int>> result;
+    for (const auto &[id, count] : counter.top(limit)) {
+      result.emplace_back(std::string(symbols.resolve(id)), count);
+    }
+    return result;
   }
 
-  // Статистика по приложениям
-  std::map<std::string, int> getAppUsageStats() const {
-    std::map<std::string, int> appStats;
+  // Условие по именам; пустое имя не ограничивает. Неизвестное имя
+  // не совпадает ни с одним нажатием - тогда nullopt.
+  std::optional<HistoryFilter> makeFilter(const std::string &appName,
+                                          const std::string &keyCombination,
+                                          std::int64_t from, std::int64_t to) const {
+    HistoryFilter filter;
+    filter.from = from;
+    filter.to = to;
+    if (!appName.empty()) {
+      filter.appId = symbols.find(appName);
+      if (!filter.appId) {
+        return std::nullopt;
+      }
+    }
+    if (!keyCombination.empty()) {
+      filter.comboId = symbols.find(keyCombination);
+      if (!filter.comboId) {
+        return std::nullopt;
+      }
+    }
+    return filter;
+  }
 
+  // Обходит подходящие нажатия от старых к новым: по столбцам, если
+  // они включены, иначе проходом по истории
+  template <typename Visitor>
+  void forEachMatch(const HistoryFilter &filter, Visitor &&visit) const {
+    if (columns) {
+      for (size_t index : columns->select(filter)) {
+        visit(keyPressHistory[index]);
+      }
+      return;
+    }
     for (const auto &press : keyPressHistory) {
-      appStats[press.appName]++;
+      if (filter.matches(press)) {
+        visit(press);
+      }
     }
-
-    return appStats;
   }
 
-  // Статистика по клавишам (все приложения)
-  std::map<std::string, int> getKeyUsageStats() const {
-    std::map<std::string, int> keyStats;
+public:
+  // Конструктор с настройкой размера истории
+  explicit KeyStatistics(size_t maxSize = 1000) : keyPressHistory(maxSize) {}
 
-    for (const auto &press : keyPressHistory) {
-      keyStats[press.keyCombination]++;
+  // Добавление нового нажатия; номера должны быть из getSymbols()
+  void addKeyPress(const KeyPress &keyPress) {
+    window.add(keyPress);
+    if (sketches) {
+      sketches->add(symbols.resolve(keyPress.appId), symbols.resolve(keyPress.comboId));
+    }
+    if (sequences) {
+      sequences->observe(keyPress.appId, keyPress.comboId, keyPress.timestamp);
+    }
+    if (heatmaps) {
+      size_t cell = heatmaps->clock.cellOf(keyPress.timestamp);
+      heatmaps->apps[keyPress.appId].add(cell);
+      heatmaps->combos[keyPress.comboId].add(cell);
+    }
+    if (keyPressHistory.capacity() == 0) {
+      return;
     }
+    // Заполненная история вытесняет самое старое нажатие
+    bool full = keyPressHistory.size() == keyPressHistory.capacity();
+    if (full) {
+      countPress(keyPressHistory.front(), -1);
+      dropOrderPair(0);
+    }
+    if (keyPressHistory.size() > (full ? 1u : 0u) &&
+        keyPress.timestamp < keyPressHistory.back().timestamp) {
+      ++outOfOrder;
+    }
+    countPress(keyPress, +1);
+    keyPressHistory.push_back(keyPress);
+    if (columns) {
+      columns->push_back(keyPress);
+    }
+  }
 
-    return keyStats;
+  void addKeyPress(std::string_view appName, std::string_view keyCombination,
+                   std::int64_t timestamp) {
+    addKeyPress(KeyPress(symbols.intern(appName), symbols.intern(keyCombination), timestamp));
   }
 
-  // Статистика по клавишам для конкретного приложения
-  std::map<std::string, int> getAppKeyStats(const std::string &appName) const {
-    std::map<std::string, int> appKeyStats;
+  void addKeyPress(const std::string &appName,
+                   const std::string &keyCombination) {
+    addKeyPress(appName, keyCombination, KeyPress::now());
+  }
 
-    for (const auto &press : keyPressHistory) {
-      if (press.appName == appName) {
-        appKeyStats[press.keyCombination]++;
+  // Таблица имен для разрешения номеров в нажатиях
+  const SymbolTable &getSymbols() const { return symbols; }
+  std::string_view getAppName(const KeyPress &press) const { return symbols.resolve(press.appId); }
+  std::string_view getKeyCombination(const KeyPress &press) const {
+    return symbols.resolve(press.comboId);
+  }
+
+  // Включает (или выключает) хранение истории по столбцам. Память на
+  // нажатие удваивается, зато фильтры ниже сканируют только нужные
+  // столбцы векторными ядрами вместо прохода по записям.
+  void setColumnarHistory(bool enabled) {
+    if (!enabled) {
+      columns.reset();
+      return;
+    }
+    if (!columns) {
+      columns.emplace(keyPressHistory.capacity());
+      for (const auto &press : keyPressHistory) {
+        columns->push_back(press);
       }
     }
+  }
+  bool hasColumnarHistory() const { return columns.has_value(); }
+
+  // Включает оценки по всему потоку нажатий в фиксированной памяти
+  // (см. Sketches.h): частоты пар, самые частые пары и число различных
+  // комбинаций. Считаются с момента включения; повторное включение
+  // с новыми параметрами начинает заново.
+  void setSketches(bool enabled, const SketchConfig &config = SketchConfig()) {
+    if (enabled) {
+      sketches.emplace(config);
+    } else {
+      sketches.reset();
+    }
+  }
+  const KeySketches *getSketches() const { return sketches ? &*sketches : nullptr; }
+
+  // Включает подсчет биграмм и триграмм комбинаций: нажатия подряд с
+  // паузами не длиннее timeoutMs. Считаются с момента включения, O(1)
+  // на нажатие.
+  void setSequenceMining(bool enabled, std::int64_t timeoutMs = 2000) {
+    if (enabled) {
+      sequences.emplace(timeoutMs);
+    } else {
+      sequences.reset();
+    }
+  }
 
-    return appKeyStats;
+  // Самые частые последовательности длины 2 или 3; пустое имя - по всем
+  // приложениям. O(limit), без прохода по истории.
+  std::vector<KeySequence> getTopSequences(size_t length, size_t limit = 10,
+                                           const std::string &appName = "") const {
+    std::vector<KeySequence> result;
+    std::optional<SymbolId> appId;
+    if (!appName.empty() && !(appId = symbols.find(appName))) {
+      return result;
+    }
+    if (!sequences) {
+      return result;
+    }
+    for (const auto &[sequence, count] : sequences->top(length, limit, appId)) {
+      KeySequence row;
+      row.appName = std::string(symbols.resolve(sequence.app));
+      for (size_t i = 0; i < sequence.length; ++i) {
+        row.combos.emplace_back(symbols.resolve(sequence.combos[i]));
+      }
+      row.pressCount = count;
+      result.push_back(std::move(row));
+    }
+    return result;
   }
 
-  // Топ N самых используемых приложений
-  std::vector<std::pair<std::string, int>> getTopApps(size_t limit = 10) const {
-    auto appStats = getAppUsageStats();
+  // Что чаще всего нажимают в приложении сразу после keyCombination
+  std::vector<std::pair<std::string, int>>
+  getLikelyNextCombos(const std::string &appName, const std::string &keyCombination,
+                      size_t limit = 5) const {
+    auto appId = symbols.find(appName);
+    auto comboId = symbols.find(keyCombination);
+    std::vector<std::pair<std::string, int>> result;
+    if (!sequences || !appId || !comboId) {
+      return result;
+    }
+    for (const auto &[nextId, count] : sequences->next(*appId, *comboId, limit)) {
+      result.emplace_back(std::string(symbols.resolve(nextId)), count);
+    }
+    return result;
+  }
+
+  // Включает тепловые карты по часам недели для приложений и комбинаций:
+  // O(1) на нажатие. utcOffset - фиксированный пояс, по умолчанию
+  // системный местный. Считаются с момента включения.
+  void setHeatmaps(bool enabled, std::optional<std::chrono::minutes> utcOffset = std::nullopt) {
+    if (enabled) {
+      heatmaps.emplace(Heatmaps{HeatmapClock(utcOffset), {}, {}});
+    } else {
+      heatmaps.reset();
+    }
+  }
 
-    std::vector<std::pair<std::string, int>> sortedApps(appStats.begin(),
-                                                        appStats.end());
+  UsageHeatmap getAppHeatmap(const std::string &appName) const {
+    return findHeatmap(heatmaps ? &heatmaps->apps : nullptr, appName);
+  }
+  UsageHeatmap getComboHeatmap(const std::string &keyCombination) const {
+    return findHeatmap(heatmaps ? &heatmaps->combos : nullptr, keyCombination);
+  }
 
-    std::sort(sortedApps.begin(), sortedApps.end(),
-              [](const auto &a, const auto &b) { return a.second > b.second; });
+  // Получение всей истории (от старых к новым)
+  const RingBuffer<KeyPress> &getHistory() const { return keyPressHistory; }
 
-    if (sortedApps.size() > limit) {
-      sortedApps.resize(limit);
-    }
+  // Получение последних N нажатий
+  std::vector<KeyPress> getRecentPresses(size_t count = 10) const {
+    size_t startIndex =
+        (keyPressHistory.size() > count) ? keyPressHistory.size() - count : 0;
 
-    return sortedApps;
+    return std::vector<KeyPress>(keyPressHistory.begin() + startIndex,
+                                 keyPressHistory.end());
   }
 
-  // Топ N самых используемых клавиш (во всех приложениях)
-  std::vector<std::pair<std::string, int>> getTopKeys(size_t limit = 10) const {
-    auto keyStats = getKeyUsageStats();
+  // Статистика по приложениям
+  std::map<std::string, int> getAppUsageStats() const { return toMap(appCounts); }
 
-    std::vector<std::pair<std::string, int>> sortedKeys(keyStats.begin(),
-                                                        keyStats.end());
+  // Статистика по клавишам (все приложения)
+  std::map<std::string, int> getKeyUsageStats() const { return toMap(keyCounts); }
 
-    std::sort(sortedKeys.begin(), sortedKeys.end(),
-              [](const auto &a, const auto &b) { return a.second > b.second; });
+  // Статистика по клавишам для конкретного приложения
+  std::map<std::string, int> getAppKeyStats(const std::string &appName) const {
+    auto appId = symbols.find(appName);
+    auto it = appId ? appKeyCounts.find(*appId) : appKeyCounts.end();
+    return it != appKeyCounts.end() ? toMap(it->second) : std::map<std::string, int>();
+  }
 
-    if (sortedKeys.size() > limit) {
-      sortedKeys.resize(limit);
+  // То же за интервал времени [from, to): считается по истории
+  std::map<std::string, int> getAppKeyStats(const std::string &appName,
+                                            std::int64_t from, std::int64_t to) const {
+    std::map<std::string, int> result;
+    auto filter = makeFilter(appName, "", from, to);
+    if (!filter) {
+      return result;
+    }
+    std::unordered_map<SymbolId, int> counts;
+    forEachMatch(*filter, [&](const KeyPress &press) { ++counts[press.comboId]; });
+    for (const auto &[comboId, count] : counts) {
+      result.emplace(std::string(symbols.resolve(comboId)), count);
     }
+    return result;
+  }
 
-    return sortedKeys;
+  // Топ N самых используемых приложений, O(N)
+  std::vector<std::pair<std::string, int>> getTopApps(size_t limit = 10) const {
+    return toTop(appCounts, limit);
+  }
+
+  // Топ N самых используемых клавиш (во всех приложениях)
+  std::vector<std::pair<std::string, int>> getTopKeys(size_t limit = 10) const {
+    return toTop(keyCounts, limit);
   }
 
   // Топ N самых используемых клавиш для конкретного приложения
   std::vector<std::pair<std::string, int>>
   getTopKeysForApp(const std::string &appName, size_t limit = 10) const {
+    auto appId = symbols.find(appName);
+    auto it = appId ? appKeyCounts.find(*appId) : appKeyCounts.end();
+    return it != appKeyCounts.end() ? toTop(it->second, limit)
+                                    : std::vector<std::pair<std::string, int>>();
+  }
 
-    auto appKeyStats = getAppKeyStats(appName);
-
-    std::vector<std::pair<std::string, int>> sortedKeys(appKeyStats.begin(),
-                                                        appKeyStats.end());
-
-    std::sort(sortedKeys.begin(), sortedKeys.end(),
-              [](const auto &a, const auto &b) { return a.second > b.second; });
-
-    if (sortedKeys.size() > limit) {
-      sortedKeys.resize(limit);
+  // Поиск нажатий по приложению, комбинации и интервалу [from, to);
+  // пустое имя не ограничивает. Строки сравниваются один раз, дальше -
+  // номера.
+  std::vector<KeyPress>
+  findPresses(const std::string &appName, const std::string &keyCombination = "",
+              std::int64_t from = std::numeric_limits<std::int64_t>::min(),
+              std::int64_t to = std::numeric_limits<std::int64_t>::max()) const {
+    std::vector<KeyPress> result;
+    if (auto filter = makeFilter(appName, keyCombination, from, to)) {
+      forEachMatch(*filter, [&](const KeyPress &press) { result.push_back(press); });
     }
+    return result;
+  }
 
-    return sortedKeys;
+  // Число нажатий под тем же условием, без копирования записей
+  size_t countPresses(const std::string &appName, const std::string &keyCombination = "",
+                      std::int64_t from = std::numeric_limits<std::int64_t>::min(),
+                      std::int64_t to = std::numeric_limits<std::int64_t>::max()) const {
+    auto filter = makeFilter(appName, keyCombination, from, to);
+    if (!filter) {
+      return 0;
+    }
+    if (columns) {
+      return columns->count(*filter);
+    }
+    size_t total = 0;
+    forEachMatch(*filter, [&](const KeyPress &) { ++total; });
+    return total;
   }
 
   // Поиск по приложению
   std::vector<KeyPress> findPressesByApp(const std::string &appName) const {
-    std::vector<KeyPress> result;
-
-    for (const auto &press : keyPressHistory) {
-      if (press.appName == appName) {
-        result.push_back(press);
-      }
-    }
-
-    return result;
+    return appName.empty() ? std::vector<KeyPress>() : findPresses(appName);
   }
 
   // Поиск по клавише
   std::vector<KeyPress>
   findPressesByKey(const std::string &keyCombination) const {
-    std::vector<KeyPress> result;
-
-    for (const auto &press : keyPressHistory) {
-      if (press.keyCombination == keyCombination) {
-        result.push_back(press);
-      }
-    }
-
-    return result;
+    return keyCombination.empty() ? std::vector<KeyPress>() : findPresses("", keyCombination);
   }
 
-  // Получение временного диапазона
-  std::pair<unsigned long, unsigned long> getTimeRange() const {
+  // Получение временного диапазона. Нажатия могут прийти не по порядку
+  // (смена часов, восстановление) - тогда min и max ищутся проходом.
+  std::pair<std::int64_t, std::int64_t> getTimeRange() const {
     if (keyPressHistory.empty()) {
       return {0, 0};
     }
+    if (outOfOrder == 0) {
+      return {keyPressHistory.front().timestamp, keyPressHistory.back().timestamp};
+    }
+
+    auto [minPress, maxPress] = std::minmax_element(
+        keyPressHistory.begin(), keyPressHistory.end());
+
+    return {minPress->timestamp, maxPress->timestamp};
+  }
+
+  // Ширина и число корзин скользящего окна; накопленные счетчики окна
+  // сбрасываются
+  void setWindowBuckets(std::int64_t bucketWidthMs, size_t bucketCount) {
+    window = SlidingWindowStats(bucketWidthMs, bucketCount);
+  }
+  const SlidingWindowStats &getWindow() const { return window; }
+
+  // Топ приложений за последние durationMs до now. Окно не зависит от
+  // емкости истории; стоимость - O(корзин), без прохода по нажатиям.
+  std::vector<std::pair<std::string, int>>
+  getTopAppsInWindow(std::int64_t durationMs, size_t limit = 10,
+                     std::int64_t now = KeyPress::now()) const {
+    return toTop(window.query(durationMs, now, SlidingWindowStats::Apps).apps, limit);
+  }
+
+  // Топ комбинаций за последние durationMs до now
+  std::vector<std::pair<std::string, int>>
+  getTopKeysInWindow(std::int64_t durationMs, size_t limit = 10,
+                     std::int64_t now = KeyPress::now()) const {
+    return toTop(window.query(durationMs, now, SlidingWindowStats::Combos).combos, limit);
+  }
 
-    auto minTime = keyPressHistory.front().timestamp;
-    auto maxTime = keyPressHistory.back().timestamp;
+  // Топ комбинаций приложения за последние durationMs до now
+  std::vector<std::pair<std::string, int>>
+  getTopKeysForAppInWindow(const std::string &appName, std::int64_t durationMs,
+                           size_t limit = 10, std::int64_t now = KeyPress::now()) const {
+    auto appId = symbols.find(appName);
+    if (!appId) {
+      return {};
+    }
+    std::unordered_map<SymbolId, int> combos;
+    for (const auto &[key, count] : window.query(durationMs, now, SlidingWindowStats::AppCombos).appCombos) {
+      if (static_cast<SymbolId>(key >> 32) == *appId) {
+        combos[static_cast<SymbolId>(key)] += count;
+      }
+    }
+    return toTop(combos, limit);
+  }
 
-    return {minTime, maxTime};
+  // Частота нажатий в минуту за последние durationMs до now; пустое
+  // имя - по всем приложениям
+  double getPressRate(const std::string &appName, std::int64_t durationMs,
+                      std::int64_t now = KeyPress::now()) const {
+    auto counts = window.query(durationMs, now,
+                               appName.empty() ? SlidingWindowStats::Totals
+                                               : SlidingWindowStats::Apps);
+    if (appName.empty()) {
+      return counts.ratePerMinute(counts.total);
+    }
+    auto appId = symbols.find(appName);
+    auto it = appId ? counts.apps.find(*appId) : counts.apps.end();
+    return counts.ratePerMinute(it != counts.apps.end() ? it->second : 0);
   }
 
-  // Очистка истории
-  void clearHistory() { keyPressHistory.clear(); }
+  // Очистка истории. Имена остаются в таблице: номера в уже выданных
+  // нажатиях продолжают разрешаться.
+  void clearHistory() {
+    keyPressHistory.clear();
+    appCounts.clear();
+    keyCounts.clear();
+    appKeyCounts.clear();
+    outOfOrder = 0;
+    window.clear();
+    if (sketches) {
+      sketches->clear();
+    }
+    if (sequences) {
+      sequences->clear();
+    }
+    if (heatmaps) {
+      heatmaps->apps.clear();
+      heatmaps->combos.clear();
+    }
+    if (columns) {
+      columns->clear();
+    }
+  }
 
   // Получение количества записей
   size_t getCount() const { return keyPressHistory.size(); }
@@ -178,16 +539,43 @@ public:
   // Проверка на пустоту
   bool isEmpty() const { return keyPressHistory.empty(); }
 
-  // Установка максимального размера истории
+  // Установка максимального размера истории (остаются самые новые)
   void setMaxHistorySize(size_t newSize) {
-    maxHistorySize = newSize;
+    for (size_t i = newSize; i < keyPressHistory.size(); ++i) {
+      size_t oldest = keyPressHistory.size() - 1 - i;
+      countPress(keyPressHistory[oldest], -1);
+      dropOrderPair(oldest);
+    }
+    keyPressHistory.setCapacity(newSize);
+    if (columns) {
+      columns->setCapacity(newSize);
+    }
+  }
+  size_t getMaxHistorySize() const { return keyPressHistory.capacity(); }
+
+  // Неизменяемая копия состояния для двоичного снимка (без оценок,
+  // последовательностей и столбцов): снимок кодируется по ней в другом
+  // потоке. Копирование дешевле кодирования, но тоже O(истории + ключей).
+  std::shared_ptr<const KeyStatistics> copyPersistentState() const {
+    return std::shared_ptr<const KeyStatistics>(new KeyStatistics(*this, PersistentCopy{}));
+  }
 
-    // Обрезаем историю если нужно
-    if (keyPressHistory.size() > maxHistorySize) {
-      keyPressHistory.erase(keyPressHistory.begin(),
-                            keyPressHistory.begin() +
-                                (keyPressHistory.size() - maxHistorySize));
+  // Неизменяемая копия счетчиков и последних recentCount нажатий для
+  // чтения из других потоков. O(различных ключей + recentCount).
+  KeyStatisticsSnapshot makeSnapshot(size_t recentCount = 20) const {
+    KeyStatisticsSnapshot snapshot;
+    snapshot.count = getCount();
+    snapshot.timeRange = getTimeRange();
+    snapshot.apps = toRanking(appCounts);
+    snapshot.keys = toRanking(keyCounts);
+    for (const auto &[appId, counter] : appKeyCounts) {
+      snapshot.appKeys.emplace(std::string(symbols.resolve(appId)), toRanking(counter));
+    }
+    for (const auto &press : getRecentPresses(recentCount)) {
+      snapshot.recent.push_back({std::string(getAppName(press)),
+                                 std::string(getKeyCombination(press)), press.timestamp});
     }
+    return snapshot;
   }
 
   // Экспорт статистики в текстовом виде
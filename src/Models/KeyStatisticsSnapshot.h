@@ -0,0 +1,61 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+class KeyStatistics;
+
+// Неизменяемая копия статистики для чтения из других потоков: строки
+// уже разрешены, рейтинги уже упорядочены. Создается писателем через
+// KeyStatistics::makeSnapshot() и публикуется в SnapshotCell.
+struct KeyStatisticsSnapshot {
+  using Ranking = std::vector<std::pair<std::string, int>>;
+
+  struct RecentPress {
+    std::string appName;
+    std::string keyCombination;
+    std::int64_t timestamp;
+  };
+
+  std::uint64_t version = 0; // растет с каждой публикацией
+  size_t count = 0;
+  std::pair<std::int64_t, std::int64_t> timeRange{0, 0};
+  Ranking apps; // по убыванию
+  Ranking keys;
+  std::unordered_map<std::string, Ranking> appKeys;
+  std::vector<RecentPress> recent; // от старых к новым
+  // Копия состояния для двоичного снимка (StatisticsSnapshot), если
+  // писатель ее опубликовал; общая для следующих версий до новой копии
+  std::shared_ptr<const KeyStatistics> state;
+
+  static Ranking head(const Ranking &ranking, size_t limit) {
+    return Ranking(ranking.begin(), ranking.begin() + std::min(limit, ranking.size()));
+  }
+
+  Ranking getTopApps(size_t limit = 10) const { return head(apps, limit); }
+  Ranking getTopKeys(size_t limit = 10) const { return head(keys, limit); }
+  Ranking getTopKeysForApp(const std::string &appName, size_t limit = 10) const {
+    auto it = appKeys.find(appName);
+    return it != appKeys.end() ? head(it->second, limit) : Ranking();
+  }
+
+  std::map<std::string, int> getAppUsageStats() const {
+    return std::map<std::string, int>(apps.begin(), apps.end());
+  }
+  std::map<std::string, int> getKeyUsageStats() const {
+    return std::map<std::string, int>(keys.begin(), keys.end());
+  }
+  std::map<std::string, int> getAppKeyStats(const std::string &appName) const {
+    auto it = appKeys.find(appName);
+    return it != appKeys.end() ? std::map<std::string, int>(it->second.begin(), it->second.end())
+                               : std::map<std::string, int>();
+  }
+
+  size_t getCount() const { return count; }
+  bool isEmpty() const { return count == 0; }
+};
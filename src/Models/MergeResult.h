@@ -0,0 +1,10 @@
+#pragma once
+#include <cstdint>
+
+// Итог слияния одной или нескольких БД в текущую
+struct MergeResult {
+  bool success = false;
+  int sourcesMerged = 0;
+  std::int64_t pressesAdded = 0; // прирост счетчиков key_counts
+  std::int64_t eventsAdded = 0;  // новые строки журнала
+};
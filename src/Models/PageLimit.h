@@ -0,0 +1,14 @@
+#pragma once
+#include <algorithm>
+#include <climits>
+#include <cstddef>
+
+// LIMIT для чтения страницы из pageSize строк: лишняя строка сверх
+// страницы говорит, что есть продолжение. 0 - без ограничений (-1 в
+// SQLite); размер страницы ограничен так, чтобы +1 не переполнял int.
+inline int pageFetchLimit(size_t pageSize) {
+  if (pageSize == 0) {
+    return -1;
+  }
+  return static_cast<int>(std::min<size_t>(pageSize, INT_MAX - 1)) + 1;
+}
@@ -0,0 +1,184 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Счетчики по ключам с постоянно поддерживаемым рейтингом. Ключи лежат
+// в массиве по убыванию счетчика, равные счетчики образуют непрерывную
+// корзину. Изменение на единицу - обмен ключа с краем его корзины,
+// O(1); первые K по убыванию - первые K элементов массива, O(K).
+// Ключ с нулевым счетчиком удаляется. Порядок внутри корзины не задан.
+template <typename Key, typename Hash = std::hash<Key>> class RankedCounter {
+private:
+  struct Entry {
+    Key key;
+    int count;
+  };
+  struct Bucket {
+    size_t first;
+    size_t last;
+  };
+
+  std::vector<Entry> ranked;
+  std::unordered_map<Key, size_t, Hash> positions;
+  std::unordered_map<int, Bucket> buckets;
+
+  void swapEntries(size_t a, size_t b) {
+    if (a != b) {
+      std::swap(ranked[a], ranked[b]);
+      positions[ranked[a].key] = a;
+      positions[ranked[b].key] = b;
+    }
+  }
+
+  // Ключ в позиции p переходит из корзины count в count + 1
+  size_t increment(size_t p) {
+    int count = ranked[p].count;
+    Bucket &from = buckets.at(count);
+    size_t q = from.first;
+    swapEntries(p, q);
+    if (from.first == from.last) {
+      buckets.erase(count);
+    } else {
+      ++from.first;
+    }
+
+    ++ranked[q].count;
+    // Соседняя корзина выше - либо count + 1, либо корзины еще нет
+    auto above = buckets.find(count + 1);
+    if (above != buckets.end()) {
+      above->second.last = q;
+    } else {
+      buckets.emplace(count + 1, Bucket{q, q});
+    }
+    return q;
+  }
+
+  // Ключ в позиции p переходит из корзины count в count - 1
+  size_t decrement(size_t p) {
+    int count = ranked[p].count;
+    Bucket &from = buckets.at(count);
+    size_t r = from.last;
+    swapEntries(p, r);
+    if (from.first == from.last) {
+      buckets.erase(count);
+    } else {
+      --from.last;
+    }
+
+    --ranked[r].count;
+    auto below = buckets.find(count - 1);
+    if (below != buckets.end()) {
+      below->second.first = r;
+    } else {
+      buckets.emplace(count - 1, Bucket{r, r});
+    }
+    return r;
+  }
+
+  // Нулевая корзина всегда последняя: ключ меняется с последним
+  // элементом и удаляется
+  void removeZero(size_t p) {
+    size_t tail = ranked.size() - 1;
+    swapEntries(p, tail);
+    positions.erase(ranked[tail].key);
+    ranked.pop_back();
+    Bucket &zero = buckets.at(0);
+    if (zero.first == zero.last) {
+      buckets.erase(0);
+    } else {
+      --zero.last;
+    }
+  }
+
+public:
+  // Прибавляет delta (может быть отрицательным) к счетчику key.
+  // Стоимость пропорциональна |delta|; обычно delta = ±1.
+  void add(const Key &key, int delta = 1) {
+    auto it = positions.find(key);
+    if (it == positions.end()) {
+      if (delta <= 0) {
+        return;
+      }
+      // Новый ключ входит в хвост с нулевым счетчиком
+      ranked.push_back({key, 0});
+      it = positions.emplace(key, ranked.size() - 1).first;
+      auto zero = buckets.find(0);
+      if (zero != buckets.end()) {
+        zero->second.last = ranked.size() - 1;
+      } else {
+        buckets.emplace(0, Bucket{ranked.size() - 1, ranked.size() - 1});
+      }
+    }
+
+    size_t p = it->second;
+    for (; delta > 0; --delta) {
+      p = increment(p);
+    }
+    for (; delta < 0 && ranked[p].count > 0; ++delta) {
+      p = decrement(p);
+    }
+    if (ranked[p].count == 0) {
+      removeZero(p);
+    }
+  }
+
+  void remove(const Key &key) { add(key, -1); }
+
+  int count(const Key &key) const {
+    auto it = positions.find(key);
+    return it != positions.end() ? ranked[it->second].count : 0;
+  }
+
+  // Первые limit ключей по убыванию счетчика
+  std::vector<std::pair<Key, int>> top(size_t limit) const {
+    std::vector<std::pair<Key, int>> result;
+    result.reserve(std::min(limit, ranked.size()));
+    for (size_t i = 0; i < ranked.size() && i < limit; ++i) {
+      result.emplace_back(ranked[i].key, ranked[i].count);
+    }
+    return result;
+  }
+
+  // Все счетчики в порядке рейтинга
+  template <typename Visitor> void forEach(Visitor &&visit) const {
+    for (const auto &entry : ranked) {
+      visit(entry.key, entry.count);
+    }
+  }
+
+  // Заменяет все счетчики готовым рейтингом (например, из снимка):
+  // O(n log n) вместо O(сумма счетчиков) через add(). Нулевые счетчики
+  // пропускаются, из повторов ключа остается больший.
+  void assign(std::vector<std::pair<Key, int>> entries) {
+    clear();
+    std::stable_sort(entries.begin(), entries.end(),
+                     [](const auto &a, const auto &b) { return a.second > b.second; });
+    ranked.reserve(entries.size());
+    for (const auto &[key, count] : entries) {
+      if (count <= 0 || !positions.emplace(key, ranked.size()).second) {
+        continue;
+      }
+      size_t p = ranked.size();
+      ranked.push_back({key, count});
+      auto bucket = buckets.find(count);
+      if (bucket != buckets.end()) {
+        bucket->second.last = p;
+      } else {
+        buckets.emplace(count, Bucket{p, p});
+      }
+    }
+  }
+
+  size_t size() const { return ranked.size(); }
+  bool empty() const { return ranked.empty(); }
+
+  void clear() {
+    ranked.clear();
+    positions.clear();
+    buckets.clear();
+  }
+};
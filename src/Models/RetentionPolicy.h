@@ -0,0 +1,14 @@
+#pragma once
+#include <chrono>
+#include <optional>
+
+// Сроки хранения уровней детализации; пустое значение - хранить всегда.
+// Счетчики за все время (key_counts) не стареют. Каждое нажатие уже
+// учтено во всех свертках при записи, поэтому устаревший уровень
+// просто удаляется: его данные остаются в более крупных свертках.
+struct RetentionPolicy {
+  std::optional<std::chrono::milliseconds> rawEvents = std::chrono::hours(24 * 30);
+  std::optional<std::chrono::milliseconds> minuteRollups = std::chrono::hours(24 * 90);
+  std::optional<std::chrono::milliseconds> hourRollups = std::chrono::hours(24 * 365);
+  std::optional<std::chrono::milliseconds> dayRollups;
+};
@@ -0,0 +1,120 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+// Кольцевой буфер фиксированной емкости: добавление за O(1), при
+// заполнении новый элемент замещает самый старый. Индекс 0 - самый
+// старый элемент, size() - 1 - самый новый; итерация идет в том же
+// порядке. Память растет по мере добавления и не превышает емкость.
+template <typename T> class RingBuffer {
+private:
+  std::vector<T> slots;
+  size_t head = 0; // слот самого старого элемента, когда буфер полон
+  size_t maxSize;
+
+  size_t physical(size_t index) const {
+    size_t slot = head + index;
+    return slot < slots.size() ? slot : slot - slots.size();
+  }
+
+public:
+  // Итератор произвольного доступа по логическому индексу
+  class const_iterator {
+  private:
+    const RingBuffer *buffer = nullptr;
+    size_t index = 0;
+
+  public:
+    using iterator_category = std::random_access_iterator_tag;
+    using value_type = T;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const T *;
+    using reference = const T &;
+
+    const_iterator() = default;
+    const_iterator(const RingBuffer *owner, size_t position)
+        : buffer(owner), index(position) {}
+
+    reference operator*() const { return (*buffer)[index]; }
+    pointer operator->() const { return &(*buffer)[index]; }
+    reference operator[](difference_type n) const { return (*buffer)[index + n]; }
+
+    const_iterator &operator++() { ++index; return *this; }
+    const_iterator operator++(int) { auto copy = *this; ++index; return copy; }
+    const_iterator &operator--() { --index; return *this; }
+    const_iterator operator--(int) { auto copy = *this; --index; return copy; }
+    const_iterator &operator+=(difference_type n) { index += n; return *this; }
+    const_iterator &operator-=(difference_type n) { index -= n; return *this; }
+    const_iterator operator+(difference_type n) const { return {buffer, index + n}; }
+    const_iterator operator-(difference_type n) const { return {buffer, index - n}; }
+    friend const_iterator operator+(difference_type n, const const_iterator &it) {
+      return it + n;
+    }
+    difference_type operator-(const const_iterator &other) const {
+      return static_cast<difference_type>(index) - static_cast<difference_type>(other.index);
+    }
+
+    bool operator==(const const_iterator &other) const { return index == other.index; }
+    bool operator!=(const const_iterator &other) const { return index != other.index; }
+    bool operator<(const const_iterator &other) const { return index < other.index; }
+    bool operator>(const const_iterator &other) const { return index > other.index; }
+    bool operator<=(const const_iterator &other) const { return index <= other.index; }
+    bool operator>=(const const_iterator &other) const { return index >= other.index; }
+  };
+
+  explicit RingBuffer(size_t capacity) : maxSize(capacity) {}
+
+  void push_back(T value) {
+    if (maxSize == 0) {
+      return;
+    }
+    if (slots.size() < maxSize) {
+      slots.push_back(std::move(value));
+      return;
+    }
+    slots[head] = std::move(value);
+    head = head + 1 == slots.size() ? 0 : head + 1;
+  }
+
+  const T &operator[](size_t index) const { return slots[physical(index)]; }
+  const T &front() const { return slots[head]; }
+  const T &back() const { return (*this)[slots.size() - 1]; }
+
+  const_iterator begin() const { return {this, 0}; }
+  const_iterator end() const { return {this, slots.size()}; }
+
+  size_t size() const { return slots.size(); }
+  size_t capacity() const { return maxSize; }
+  bool empty() const { return slots.empty(); }
+
+  void clear() {
+    slots.clear();
+    head = 0;
+  }
+
+  // Заменяет содержимое элементами от старых к новым; сверх емкости
+  // остаются самые новые. Вектор перемещается без поэлементного копирования.
+  void assign(std::vector<T> items) {
+    if (items.size() > maxSize) {
+      items.erase(items.begin(), items.begin() + (items.size() - maxSize));
+    }
+    slots = std::move(items);
+    head = 0;
+  }
+
+  // Новая емкость; при уменьшении остаются самые новые элементы.
+  // Элементы переупорядочиваются один раз, за O(size).
+  void setCapacity(size_t capacity) {
+    size_t keep = std::min(slots.size(), capacity);
+    std::rotate(slots.begin(), slots.begin() + head, slots.end());
+    slots.erase(slots.begin(), slots.begin() + (slots.size() - keep));
+    head = 0;
+    maxSize = capacity;
+    if (slots.capacity() > maxSize) {
+      slots.shrink_to_fit();
+    }
+  }
+};
@@ -0,0 +1,139 @@
+#pragma once
+#include "RankedCounter.h"
+#include "SymbolTable.h"
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Последовательность из 2 (биграмма) или 3 (триграмма) комбинаций,
+// нажатых подряд без паузы длиннее таймаута. Приложение - то, где
+// последовательность завершилась: Ctrl+C в редакторе, Alt+Tab, Ctrl+V в
+// браузере относится к браузеру.
+template <typename Id> struct KeySequenceOf {
+  Id app{};
+  std::array<Id, 3> combos{};
+  std::uint8_t length = 0;
+
+  bool operator==(const KeySequenceOf &other) const {
+    return app == other.app && length == other.length && combos == other.combos;
+  }
+};
+
+template <typename Id, typename Hash = std::hash<Id>> struct KeySequenceHash {
+  size_t operator()(const KeySequenceOf<Id> &sequence) const {
+    size_t h = Hash()(sequence.app) ^ sequence.length;
+    for (size_t i = 0; i < sequence.length; ++i) {
+      h ^= Hash()(sequence.combos[i]) + 0x9e3779b9 + (h << 6) + (h >> 2);
+    }
+    return h;
+  }
+};
+
+// Цепочка последних нажатий: каждое нажатие порождает биграмму с
+// предыдущим и триграмму с двумя предыдущими, если паузы между ними не
+// длиннее таймаута. O(1) на нажатие; Id - номер или строка.
+template <typename Id> class SequenceTracker {
+private:
+  std::array<Id, 2> recent{}; // recent[1] - последнее нажатие
+  size_t chainLength = 0;
+  std::int64_t lastTimestamp = 0;
+  std::int64_t timeout;
+
+public:
+  explicit SequenceTracker(std::int64_t timeoutMs = 2000) : timeout(timeoutMs) {}
+
+  template <typename Emit>
+  void observe(const Id &app, const Id &combo, std::int64_t timestamp, Emit &&emit) {
+    // Пауза длиннее таймаута (или время назад) рвет цепочку
+    if (chainLength > 0 && (timestamp - lastTimestamp > timeout || timestamp < lastTimestamp)) {
+      chainLength = 0;
+    }
+    if (chainLength >= 1) {
+      emit(KeySequenceOf<Id>{app, {recent[1], combo, Id{}}, 2});
+    }
+    if (chainLength >= 2) {
+      emit(KeySequenceOf<Id>{app, {recent[0], recent[1], combo}, 3});
+    }
+    recent[0] = std::move(recent[1]);
+    recent[1] = combo;
+    chainLength = std::min<size_t>(chainLength + 1, 2);
+    lastTimestamp = timestamp;
+  }
+
+  void reset() { chainLength = 0; }
+
+  std::int64_t getTimeout() const { return timeout; }
+  void setTimeout(std::int64_t timeoutMs) { timeout = timeoutMs; }
+};
+
+// Частоты последовательностей в памяти, по номерам SymbolTable. Рейтинги
+// (RankedCounter) поддерживаются на каждое нажатие, поэтому топ - O(K)
+// без прохода по истории. Для каждого приложения хранится разреженная
+// матрица переходов "комбинация -> следующая комбинация".
+class SequenceMiner {
+public:
+  using Sequence = KeySequenceOf<SymbolId>;
+  using Counter = RankedCounter<Sequence, KeySequenceHash<SymbolId>>;
+
+private:
+  SequenceTracker<SymbolId> tracker;
+  std::array<Counter, 2> overall; // [0] - биграммы, [1] - триграммы
+  std::unordered_map<SymbolId, std::array<Counter, 2>> byApp;
+  // (приложение, комбинация) -> рейтинг следующих комбинаций
+  std::unordered_map<std::uint64_t, RankedCounter<SymbolId>> transitions;
+
+  static std::uint64_t transitionKey(SymbolId appId, SymbolId fromId) {
+    return (static_cast<std::uint64_t>(appId) << 32) | fromId;
+  }
+
+  static size_t slot(size_t length) { return length == 3 ? 1 : 0; }
+
+public:
+  explicit SequenceMiner(std::int64_t timeoutMs = 2000) : tracker(timeoutMs) {}
+
+  void observe(SymbolId appId, SymbolId comboId, std::int64_t timestamp) {
+    tracker.observe(appId, comboId, timestamp, [&](const Sequence &sequence) {
+      overall[slot(sequence.length)].add(sequence);
+      byApp[sequence.app][slot(sequence.length)].add(sequence);
+      if (sequence.length == 2) {
+        transitions[transitionKey(sequence.app, sequence.combos[0])].add(sequence.combos[1]);
+      }
+    });
+  }
+
+  // Самые частые последовательности длины 2 или 3, по всем приложениям
+  // или по одному
+  std::vector<std::pair<Sequence, int>> top(size_t length, size_t limit,
+                                            std::optional<SymbolId> appId = std::nullopt) const {
+    if (!appId) {
+      return overall[slot(length)].top(limit);
+    }
+    auto it = byApp.find(*appId);
+    return it != byApp.end() ? it->second[slot(length)].top(limit)
+                             : std::vector<std::pair<Sequence, int>>();
+  }
+
+  // Строка матрицы переходов: что чаще всего нажимают после fromId
+  std::vector<std::pair<SymbolId, int>> next(SymbolId appId, SymbolId fromId,
+                                             size_t limit) const {
+    auto it = transitions.find(transitionKey(appId, fromId));
+    return it != transitions.end() ? it->second.top(limit)
+                                   : std::vector<std::pair<SymbolId, int>>();
+  }
+
+  std::int64_t getTimeout() const { return tracker.getTimeout(); }
+
+  void clear() {
+    tracker.reset();
+    for (auto &counter : overall) {
+      counter.clear();
+    }
+    byApp.clear();
+    transitions.clear();
+  }
+};
@@ -0,0 +1,454 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <iterator>
+#include <optional>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Потоковые оценки фиксированного размера для неограниченной истории.
+// Ключи хешируются по строкам, а не по номерам SymbolTable, поэтому
+// оценки с разных машин с одинаковыми параметрами можно объединять
+// (merge) для сводной статистики; переносимый образ - SketchCodec.
+
+class SketchCodec;
+
+// Перемешивание splitmix64
+inline std::uint64_t mixHash64(std::uint64_t hash) {
+  hash ^= hash >> 30;
+  hash *= 0xbf58476d1ce4e5b9ull;
+  hash ^= hash >> 27;
+  hash *= 0x94d049bb133111ebull;
+  hash ^= hash >> 31;
+  return hash;
+}
+
+// Стабильный 64-битный хеш строки: FNV-1a с перемешиванием splitmix64,
+// одинаковый на всех платформах и запусках
+inline std::uint64_t stableHash64(std::string_view text) {
+  std::uint64_t hash = 0xcbf29ce484222325ull;
+  for (unsigned char c : text) {
+    hash = (hash ^ c) * 0x100000001b3ull;
+  }
+  return mixHash64(hash);
+}
+
+// Стабильный хеш пары по хешам ее частей, без склейки строк
+inline std::uint64_t stableHash64(std::uint64_t first, std::uint64_t second) {
+  return mixHash64(first ^ (second + 0x9e3779b97f4a7c15ull + (first << 6) + (first >> 2)));
+}
+
+// Count-Min: частоты с завышением. При ширине w = ceil(e / epsilon) и
+// глубине d = ceil(ln(1 / delta)) оценка не меньше точной и превышает ее
+// не более чем на epsilon * N (N - всего добавлено) с вероятностью
+// 1 - delta. Память - w * d счетчиков.
+class CountMinSketch {
+private:
+  friend class SketchCodec;
+
+  size_t width;
+  size_t depth;
+  std::vector<std::uint64_t> counters; // depth строк по width
+  std::uint64_t total = 0;
+
+  // Строка i использует хеш h1 + i * h2 (Kirsch-Mitzenmacher)
+  size_t column(std::uint64_t hash, size_t row) const {
+    std::uint64_t h1 = hash & 0xffffffffull;
+    std::uint64_t h2 = (hash >> 32) | 1;
+    return static_cast<size_t>((h1 + row * h2) % width);
+  }
+
+public:
+  CountMinSketch(size_t width, size_t depth)
+      : width(std::max<size_t>(width, 1)), depth(std::max<size_t>(depth, 1)),
+        counters(this->width * this->depth) {}
+
+  static CountMinSketch withError(double epsilon, double delta) {
+    return CountMinSketch(static_cast<size_t>(std::ceil(std::exp(1.0) / epsilon)),
+                          static_cast<size_t>(std::ceil(std::log(1.0 / delta))));
+  }
+
+  void add(std::uint64_t hash, std::uint64_t count = 1) {
+    for (size_t row = 0; row < depth; ++row) {
+      counters[row * width + column(hash, row)] += count;
+    }
+    total += count;
+  }
+  void add(std::string_view key, std::uint64_t count = 1) { add(stableHash64(key), count); }
+
+  std::uint64_t estimate(std::uint64_t hash) const {
+    std::uint64_t result = UINT64_MAX;
+    for (size_t row = 0; row < depth; ++row) {
+      result = std::min(result, counters[row * width + column(hash, row)]);
+    }
+    return result;
+  }
+  std::uint64_t estimate(std::string_view key) const { return estimate(stableHash64(key)); }
+
+  // Граница ошибки для текущего N: epsilon * N, где epsilon = e / width
+  double errorBound() const { return std::exp(1.0) / width * static_cast<double>(total); }
+
+  // Оценки с одинаковыми размерами складываются по счетчикам
+  void merge(const CountMinSketch &other) {
+    if (other.width != width || other.depth != depth) {
+      throw std::invalid_argument("Count-Min sketches differ in size");
+    }
+    for (size_t i = 0; i < counters.size(); ++i) {
+      counters[i] += other.counters[i];
+    }
+    total += other.total;
+  }
+
+  std::uint64_t totalCount() const { return total; }
+  size_t getWidth() const { return width; }
+  size_t getDepth() const { return depth; }
+  size_t memoryBytes() const { return counters.size() * sizeof(std::uint64_t); }
+
+  void clear() {
+    std::fill(counters.begin(), counters.end(), 0);
+    total = 0;
+  }
+};
+
+// Space-Saving: самые частые ключи в k ячейках. Оценка ключа завышена
+// не более чем на свою погрешность error <= N / k; любой ключ с частотой
+// больше N / k гарантированно присутствует. Новый ключ при полной
+// таблице вытесняет ключ с наименьшим счетчиком и наследует его.
+template <typename Key = std::string, typename Hash = std::hash<Key>>
+class SpaceSaving {
+public:
+  struct Entry {
+    Key key;
+    std::uint64_t count;
+    std::uint64_t error; // count - error <= точная частота <= count
+  };
+
+private:
+  friend class SketchCodec;
+
+  size_t capacity;
+  std::vector<Entry> entries;
+  std::unordered_map<Key, size_t, Hash> positions;
+  std::set<std::pair<std::uint64_t, size_t>> byCount; // (count, позиция)
+  std::uint64_t total = 0;
+
+  void setCount(size_t index, std::uint64_t count) {
+    byCount.erase({entries[index].count, index});
+    entries[index].count = count;
+    byCount.insert({count, index});
+  }
+
+  // Счетчик ключа, которого нет в полной таблице, не больше минимума
+  std::uint64_t absentBound() const {
+    return entries.size() < capacity || byCount.empty() ? 0 : byCount.begin()->first;
+  }
+
+public:
+  explicit SpaceSaving(size_t capacity) : capacity(std::max<size_t>(capacity, 1)) {}
+
+  // Возвращает ключ, вытесненный новым ключом из полной таблицы
+  std::optional<Key> add(const Key &key, std::uint64_t count = 1) {
+    total += count;
+    auto it = positions.find(key);
+    if (it != positions.end()) {
+      setCount(it->second, entries[it->second].count + count);
+      return std::nullopt;
+    }
+    if (entries.size() < capacity) {
+      entries.push_back({key, count, 0});
+      positions.emplace(key, entries.size() - 1);
+      byCount.insert({count, entries.size() - 1});
+      return std::nullopt;
+    }
+    // Вытесняем минимальный ключ: новый наследует его счетчик как погрешность
+    size_t index = byCount.begin()->second;
+    std::uint64_t minimum = entries[index].count;
+    std::optional<Key> evicted(std::move(entries[index].key));
+    positions.erase(*evicted);
+    entries[index].key = key;
+    entries[index].error = minimum;
+    positions.emplace(key, index);
+    setCount(index, minimum + count);
+    return evicted;
+  }
+
+  bool contains(const Key &key) const { return positions.count(key) != 0; }
+
+  // Оценка сверху; для отсутствующего ключа - минимум полной таблицы
+  std::uint64_t estimate(const Key &key) const {
+    auto it = positions.find(key);
+    return it != positions.end() ? entries[it->second].count : absentBound();
+  }
+
+  // Первые limit ключей по убыванию оценки
+  std::vector<Entry> top(size_t limit) const {
+    std::vector<Entry> result;
+    for (auto it = byCount.rbegin(); it != byCount.rend() && result.size() < limit; ++it) {
+      result.push_back(entries[it->second]);
+    }
+    return result;
+  }
+
+  // Объединение по Agarwal et al. ("Mergeable Summaries"): оценки
+  // складываются, отсутствующий ключ берет минимум другой таблицы;
+  // остаются k наибольших. Погрешность остается <= (N1 + N2) / k.
+  void merge(const SpaceSaving &other) {
+    if (other.capacity != capacity) {
+      throw std::invalid_argument("Space-Saving summaries differ in capacity");
+    }
+    std::unordered_map<Key, Entry, Hash> combined;
+    std::uint64_t ownAbsent = absentBound();
+    std::uint64_t otherAbsent = other.absentBound();
+    for (const auto &entry : entries) {
+      combined.emplace(entry.key, Entry{entry.key, entry.count + otherAbsent,
+                                        entry.error + otherAbsent});
+    }
+    for (const auto &entry : other.entries) {
+      auto [it, inserted] = combined.try_emplace(
+          entry.key, Entry{entry.key, entry.count + ownAbsent, entry.error + ownAbsent});
+      if (!inserted) {
+        it->second.count += entry.count - otherAbsent;
+        it->second.error += entry.error - otherAbsent;
+      }
+    }
+
+    std::vector<Entry> merged;
+    merged.reserve(combined.size());
+    for (auto &[key, entry] : combined) {
+      merged.push_back(std::move(entry));
+    }
+    size_t keep = std::min(capacity, merged.size());
+    std::partial_sort(merged.begin(), merged.begin() + keep, merged.end(),
+                      [](const Entry &a, const Entry &b) { return a.count > b.count; });
+    merged.resize(keep);
+
+    std::uint64_t mergedTotal = total + other.total;
+    clear();
+    total = mergedTotal;
+    for (auto &entry : merged) {
+      positions.emplace(entry.key, entries.size());
+      byCount.insert({entry.count, entries.size()});
+      entries.push_back(std::move(entry));
+    }
+  }
+
+  // Граница погрешности для текущего N: N / k
+  double errorBound() const { return static_cast<double>(total) / capacity; }
+
+  std::uint64_t totalCount() const { return total; }
+  size_t size() const { return entries.size(); }
+  size_t getCapacity() const { return capacity; }
+
+  void clear() {
+    entries.clear();
+    positions.clear();
+    byCount.clear();
+    total = 0;
+  }
+};
+
+// HyperLogLog: число различных ключей в 2^p однобайтовых регистрах.
+// Относительная стандартная ошибка 1.04 / sqrt(2^p): 1.6% при p = 12
+// (4 КБ). Малые значения уточняются линейным подсчетом.
+class HyperLogLog {
+private:
+  friend class SketchCodec;
+
+  int precision;
+  std::vector<std::uint8_t> registers;
+
+public:
+  explicit HyperLogLog(int precision = 12)
+      : precision(std::clamp(precision, 4, 18)), registers(size_t{1} << this->precision) {}
+
+  void add(std::uint64_t hash) {
+    size_t index = static_cast<size_t>(hash >> (64 - precision));
+    std::uint64_t rest = hash << precision;
+    // Ранг - позиция первой единицы в оставшихся 64 - p битах
+    std::uint8_t rank = 1;
+    int maxRank = 64 - precision + 1;
+    while (rank < maxRank && (rest & (1ull << 63)) == 0) {
+      rest <<= 1;
+      ++rank;
+    }
+    registers[index] = std::max(registers[index], rank);
+  }
+  void add(std::string_view key) { add(stableHash64(key)); }
+
+  double estimate() const {
+    double m = static_cast<double>(registers.size());
+    double alpha = registers.size() == 16   ? 0.673
+                   : registers.size() == 32 ? 0.697
+                   : registers.size() == 64 ? 0.709
+                                            : 0.7213 / (1.0 + 1.079 / m);
+    double sum = 0.0;
+    size_t zeros = 0;
+    for (std::uint8_t value : registers) {
+      sum += std::ldexp(1.0, -value);
+      zeros += value == 0;
+    }
+    double raw = alpha * m * m / sum;
+    if (raw <= 2.5 * m && zeros != 0) {
+      return m * std::log(m / static_cast<double>(zeros));
+    }
+    return raw;
+  }
+
+  // Относительная стандартная ошибка оценки
+  double relativeError() const { return 1.04 / std::sqrt(static_cast<double>(registers.size())); }
+
+  // Объединение - поэлементный максимум регистров
+  void merge(const HyperLogLog &other) {
+    if (other.precision != precision) {
+      throw std::invalid_argument("HyperLogLog sketches differ in precision");
+    }
+    for (size_t i = 0; i < registers.size(); ++i) {
+      registers[i] = std::max(registers[i], other.registers[i]);
+    }
+  }
+
+  int getPrecision() const { return precision; }
+  size_t memoryBytes() const { return registers.size(); }
+
+  void clear() { std::fill(registers.begin(), registers.end(), 0); }
+};
+
+// Параметры оценок для KeySketches
+struct SketchConfig {
+  double frequencyEpsilon = 0.001; // Count-Min: ошибка <= epsilon * N
+  double frequencyDelta = 0.01;    // ... с вероятностью 1 - delta
+  size_t heavyHitters = 256;       // Space-Saving: ячеек
+  int cardinalityPrecision = 12;   // HyperLogLog: 2^p регистров
+};
+
+// Набор оценок по всем нажатиям (без вытеснения): частоты и самые
+// частые пары (приложение, комбинация), число различных комбинаций и
+// пар. Размер фиксирован параметрами и не зависит от потока.
+class KeySketches {
+public:
+  struct HeavyHitter {
+    std::string appName;
+    std::string keyCombination;
+    std::uint64_t count;
+    std::uint64_t error;
+  };
+
+private:
+  friend class SketchCodec;
+
+  static constexpr char kSeparator = '\x1f';
+
+  // Пары учитываются по хешу; строка "приложение\x1fкомбинация" хранится
+  // только для пар, которые сейчас в таблице Space-Saving
+  CountMinSketch pairFrequencies;
+  CountMinSketch comboFrequencies;
+  SpaceSaving<std::uint64_t> heavyPairs;
+  std::unordered_map<std::uint64_t, std::string> pairNames;
+  HyperLogLog distinctCombos;
+  HyperLogLog distinctPairs;
+
+  static std::uint64_t pairHash(std::string_view appName, std::string_view keyCombination) {
+    return stableHash64(stableHash64(appName), stableHash64(keyCombination));
+  }
+
+  static void assignPairName(std::string &name, std::string_view appName,
+                             std::string_view keyCombination) {
+    name.assign(appName).push_back(kSeparator);
+    name.append(keyCombination);
+  }
+
+public:
+  explicit KeySketches(const SketchConfig &config = SketchConfig())
+      : pairFrequencies(CountMinSketch::withError(config.frequencyEpsilon, config.frequencyDelta)),
+        comboFrequencies(CountMinSketch::withError(config.frequencyEpsilon, config.frequencyDelta)),
+        heavyPairs(config.heavyHitters), distinctCombos(config.cardinalityPrecision),
+        distinctPairs(config.cardinalityPrecision) {}
+
+  // Без выделения памяти, кроме случая, когда пара занимает ячейку
+  // Space-Saving; строка вытесненной пары тогда переиспользуется
+  void add(std::string_view appName, std::string_view keyCombination) {
+    std::uint64_t comboHash = stableHash64(keyCombination);
+    std::uint64_t pair = stableHash64(stableHash64(appName), comboHash);
+    pairFrequencies.add(pair);
+    comboFrequencies.add(comboHash);
+    distinctPairs.add(pair);
+    distinctCombos.add(comboHash);
+
+    bool known = heavyPairs.contains(pair);
+    std::optional<std::uint64_t> evicted = heavyPairs.add(pair);
+    if (known) {
+      return;
+    }
+    if (!evicted) {
+      assignPairName(pairNames[pair], appName, keyCombination);
+      return;
+    }
+    auto node = pairNames.extract(*evicted);
+    node.key() = pair;
+    assignPairName(node.mapped(), appName, keyCombination);
+    pairNames.insert(std::move(node));
+  }
+
+  // Оценка сверху числа нажатий пары; ошибка <= frequencyErrorBound()
+  std::uint64_t estimatePair(std::string_view appName, std::string_view keyCombination) const {
+    return pairFrequencies.estimate(pairHash(appName, keyCombination));
+  }
+  std::uint64_t estimateCombo(std::string_view keyCombination) const {
+    return comboFrequencies.estimate(keyCombination);
+  }
+  double frequencyErrorBound() const { return pairFrequencies.errorBound(); }
+
+  // Самые частые пары; каждая пара с частотой > N / heavyHitters здесь
+  std::vector<HeavyHitter> topPairs(size_t limit = 10) const {
+    std::vector<HeavyHitter> result;
+    for (const auto &entry : heavyPairs.top(limit)) {
+      const std::string &name = pairNames.at(entry.key);
+      size_t split = name.find(kSeparator);
+      result.push_back({name.substr(0, split), name.substr(split + 1), entry.count, entry.error});
+    }
+    return result;
+  }
+
+  double distinctComboCount() const { return distinctCombos.estimate(); }
+  double distinctPairCount() const { return distinctPairs.estimate(); }
+
+  std::uint64_t totalCount() const { return pairFrequencies.totalCount(); }
+
+  // Объединение с оценками другого экземпляра с теми же параметрами.
+  // Параметры проверяются до изменений, чтобы отказ не оставил
+  // наполовину объединенный набор.
+  void merge(const KeySketches &other) {
+    if (other.pairFrequencies.getWidth() != pairFrequencies.getWidth() ||
+        other.pairFrequencies.getDepth() != pairFrequencies.getDepth() ||
+        other.heavyPairs.getCapacity() != heavyPairs.getCapacity() ||
+        other.distinctPairs.getPrecision() != distinctPairs.getPrecision()) {
+      throw std::invalid_argument("Sketch sets were created with different parameters");
+    }
+    pairFrequencies.merge(other.pairFrequencies);
+    comboFrequencies.merge(other.comboFrequencies);
+    heavyPairs.merge(other.heavyPairs);
+    distinctCombos.merge(other.distinctCombos);
+    distinctPairs.merge(other.distinctPairs);
+
+    // Имена - только для пар, оставшихся в объединенной таблице
+    pairNames.insert(other.pairNames.begin(), other.pairNames.end());
+    for (auto it = pairNames.begin(); it != pairNames.end();) {
+      it = heavyPairs.contains(it->first) ? std::next(it) : pairNames.erase(it);
+    }
+  }
+
+  void clear() {
+    pairFrequencies.clear();
+    comboFrequencies.clear();
+    heavyPairs.clear();
+    pairNames.clear();
+    distinctCombos.clear();
+    distinctPairs.clear();
+  }
+};
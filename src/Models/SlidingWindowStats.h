@@ -0,0 +1,180 @@
+#pragma once
+#include "KeyPress.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Счетчики за последнее время: кольцо корзин фиксированной ширины.
+// Нажатие попадает в корзину timestamp / width; слот корзины в кольце -
+// ее номер по модулю числа корзин. Корзина, номер которой вышел из
+// окна, считается пустой и переиспользуется при следующем попадании в
+// ее слот, поэтому устаревание не требует ни таймера, ни прохода по
+// истории. Запрос за последние D мс складывает ceil(D / width) корзин.
+//
+// Копии окна делят корзины (копирование при записи): копия для снимка
+// стоит O(корзин) указателей, а писатель клонирует корзину, только если
+// ее еще держит копия. Копировать окно можно только в потоке писателя.
+class SlidingWindowStats {
+public:
+  // Сумма корзин за запрошенный интервал [from, to)
+  struct Counts {
+    std::int64_t from = 0;
+    std::int64_t to = 0;
+    int total = 0;
+    std::unordered_map<SymbolId, int> apps;
+    std::unordered_map<SymbolId, int> combos;
+    std::unordered_map<std::uint64_t, int> appCombos; // appComboKey()
+
+    // Частота в нажатиях в минуту; интервал заканчивается моментом
+    // запроса, поэтому неполная текущая корзина не занижает частоту
+    double ratePerMinute(int count) const {
+      return to > from ? count * 60000.0 / static_cast<double>(to - from) : 0.0;
+    }
+  };
+
+  // Какие счетчики складывать в query(): лишние карты не собираются
+  enum Fields : unsigned { Totals = 0, Apps = 1, Combos = 2, AppCombos = 4, All = 7 };
+
+  static std::uint64_t appComboKey(SymbolId appId, SymbolId comboId) {
+    return (static_cast<std::uint64_t>(appId) << 32) | comboId;
+  }
+
+  static constexpr std::int64_t kEmpty = std::numeric_limits<std::int64_t>::min();
+
+  // Корзина окна; видна снаружи ради forEachBucket/restoreBucket
+  struct Bucket {
+    std::int64_t index = kEmpty; // номер корзины (timestamp / width)
+    int total = 0;
+    std::unordered_map<SymbolId, int> apps;
+    std::unordered_map<SymbolId, int> combos;
+    std::unordered_map<std::uint64_t, int> appCombos;
+  };
+
+private:
+  std::int64_t width;
+  std::vector<std::shared_ptr<Bucket>> buckets; // пустой слот - nullptr
+
+  std::int64_t bucketIndex(std::int64_t timestamp) const {
+    // Деление с округлением вниз и для времени до эпохи
+    return timestamp >= 0 ? timestamp / width : (timestamp - width + 1) / width;
+  }
+
+  size_t slotFor(std::int64_t index) const {
+    auto count = static_cast<std::int64_t>(buckets.size());
+    return static_cast<size_t>(((index % count) + count) % count);
+  }
+
+  const Bucket *find(std::int64_t index) const {
+    const Bucket *bucket = buckets[slotFor(index)].get();
+    return bucket && bucket->index == index ? bucket : nullptr;
+  }
+
+  // Корзина для изменения: новая вместо вытесненной или своя копия общей.
+  // Копии окна отпускают корзины в других потоках; барьер после
+  // use_count() == 1 упорядочивает их последние чтения до нашей записи.
+  Bucket &writable(std::shared_ptr<Bucket> &slot, std::int64_t index) {
+    if (!slot || slot->index != index) {
+      slot = std::make_shared<Bucket>();
+      slot->index = index;
+    } else if (slot.use_count() > 1) {
+      slot = std::make_shared<Bucket>(*slot);
+    } else {
+      std::atomic_thread_fence(std::memory_order_acquire);
+    }
+    return *slot;
+  }
+
+public:
+  // По умолчанию - минутные корзины за последние сутки
+  explicit SlidingWindowStats(std::int64_t bucketWidthMs = 60000,
+                              size_t bucketCount = 24 * 60)
+      : width(std::max<std::int64_t>(bucketWidthMs, 1)),
+        buckets(std::max<size_t>(bucketCount, 1)) {}
+
+  std::int64_t bucketWidth() const { return width; }
+  size_t bucketCount() const { return buckets.size(); }
+  std::int64_t span() const { return width * static_cast<std::int64_t>(buckets.size()); }
+
+  // Учитывает нажатие. Нажатие старше окна самой новой корзины в его
+  // слоте отбрасывается: его интервал уже вытеснен.
+  void add(const KeyPress &press) {
+    std::int64_t index = bucketIndex(press.timestamp);
+    std::shared_ptr<Bucket> &slot = buckets[slotFor(index)];
+    if (slot && slot->index > index) {
+      return;
+    }
+    Bucket &bucket = writable(slot, index);
+    ++bucket.total;
+    ++bucket.apps[press.appId];
+    ++bucket.combos[press.comboId];
+    ++bucket.appCombos[appComboKey(press.appId, press.comboId)];
+  }
+
+  // Складывает корзины за последние durationMs до момента now (корзина
+  // с now включается). Длительность округляется вверх до целых корзин и
+  // ограничена span(). Стоимость - O(корзин в интервале) по числу
+  // разных ключей в корзине.
+  Counts query(std::int64_t durationMs, std::int64_t now, unsigned fields = All) const {
+    std::int64_t newest = bucketIndex(now);
+    std::int64_t count = std::clamp<std::int64_t>((durationMs + width - 1) / width, 1,
+                                                  static_cast<std::int64_t>(buckets.size()));
+    Counts result;
+    result.from = (newest - count + 1) * width;
+    result.to = std::min(now + 1, (newest + 1) * width);
+    for (std::int64_t index = newest - count + 1; index <= newest; ++index) {
+      const Bucket *bucket = find(index);
+      if (!bucket) {
+        continue;
+      }
+      result.total += bucket->total;
+      if (fields & Apps) {
+        for (const auto &[id, n] : bucket->apps) {
+          result.apps[id] += n;
+        }
+      }
+      if (fields & Combos) {
+        for (const auto &[id, n] : bucket->combos) {
+          result.combos[id] += n;
+        }
+      }
+      if (fields & AppCombos) {
+        for (const auto &[key, n] : bucket->appCombos) {
+          result.appCombos[key] += n;
+        }
+      }
+    }
+    return result;
+  }
+
+  // Непустые корзины в порядке слотов - для сохранения окна в снимок
+  template <typename Visitor> void forEachBucket(Visitor &&visit) const {
+    for (const auto &bucket : buckets) {
+      if (bucket && bucket->index != kEmpty) {
+        visit(*bucket);
+      }
+    }
+  }
+
+  // Возвращает сохраненную корзину в ее слот; более старая, чем уже
+  // лежащая в слоте, отбрасывается, как в add()
+  void restoreBucket(Bucket bucket) {
+    if (bucket.index == kEmpty) {
+      return;
+    }
+    std::shared_ptr<Bucket> &slot = buckets[slotFor(bucket.index)];
+    if (!slot || slot->index < bucket.index) {
+      slot = std::make_shared<Bucket>(std::move(bucket));
+    }
+  }
+
+  void clear() {
+    for (auto &bucket : buckets) {
+      bucket.reset();
+    }
+  }
+};
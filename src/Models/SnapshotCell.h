@@ -0,0 +1,129 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Ячейка с неизменяемым снимком: один писатель публикует новые версии,
+// читатели из любых потоков получают согласованную версию без
+// блокировок. Освобождение старых версий - по эпохам (EBR): читатель
+// объявляет текущую эпоху в своем слоте, писатель откладывает замененную
+// версию с номером эпохи и удаляет ее, когда ни один слот не объявляет
+// эпоху не новее этой. Писатель никогда не ждет читателей: пока
+// медленный читатель держит старую версию, она просто остается в списке
+// отложенных.
+template <typename T> class SnapshotCell {
+private:
+  static constexpr size_t kReaderSlots = 64;
+  static constexpr std::uint64_t kIdle = std::numeric_limits<std::uint64_t>::max();
+
+  // Слот на отдельной строке кэша, чтобы читатели не мешали друг другу
+  struct alignas(64) Slot {
+    std::atomic<bool> used{false};
+    std::atomic<std::uint64_t> epoch{kIdle};
+  };
+
+  struct Retired {
+    std::uint64_t epoch;
+    const T *snapshot;
+  };
+
+  std::atomic<const T *> current;
+  std::atomic<std::uint64_t> globalEpoch{0};
+  mutable std::array<Slot, kReaderSlots> slots;
+  std::vector<Retired> retired; // только писатель
+
+  Slot &acquireSlot() const {
+    // Поиск начинается со слота потока, чтобы читатели не сталкивались;
+    // если все слоты заняты - ждем освобождения
+    size_t start = std::hash<std::thread::id>()(std::this_thread::get_id());
+    while (true) {
+      for (size_t i = 0; i < kReaderSlots; ++i) {
+        Slot &slot = slots[(start + i) % kReaderSlots];
+        bool expected = false;
+        if (!slot.used.load(std::memory_order_relaxed) &&
+            slot.used.compare_exchange_strong(expected, true)) {
+          return slot;
+        }
+      }
+      std::this_thread::yield();
+    }
+  }
+
+  void reclaim() {
+    std::uint64_t oldestActive = kIdle;
+    for (const Slot &slot : slots) {
+      oldestActive = std::min(oldestActive, slot.epoch.load());
+    }
+    size_t kept = 0;
+    for (const Retired &entry : retired) {
+      if (entry.epoch < oldestActive) {
+        delete entry.snapshot;
+      } else {
+        retired[kept++] = entry;
+      }
+    }
+    retired.resize(kept);
+  }
+
+public:
+  // Снимок, удерживаемый читателем; действителен до разрушения
+  class ReadGuard {
+  private:
+    Slot *slot = nullptr;
+    const T *snapshot = nullptr;
+
+  public:
+    ReadGuard(Slot &owner, const T *value) : slot(&owner), snapshot(value) {}
+    ReadGuard(const ReadGuard &) = delete;
+    ReadGuard &operator=(const ReadGuard &) = delete;
+    ReadGuard(ReadGuard &&other) noexcept
+        : slot(std::exchange(other.slot, nullptr)), snapshot(other.snapshot) {}
+    ~ReadGuard() {
+      if (slot) {
+        slot->epoch.store(kIdle);
+        slot->used.store(false, std::memory_order_release);
+      }
+    }
+
+    const T &operator*() const { return *snapshot; }
+    const T *operator->() const { return snapshot; }
+  };
+
+  explicit SnapshotCell(std::unique_ptr<const T> initial = std::make_unique<const T>())
+      : current(initial.release()) {}
+  SnapshotCell(const SnapshotCell &) = delete;
+  SnapshotCell &operator=(const SnapshotCell &) = delete;
+
+  // Читатели должны завершиться до разрушения ячейки
+  ~SnapshotCell() {
+    for (const Retired &entry : retired) {
+      delete entry.snapshot;
+    }
+    delete current.load();
+  }
+
+  // Любой поток. Порядок важен: эпоха объявляется до чтения указателя,
+  // поэтому писатель, заменивший указатель позже, увидит объявление.
+  ReadGuard read() const {
+    Slot &slot = acquireSlot();
+    slot.epoch.store(globalEpoch.load());
+    return ReadGuard(slot, current.load());
+  }
+
+  // Только поток писателя
+  void publish(std::unique_ptr<const T> snapshot) {
+    const T *previous = current.exchange(snapshot.release());
+    retired.push_back({globalEpoch.fetch_add(1), previous});
+    reclaim();
+  }
+
+  // Число замененных версий, еще удерживаемых читателями (писатель)
+  size_t retiredCount() const { return retired.size(); }
+};
@@ -0,0 +1,51 @@
+#pragma once
+#include <cstdint>
+#include <deque>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+using SymbolId = std::uint32_t;
+
+// Интернирование строк (имена приложений, комбинации): каждая строка
+// хранится один раз и получает 32-битный номер по порядку появления.
+// Сравнение и хеширование записей идут по номерам, строка нужна только
+// для вывода. Строки не перемещаются, поэтому string_view из resolve()
+// действительны, пока жива таблица. Не потокобезопасна.
+class SymbolTable {
+private:
+  std::deque<std::string> names; // deque не перемещает элементы при росте
+  std::unordered_map<std::string_view, SymbolId> ids;
+
+public:
+  SymbolTable() = default;
+  // Копия строит свой индекс: ключи-string_view указывают в свои строки
+  SymbolTable(const SymbolTable &other) : names(other.names) {
+    ids.reserve(names.size());
+    for (SymbolId id = 0; id < names.size(); ++id) {
+      ids.emplace(names[id], id);
+    }
+  }
+  SymbolTable &operator=(const SymbolTable &) = delete;
+
+  SymbolId intern(std::string_view name) {
+    auto it = ids.find(name);
+    if (it != ids.end()) {
+      return it->second;
+    }
+    SymbolId id = static_cast<SymbolId>(names.size());
+    const std::string &stored = names.emplace_back(name);
+    ids.emplace(stored, id);
+    return id;
+  }
+
+  std::optional<SymbolId> find(std::string_view name) const {
+    auto it = ids.find(name);
+    return it != ids.end() ? std::optional<SymbolId>(it->second) : std::nullopt;
+  }
+
+  std::string_view resolve(SymbolId id) const { return names[id]; }
+
+  size_t size() const { return names.size(); }
+};
@@ -0,0 +1,109 @@
+#pragma once
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <ctime>
+#include <limits>
+#include <optional>
+
+// Нажатия по часам недели: 7 дней (с понедельника) x 24 часа местного
+// времени. Ячейка - day * 24 + hour.
+struct UsageHeatmap {
+  static constexpr size_t kDays = 7;
+  static constexpr size_t kHours = 24;
+  static constexpr size_t kCells = kDays * kHours;
+
+  std::array<std::int64_t, kCells> counts{};
+
+  std::int64_t at(size_t day, size_t hour) const { return counts[day * kHours + hour]; }
+  void add(size_t cell, std::int64_t count = 1) { counts[cell] += count; }
+
+  std::int64_t total() const {
+    std::int64_t sum = 0;
+    for (auto count : counts) {
+      sum += count;
+    }
+    return sum;
+  }
+
+  bool operator==(const UsageHeatmap &other) const { return counts == other.counts; }
+};
+
+// Перевод момента времени (мс от эпохи, UTC) в ячейку тепловой карты.
+// Пояс - фиксированное смещение или системный местный с переходами на
+// летнее время. Смещение местного пояса запоминается на четверть часа
+// (переходы во всех поясах выровнены по 15 минутам), поэтому подряд
+// идущие нажатия не обращаются к localtime.
+class HeatmapClock {
+private:
+  static constexpr std::int64_t kHourMs = 3600000;
+  static constexpr std::int64_t kDayMs = 24 * kHourMs;
+  static constexpr std::int64_t kQuarterMs = kHourMs / 4;
+
+  std::optional<std::int64_t> fixedOffsetMs;
+  std::int64_t cachedQuarter = std::numeric_limits<std::int64_t>::min();
+  std::int64_t cachedOffsetMs = 0;
+
+  static std::int64_t floorDiv(std::int64_t value, std::int64_t divisor) {
+    std::int64_t quotient = value / divisor;
+    return value % divisor < 0 ? quotient - 1 : quotient;
+  }
+
+  // Смещение системного пояса в момент timestampMs
+  static std::int64_t localOffsetMs(std::int64_t timestampMs) {
+    std::time_t seconds = static_cast<std::time_t>(floorDiv(timestampMs, 1000));
+    std::tm local{};
+#ifdef _WIN32
+    if (localtime_s(&local, &seconds) != 0) {
+      return 0;
+    }
+#else
+    if (!localtime_r(&seconds, &local)) {
+      return 0;
+    }
+#endif
+    // Местные дата и время как секунды "UTC" (days_from_civil) минус сам момент
+    std::int64_t year = local.tm_year + 1900 - (local.tm_mon < 2 ? 1 : 0);
+    std::int64_t era = (year >= 0 ? year : year - 399) / 400;
+    std::int64_t yoe = year - era * 400;
+    std::int64_t month = local.tm_mon + 1;
+    std::int64_t doy = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + local.tm_mday - 1;
+    std::int64_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    std::int64_t days = era * 146097 + doe - 719468;
+    std::int64_t localSeconds =
+        days * 86400 + local.tm_hour * 3600 + local.tm_min * 60 + local.tm_sec;
+    return (localSeconds - static_cast<std::int64_t>(seconds)) * 1000;
+  }
+
+public:
+  // Пусто - системный местный пояс
+  explicit HeatmapClock(std::optional<std::chrono::minutes> utcOffset = std::nullopt) {
+    if (utcOffset) {
+      fixedOffsetMs = std::chrono::duration_cast<std::chrono::milliseconds>(*utcOffset).count();
+    }
+  }
+
+  bool isLocal() const { return !fixedOffsetMs; }
+  std::int64_t getFixedOffsetMs() const { return fixedOffsetMs.value_or(0); }
+
+  std::int64_t offsetAt(std::int64_t timestampMs) {
+    if (fixedOffsetMs) {
+      return *fixedOffsetMs;
+    }
+    std::int64_t quarter = floorDiv(timestampMs, kQuarterMs);
+    if (quarter != cachedQuarter) {
+      cachedQuarter = quarter;
+      cachedOffsetMs = localOffsetMs(quarter * kQuarterMs);
+    }
+    return cachedOffsetMs;
+  }
+
+  size_t cellOf(std::int64_t timestampMs) {
+    std::int64_t local = timestampMs + offsetAt(timestampMs);
+    std::int64_t days = floorDiv(local, kDayMs);
+    // 1970-01-01 - четверг (день 3 при отсчете с понедельника)
+    std::int64_t day = ((days + 3) % 7 + 7) % 7;
+    std::int64_t hour = (local - days * kDayMs) / kHourMs;
+    return static_cast<size_t>(day * 24 + hour);
+  }
+};
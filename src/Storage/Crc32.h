@@ -0,0 +1,58 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+// CRC-32 (IEEE 802.3, полином 0xEDB88320), табличный вариант
+// "slicing-by-8": восемь таблиц, по 8 байт за шаг
+namespace crc32_detail {
+
+using Table = std::array<std::uint32_t, 256>;
+
+constexpr Table makeTable() {
+  Table table{};
+  for (std::uint32_t i = 0; i < 256; ++i) {
+    std::uint32_t c = i;
+    for (int bit = 0; bit < 8; ++bit) {
+      c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+    }
+    table[i] = c;
+  }
+  return table;
+}
+
+// tables[k][b] - CRC байта b, за которым следуют k нулевых байт
+constexpr std::array<Table, 8> makeTables() {
+  std::array<Table, 8> tables{};
+  tables[0] = makeTable();
+  for (size_t k = 1; k < 8; ++k) {
+    for (size_t i = 0; i < 256; ++i) {
+      std::uint32_t previous = tables[k - 1][i];
+      tables[k][i] = (previous >> 8) ^ tables[0][previous & 0xFF];
+    }
+  }
+  return tables;
+}
+
+constexpr auto kTables = makeTables();
+
+} // namespace crc32_detail
+
+inline std::uint32_t crc32(const void *data, size_t size,
+                           std::uint32_t crc = 0) {
+  using crc32_detail::kTables;
+  const auto *bytes = static_cast<const unsigned char *>(data);
+  crc = ~crc;
+  for (; size >= 8; size -= 8, bytes += 8) {
+    // Сборка по байтам не зависит от порядка байт машины
+    std::uint32_t low = crc ^ (std::uint32_t(bytes[0]) | std::uint32_t(bytes[1]) << 8 |
+                               std::uint32_t(bytes[2]) << 16 | std::uint32_t(bytes[3]) << 24);
+    crc = kTables[7][low & 0xFF] ^ kTables[6][(low >> 8) & 0xFF] ^
+          kTables[5][(low >> 16) & 0xFF] ^ kTables[4][low >> 24] ^ kTables[3][bytes[4]] ^
+          kTables[2][bytes[5]] ^ kTables[1][bytes[6]] ^ kTables[0][bytes[7]];
+  }
+  for (size_t i = 0; i < size; ++i) {
+    crc = kTables[0][(crc ^ bytes[i]) & 0xFF] ^ (crc >> 8);
+  }
+  return ~crc;
+}
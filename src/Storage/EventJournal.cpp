@@ -0,0 +1,139 @@
+#include "EventJournal.h"
+#include "Crc32.h"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+namespace {
+
+constexpr std::uint64_t kJournalMagic = 0x4C4E524A414B4F48ull; // "HOKAJRNL"
+constexpr std::uint32_t kJournalVersion = 1;
+
+} // namespace
+
+bool EventJournal::open(const std::string& path, size_t recordCapacity,
+                        std::uint64_t firstSequence) {
+    if (!file.open(path, MappedFile::Mode::ReadWrite,
+                   kHeaderSize + recordCapacity * kRecordSize)) {
+        return false;
+    }
+
+    Header* h = header();
+    bool compatible = h->magic == kJournalMagic && h->version == kJournalVersion &&
+                      h->recordSize == kRecordSize &&
+                      kHeaderSize + h->capacity * kRecordSize <= file.size();
+    if (!compatible) {
+        if (h->magic != 0) {
+            std::cerr << "Event journal " << path << " has unknown format, starting empty"
+                      << std::endl;
+        }
+        std::memset(file.data(), 0, file.size());
+        h->magic = kJournalMagic;
+        h->version = kJournalVersion;
+        h->recordSize = kRecordSize;
+        h->capacity = (file.size() - kHeaderSize) / kRecordSize;
+        h->baseSequence = std::max<std::uint64_t>(firstSequence, 1);
+        h->consumedSequence = h->baseSequence - 1;
+    }
+    capacity = static_cast<size_t>(h->capacity);
+
+    // Конец журнала - первый слот с неверной CRC или чужим номером
+    writeSlot = 0;
+    while (writeSlot < capacity && isValid(*slot(writeSlot), writeSlot)) {
+        ++writeSlot;
+    }
+    lastSequence = h->baseSequence + writeSlot - 1;
+    return true;
+}
+
+bool EventJournal::isValid(const Record& record, size_t index) {
+    if (record.sequence != header()->baseSequence + index ||
+        size_t(record.appLength) + record.comboLength > sizeof(record.text)) {
+        return false;
+    }
+    return record.crc == crc32(reinterpret_cast<const char*>(&record) + sizeof(record.crc),
+                               kRecordSize - sizeof(record.crc));
+}
+
+std::uint64_t EventJournal::append(std::string_view appName, std::string_view keyCombination,
+                                   std::int64_t timestamp) {
+    // Запись собирается на стеке и копируется в отображение целиком
+    Record record{};
+    appName = appName.substr(0, std::min(appName.size(), sizeof(record.text) / 2));
+    keyCombination = keyCombination.substr(
+        0, std::min(keyCombination.size(), sizeof(record.text) - appName.size()));
+    record.appLength = static_cast<std::uint16_t>(appName.size());
+    record.comboLength = static_cast<std::uint16_t>(keyCombination.size());
+    record.timestamp = timestamp;
+    std::memcpy(record.text, appName.data(), appName.size());
+    std::memcpy(record.text + appName.size(), keyCombination.data(), keyCombination.size());
+
+    std::lock_guard<std::mutex> lock(appendMutex);
+    if (!file.isOpen()) {
+        return 0;
+    }
+
+    Header* h = header();
+    // Все подтверждено - начинаем с первого слота. Одна запись номера
+    // делает старые записи недействительными.
+    if (writeSlot > 0 && h->consumedSequence >= lastSequence) {
+        h->baseSequence = lastSequence + 1;
+        writeSlot = 0;
+    }
+    if (writeSlot == capacity) {
+        return 0;
+    }
+
+    record.sequence = h->baseSequence + writeSlot;
+    record.crc = crc32(reinterpret_cast<const char*>(&record) + sizeof(record.crc),
+                       kRecordSize - sizeof(record.crc));
+    std::memcpy(slot(writeSlot), &record, kRecordSize);
+    ++writeSlot;
+    lastSequence = record.sequence;
+    return record.sequence;
+}
+
+size_t EventJournal::replay(const std::function<void(const JournalRecord&)>& onRecord) {
+    std::lock_guard<std::mutex> lock(appendMutex);
+    if (!file.isOpen()) {
+        return 0;
+    }
+
+    size_t replayed = 0;
+    std::uint64_t consumed = header()->consumedSequence;
+    for (size_t index = 0; index < writeSlot; ++index) {
+        const Record* record = slot(index);
+        if (record->sequence <= consumed) {
+            continue;
+        }
+        onRecord(JournalRecord{record->sequence, record->timestamp,
+                               std::string_view(record->text, record->appLength),
+                               std::string_view(record->text + record->appLength,
+                                                record->comboLength)});
+        ++replayed;
+    }
+    return replayed;
+}
+
+void EventJournal::markConsumed(std::uint64_t sequence) {
+    std::lock_guard<std::mutex> lock(appendMutex);
+    if (file.isOpen() && sequence > header()->consumedSequence) {
+        header()->consumedSequence = sequence;
+    }
+}
+
+std::uint64_t EventJournal::getConsumedSequence() {
+    std::lock_guard<std::mutex> lock(appendMutex);
+    return file.isOpen() ? header()->consumedSequence : 0;
+}
+
+size_t EventJournal::getFreeSlots() {
+    std::lock_guard<std::mutex> lock(appendMutex);
+    if (!file.isOpen()) {
+        return 0;
+    }
+    if (writeSlot > 0 && header()->consumedSequence >= lastSequence) {
+        return capacity;
+    }
+    return capacity - writeSlot;
+}
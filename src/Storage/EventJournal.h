@@ -0,0 +1,106 @@
+#pragma once
+#include "MappedFile.h"
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <string_view>
+
+// Нажатие, прочитанное из журнала при восстановлении. Строки указывают
+// в отображенный файл и действительны только внутри обработчика.
+struct JournalRecord {
+  std::uint64_t sequence = 0;
+  std::int64_t timestamp = 0;
+  std::string_view appName;
+  std::string_view keyCombination;
+};
+
+// Журнал нажатий перед SQLite: файл, отображенный в память, с записями
+// фиксированного размера и CRC. Запись нажатия - одно копирование в
+// отображение, без системных вызовов; после падения процесса данные
+// остаются в кэше страниц ОС. SQLite забирает нажатия асинхронно и
+// сообщает markConsumed(); неподтвержденный хвост восстанавливается
+// при следующем запуске через replay().
+//
+// Запись в слоте i действительна, только если ее CRC сходится и номер
+// равен baseSequence + i. Когда все записи подтверждены, журнал
+// начинается с первого слота заново одной записью baseSequence - старые
+// записи автоматически становятся недействительными.
+class EventJournal {
+public:
+  static constexpr size_t kRecordSize = 256;
+  static constexpr size_t kHeaderSize = kRecordSize;
+
+private:
+  MappedFile file;
+  size_t capacity = 0; // слотов для записей
+
+  // Заголовок в начале файла (все поля выровнены по 8 байт)
+  struct Header {
+    std::uint64_t magic;
+    std::uint32_t version;
+    std::uint32_t recordSize;
+    std::uint64_t capacity;
+    std::uint64_t baseSequence;     // номер записи в слоте 0
+    std::uint64_t consumedSequence; // все записи до него включительно в БД
+  };
+
+  // Запись: CRC считается по всему, что после поля crc
+  struct Record {
+    std::uint32_t crc;
+    std::uint16_t appLength;
+    std::uint16_t comboLength;
+    std::uint64_t sequence;
+    std::int64_t timestamp;
+    char text[kRecordSize - 24]; // имя приложения, затем комбинация
+  };
+  static_assert(sizeof(Record) == kRecordSize, "journal record must be fixed-size");
+
+  std::mutex appendMutex;
+  size_t writeSlot = 0;                   // под appendMutex
+  std::atomic<std::uint64_t> lastSequence{0};
+
+  Header *header() { return reinterpret_cast<Header *>(file.data()); }
+  Record *slot(size_t index) {
+    return reinterpret_cast<Record *>(file.data() + kHeaderSize + index * kRecordSize);
+  }
+  bool isValid(const Record &record, size_t index);
+
+public:
+  EventJournal() = default;
+  EventJournal(const EventJournal &) = delete;
+  EventJournal &operator=(const EventJournal &) = delete;
+
+  // Открывает или создает журнал на capacity записей. Новый журнал
+  // нумерует записи с firstSequence, чтобы номера не пересекались с уже
+  // зафиксированными в БД.
+  bool open(const std::string &path, size_t capacity = 65536,
+            std::uint64_t firstSequence = 1);
+  void close() { file.close(); }
+  bool isOpen() const { return file.isOpen(); }
+
+  // Номер записанного нажатия; 0 - журнал заполнен неподтвержденными
+  // записями (нужно дождаться SQLite) или не открыт. Слишком длинные
+  // строки обрезаются до размера записи.
+  std::uint64_t append(std::string_view appName, std::string_view keyCombination,
+                       std::int64_t timestamp);
+
+  // Передает onRecord все записи после последней подтвержденной, по
+  // порядку. Возвращает их число.
+  size_t replay(const std::function<void(const JournalRecord &)> &onRecord);
+
+  // Записи до sequence включительно сохранены в БД (из любого потока)
+  void markConsumed(std::uint64_t sequence);
+
+  std::uint64_t getLastSequence() const { return lastSequence; }
+  std::uint64_t getConsumedSequence();
+  // Сколько записей примет append(); все слоты свободны, если записанное
+  // подтверждено и журнал начнется заново
+  size_t getFreeSlots();
+  size_t getCapacity() const { return capacity; }
+
+  // Сброс страниц на диск - защита и от сбоя питания, а не только
+  // от падения процесса
+  bool sync() { return file.sync(); }
+};
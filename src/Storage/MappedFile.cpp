@@ -0,0 +1,150 @@
+#include "MappedFile.h"
+#include <iostream>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+
+bool MappedFile::open(const std::string& path, Mode mode, size_t size) {
+    close();
+    writable = mode == Mode::ReadWrite;
+
+    fileHandle = CreateFileA(path.c_str(),
+                             writable ? GENERIC_READ | GENERIC_WRITE : GENERIC_READ,
+                             FILE_SHARE_READ, nullptr,
+                             writable ? OPEN_ALWAYS : OPEN_EXISTING,
+                             FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (fileHandle == INVALID_HANDLE_VALUE) {
+        fileHandle = nullptr;
+        std::cerr << "Failed to open mapped file: " << path << std::endl;
+        return false;
+    }
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(fileHandle, &fileSize)) {
+        close();
+        return false;
+    }
+    length = static_cast<size_t>(fileSize.QuadPart);
+    if (writable && length < size) {
+        length = size;
+    }
+    if (length == 0) {
+        close();
+        return false;
+    }
+
+    // Отображение размером больше файла дополняет его нулями
+    LARGE_INTEGER mapSize;
+    mapSize.QuadPart = static_cast<LONGLONG>(length);
+    mappingHandle = CreateFileMappingA(fileHandle, nullptr,
+                                       writable ? PAGE_READWRITE : PAGE_READONLY,
+                                       mapSize.HighPart, mapSize.LowPart, nullptr);
+    if (!mappingHandle) {
+        std::cerr << "Failed to map file: " << path << std::endl;
+        close();
+        return false;
+    }
+
+    view = static_cast<char*>(MapViewOfFile(mappingHandle,
+                                            writable ? FILE_MAP_WRITE : FILE_MAP_READ,
+                                            0, 0, length));
+    if (!view) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+void MappedFile::close() {
+    if (view) {
+        UnmapViewOfFile(view);
+        view = nullptr;
+    }
+    if (mappingHandle) {
+        CloseHandle(mappingHandle);
+        mappingHandle = nullptr;
+    }
+    if (fileHandle) {
+        CloseHandle(fileHandle);
+        fileHandle = nullptr;
+    }
+    length = 0;
+}
+
+bool MappedFile::sync() {
+    if (!view || !writable) {
+        return view != nullptr;
+    }
+    return FlushViewOfFile(view, length) && FlushFileBuffers(fileHandle);
+}
+
+#else
+
+bool MappedFile::open(const std::string& path, Mode mode, size_t size) {
+    close();
+    writable = mode == Mode::ReadWrite;
+
+    fd = ::open(path.c_str(), writable ? O_RDWR | O_CREAT : O_RDONLY, 0644);
+    if (fd < 0) {
+        std::cerr << "Failed to open mapped file: " << path << std::endl;
+        return false;
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        close();
+        return false;
+    }
+    length = static_cast<size_t>(info.st_size);
+    if (writable && length < size) {
+        if (ftruncate(fd, static_cast<off_t>(size)) != 0) {
+            std::cerr << "Failed to resize mapped file: " << path << std::endl;
+            close();
+            return false;
+        }
+        length = size;
+    }
+    if (length == 0) {
+        close();
+        return false;
+    }
+
+    void* mapped = mmap(nullptr, length, writable ? PROT_READ | PROT_WRITE : PROT_READ,
+                        MAP_SHARED, fd, 0);
+    if (mapped == MAP_FAILED) {
+        std::cerr << "Failed to map file: " << path << std::endl;
+        close();
+        return false;
+    }
+    view = static_cast<char*>(mapped);
+    return true;
+}
+
+void MappedFile::close() {
+    if (view) {
+        munmap(view, length);
+        view = nullptr;
+    }
+    if (fd >= 0) {
+        ::close(fd);
+        fd = -1;
+    }
+    length = 0;
+}
+
+bool MappedFile::sync() {
+    if (!view || !writable) {
+        return view != nullptr;
+    }
+    return msync(view, length, MS_SYNC) == 0;
+}
+
+#endif
@@ -0,0 +1,43 @@
+#pragma once
+#include <cstddef>
+#include <string>
+
+// Файл, целиком отображенный в память. Изменения попадают в кэш страниц
+// ОС сразу и переживают падение процесса; sync() дописывает их на диск.
+class MappedFile {
+private:
+#ifdef _WIN32
+  // HANDLE, чтобы не тянуть windows.h в заголовок
+  void *fileHandle = nullptr;
+  void *mappingHandle = nullptr;
+#else
+  int fd = -1;
+#endif
+  char *view = nullptr;
+  size_t length = 0;
+  bool writable = false;
+
+public:
+  enum class Mode {
+    ReadOnly,  // существующий файл целиком
+    ReadWrite, // файл создается или дополняется нулями до size
+  };
+
+  MappedFile() = default;
+  ~MappedFile() { close(); }
+
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+
+  // size игнорируется в ReadOnly; в ReadWrite файл не укорачивается
+  bool open(const std::string &path, Mode mode, size_t size = 0);
+  void close();
+  bool isOpen() const { return view != nullptr; }
+
+  char *data() { return view; }
+  const char *data() const { return view; }
+  size_t size() const { return length; }
+
+  // Синхронная запись измененных страниц на диск
+  bool sync();
+};
@@ -0,0 +1,245 @@
+#include "SketchCodec.h"
+#include "Crc32.h"
+#include <utility>
+
+namespace {
+
+constexpr std::uint64_t kSketchMagic = 0x48434B53414B4F48ull; // "HOKASKCH"
+constexpr size_t kHeaderSize = 8 + 4 + 8 + 4;
+
+// Пределы, за которыми образ заведомо испорчен
+constexpr std::uint64_t kMaxHeavyHitters = std::uint64_t(1) << 24;
+constexpr std::uint32_t kMaxNameLength = 1 << 16;
+
+// Дописывает числа в порядке little-endian
+class LittleEndianWriter {
+private:
+    std::string& out;
+
+public:
+    explicit LittleEndianWriter(std::string& image) : out(image) {}
+
+    void putU32(std::uint32_t value) {
+        for (int shift = 0; shift < 32; shift += 8) {
+            out.push_back(static_cast<char>(value >> shift));
+        }
+    }
+
+    void putU64(std::uint64_t value) {
+        for (int shift = 0; shift < 64; shift += 8) {
+            out.push_back(static_cast<char>(value >> shift));
+        }
+    }
+
+    void putString(const std::string& text) {
+        putU32(static_cast<std::uint32_t>(text.size()));
+        out.append(text);
+    }
+
+    void putBytes(const std::uint8_t* data, size_t size) {
+        out.append(reinterpret_cast<const char*>(data), size);
+    }
+};
+
+// Чтение little-endian с проверкой границ: после первого выхода за конец
+// все чтения неуспешны
+class LittleEndianReader {
+private:
+    const unsigned char* position;
+    const unsigned char* end;
+    bool failed = false;
+
+public:
+    LittleEndianReader(const char* data, size_t size)
+        : position(reinterpret_cast<const unsigned char*>(data)), end(position + size) {}
+
+    const unsigned char* take(size_t size) {
+        if (failed || static_cast<size_t>(end - position) < size) {
+            failed = true;
+            return nullptr;
+        }
+        const unsigned char* data = position;
+        position += size;
+        return data;
+    }
+
+    bool getU32(std::uint32_t& value) {
+        const unsigned char* data = take(4);
+        value = 0;
+        for (int i = 0; data && i < 4; ++i) {
+            value |= std::uint32_t(data[i]) << (8 * i);
+        }
+        return data != nullptr;
+    }
+
+    bool getU64(std::uint64_t& value) {
+        const unsigned char* data = take(8);
+        value = 0;
+        for (int i = 0; data && i < 8; ++i) {
+            value |= std::uint64_t(data[i]) << (8 * i);
+        }
+        return data != nullptr;
+    }
+
+    bool getString(std::string& text) {
+        std::uint32_t length = 0;
+        const unsigned char* data = getU32(length) && length <= kMaxNameLength
+            ? take(length) : nullptr;
+        if (data) {
+            text.assign(reinterpret_cast<const char*>(data), length);
+        }
+        return data != nullptr;
+    }
+
+    size_t remaining() const { return failed ? 0 : static_cast<size_t>(end - position); }
+    bool atEnd() const { return !failed && position == end; }
+};
+
+void putCountMin(LittleEndianWriter& writer, const std::vector<std::uint64_t>& counters,
+                 std::uint64_t total) {
+    writer.putU64(total);
+    for (std::uint64_t counter : counters) {
+        writer.putU64(counter);
+    }
+}
+
+bool getCountMin(LittleEndianReader& reader, std::vector<std::uint64_t>& counters,
+                 std::uint64_t& total) {
+    if (!reader.getU64(total) || reader.remaining() / 8 < counters.size()) {
+        return false;
+    }
+    for (auto& counter : counters) {
+        reader.getU64(counter);
+    }
+    return true;
+}
+
+bool getRegisters(LittleEndianReader& reader, std::vector<std::uint8_t>& registers,
+                  int precision) {
+    const unsigned char* data = reader.take(registers.size());
+    if (!data) {
+        return false;
+    }
+    int maxRank = 64 - precision + 1;
+    for (size_t i = 0; i < registers.size(); ++i) {
+        if (data[i] > maxRank) {
+            return false;
+        }
+        registers[i] = data[i];
+    }
+    return true;
+}
+
+} // namespace
+
+std::string SketchCodec::encode(const KeySketches& sketches) {
+    std::string payload;
+    LittleEndianWriter writer(payload);
+
+    const auto& pairs = sketches.pairFrequencies;
+    writer.putU64(pairs.width);
+    writer.putU64(pairs.depth);
+    writer.putU64(sketches.heavyPairs.capacity);
+    writer.putU32(static_cast<std::uint32_t>(sketches.distinctPairs.precision));
+
+    putCountMin(writer, pairs.counters, pairs.total);
+    putCountMin(writer, sketches.comboFrequencies.counters, sketches.comboFrequencies.total);
+
+    const auto& heavy = sketches.heavyPairs;
+    writer.putU64(heavy.total);
+    writer.putU64(heavy.entries.size());
+    for (const auto& entry : heavy.entries) {
+        writer.putU64(entry.key);
+        writer.putU64(entry.count);
+        writer.putU64(entry.error);
+        writer.putString(sketches.pairNames.at(entry.key));
+    }
+
+    writer.putBytes(sketches.distinctCombos.registers.data(),
+                    sketches.distinctCombos.registers.size());
+    writer.putBytes(sketches.distinctPairs.registers.data(),
+                    sketches.distinctPairs.registers.size());
+
+    std::string image;
+    image.reserve(kHeaderSize + payload.size());
+    LittleEndianWriter header(image);
+    header.putU64(kSketchMagic);
+    header.putU32(kVersion);
+    header.putU64(payload.size());
+    header.putU32(crc32(payload.data(), payload.size()));
+    image += payload;
+    return image;
+}
+
+bool SketchCodec::decode(const char* data, size_t size, KeySketches& sketches) {
+    LittleEndianReader header(data, size);
+    std::uint64_t magic = 0;
+    std::uint32_t version = 0;
+    std::uint64_t payloadSize = 0;
+    std::uint32_t payloadCrc = 0;
+    if (!header.getU64(magic) || !header.getU32(version) || !header.getU64(payloadSize) ||
+        !header.getU32(payloadCrc) || magic != kSketchMagic || version != kVersion ||
+        payloadSize != header.remaining() ||
+        crc32(data + kHeaderSize, payloadSize) != payloadCrc) {
+        return false;
+    }
+
+    LittleEndianReader reader(data + kHeaderSize, payloadSize);
+    std::uint64_t width = 0;
+    std::uint64_t depth = 0;
+    std::uint64_t capacity = 0;
+    std::uint32_t precision = 0;
+    if (!reader.getU64(width) || !reader.getU64(depth) || !reader.getU64(capacity) ||
+        !reader.getU32(precision) || width == 0 || depth == 0 ||
+        depth > reader.remaining() / 8 / width || capacity == 0 ||
+        capacity > kMaxHeavyHitters || precision < 4 || precision > 18) {
+        return false;
+    }
+
+    SketchConfig config;
+    config.heavyHitters = static_cast<size_t>(capacity);
+    config.cardinalityPrecision = static_cast<int>(precision);
+    KeySketches decoded(config);
+    decoded.pairFrequencies = CountMinSketch(static_cast<size_t>(width), static_cast<size_t>(depth));
+    decoded.comboFrequencies = decoded.pairFrequencies;
+    if (!getCountMin(reader, decoded.pairFrequencies.counters, decoded.pairFrequencies.total) ||
+        !getCountMin(reader, decoded.comboFrequencies.counters, decoded.comboFrequencies.total)) {
+        return false;
+    }
+
+    // Записи Space-Saving: имя должно давать тот же хеш пары
+    auto& heavy = decoded.heavyPairs;
+    std::uint64_t entryCount = 0;
+    if (!reader.getU64(heavy.total) || !reader.getU64(entryCount) || entryCount > capacity ||
+        entryCount > reader.remaining() / (3 * 8 + 4)) {
+        return false;
+    }
+    heavy.entries.reserve(static_cast<size_t>(entryCount));
+    for (std::uint64_t i = 0; i < entryCount; ++i) {
+        SpaceSaving<std::uint64_t>::Entry entry{};
+        std::string name;
+        if (!reader.getU64(entry.key) || !reader.getU64(entry.count) ||
+            !reader.getU64(entry.error) || !reader.getString(name) || entry.error > entry.count) {
+            return false;
+        }
+        size_t split = name.find(KeySketches::kSeparator);
+        if (split == std::string::npos ||
+            KeySketches::pairHash(std::string_view(name).substr(0, split),
+                                  std::string_view(name).substr(split + 1)) != entry.key ||
+            !heavy.positions.emplace(entry.key, heavy.entries.size()).second) {
+            return false;
+        }
+        heavy.byCount.insert({entry.count, heavy.entries.size()});
+        heavy.entries.push_back(entry);
+        decoded.pairNames.emplace(entry.key, std::move(name));
+    }
+
+    if (!getRegisters(reader, decoded.distinctCombos.registers, static_cast<int>(precision)) ||
+        !getRegisters(reader, decoded.distinctPairs.registers, static_cast<int>(precision)) ||
+        !reader.atEnd()) {
+        return false;
+    }
+
+    sketches = std::move(decoded);
+    return true;
+}
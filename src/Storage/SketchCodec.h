@@ -0,0 +1,29 @@
+#pragma once
+#include "Models/Sketches.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Переносимый двоичный образ KeySketches для сводной статистики: образ,
+// снятый на одной машине, декодируется на другой и вливается через
+// KeySketches::merge. В отличие от StatisticsSnapshot числа пишутся
+// побайтно в порядке little-endian, поэтому образ не зависит ни от
+// порядка байт, ни от выравнивания. Параметры оценок входят в образ:
+// декодированный набор получает их оттуда, а merge отказывает набору
+// с другими размерами.
+//
+// Формат: магия "HOKASKCH", версия, размер и CRC32 нагрузки; затем
+// параметры (ширина и глубина Count-Min, емкость Space-Saving, точность
+// HyperLogLog), счетчики Count-Min пар и комбинаций, записи Space-Saving
+// (хеш пары, оценка, погрешность, имя) и регистры HyperLogLog.
+class SketchCodec {
+public:
+  static constexpr std::uint32_t kVersion = 1;
+
+  static std::string encode(const KeySketches &sketches);
+
+  // Заменяет sketches набором из образа. При ошибке (формат, версия, CRC,
+  // выход за границы, несогласованные данные) sketches не меняется и
+  // возвращается false.
+  static bool decode(const char *data, size_t size, KeySketches &sketches);
+};
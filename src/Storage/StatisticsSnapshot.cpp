@@ -0,0 +1,504 @@
+#include "StatisticsSnapshot.h"
+#include "Crc32.h"
+#include "MappedFile.h"
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <optional>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace {
+
+constexpr std::uint64_t kSnapshotMagic = 0x54415453414B4F48ull; // "HOKASTAT"
+constexpr std::uint32_t kByteOrderMark = 0x01020304;
+
+// Заголовок в начале файла (все поля выровнены по 8 байт)
+struct Header {
+    std::uint64_t magic;
+    std::uint32_t version;
+    std::uint32_t byteOrder; // kByteOrderMark в порядке байт записавшей машины
+    std::uint64_t payloadSize;
+    std::uint32_t payloadCrc;
+    std::uint32_t reserved;
+    std::int64_t savedAt; // мс от эпохи
+};
+
+static_assert(std::is_trivially_copyable<KeyPress>::value,
+              "history is stored as raw KeyPress records");
+
+using Ranking = std::vector<std::pair<SymbolId, int>>;
+
+// Дописывает значения в образ как есть
+class ImageWriter {
+private:
+    std::string& out;
+
+public:
+    explicit ImageWriter(std::string& image) : out(image) {}
+
+    template <typename T> void put(const T& value) {
+        static_assert(std::is_trivially_copyable<T>::value, "raw value expected");
+        out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+    }
+
+    void putBytes(const void* data, size_t size) {
+        out.append(static_cast<const char*>(data), size);
+    }
+
+    template <typename Counter> void putRanking(const Counter& counter) {
+        put<std::uint64_t>(counter.size());
+        counter.forEach([&](SymbolId id, int count) {
+            put(id);
+            put(count);
+        });
+    }
+
+    template <typename Map> void putCounts(const Map& counts) {
+        put<std::uint64_t>(counts.size());
+        for (const auto& [key, count] : counts) {
+            put(key);
+            put(count);
+        }
+    }
+};
+
+// Чтение образа с проверкой границ: после первого выхода за конец все
+// чтения неуспешны. Значения копируются, поэтому выравнивание не важно.
+class ImageReader {
+private:
+    const char* position;
+    const char* end;
+    bool failed = false;
+
+public:
+    ImageReader(const char* data, size_t size) : position(data), end(data + size) {}
+
+    const char* take(size_t size) {
+        if (failed || static_cast<size_t>(end - position) < size) {
+            failed = true;
+            return nullptr;
+        }
+        const char* data = position;
+        position += size;
+        return data;
+    }
+
+    template <typename T> bool get(T& value) {
+        const char* data = take(sizeof(T));
+        if (data) {
+            std::memcpy(&value, data, sizeof(T));
+        }
+        return data != nullptr;
+    }
+
+    // Число элементов, каждый не меньше elementSize байт: заведомо больше
+    // остатка образа - ошибка, а не попытка выделить память под него
+    bool getCount(std::uint64_t& count, size_t elementSize) {
+        if (!get(count) || count > static_cast<std::uint64_t>(end - position) / elementSize) {
+            failed = true;
+        }
+        return !failed;
+    }
+
+    template <typename Key> bool getCounts(std::vector<std::pair<Key, int>>& counts) {
+        std::uint64_t count = 0;
+        if (!getCount(count, sizeof(Key) + sizeof(int))) {
+            return false;
+        }
+        counts.resize(static_cast<size_t>(count));
+        for (auto& [key, value] : counts) {
+            get(key);
+            get(value);
+        }
+        return !failed;
+    }
+
+    bool hasFailed() const { return failed; }
+    bool atEnd() const { return position == end; }
+};
+
+// Снимок, разобранный до применения к KeyStatistics; номера имен - из
+// снимка
+struct DecodedBucket {
+    std::int64_t index = 0;
+    int total = 0;
+    Ranking apps;
+    Ranking combos;
+    std::vector<std::pair<std::uint64_t, int>> appCombos;
+};
+
+struct DecodedHeatmaps {
+    bool local = true;
+    std::int64_t fixedOffsetMs = 0;
+    std::vector<std::pair<SymbolId, UsageHeatmap>> apps;
+    std::vector<std::pair<SymbolId, UsageHeatmap>> combos;
+};
+
+struct DecodedSnapshot {
+    std::vector<std::string_view> names;
+    std::uint64_t historyCapacity = 0;
+    std::uint64_t outOfOrder = 0;
+    std::vector<KeyPress> history;
+    Ranking appCounts;
+    Ranking keyCounts;
+    std::vector<std::pair<SymbolId, Ranking>> appKeyCounts;
+    std::int64_t bucketWidth = 0;
+    std::uint64_t bucketCount = 0;
+    std::vector<DecodedBucket> buckets;
+    std::optional<DecodedHeatmaps> heatmaps;
+
+    bool isKnown(SymbolId id) const { return id < names.size(); }
+
+    bool allKnown(const Ranking& ranking) const {
+        for (const auto& entry : ranking) {
+            if (!isKnown(entry.first)) {
+                return false;
+            }
+        }
+        return true;
+    }
+};
+
+// Размер окна, при котором образ заведомо испорчен (корзин больше, чем
+// минутных корзин за 30 лет)
+constexpr std::uint64_t kMaxBuckets = std::uint64_t(1) << 24;
+
+bool decodeHeatmapList(ImageReader& reader, const DecodedSnapshot& decoded,
+                       std::vector<std::pair<SymbolId, UsageHeatmap>>& maps) {
+    std::uint64_t count = 0;
+    if (!reader.getCount(count, sizeof(SymbolId) + sizeof(UsageHeatmap::counts))) {
+        return false;
+    }
+    maps.resize(static_cast<size_t>(count));
+    for (auto& [id, heatmap] : maps) {
+        const char* cells = reader.get(id) ? reader.take(sizeof(heatmap.counts)) : nullptr;
+        if (!cells || !decoded.isKnown(id)) {
+            return false;
+        }
+        std::memcpy(heatmap.counts.data(), cells, sizeof(heatmap.counts));
+    }
+    return true;
+}
+
+bool decodePayload(ImageReader& reader, DecodedSnapshot& decoded) {
+    // Таблица имен: длины подряд, затем сами строки подряд
+    std::uint32_t symbolCount = 0;
+    if (!reader.get(symbolCount)) {
+        return false;
+    }
+    const char* lengths = reader.take(std::size_t(symbolCount) * sizeof(std::uint32_t));
+    if (!lengths) {
+        return false;
+    }
+    decoded.names.reserve(symbolCount);
+    for (std::uint32_t i = 0; i < symbolCount; ++i) {
+        std::uint32_t length = 0;
+        std::memcpy(&length, lengths + i * sizeof(length), sizeof(length));
+        const char* text = reader.take(length);
+        if (!text) {
+            return false;
+        }
+        decoded.names.emplace_back(text, length);
+    }
+
+    // История: записи KeyPress от старых к новым
+    std::uint64_t historySize = 0;
+    if (!reader.get(decoded.historyCapacity) || !reader.get(decoded.outOfOrder) ||
+        !reader.getCount(historySize, sizeof(KeyPress)) ||
+        historySize > decoded.historyCapacity) {
+        return false;
+    }
+    decoded.history.resize(static_cast<size_t>(historySize));
+    const char* presses = reader.take(decoded.history.size() * sizeof(KeyPress));
+    if (!presses) {
+        return false;
+    }
+    if (!decoded.history.empty()) {
+        std::memcpy(decoded.history.data(), presses, decoded.history.size() * sizeof(KeyPress));
+    }
+    for (const auto& press : decoded.history) {
+        if (!decoded.isKnown(press.appId) || !decoded.isKnown(press.comboId)) {
+            return false;
+        }
+    }
+
+    // Счетчики по истории
+    std::uint64_t groups = 0;
+    if (!reader.getCounts(decoded.appCounts) || !reader.getCounts(decoded.keyCounts) ||
+        !decoded.allKnown(decoded.appCounts) || !decoded.allKnown(decoded.keyCounts) ||
+        !reader.getCount(groups, sizeof(SymbolId) + sizeof(std::uint64_t))) {
+        return false;
+    }
+    decoded.appKeyCounts.resize(static_cast<size_t>(groups));
+    for (auto& [appId, ranking] : decoded.appKeyCounts) {
+        if (!reader.get(appId) || !reader.getCounts(ranking) || !decoded.isKnown(appId) ||
+            !decoded.allKnown(ranking)) {
+            return false;
+        }
+    }
+
+    // Скользящее окно
+    std::uint64_t liveBuckets = 0;
+    if (!reader.get(decoded.bucketWidth) || !reader.get(decoded.bucketCount) ||
+        decoded.bucketWidth <= 0 || decoded.bucketCount == 0 ||
+        decoded.bucketCount > kMaxBuckets ||
+        !reader.getCount(liveBuckets, sizeof(std::int64_t) + sizeof(int)) ||
+        liveBuckets > decoded.bucketCount) {
+        return false;
+    }
+    decoded.buckets.resize(static_cast<size_t>(liveBuckets));
+    for (auto& bucket : decoded.buckets) {
+        if (!reader.get(bucket.index) || !reader.get(bucket.total) ||
+            !reader.getCounts(bucket.apps) || !reader.getCounts(bucket.combos) ||
+            !reader.getCounts(bucket.appCombos) || !decoded.allKnown(bucket.apps) ||
+            !decoded.allKnown(bucket.combos)) {
+            return false;
+        }
+        for (const auto& [key, count] : bucket.appCombos) {
+            if (!decoded.isKnown(static_cast<SymbolId>(key >> 32)) ||
+                !decoded.isKnown(static_cast<SymbolId>(key))) {
+                return false;
+            }
+        }
+    }
+
+    // Тепловые карты, если были включены
+    std::uint8_t hasHeatmaps = 0;
+    if (!reader.get(hasHeatmaps)) {
+        return false;
+    }
+    if (hasHeatmaps) {
+        auto& heatmaps = decoded.heatmaps.emplace();
+        std::uint8_t local = 0;
+        if (!reader.get(local) || !reader.get(heatmaps.fixedOffsetMs) ||
+            !decodeHeatmapList(reader, decoded, heatmaps.apps) ||
+            !decodeHeatmapList(reader, decoded, heatmaps.combos)) {
+            return false;
+        }
+        heatmaps.local = local != 0;
+    }
+    return !reader.hasFailed() && reader.atEnd();
+}
+
+} // namespace
+
+std::string StatisticsSnapshot::encode(const KeyStatistics& stats) {
+    std::string image(sizeof(Header), '\0');
+    image.reserve(sizeof(Header) + stats.keyPressHistory.size() * sizeof(KeyPress) +
+                  stats.symbols.size() * 32);
+    ImageWriter writer(image);
+
+    // Таблица имен
+    const SymbolTable& symbols = stats.symbols;
+    writer.put(static_cast<std::uint32_t>(symbols.size()));
+    for (SymbolId id = 0; id < symbols.size(); ++id) {
+        writer.put(static_cast<std::uint32_t>(symbols.resolve(id).size()));
+    }
+    for (SymbolId id = 0; id < symbols.size(); ++id) {
+        std::string_view name = symbols.resolve(id);
+        writer.putBytes(name.data(), name.size());
+    }
+
+    // История от старых к новым
+    const auto& history = stats.keyPressHistory;
+    writer.put<std::uint64_t>(history.capacity());
+    writer.put<std::uint64_t>(stats.outOfOrder);
+    writer.put<std::uint64_t>(history.size());
+    for (const auto& press : history) {
+        writer.put(press);
+    }
+
+    writer.putRanking(stats.appCounts);
+    writer.putRanking(stats.keyCounts);
+    writer.put<std::uint64_t>(stats.appKeyCounts.size());
+    for (const auto& [appId, counter] : stats.appKeyCounts) {
+        writer.put(appId);
+        writer.putRanking(counter);
+    }
+
+    const SlidingWindowStats& window = stats.window;
+    writer.put(window.bucketWidth());
+    writer.put<std::uint64_t>(window.bucketCount());
+    std::uint64_t liveBuckets = 0;
+    window.forEachBucket([&](const SlidingWindowStats::Bucket&) { ++liveBuckets; });
+    writer.put(liveBuckets);
+    window.forEachBucket([&](const SlidingWindowStats::Bucket& bucket) {
+        writer.put(bucket.index);
+        writer.put(bucket.total);
+        writer.putCounts(bucket.apps);
+        writer.putCounts(bucket.combos);
+        writer.putCounts(bucket.appCombos);
+    });
+
+    writer.put<std::uint8_t>(stats.heatmaps ? 1 : 0);
+    if (stats.heatmaps) {
+        writer.put<std::uint8_t>(stats.heatmaps->clock.isLocal() ? 1 : 0);
+        writer.put(stats.heatmaps->clock.getFixedOffsetMs());
+        for (const auto* maps : {&stats.heatmaps->apps, &stats.heatmaps->combos}) {
+            writer.put<std::uint64_t>(maps->size());
+            for (const auto& [id, heatmap] : *maps) {
+                writer.put(id);
+                writer.putBytes(heatmap.counts.data(), sizeof(heatmap.counts));
+            }
+        }
+    }
+
+    Header header{};
+    header.magic = kSnapshotMagic;
+    header.version = kVersion;
+    header.byteOrder = kByteOrderMark;
+    header.payloadSize = image.size() - sizeof(Header);
+    header.payloadCrc = crc32(image.data() + sizeof(Header), image.size() - sizeof(Header));
+    header.savedAt = KeyPress::now();
+    std::memcpy(image.data(), &header, sizeof(header));
+    return image;
+}
+
+bool StatisticsSnapshot::writeFile(const std::string& path, const std::string& image) {
+    std::string temporary = path + ".tmp";
+    std::remove(temporary.c_str()); // MappedFile не укорачивает файл
+
+    MappedFile file;
+    if (!file.open(temporary, MappedFile::Mode::ReadWrite, image.size())) {
+        return false;
+    }
+    std::memcpy(file.data(), image.data(), image.size());
+    bool synced = file.sync();
+    file.close();
+
+    std::error_code error;
+    if (synced) {
+        std::filesystem::rename(temporary, path, error);
+    }
+    if (!synced || error) {
+        std::cerr << "Failed to write statistics snapshot: " << path << std::endl;
+        std::remove(temporary.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool StatisticsSnapshot::decode(const char* data, size_t size, KeyStatistics& stats) {
+    Header header{};
+    if (size < sizeof(Header)) {
+        return false;
+    }
+    std::memcpy(&header, data, sizeof(header));
+    if (header.magic != kSnapshotMagic || header.version != kVersion ||
+        header.byteOrder != kByteOrderMark || header.payloadSize != size - sizeof(Header) ||
+        header.payloadCrc != crc32(data + sizeof(Header), size - sizeof(Header))) {
+        return false;
+    }
+
+    DecodedSnapshot decoded;
+    ImageReader reader(data + sizeof(Header), size - sizeof(Header));
+    if (!decodePayload(reader, decoded)) {
+        return false;
+    }
+
+    // Дальше ошибок нет: образ целиком проверен. Номера из снимка
+    // переводятся, только если таблица stats уже была заполнена иначе.
+    std::vector<SymbolId> ids(decoded.names.size());
+    bool identity = true;
+    for (size_t i = 0; i < decoded.names.size(); ++i) {
+        ids[i] = stats.symbols.intern(decoded.names[i]);
+        identity = identity && ids[i] == i;
+    }
+    auto remap = [&](Ranking ranking) {
+        if (!identity) {
+            for (auto& entry : ranking) {
+                entry.first = ids[entry.first];
+            }
+        }
+        return ranking;
+    };
+    if (!identity) {
+        for (auto& press : decoded.history) {
+            press.appId = ids[press.appId];
+            press.comboId = ids[press.comboId];
+        }
+    }
+
+    stats.keyPressHistory = RingBuffer<KeyPress>(static_cast<size_t>(decoded.historyCapacity));
+    stats.keyPressHistory.assign(std::move(decoded.history));
+    stats.outOfOrder = static_cast<size_t>(decoded.outOfOrder);
+    stats.appCounts.assign(remap(std::move(decoded.appCounts)));
+    stats.keyCounts.assign(remap(std::move(decoded.keyCounts)));
+    stats.appKeyCounts.clear();
+    for (auto& [appId, ranking] : decoded.appKeyCounts) {
+        stats.appKeyCounts[ids[appId]].assign(remap(std::move(ranking)));
+    }
+
+    stats.window = SlidingWindowStats(decoded.bucketWidth, static_cast<size_t>(decoded.bucketCount));
+    for (auto& saved : decoded.buckets) {
+        SlidingWindowStats::Bucket bucket;
+        bucket.index = saved.index;
+        bucket.total = saved.total;
+        bucket.apps.reserve(saved.apps.size());
+        bucket.combos.reserve(saved.combos.size());
+        bucket.appCombos.reserve(saved.appCombos.size());
+        for (const auto& [id, count] : saved.apps) {
+            bucket.apps[ids[id]] = count;
+        }
+        for (const auto& [id, count] : saved.combos) {
+            bucket.combos[ids[id]] = count;
+        }
+        for (const auto& [key, count] : saved.appCombos) {
+            bucket.appCombos[SlidingWindowStats::appComboKey(
+                ids[static_cast<SymbolId>(key >> 32)], ids[static_cast<SymbolId>(key)])] = count;
+        }
+        stats.window.restoreBucket(std::move(bucket));
+    }
+
+    if (decoded.heatmaps) {
+        const auto& saved = *decoded.heatmaps;
+        KeyStatistics::Heatmaps heatmaps{
+            saved.local ? HeatmapClock()
+                        : HeatmapClock(std::chrono::minutes(saved.fixedOffsetMs / 60000)),
+            {}, {}};
+        for (const auto& [id, heatmap] : saved.apps) {
+            heatmaps.apps[ids[id]] = heatmap;
+        }
+        for (const auto& [id, heatmap] : saved.combos) {
+            heatmaps.combos[ids[id]] = heatmap;
+        }
+        stats.heatmaps = std::move(heatmaps);
+    } else if (stats.heatmaps) {
+        stats.heatmaps->apps.clear();
+        stats.heatmaps->combos.clear();
+    }
+
+    // Производные структуры строятся заново по восстановленной истории
+    if (stats.columns) {
+        stats.columns.reset();
+        stats.setColumnarHistory(true);
+    }
+    if (stats.sketches) {
+        stats.sketches->clear();
+    }
+    if (stats.sequences) {
+        stats.sequences->clear();
+    }
+    return true;
+}
+
+bool StatisticsSnapshot::load(const std::string& path, KeyStatistics& stats) {
+    std::error_code error;
+    if (!std::filesystem::exists(path, error)) {
+        return false;
+    }
+    MappedFile file;
+    if (!file.open(path, MappedFile::Mode::ReadOnly)) {
+        return false;
+    }
+    if (!decode(file.data(), file.size(), stats)) {
+        std::cerr << "Statistics snapshot " << path << " is damaged or has unknown format"
+                  << std::endl;
+        return false;
+    }
+    return true;
+}
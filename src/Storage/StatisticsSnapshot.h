@@ -0,0 +1,43 @@
+#pragma once
+#include "Models/KeyStatistics.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Двоичный снимок KeyStatistics для теплого старта: таблица имен,
+// история нажатий (16-байтовые записи подряд), счетчики в порядке
+// рейтинга, корзины скользящего окна и тепловые карты. Загрузка
+// отображает файл в память, проверяет заголовок и CRC и собирает
+// структуры блоками - без addKeyPress на каждое нажатие и без запросов
+// к SQLite. Оценки (Sketches) и последовательности в снимок не входят
+// и после загрузки считаются заново.
+//
+// Формат: заголовок фиксированного размера (магия, версия, порядок
+// байт, размер и CRC32 полезной нагрузки), затем сама нагрузка. Числа -
+// в порядке байт записавшей машины; снимок с другим порядком байт или
+// другой версии не загружается.
+class StatisticsSnapshot {
+public:
+  static constexpr std::uint32_t kVersion = 1;
+
+  // Образ снимка в памяти. Вызывается в потоке писателя KeyStatistics
+  // или в любом потоке по KeyStatistics::copyPersistentState();
+  // O(истории + ключей), нажатия копируются одним блоком.
+  static std::string encode(const KeyStatistics &stats);
+
+  // Запись образа во временный файл рядом и замена path: после сбоя на
+  // диске остается прежний целый снимок
+  static bool writeFile(const std::string &path, const std::string &image);
+  static bool save(const KeyStatistics &stats, const std::string &path) {
+    return writeFile(path, encode(stats));
+  }
+
+  // Восстанавливает stats из образа. Емкость истории и окно берутся из
+  // снимка. Имена добавляются в таблицу stats; если она уже не пуста,
+  // номера в нажатиях переводятся. При ошибке (формат, версия, CRC,
+  // выход за границы) stats не меняется и возвращается false.
+  static bool decode(const char *data, size_t size, KeyStatistics &stats);
+
+  // Отображает файл и вызывает decode(); файла нет - false без сообщений
+  static bool load(const std::string &path, KeyStatistics &stats);
+};
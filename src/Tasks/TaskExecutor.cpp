@@ -0,0 +1,155 @@
+#include "TaskExecutor.h"
+#include <algorithm>
+#include <iostream>
+
+TaskExecutor::TaskExecutor(size_t workerCount) {
+    workerCount = std::max<size_t>(workerCount, 1);
+    for (size_t i = 0; i < workerCount; ++i) {
+        // Первый из нескольких потоков держим свободным для окна
+        workers.emplace_back(&TaskExecutor::workerLoop, this, i == 0 && workerCount > 1);
+    }
+}
+
+CancellationToken TaskExecutor::submit(TaskPriority priority, Task task, const std::string& key) {
+    CancellationToken token;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (stopping) {
+            token.cancel();
+            return token;
+        }
+        if (!key.empty()) {
+            auto [it, inserted] = latestByKey.try_emplace(key, token);
+            if (!inserted) {
+                // Вытесненная задача в очереди будет пропущена, выполняющаяся
+                // увидит флаг
+                it->second.cancel();
+                it->second = token;
+            }
+        }
+        queues[static_cast<size_t>(priority)].push_back({std::move(task), token, key});
+    }
+    condition.notify_all();
+    return token;
+}
+
+void TaskExecutor::deliver(std::function<void()> action) {
+    if (deliverer) {
+        deliverer(std::move(action));
+    } else {
+        action();
+    }
+}
+
+void TaskExecutor::cancel(const std::string& key) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = latestByKey.find(key);
+    if (it != latestByKey.end()) {
+        it->second.cancel();
+        latestByKey.erase(it);
+    }
+}
+
+size_t TaskExecutor::pendingCount() {
+    std::lock_guard<std::mutex> lock(mutex);
+    size_t count = 0;
+    for (const auto& queue : queues) {
+        count += queue.size();
+    }
+    return count;
+}
+
+void TaskExecutor::waitIdle() {
+    std::unique_lock<std::mutex> lock(mutex);
+    idleCondition.wait(lock, [this] {
+        return running == 0 && std::all_of(queues.begin(), queues.end(),
+                                           [](const auto& queue) { return queue.empty(); });
+    });
+}
+
+void TaskExecutor::shutdown() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (stopping && workers.empty()) {
+            return;
+        }
+        stopping = true;
+        for (auto& queue : queues) {
+            for (auto& queued : queue) {
+                queued.token.cancel();
+            }
+            queue.clear();
+        }
+        for (auto& [key, token] : latestByKey) {
+            token.cancel();
+        }
+        latestByKey.clear();
+    }
+    condition.notify_all();
+    idleCondition.notify_all();
+
+    for (auto& worker : workers) {
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+    workers.clear();
+}
+
+void TaskExecutor::workerLoop(bool interactiveOnly) {
+    size_t lowestPriority = interactiveOnly
+        ? static_cast<size_t>(TaskPriority::Interactive) + 1
+        : kPriorityCount;
+
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        QueuedTask next;
+        bool found = false;
+        condition.wait(lock, [&] {
+            if (stopping) {
+                return true;
+            }
+            for (size_t p = 0; p < lowestPriority && !found; ++p) {
+                // Отмененные задачи просто выбрасываем; если очередь от этого
+                // опустела, waitIdle должен узнать об этом сразу
+                bool dropped = false;
+                while (!queues[p].empty() && queues[p].front().token.isCancelled()) {
+                    queues[p].pop_front();
+                    dropped = true;
+                }
+                if (dropped) {
+                    idleCondition.notify_all();
+                }
+                if (!queues[p].empty()) {
+                    next = std::move(queues[p].front());
+                    queues[p].pop_front();
+                    found = true;
+                }
+            }
+            return found;
+        });
+        if (!found) {
+            break;
+        }
+
+        ++running;
+        lock.unlock();
+        try {
+            next.task(next.token);
+        } catch (const std::exception& e) {
+            std::cerr << "Exception in background task: " << e.what() << std::endl;
+        } catch (...) {
+            std::cerr << "Unknown exception in background task" << std::endl;
+        }
+        lock.lock();
+        --running;
+        // Задача выполнена - ее ключ больше ничего не отменяет
+        if (!next.key.empty()) {
+            auto it = latestByKey.find(next.key);
+            if (it != latestByKey.end() && it->second.isSameAs(next.token)) {
+                latestByKey.erase(it);
+            }
+        }
+        idleCondition.notify_all();
+    }
+}
@@ -0,0 +1,121 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Приоритеты фоновых задач, от самого срочного
+enum class TaskPriority {
+  Interactive = 0, // запросы, которых ждет пользователь в окне
+  Export,
+  Analytics,
+  Maintenance,
+};
+
+// Флаг отмены задачи. Долгая задача проверяет его между шагами;
+// результат отмененной задачи в UI не доставляется.
+class CancellationToken {
+private:
+  std::shared_ptr<std::atomic<bool>> flag = std::make_shared<std::atomic<bool>>(false);
+
+public:
+  bool isCancelled() const { return flag->load(std::memory_order_relaxed); }
+  void cancel() const { flag->store(true, std::memory_order_relaxed); }
+  bool isSameAs(const CancellationToken &other) const { return flag == other.flag; }
+};
+
+// Пул фоновых потоков с очередями по приоритетам. Задачи с одним ключом
+// вытесняют друг друга: новая отменяет предыдущую (например, запрос
+// статистики при быстром переключении приложений). При нескольких
+// потоках первый берет только Interactive, поэтому долгая выгрузка или
+// анализ не задерживают ответ окну.
+//
+// Результаты возвращаются в UI-поток через доставщик (в приложении -
+// Fl::awake); без доставщика обработчик вызывается в рабочем потоке.
+class TaskExecutor {
+public:
+  using Task = std::function<void(const CancellationToken &)>;
+  using Deliverer = std::function<void(std::function<void()>)>;
+
+private:
+  struct QueuedTask {
+    Task task;
+    CancellationToken token;
+    std::string key;
+  };
+
+  static constexpr size_t kPriorityCount = 4;
+
+  std::mutex mutex;
+  std::condition_variable condition;
+  std::array<std::deque<QueuedTask>, kPriorityCount> queues;
+  std::unordered_map<std::string, CancellationToken> latestByKey;
+  std::vector<std::thread> workers;
+  bool stopping = false;
+  size_t running = 0;
+  std::condition_variable idleCondition;
+  Deliverer deliverer;
+
+  void workerLoop(bool interactiveOnly);
+
+public:
+  explicit TaskExecutor(size_t workerCount = 2);
+  ~TaskExecutor() { shutdown(); }
+
+  TaskExecutor(const TaskExecutor &) = delete;
+  TaskExecutor &operator=(const TaskExecutor &) = delete;
+
+  // Задается до первой задачи
+  void setDeliverer(Deliverer deliver) { deliverer = std::move(deliver); }
+
+  // Ставит задачу в очередь. Непустой key отменяет предыдущую задачу
+  // с тем же ключом, ждет ли она в очереди или уже выполняется.
+  CancellationToken submit(TaskPriority priority, Task task, const std::string &key = "");
+
+  // Работа в фоне, результат - в UI-поток, если задачу не отменили
+  template <typename Result>
+  CancellationToken submit(TaskPriority priority, const std::string &key,
+                           std::function<Result(const CancellationToken &)> work,
+                           std::function<void(Result)> onResult);
+
+  // Выполняет action в UI-потоке (или сразу, если доставщика нет)
+  void deliver(std::function<void()> action);
+
+  void cancel(const std::string &key);
+  size_t pendingCount();
+  // Ждет, пока очереди опустеют и все задачи завершатся
+  void waitIdle();
+  // Отменяет ожидающие задачи, дожидается выполняющихся и останавливает потоки
+  void shutdown();
+};
+
+template <typename Result>
+CancellationToken TaskExecutor::submit(TaskPriority priority, const std::string &key,
+                                       std::function<Result(const CancellationToken &)> work,
+                                       std::function<void(Result)> onResult) {
+  return submit(
+      priority,
+      [this, work = std::move(work), onResult = std::move(onResult)](
+          const CancellationToken &token) {
+        auto result = std::make_shared<Result>(work(token));
+        if (token.isCancelled()) {
+          return;
+        }
+        // Отмена могла прийти, пока результат ждал UI-поток
+        deliver([token, result, onResult] {
+          if (!token.isCancelled()) {
+            onResult(std::move(*result));
+          }
+        });
+      },
+      key);
+}
@@ -0,0 +1,47 @@
+#include "StatisticsFormatter.h"
+#include <iomanip>
+#include <sstream>
+
+std::string formatAppStatistics(const std::string &appName,
+                                const std::vector<ComboStat> &rows) {
+  std::stringstream ss;
+
+  if (rows.empty()) {
+    ss << "No key presses recorded for " << appName << " yet.\n";
+    return ss.str();
+  }
+
+  int rank = 1;
+  std::int64_t totalPresses = 0;
+
+  for (const auto &row : rows) {
+    totalPresses += row.pressCount;
+    ss << std::setw(2) << rank << ". " << std::setw(25) << std::left
+       << row.keyCombination << std::setw(6) << std::right << row.pressCount
+       << " times\n";
+    rank++;
+  }
+
+  ss << "\n" << std::string(40, '-') << "\n";
+  ss << "Total combinations: " << rows.size() << "\n";
+  ss << "Total key presses: " << totalPresses << "\n";
+
+  return ss.str();
+}
+
+std::string formatRecentKeys(size_t pressCount,
+                             const std::vector<std::pair<std::string, int>> &ranking) {
+  if (ranking.empty()) {
+    return "";
+  }
+
+  std::stringstream ss;
+  ss << "\nRecent (last " << pressCount << " presses):\n";
+  int rank = 1;
+  for (const auto &[keyCombination, count] : ranking) {
+    ss << std::setw(2) << rank << ". " << std::setw(25) << std::left
+       << keyCombination << std::setw(6) << std::right << count << " times\n";
+    rank++;
+  }
+  return ss.str();
+}
@@ -0,0 +1,14 @@
+#pragma once
+#include "Models/ComboStats.h"
+#include <string>
+#include <utility>
+#include <vector>
+
+// Текстовое представление статистики приложения для окна и экспорта
+std::string formatAppStatistics(const std::string &appName,
+                                const std::vector<ComboStat> &rows);
+
+// Самые частые комбинации приложения среди последних pressCount нажатий
+// (статистика в памяти, без запроса к БД); пусто, если нажатий нет
+std::string formatRecentKeys(size_t pressCount,
+                             const std::vector<std::pair<std::string, int>> &ranking);
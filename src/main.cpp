@@ -1,25 +1,88 @@
 #include <FL/Fl.H>
 #include <FL/Fl_Window.H>
 #include <FL/x.H>
-#include <fstream>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
 #include <iostream>
 #include <memory>
+#include <string>
 #include <windows.h>
 #include "Database/Database.h"
+#include "Export/StatisticsExporter.h"
 #include "KeyLogger/KeyLogger.h"
+#include "Models/ConcurrentKeyStatistics.h"
+#include "Storage/EventJournal.h"
+#include "Storage/StatisticsSnapshot.h"
+#include "Tasks/TaskExecutor.h"
 #include "UI/MainWindow.h"
+#include "UI/StatisticsFormatter.h"
 #include "UI/SystemTray.h"
 
+// Параметры запуска:
+//   --db <путь|:memory:>       основная БД (по умолчанию keypress_stats.db)
+//   --snapshot <путь>          файл снимков основной БД; для :memory:
+//                              по умолчанию keypress_stats.db
+//   --snapshot-interval <сек>  период снимков (по умолчанию 60)
+//   --stats-snapshot <путь>    двоичный снимок статистики в памяти
+//                              (по умолчанию hoka_stats.snapshot), тот же период
+// Журнал нажатий лежит рядом с БД (<db>.journal; для :memory: - рядом
+// с файлом снимков), чтобы у каждой БД был свой журнал.
+struct LaunchOptions {
+    std::string databasePath = "keypress_stats.db";
+    std::string snapshotPath;
+    std::string journalPath;
+    std::chrono::seconds snapshotInterval{60};
+    std::string statsSnapshotPath = "hoka_stats.snapshot";
+};
+
+LaunchOptions parseLaunchOptions(int argc, char* argv[]) {
+    LaunchOptions options;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string name = argv[i];
+        std::string value = argv[i + 1];
+        if (name == "--db") {
+            options.databasePath = value;
+        } else if (name == "--snapshot") {
+            options.snapshotPath = value;
+        } else if (name == "--snapshot-interval") {
+            options.snapshotInterval = std::chrono::seconds(std::max(1L, std::atol(value.c_str())));
+        } else if (name == "--stats-snapshot") {
+            options.statsSnapshotPath = value;
+        } else {
+            std::cerr << "Unknown option: " << name << std::endl;
+        }
+    }
+    if (options.databasePath == Database::kInMemory && options.snapshotPath.empty()) {
+        options.snapshotPath = "keypress_stats.db";
+    }
+    options.journalPath = (options.databasePath == Database::kInMemory
+        ? options.snapshotPath : options.databasePath) + ".journal";
+    return options;
+}
+
 class HokaApplication {
 private:
+    LaunchOptions options;
     std::unique_ptr<Database> db;
+    std::unique_ptr<EventJournal> journal;
+    std::atomic<bool> journalDrainPending{false};
+    bool journalFullReported = false; // в потоке KeyLogger
+    std::unique_ptr<ConcurrentKeyStatistics> liveStats;
+    std::atomic<bool> liveStatsClearPending{false};
+    std::chrono::steady_clock::time_point lastStatsSnapshot;
+    std::unique_ptr<TaskExecutor> tasks;
     std::unique_ptr<KeyLogger> logger;
     std::unique_ptr<MainWindow> window;
     std::unique_ptr<SystemTray> tray;
     
     bool initializeDatabase() {
         db = std::make_unique<Database>();
-        if (!db->initialize()) {
+        if (!options.snapshotPath.empty()) {
+            db->setSnapshotPolicy(options.snapshotPath, options.snapshotInterval);
+        }
+        if (!db->initialize(options.databasePath)) {
             std::cerr << "Failed to initialize database" << std::endl;
             return false;
         }
@@ -27,6 +90,111 @@ private:
         return true;
     }
     
+    // Журнал нажатий перед БД: сначала дописываем в БД то, что не успело
+    // попасть в нее до прошлого завершения, затем принимаем новые нажатия
+    bool initializeJournal() {
+        journal = std::make_unique<EventJournal>();
+        std::uint64_t committed = db->getCommittedJournalSequence();
+        if (!journal->open(options.journalPath, 65536, committed + 1)) {
+            std::cerr << "Failed to open event journal" << std::endl;
+            return false;
+        }
+        // Пакет мог попасть в БД, а отметка в журнале - нет
+        journal->markConsumed(committed);
+
+        EventJournal* events = journal.get();
+        db->setJournalCommitCallback([events](std::uint64_t sequence) {
+            events->markConsumed(sequence);
+        });
+
+        size_t replayed = journal->replay([this](const JournalRecord& record) {
+            db->updateKeyStatistics(std::string(record.appName),
+                                    std::string(record.keyCombination),
+                                    record.timestamp, record.sequence);
+        });
+        if (replayed > 0) {
+            db->flush();
+            std::cout << "Recovered " << replayed << " key presses from journal" << std::endl;
+        }
+        return true;
+    }
+
+    // Вызывается в потоке KeyLogger. Журнал начинается с первого слота,
+    // только когда подтверждено все записанное, поэтому на подходе к
+    // заполнению буфер БД сбрасывается в фоне (со снимками - снимком:
+    // подтверждение ждет его). Нажатия, не попавшие в журнал, пока он
+    // полон, остаются без защиты от падения - об этом пишем в лог.
+    void drainJournalIfFull(const KeyPressEvent& event) {
+        bool full = event.journalSequence == 0 && journal->isOpen();
+        if (full && !journalFullReported) {
+            std::cerr << "Event journal is full, key presses are not crash-protected "
+                         "until the database catches up" << std::endl;
+        }
+        journalFullReported = full;
+        if (!full && journal->getFreeSlots() > journal->getCapacity() / 8) {
+            return;
+        }
+        if (journalDrainPending.exchange(true)) {
+            return;
+        }
+        tasks->submit(TaskPriority::Maintenance, [this](const CancellationToken&) {
+            bool drained = options.snapshotPath.empty() ? db->flush() : db->snapshotNow();
+            if (!drained) {
+                std::cerr << "Failed to flush database for event journal" << std::endl;
+            }
+            journalDrainPending = false;
+        }, "journal-drain");
+    }
+    
+    // Статистика в памяти: теплый старт из двоичного снимка, без
+    // прохода по БД
+    void initializeLiveStatistics() {
+        liveStats = std::make_unique<ConcurrentKeyStatistics>(100000, 64);
+        auto started = std::chrono::steady_clock::now();
+        if (StatisticsSnapshot::load(options.statsSnapshotPath, liveStats->writer())) {
+            auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::steady_clock::now() - started);
+            std::cout << "Statistics snapshot loaded in " << elapsed.count() << " ms" << std::endl;
+        }
+        liveStats->publish();
+        lastStatsSnapshot = std::chrono::steady_clock::now();
+    }
+
+    // Вызывается в потоке KeyLogger (писатель liveStats): здесь только
+    // проверка срока и копия состояния в опубликованный снимок. Образ
+    // собирается и пишется в фоне по снимку для читателей; новый снимок
+    // отменяет еще не записанный прежний.
+    void saveStatisticsSnapshotIfDue() {
+        auto now = std::chrono::steady_clock::now();
+        if (now - lastStatsSnapshot < options.snapshotInterval) {
+            return;
+        }
+        lastStatsSnapshot = now;
+        liveStats->publishState();
+        std::string path = options.statsSnapshotPath;
+        tasks->submit(TaskPriority::Maintenance, [this, path](const CancellationToken& token) {
+            std::shared_ptr<const KeyStatistics> state = liveStats->read()->state;
+            if (state && !token.isCancelled()) {
+                StatisticsSnapshot::writeFile(path, StatisticsSnapshot::encode(*state));
+            }
+        }, "stats-snapshot");
+    }
+    
+    // Фоновые задачи: запросы, выгрузка и обслуживание БД идут вне
+    // UI-потока, результаты возвращаются в него через Fl::awake
+    void initializeTasks() {
+        Fl::lock(); // включает очередь Fl::awake
+        tasks = std::make_unique<TaskExecutor>(2);
+        tasks->setDeliverer([](std::function<void()> action) {
+            auto* pending = new std::function<void()>(std::move(action));
+            Fl::awake([](void* data) {
+                std::unique_ptr<std::function<void()>> run(
+                    static_cast<std::function<void()>*>(data));
+                (*run)();
+            }, pending);
+        });
+    }
+    
     bool initializeSystemTray() {
         tray = std::make_unique<SystemTray>();
         if (!tray->initialize(L"Hoka Key Analyzer")) {
@@ -73,22 +241,33 @@ private:
     }
     
     void setupWindowCallbacks() {
-        // Callback для выбора приложения
+        // Callback для выбора приложения: при быстром переключении
+        // устаревший запрос отменяется новым
         window->setOnAppSelectedCallback([this](const std::string& app) {
             std::cout << "AppSelectedCallback: selected app = " << app << std::endl;
-            std::string stats = db->getAppStatistics(app);
-            std::cout << "AppSelectedCallback: stats = " << stats << std::endl;
-            window->updateAppStatistics(app, stats);
+            tasks->submit<std::string>(TaskPriority::Interactive, "app-statistics",
+                [this, app](const CancellationToken&) { return loadAppStatistics(app); },
+                [this, app](std::string stats) { window->updateAppStatistics(app, stats); });
         });
         
         // Callback для очистки статистики
         window->setOnClearCallback([this]() {
-            if (db->clearStatistics()) {
-                std::cout << "ClearCallback: statistics cleared" << std::endl;
-                window->clearRecentActivity();
-                window->updateAppStatistics("", "");
-                window->setStatus("Statistics cleared");
-            }
+            tasks->cancel("app-statistics");
+            tasks->cancel("refresh");
+            tasks->submit<bool>(TaskPriority::Maintenance, "",
+                [this](const CancellationToken&) {
+                    // Статистику в памяти очищает ее писатель при следующем нажатии
+                    liveStatsClearPending = true;
+                    return db->clearStatistics();
+                },
+                [this](bool cleared) {
+                    if (cleared) {
+                        std::cout << "ClearCallback: statistics cleared" << std::endl;
+                        window->clearRecentActivity();
+                        window->updateAppStatistics("", "");
+                        window->setStatus("Statistics cleared");
+                    }
+                });
         });
         
         // Callback для экспорта
@@ -97,6 +276,47 @@ private:
         });
     }
     
+    // Список приложений и статистика выбранного после новых нажатий.
+    // Серия нажатий схлопывается: каждый новый запрос отменяет прежний.
+    // Вызывается в UI-потоке.
+    void refreshWindowData() {
+        std::string selectedApp = window->getSelectedApp();
+        struct WindowData {
+            std::vector<std::string> apps;
+            std::string stats;
+        };
+        tasks->submit<WindowData>(TaskPriority::Interactive, "refresh",
+            [this, selectedApp](const CancellationToken& token) {
+                WindowData data;
+                data.apps = db->getAllApps();
+                if (!selectedApp.empty() && !token.isCancelled()) {
+                    data.stats = loadAppStatistics(selectedApp);
+                }
+                return data;
+            },
+            [this, selectedApp](WindowData data) {
+                window->updateAppList(data.apps);
+                if (!selectedApp.empty() && window->getSelectedApp() == selectedApp) {
+                    window->updateAppStatistics(selectedApp, data.stats);
+                }
+            });
+    }
+    
+    // Полная статистика приложения из БД и топ среди последних нажатий
+    // из статистики в памяти - опубликованный снимок читается без
+    // блокировок, писатель (поток KeyLogger) не ждет
+    std::string loadAppStatistics(const std::string& app) {
+        ComboStatsQuery query;
+        query.appName = app;
+        query.pageSize = 0;
+        std::string text = formatAppStatistics(app, db->queryComboStats(query).rows);
+        if (!liveStatsClearPending) {
+            auto recent = liveStats->read();
+            text += formatRecentKeys(recent->getCount(), recent->getTopKeysForApp(app, 5));
+        }
+        return text;
+    }
+    
     void setupSystemTrayCallbacks() {
         tray->onRestoreCallback = [this]() { 
             window->restoreFromTray(); 
@@ -126,6 +346,7 @@ private:
     
     bool initializeKeyLogger() {
         logger = std::make_unique<KeyLogger>();
+        logger->setJournal(journal.get());
         
         // Устанавливаем callback для обработки событий клавиатуры
         auto keyEventCallback = [this](const KeyPressEvent& event) {
@@ -147,26 +368,28 @@ private:
         }
         
         // Обновляем статистику в базе данных
-        db->updateKeyStatistics(event.appName, event.keyCombination);
-        
-        // Обновляем UI только если окно видимо (для производительности)
-        if (window->visible()) {
-            // Добавляем событие в список недавних нажатий
-            window->addRecentKeyPress(event.appName, event.keyCombination);
-            
-            // Обновляем список приложений
-            window->updateAppList(db->getAllApps());
-            
-            // Обновляем статистику выбранного приложения
-            std::string selectedApp = window->getSelectedApp();
-            if (!selectedApp.empty()) {
-                std::string stats = db->getAppStatistics(selectedApp);
-                window->updateAppStatistics(selectedApp, stats);
-            }
+        db->updateKeyStatistics(event.appName, event.keyCombination,
+                                event.timestamp, event.journalSequence);
+        if (liveStatsClearPending.exchange(false)) {
+            liveStats->writer().clearHistory();
+            liveStats->publish();
         }
+        liveStats->addKeyPress(event.appName, event.keyCombination, event.timestamp);
+        drainJournalIfFull(event);
+        saveStatisticsSnapshotIfDue();
         
-        // Обновляем tooltip в системном лотке
-        updateSystemTrayTooltip(event);
+        // Окно трогаем только из UI-потока; запросы к БД - в фоне
+        tasks->deliver([this, event]() {
+            // Обновляем UI только если окно видимо (для производительности)
+            if (window->visible()) {
+                // Добавляем событие в список недавних нажатий
+                window->addRecentKeyPress(event.appName, event.keyCombination);
+                refreshWindowData();
+            }
+            
+            // Обновляем tooltip в системном лотке
+            updateSystemTrayTooltip(event);
+        });
     }
     
     void updateSystemTrayTooltip(const KeyPressEvent& event) {
@@ -176,20 +399,25 @@ private:
     }
     
     void exportStatistics() {
-        std::ofstream exportFile("hoka_stats.txt");
-        if (exportFile) {
-            auto apps = db->getAllApps();
-            for (const auto& app : apps) {
-                exportFile << "\nStatistics for " << app << ":\n";
-                exportFile << db->getAppStatistics(app);
-            }
-            exportFile.close();
-            window->showNotification("Exported to hoka_stats.txt");
-            std::cout << "ExportCallback: exported to hoka_stats.txt" << std::endl;
-        } else {
-            window->showError("Failed to export");
-            std::cout << "ExportCallback: failed to export" << std::endl;
-        }
+        // Один проход по БД с записью через буфер, без сборки строк
+        // по каждому приложению; окно тем временем остается отзывчивым
+        window->setStatus("Exporting...");
+        tasks->submit<bool>(TaskPriority::Export, "export",
+            [this](const CancellationToken&) {
+                StatisticsExporter exporter(*db);
+                ExportOptions options;
+                options.format = ExportFormat::Text;
+                return exporter.exportToFile("hoka_stats.txt", options).success;
+            },
+            [this](bool exported) {
+                if (exported) {
+                    window->showNotification("Exported to hoka_stats.txt");
+                    std::cout << "ExportCallback: exported to hoka_stats.txt" << std::endl;
+                } else {
+                    window->showError("Failed to export");
+                    std::cout << "ExportCallback: failed to export" << std::endl;
+                }
+            });
     }
     std::atomic<bool> shouldExit{false};
     void shutdown() {
@@ -199,6 +427,24 @@ private:
         if (logger) {
             logger->stop();
         }
+        // Ожидающие задачи отменяются, выполняющиеся (выгрузка) дописываются
+        if (tasks) {
+            tasks->shutdown();
+        }
+        // Поток KeyLogger остановлен - снимок статистики пишем сами
+        if (liveStats) {
+            StatisticsSnapshot::save(liveStats->writer(), options.statsSnapshotPath);
+        }
+
+        // exit(0) ниже не вызовет деструкторы, поэтому буфер записи
+        // сбрасываем явно
+        if (db) {
+            db->flush();
+            db->snapshotNow();
+        }
+        if (journal) {
+            journal->sync();
+        }
     
         if (tray) {
             tray->hide();
@@ -213,11 +459,17 @@ private:
     }
 
 public:
+    explicit HokaApplication(LaunchOptions launchOptions)
+        : options(std::move(launchOptions)) {}
+
     bool initialize() {
         std::cout << "Starting Hoka..." << std::endl;
         
         // Инициализируем компоненты в правильном порядке
         if (!initializeDatabase()) return false;
+        if (!initializeJournal()) return false;
+        initializeLiveStatistics();
+        initializeTasks();
         if (!initializeSystemTray()) return false;
         
         initializeMainWindow();
@@ -244,8 +496,8 @@ public:
     }
 };
 
-int main() {
-    HokaApplication app;
+int main(int argc, char* argv[]) {
+    HokaApplication app(parseLaunchOptions(argc, argv));
     
     if (!app.initialize()) {
         std::cerr << "Failed to initialize application" << std::endl;